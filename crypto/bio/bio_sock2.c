@@ -204,6 +204,8 @@ int BIO_connect(int sock, const BIO_ADDR *addr, int options)
  * Options can be a combination of the following:
  * - BIO_SOCK_REUSEADDR: Try to reuse the address and port combination
  *   for a recently closed port.
+ * - BIO_SOCK_REUSEPORT: Allow several sockets to bind to the same address and
+ *   port, so that the kernel spreads incoming traffic between them.
  *
  * When restarting the program it could be that the port is still in use.  If
  * you set to BIO_SOCK_REUSEADDR option it will try to reuse the port anyway.
@@ -236,6 +238,21 @@ int BIO_bind(int sock, const BIO_ADDR *addr, int options)
     }
 # endif
 
+    if (options & BIO_SOCK_REUSEPORT) {
+# if defined(SO_REUSEPORT) && !defined(OPENSSL_SYS_WINDOWS)
+        if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT,
+                       (const void *)&on, sizeof(on)) != 0) {
+            ERR_raise_data(ERR_LIB_SYS, get_last_socket_error(),
+                           "calling setsockopt()");
+            ERR_raise(ERR_LIB_BIO, BIO_R_UNABLE_TO_REUSEPORT);
+            return 0;
+        }
+# else
+        ERR_raise(ERR_LIB_BIO, BIO_R_UNABLE_TO_REUSEPORT);
+        return 0;
+# endif
+    }
+
     if (bind(sock, BIO_ADDR_sockaddr(addr), BIO_ADDR_sockaddr_size(addr)) != 0) {
         ERR_raise_data(ERR_LIB_SYS, get_last_socket_error() /* may be 0 */,
                        "calling bind()");
@@ -261,6 +278,8 @@ int BIO_bind(int sock, const BIO_ADDR *addr, int options)
  * - BIO_SOCK_NODELAY: don't delay small messages.
  * - BIO_SOCK_REUSEADDR: Try to reuse the address and port combination
  *   for a recently closed port.
+ * - BIO_SOCK_REUSEPORT: Allow several sockets to bind to the same address and
+ *   port.
  * - BIO_SOCK_V6_ONLY: When creating an IPv6 socket, make it listen only
  *   for IPv6 addresses and not IPv4 addresses mapped to IPv6.
  * - BIO_SOCK_TFO: accept TCP fast open (set TCP_FASTOPEN)
@@ -33,6 +33,20 @@
 #  define IPPROTO_IPV6 41       /* windows is lame */
 # endif
 
+# if defined(OPENSSL_SYS_LINUX)
+#  include <netinet/udp.h>
+#  if !defined(SOL_UDP)
+#   define SOL_UDP     17
+#  endif
+/* Older libc headers do not know about UDP segmentation offload. */
+#  if !defined(UDP_SEGMENT)
+#   define UDP_SEGMENT 103
+#  endif
+#  if !defined(UDP_GRO)
+#   define UDP_GRO     104
+#  endif
+# endif
+
 # if defined(__FreeBSD__) && defined(IN6_IS_ADDR_V4MAPPED)
 /* Standard definition causes type-punning problems. */
 #  undef IN6_IS_ADDR_V4MAPPED
@@ -127,16 +141,33 @@
 #   else
 #     define BIO_CMSG_ALLOC_LEN_3   0
 #   endif
+#   if defined(OPENSSL_SYS_LINUX) && M_METHOD != M_METHOD_WSARECVMSG
+    /*
+     * UDP_SEGMENT (uint16_t) and UDP_GRO (int) control messages may follow
+     * the packet info.
+     */
+#    define SUPPORT_UDP_SEGMENT
+#    define BIO_CMSG_ALLOC_LEN_4   BIO_CMSG_SPACE(sizeof(int))
+#   else
+#    define BIO_CMSG_ALLOC_LEN_4   0
+#   endif
 #   define BIO_MAX(X,Y) ((X) > (Y) ? (X) : (Y))
 #   define BIO_CMSG_ALLOC_LEN                                        \
-        BIO_MAX(BIO_CMSG_ALLOC_LEN_1,                                \
-                BIO_MAX(BIO_CMSG_ALLOC_LEN_2, BIO_CMSG_ALLOC_LEN_3))
+        (BIO_MAX(BIO_CMSG_ALLOC_LEN_1,                               \
+                 BIO_MAX(BIO_CMSG_ALLOC_LEN_2, BIO_CMSG_ALLOC_LEN_3)) \
+         + BIO_CMSG_ALLOC_LEN_4)
 #  endif
 #  if (defined(IP_PKTINFO) || defined(IP_RECVDSTADDR)) && defined(IPV6_RECVPKTINFO)
 #   define SUPPORT_LOCAL_ADDR
 #  endif
 # endif
 
+/*
+ * Maximum number of segments the kernel accepts in a single UDP_SEGMENT send
+ * (UDP_MAX_SEGMENTS in the Linux kernel).
+ */
+# define BIO_UDP_MAX_SEGMENTS   64
+
 # define BIO_MSG_N(array, stride, n) (*(BIO_MSG *)((char *)(array) + (n)*(stride)))
 
 static int dgram_write(BIO *h, const char *buf, int num);
@@ -216,6 +247,9 @@ typedef struct bio_dgram_data_st {
     OSSL_TIME socket_timeout;
     unsigned int peekmode;
     char local_addr_enabled;
+    char gro_enabled;
+    /* 1 if UDP_SEGMENT is usable, 0 if not, -1 if not yet probed. */
+    signed char gso_cap;
 } bio_dgram_data;
 
 # ifndef OPENSSL_NO_SCTP
@@ -267,6 +301,7 @@ static int dgram_new(BIO *bi)
 
     if (data == NULL)
         return 0;
+    data->gso_cap = -1;
     bi->ptr = data;
     return 1;
 }
@@ -544,6 +579,31 @@ static int enable_local_addr(BIO *b, int enable) {
 }
 # endif
 
+# if defined(SUPPORT_UDP_SEGMENT)
+/*
+ * Determines whether the kernel supports UDP_SEGMENT on this socket. Kernels
+ * without UDP segmentation offload do not know the socket option.
+ */
+static int probe_gso(BIO *b)
+{
+    bio_dgram_data *data = b->ptr;
+    int val = 0;
+    socklen_t len = sizeof(val);
+
+    if (data->gso_cap < 0)
+        data->gso_cap
+            = getsockopt(b->num, SOL_UDP, UDP_SEGMENT, &val, &len) == 0;
+
+    return data->gso_cap;
+}
+
+static int enable_gro(BIO *b, int enable)
+{
+    return setsockopt(b->num, SOL_UDP, UDP_GRO,
+                      &enable, sizeof(enable)) == 0;
+}
+# endif
+
 static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
 {
     long ret = 1;
@@ -588,6 +648,11 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
             if (enable_local_addr(b, 1) < 1)
                 data->local_addr_enabled = 0;
         }
+# endif
+        data->gso_cap = -1;
+# if defined(SUPPORT_UDP_SEGMENT)
+        if (data->gro_enabled && !enable_gro(b, 1))
+            data->gro_enabled = 0;
 # endif
         break;
     case BIO_C_GET_FD:
@@ -999,6 +1064,34 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
         *(int *)ptr = data->local_addr_enabled;
         break;
 
+    case BIO_CTRL_DGRAM_GET_GSO_CAP:
+# if defined(SUPPORT_UDP_SEGMENT)
+        ret = probe_gso(b) ? BIO_UDP_MAX_SEGMENTS : 0;
+# else
+        ret = 0;
+# endif
+        break;
+
+    case BIO_CTRL_DGRAM_SET_GRO_ENABLE:
+# if defined(SUPPORT_UDP_SEGMENT)
+        num = num > 0;
+        if (num != data->gro_enabled) {
+            if (!enable_gro(b, num)) {
+                ret = 0;
+                break;
+            }
+
+            data->gro_enabled = (char)num;
+        }
+# else
+        ret = 0;
+# endif
+        break;
+
+    case BIO_CTRL_DGRAM_GET_GRO_ENABLE:
+        *(int *)ptr = data->gro_enabled;
+        break;
+
     case BIO_CTRL_DGRAM_GET_EFFECTIVE_CAPS:
         ret = (long)(BIO_DGRAM_CAP_HANDLES_DST_ADDR
                      | BIO_DGRAM_CAP_HANDLES_SRC_ADDR
@@ -1300,6 +1393,84 @@ static int pack_local(BIO *b, MSGHDR_TYPE *mh, const BIO_ADDR *local) {
 }
 # endif
 
+/*
+ * Returns the segment size to use when sending a BIO_MSG as a GSO
+ * super-datagram, or 0 if it is to be sent as a single datagram.
+ */
+static ossl_inline size_t msg_segment_size(const BIO_MSG *msg)
+{
+    size_t seg_size = BIO_MSG_SEGMENT_SIZE(msg->flags);
+
+    return seg_size > 0 && msg->data_len > seg_size ? seg_size : 0;
+}
+
+# if M_METHOD == M_METHOD_RECVMMSG || M_METHOD == M_METHOD_RECVMSG
+static ossl_inline int dgram_can_gso(BIO *b)
+{
+#  if defined(SUPPORT_UDP_SEGMENT)
+    return probe_gso(b);
+#  else
+    return 0;
+#  endif
+}
+# endif
+
+# if defined(SUPPORT_UDP_SEGMENT)
+/* Appends a UDP_SEGMENT control message to a msghdr for a GSO send. */
+static void pack_segment_size(struct msghdr *mh, unsigned char *control,
+                              size_t seg_size)
+{
+    struct cmsghdr *cmsg;
+    uint16_t v = (uint16_t)seg_size;
+
+    if (mh->msg_control == NULL) {
+        mh->msg_control     = control;
+        mh->msg_controllen  = 0;
+    }
+
+    cmsg = (struct cmsghdr *)((unsigned char *)mh->msg_control
+                              + mh->msg_controllen);
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(v));
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type  = UDP_SEGMENT;
+    memcpy(CMSG_DATA(cmsg), &v, sizeof(v));
+    mh->msg_controllen += CMSG_SPACE(sizeof(v));
+}
+
+/*
+ * Extracts the segment size of a datagram coalesced by UDP_GRO from the control
+ * buffer, in the form returned in BIO_MSG flags. Returns 0 if the datagram was
+ * not coalesced.
+ */
+static uint64_t extract_segment_size(struct msghdr *mh, size_t data_len)
+{
+    struct cmsghdr *cmsg;
+    int seg_size;
+
+    if (mh->msg_control == NULL)
+        return 0;
+
+    for (cmsg = CMSG_FIRSTHDR(mh); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(mh, cmsg)) {
+        if (cmsg->cmsg_level != SOL_UDP || cmsg->cmsg_type != UDP_GRO)
+            continue;
+
+        memcpy(&seg_size, CMSG_DATA(cmsg), sizeof(seg_size));
+        if (seg_size > 0 && (size_t)seg_size < data_len
+            && seg_size <= (int)BIO_MSG_SEGMENT_SIZE_MASK)
+            return (uint64_t)seg_size;
+    }
+
+    return 0;
+}
+# elif M_METHOD == M_METHOD_RECVMMSG || M_METHOD == M_METHOD_RECVMSG
+static ossl_inline void pack_segment_size(struct msghdr *mh,
+                                          unsigned char *control,
+                                          size_t seg_size)
+{
+}
+# endif
+
 /*
  * Converts flags passed to BIO_sendmmsg or BIO_recvmmsg to syscall flags. You
  * should mask out any system flags returned by this function you cannot support
@@ -1321,7 +1492,7 @@ static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
 #  define BIO_MAX_MSGS_PER_CALL   64
     int sysflags;
     bio_dgram_data *data = (bio_dgram_data *)b->ptr;
-    size_t i;
+    size_t i, seg_size;
     struct mmsghdr mh[BIO_MAX_MSGS_PER_CALL];
     struct iovec iov[BIO_MAX_MSGS_PER_CALL];
     unsigned char control[BIO_MAX_MSGS_PER_CALL][BIO_CMSG_ALLOC_LEN];
@@ -1330,6 +1501,7 @@ static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
     int sysflags;
     bio_dgram_data *data = (bio_dgram_data *)b->ptr;
     ossl_ssize_t l;
+    size_t seg_size;
     struct msghdr mh;
     struct iovec iov;
     unsigned char control[BIO_CMSG_ALLOC_LEN];
@@ -1388,6 +1560,18 @@ static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
                 return 0;
             }
         }
+
+        /* If segmentation was requested, the kernel must support it */
+        seg_size = msg_segment_size(&BIO_MSG_N(msg, stride, i));
+        if (seg_size > 0) {
+            if (!dgram_can_gso(b)) {
+                ERR_raise(ERR_LIB_BIO, BIO_R_UNSUPPORTED_METHOD);
+                *num_processed = 0;
+                return 0;
+            }
+
+            pack_segment_size(&mh[i].msg_hdr, control[i], seg_size);
+        }
     }
 
     /* Do the batch */
@@ -1426,6 +1610,17 @@ static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
         }
     }
 
+    seg_size = msg_segment_size(msg);
+    if (seg_size > 0) {
+        if (!dgram_can_gso(b)) {
+            ERR_raise(ERR_LIB_BIO, BIO_R_UNSUPPORTED_METHOD);
+            *num_processed = 0;
+            return 0;
+        }
+
+        pack_segment_size(&mh, control, seg_size);
+    }
+
     l = sendmsg(b->num, &mh, sysflags);
     if (l < 0) {
         ERR_raise(ERR_LIB_SYS, get_last_socket_error());
@@ -1439,6 +1634,13 @@ static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
     return 1;
 
 # elif M_METHOD == M_METHOD_WSARECVMSG || M_METHOD == M_METHOD_RECVFROM
+    /* Segmentation offload is not supported here */
+    if (msg_segment_size(&msg[0]) > 0) {
+        ERR_raise(ERR_LIB_BIO, BIO_R_UNSUPPORTED_METHOD);
+        *num_processed = 0;
+        return 0;
+    }
+
 #  if M_METHOD == M_METHOD_WSARECVMSG
     if (bio_WSASendMsg != NULL) {
         /* WSASendMsg-based implementation for Windows. */
@@ -1581,6 +1783,14 @@ static int dgram_recvmmsg(BIO *b, BIO_MSG *msg,
             *num_processed = 0;
             return 0;
         }
+
+#  if defined(SUPPORT_UDP_SEGMENT)
+        /* The GRO segment size is always delivered as a control message */
+        if (data->gro_enabled) {
+            mh[i].msg_hdr.msg_control    = control[i];
+            mh[i].msg_hdr.msg_controllen = BIO_CMSG_ALLOC_LEN;
+        }
+#  endif
     }
 
     /* Do the batch */
@@ -1593,7 +1803,12 @@ static int dgram_recvmmsg(BIO *b, BIO_MSG *msg,
 
     for (i = 0; i < (size_t)ret; ++i) {
         BIO_MSG_N(msg, stride, i).data_len = mh[i].msg_len;
+#  if defined(SUPPORT_UDP_SEGMENT)
+        BIO_MSG_N(msg, stride, i).flags
+            = extract_segment_size(&mh[i].msg_hdr, mh[i].msg_len);
+#  else
         BIO_MSG_N(msg, stride, i).flags    = 0;
+#  endif
         /*
          * *(msg->peer) will have been filled in by recvmmsg;
          * for msg->local we parse the control data returned
@@ -1630,6 +1845,14 @@ static int dgram_recvmmsg(BIO *b, BIO_MSG *msg,
         return 0;
     }
 
+#  if defined(SUPPORT_UDP_SEGMENT)
+    /* The GRO segment size is always delivered as a control message */
+    if (data->gro_enabled) {
+        mh.msg_control      = control;
+        mh.msg_controllen   = BIO_CMSG_ALLOC_LEN;
+    }
+#  endif
+
     l = recvmsg(b->num, &mh, sysflags);
     if (l < 0) {
         ERR_raise(ERR_LIB_SYS, get_last_socket_error());
@@ -1638,7 +1861,11 @@ static int dgram_recvmmsg(BIO *b, BIO_MSG *msg,
     }
 
     msg->data_len   = (size_t)l;
+#  if defined(SUPPORT_UDP_SEGMENT)
+    msg->flags      = extract_segment_size(&mh, (size_t)l);
+#  else
     msg->flags      = 0;
+#  endif
 
     if (msg->local != NULL)
         if (extract_local(b, &mh, msg->local) < 1)
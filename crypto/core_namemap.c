@@ -8,22 +8,62 @@
  */
 
 #include "internal/namemap.h"
-#include <openssl/lhash.h>
-#include "crypto/lhash.h"      /* ossl_lh_strcasehash */
+#include "internal/hashtable.h"
 #include "internal/tsan_assist.h"
 #include "internal/sizes.h"
 #include "crypto/context.h"
 
+/*
+ * The name->number mapping is kept in an RCU protected hash table, and the
+ * number->names mapping in an index that is only ever grown by publishing a
+ * larger copy.  Entries are never removed before the namemap itself is freed,
+ * so lookups run without taking any lock and the entries they find remain
+ * valid.  Writers are serialised by the namemap lock.
+ */
+
+/* Names longer than this are still supported, they just share hash keys */
+#define NAMENUM_KEY_LEN         64
+
+/* The number of hash table neighborhoods initially allocated */
+#define NAMENUM_HT_INIT_SIZE    2048
+
+/* The initial size of the number->names index */
+#define NUMNAMES_INIT_SIZE      256
+
 /*-
  * The namenum entry
  * =================
  */
-typedef struct {
+typedef struct namenum_entry_st NAMENUM_ENTRY;
+
+struct namenum_entry_st {
     char *name;
     int number;
-} NAMENUM_ENTRY;
 
-DEFINE_LHASH_OF_EX(NAMENUM_ENTRY);
+    /* Next entry with the same hash table key */
+    NAMENUM_ENTRY *next_key;
+    /* Next name with the same number, in registration order */
+    NAMENUM_ENTRY *next_name;
+};
+
+HT_START_KEY_DEFN(namenum_key)
+HT_DEF_KEY_FIELD_CHAR_ARRAY(name, NAMENUM_KEY_LEN)
+HT_END_KEY_DEFN(NAMENUM_KEY)
+
+IMPLEMENT_HT_VALUE_TYPE_FNS(NAMENUM_ENTRY, namenum, static)
+
+/*-
+ * The number->names index
+ * =======================
+ */
+typedef struct numnames_st NUMNAMES;
+
+struct numnames_st {
+    /* Smaller copies replaced by this one, freed with the namemap */
+    NUMNAMES *retired;
+    size_t size;
+    NAMENUM_ENTRY *names[1];
+};
 
 /*-
  * The namemap itself
@@ -34,22 +74,27 @@ struct ossl_namemap_st {
     /* Flags */
     unsigned int stored:1; /* If 1, it's stored in a library context */
 
-    CRYPTO_RWLOCK *lock;
-    LHASH_OF(NAMENUM_ENTRY) *namenum;  /* Name->number mapping */
+    CRYPTO_RWLOCK *lock;               /* Only taken by writers */
+    HT *namenum;                       /* Name->number mapping */
+    NUMNAMES *numnames;                /* Number->names mapping */
 
     TSAN_QUALIFIER int max_number;     /* Current max number */
 };
 
-/* LHASH callbacks */
-
-static unsigned long namenum_hash(const NAMENUM_ENTRY *n)
+static void namenum_key_init(NAMENUM_KEY *key, const char *name,
+                             size_t name_len)
 {
-    return ossl_lh_strcasehash(n->name);
+    HT_INIT_KEY(key);
+    ossl_ht_strcase(key->keyfields.name, name,
+                    (int)(name_len < NAMENUM_KEY_LEN ? name_len
+                                                     : NAMENUM_KEY_LEN - 1));
 }
 
-static int namenum_cmp(const NAMENUM_ENTRY *a, const NAMENUM_ENTRY *b)
+static int namenum_match(const NAMENUM_ENTRY *n, const char *name,
+                         size_t name_len)
 {
-    return OPENSSL_strcasecmp(a->name, b->name);
+    return OPENSSL_strncasecmp(n->name, name, name_len) == 0
+        && n->name[name_len] == '\0';
 }
 
 static void namenum_free(NAMENUM_ENTRY *n)
@@ -63,7 +108,7 @@ static void namenum_free(NAMENUM_ENTRY *n)
 
 void *ossl_stored_namemap_new(OSSL_LIB_CTX *libctx)
 {
-    OSSL_NAMEMAP *namemap = ossl_namemap_new();
+    OSSL_NAMEMAP *namemap = ossl_namemap_new(libctx);
 
     if (namemap != NULL)
         namemap->stored = 1;
@@ -107,113 +152,86 @@ int ossl_namemap_empty(OSSL_NAMEMAP *namemap)
 #endif
 }
 
-typedef struct doall_names_data_st {
-    int number;
-    const char **names;
-    int found;
-} DOALL_NAMES_DATA;
-
-static void do_name(const NAMENUM_ENTRY *namenum, DOALL_NAMES_DATA *data)
-{
-    if (namenum->number == data->number)
-        data->names[data->found++] = namenum->name;
-}
-
-IMPLEMENT_LHASH_DOALL_ARG_CONST(NAMENUM_ENTRY, DOALL_NAMES_DATA);
-
 /*
  * Call the callback for all names in the namemap with the given number.
  * A return value 1 means that the callback was called for all names. A
  * return value of 0 means that the callback was not called for any names.
+ *
+ * The callback is called without any lock held, so it may itself add
+ * names to the namemap.
  */
 int ossl_namemap_doall_names(const OSSL_NAMEMAP *namemap, int number,
                              void (*fn)(const char *name, void *data),
                              void *data)
 {
-    DOALL_NAMES_DATA cbdata;
-    size_t num_names;
-    int i;
-
-    cbdata.number = number;
-    cbdata.found = 0;
+    NUMNAMES *numnames;
+    NAMENUM_ENTRY *namenum;
 
     if (namemap == NULL)
         return 0;
 
-    /*
-     * We collect all the names first under a read lock. Subsequently we call
-     * the user function, so that we're not holding the read lock when in user
-     * code. This could lead to deadlocks.
-     */
-    if (!CRYPTO_THREAD_read_lock(namemap->lock))
-        return 0;
-
-    num_names = lh_NAMENUM_ENTRY_num_items(namemap->namenum);
-    if (num_names == 0) {
-        CRYPTO_THREAD_unlock(namemap->lock);
-        return 0;
-    }
-    cbdata.names = OPENSSL_malloc(sizeof(*cbdata.names) * num_names);
-    if (cbdata.names == NULL) {
-        CRYPTO_THREAD_unlock(namemap->lock);
+    numnames = ossl_rcu_deref(&namemap->numnames);
+    if (numnames == NULL)
         return 0;
-    }
-    lh_NAMENUM_ENTRY_doall_DOALL_NAMES_DATA(namemap->namenum, do_name,
-                                            &cbdata);
-    CRYPTO_THREAD_unlock(namemap->lock);
-
-    for (i = 0; i < cbdata.found; i++)
-        fn(cbdata.names[i], data);
+    if (number <= 0 || (size_t)number >= numnames->size)
+        return 1;
 
-    OPENSSL_free(cbdata.names);
+    for (namenum = ossl_rcu_deref(&numnames->names[number]);
+         namenum != NULL;
+         namenum = ossl_rcu_deref(&namenum->next_name))
+        fn(namenum->name, data);
     return 1;
 }
 
-/* This function is not thread safe, the namemap must be locked */
+/*
+ * Finds a name without taking the namemap lock.  The hash table is only
+ * read locked for the lookup itself, the entries found are never freed
+ * while the namemap exists.
+ */
 static int namemap_name2num(const OSSL_NAMEMAP *namemap,
-                            const char *name)
+                            const char *name, size_t name_len)
 {
-    NAMENUM_ENTRY *namenum_entry, namenum_tmpl;
-
-    namenum_tmpl.name = (char *)name;
-    namenum_tmpl.number = 0;
-    namenum_entry =
-        lh_NAMENUM_ENTRY_retrieve(namemap->namenum, &namenum_tmpl);
-    return namenum_entry != NULL ? namenum_entry->number : 0;
+    NAMENUM_KEY key;
+    NAMENUM_ENTRY *namenum;
+    HT_VALUE *v = NULL;
+
+    namenum_key_init(&key, name, name_len);
+    ossl_ht_read_lock(namemap->namenum);
+    namenum = ossl_ht_namenum_NAMENUM_ENTRY_get(namemap->namenum,
+                                                TO_HT_KEY(&key), &v);
+    ossl_ht_read_unlock(namemap->namenum);
+
+    for (; namenum != NULL; namenum = ossl_rcu_deref(&namenum->next_key))
+        if (namenum_match(namenum, name, name_len))
+            return namenum->number;
+    return 0;
 }
 
 int ossl_namemap_name2num(const OSSL_NAMEMAP *namemap, const char *name)
 {
-    int number;
-
 #ifndef FIPS_MODULE
     if (namemap == NULL)
         namemap = ossl_namemap_stored(NULL);
 #endif
 
-    if (namemap == NULL)
-        return 0;
-
-    if (!CRYPTO_THREAD_read_lock(namemap->lock))
+    if (namemap == NULL || name == NULL)
         return 0;
-    number = namemap_name2num(namemap, name);
-    CRYPTO_THREAD_unlock(namemap->lock);
 
-    return number;
+    return namemap_name2num(namemap, name, strlen(name));
 }
 
 int ossl_namemap_name2num_n(const OSSL_NAMEMAP *namemap,
                             const char *name, size_t name_len)
 {
-    char *tmp;
-    int ret;
+#ifndef FIPS_MODULE
+    if (namemap == NULL)
+        namemap = ossl_namemap_stored(NULL);
+#endif
 
-    if (name == NULL || (tmp = OPENSSL_strndup(name, name_len)) == NULL)
+    if (namemap == NULL || name == NULL)
         return 0;
 
-    ret = ossl_namemap_name2num(namemap, tmp);
-    OPENSSL_free(tmp);
-    return ret;
+    return namemap_name2num(namemap, name, OPENSSL_strnlen(name, name_len));
 }
 
 struct num2name_data_st {
@@ -243,15 +261,47 @@ const char *ossl_namemap_num2name(const OSSL_NAMEMAP *namemap, int number,
     return data.name;
 }
 
+/*
+ * Makes sure the number->names index can hold |number|.  If it has to grow,
+ * the larger copy is published and the old one is kept around for readers
+ * that may still be looking at it.
+ * This function is not thread safe, the namemap must be locked.
+ */
+static int namemap_numnames_reserve(OSSL_NAMEMAP *namemap, int number)
+{
+    NUMNAMES *old = namemap->numnames, *new;
+    size_t size;
+
+    if (old != NULL && (size_t)number < old->size)
+        return 1;
+
+    for (size = old != NULL ? old->size : NUMNAMES_INIT_SIZE;
+         size <= (size_t)number; size *= 2)
+        continue;
+
+    new = OPENSSL_zalloc(sizeof(*new) + sizeof(new->names[0]) * (size - 1));
+    if (new == NULL)
+        return 0;
+    new->size = size;
+    if (old != NULL)
+        memcpy(new->names, old->names, sizeof(old->names[0]) * old->size);
+    new->retired = old;
+    ossl_rcu_assign_ptr(&namemap->numnames, &new);
+    return 1;
+}
+
 /* This function is not thread safe, the namemap must be locked */
 static int namemap_add_name(OSSL_NAMEMAP *namemap, int number,
                             const char *name)
 {
-    NAMENUM_ENTRY *namenum = NULL;
+    NAMENUM_ENTRY *namenum = NULL, *head, **tail;
+    NAMENUM_KEY key;
+    HT_VALUE *v = NULL;
+    size_t name_len = strlen(name);
     int tmp_number;
 
     /* If it already exists, we don't add it */
-    if ((tmp_number = namemap_name2num(namemap, name)) != 0)
+    if ((tmp_number = namemap_name2num(namemap, name, name_len)) != 0)
         return tmp_number;
 
     if ((namenum = OPENSSL_zalloc(sizeof(*namenum))) == NULL)
@@ -263,10 +313,38 @@ static int namemap_add_name(OSSL_NAMEMAP *namemap, int number,
     /* The tsan_counter use here is safe since we're under lock */
     namenum->number =
         number != 0 ? number : 1 + tsan_counter(&namemap->max_number);
-    (void)lh_NAMENUM_ENTRY_insert(namemap->namenum, namenum);
-
-    if (lh_NAMENUM_ENTRY_error(namemap->namenum))
+    if (namenum->number <= 0
+            || !namemap_numnames_reserve(namemap, namenum->number))
         goto err;
+
+    /*
+     * Publish the name->number mapping.  Names sharing a key are chained
+     * off the entry that is in the hash table.
+     */
+    namenum_key_init(&key, name, name_len);
+    ossl_ht_write_lock(namemap->namenum);
+    head = ossl_ht_namenum_NAMENUM_ENTRY_get(namemap->namenum,
+                                             TO_HT_KEY(&key), &v);
+    if (head == NULL) {
+        if (!ossl_ht_namenum_NAMENUM_ENTRY_insert(namemap->namenum,
+                                                  TO_HT_KEY(&key), namenum,
+                                                  NULL)) {
+            ossl_ht_write_unlock(namemap->namenum);
+            goto err;
+        }
+    } else {
+        while (head->next_key != NULL)
+            head = head->next_key;
+        ossl_rcu_assign_ptr(&head->next_key, &namenum);
+    }
+    ossl_ht_write_unlock(namemap->namenum);
+
+    /* Publish the number->name mapping, this can't fail any more */
+    for (tail = &namemap->numnames->names[namenum->number]; *tail != NULL;
+         tail = &(*tail)->next_name)
+        continue;
+    ossl_rcu_assign_ptr(tail, &namenum);
+
     return namenum->number;
 
  err:
@@ -334,7 +412,7 @@ int ossl_namemap_add_names(OSSL_NAMEMAP *namemap, int number,
             goto end;
         }
 
-        this_number = namemap_name2num(namemap, p);
+        this_number = namemap_name2num(namemap, p, l);
 
         if (number == 0) {
             number = this_number;
@@ -508,14 +586,20 @@ OSSL_NAMEMAP *ossl_namemap_stored(OSSL_LIB_CTX *libctx)
     return namemap;
 }
 
-OSSL_NAMEMAP *ossl_namemap_new(void)
+OSSL_NAMEMAP *ossl_namemap_new(OSSL_LIB_CTX *libctx)
 {
     OSSL_NAMEMAP *namemap;
-
+    HT_CONFIG htconf = {
+        NULL,                   /* libctx, filled in below */
+        NULL,                   /* entries are freed with the numnames */
+        NULL,                   /* default hash function */
+        NAMENUM_HT_INIT_SIZE    /* initial size */
+    };
+
+    htconf.ctx = libctx;
     if ((namemap = OPENSSL_zalloc(sizeof(*namemap))) != NULL
         && (namemap->lock = CRYPTO_THREAD_lock_new()) != NULL
-        && (namemap->namenum =
-            lh_NAMENUM_ENTRY_new(namenum_hash, namenum_cmp)) != NULL)
+        && (namemap->namenum = ossl_ht_new(&htconf)) != NULL)
         return namemap;
 
     ossl_namemap_free(namemap);
@@ -524,11 +608,27 @@ OSSL_NAMEMAP *ossl_namemap_new(void)
 
 void ossl_namemap_free(OSSL_NAMEMAP *namemap)
 {
+    NUMNAMES *numnames, *retired;
+    NAMENUM_ENTRY *namenum, *next;
+    size_t i;
+
     if (namemap == NULL || namemap->stored)
         return;
 
-    lh_NAMENUM_ENTRY_doall(namemap->namenum, namenum_free);
-    lh_NAMENUM_ENTRY_free(namemap->namenum);
+    ossl_ht_free(namemap->namenum);
+
+    /* Every entry is on exactly one list of the current index */
+    if ((numnames = namemap->numnames) != NULL)
+        for (i = 0; i < numnames->size; i++)
+            for (namenum = numnames->names[i]; namenum != NULL;
+                 namenum = next) {
+                next = namenum->next_name;
+                namenum_free(namenum);
+            }
+    for (; numnames != NULL; numnames = retired) {
+        retired = numnames->retired;
+        OPENSSL_free(numnames);
+    }
 
     CRYPTO_THREAD_lock_free(namemap->lock);
     OPENSSL_free(namemap);
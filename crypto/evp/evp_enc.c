@@ -487,6 +487,104 @@ int EVP_CipherFinal(EVP_CIPHER_CTX *ctx, unsigned char *out, int *outl)
         return EVP_DecryptFinal(ctx, out, outl);
 }
 
+static int evp_cipher_aead_one(EVP_CIPHER_CTX *ctx, const unsigned char *iv,
+                               const unsigned char *aad, size_t aadlen,
+                               const unsigned char *in, size_t inl,
+                               unsigned char *out, unsigned char *tag,
+                               size_t taglen)
+{
+    int outl, finl;
+
+    if (aadlen > INT_MAX || inl > INT_MAX) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_LENGTH);
+        return 0;
+    }
+
+    if (EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1) <= 0)
+        return 0;
+
+    if (!ctx->encrypt
+        && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, (int)taglen,
+                               tag) <= 0)
+        return 0;
+
+    /* CCM needs to know the total length up front */
+    if (EVP_CIPHER_CTX_get_mode(ctx) == EVP_CIPH_CCM_MODE
+        && EVP_CipherUpdate(ctx, NULL, &outl, NULL, (int)inl) <= 0)
+        return 0;
+
+    if (aadlen > 0
+        && EVP_CipherUpdate(ctx, NULL, &outl, aad, (int)aadlen) <= 0)
+        return 0;
+
+    outl = 0;
+    if (inl > 0 && EVP_CipherUpdate(ctx, out, &outl, in, (int)inl) <= 0)
+        return 0;
+
+    if (EVP_CipherFinal_ex(ctx, out + outl, &finl) <= 0)
+        return 0;
+
+    if (ctx->encrypt
+        && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, (int)taglen,
+                               tag) <= 0)
+        return 0;
+
+    return 1;
+}
+
+int EVP_CipherAEADBatch(EVP_CIPHER_CTX *ctx, size_t num,
+                        const unsigned char **iv, size_t ivlen,
+                        const unsigned char **aad, const size_t *aadlen,
+                        const unsigned char **in, const size_t *inl,
+                        unsigned char **out, unsigned char **tag,
+                        size_t taglen)
+{
+    size_t i, j;
+    int ret;
+
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+
+    if ((EVP_CIPHER_get_flags(ctx->cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) == 0) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_OPERATION);
+        return 0;
+    }
+
+    if (ivlen != (size_t)EVP_CIPHER_CTX_get_iv_length(ctx)) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+
+    if (num == 0)
+        return 1;
+
+    if (ctx->cipher->prov != NULL && ctx->cipher->aead_batch != NULL) {
+        ret = ctx->cipher->aead_batch(ctx->algctx, num, iv, ivlen, aad, aadlen,
+                                      in, inl, out, tag, taglen);
+        return ret > 0;
+    }
+
+    /*
+     * Ciphers without a batch implementation are driven one item at a time
+     * through the ordinary AEAD interface.
+     */
+    for (i = 0; i < num; ++i)
+        if (!evp_cipher_aead_one(ctx, iv[i], aad[i], aadlen[i], in[i], inl[i],
+                                 out[i], tag[i], taglen))
+            goto err;
+
+    return 1;
+ err:
+    /* Plaintext must not be released if any message failed to authenticate */
+    if (!ctx->encrypt)
+        for (j = 0; j <= i; ++j)
+            if (inl[j] > 0)
+                OPENSSL_cleanse(out[j], inl[j]);
+    return 0;
+}
+
 int EVP_EncryptInit(EVP_CIPHER_CTX *ctx, const EVP_CIPHER *cipher,
                     const unsigned char *key, const unsigned char *iv)
 {
@@ -1671,6 +1769,11 @@ static void *evp_cipher_from_algorithm(const int name_id,
             cipher->settable_ctx_params =
                 OSSL_FUNC_cipher_settable_ctx_params(fns);
             break;
+        case OSSL_FUNC_CIPHER_AEAD_BATCH:
+            if (cipher->aead_batch != NULL)
+                break;
+            cipher->aead_batch = OSSL_FUNC_cipher_aead_batch(fns);
+            break;
         }
     }
     if ((fnciphcnt != 0 && fnciphcnt != 3 && fnciphcnt != 4)
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <openssl/crypto.h>
 #include "internal/core.h"
 #include "internal/property.h"
@@ -20,6 +21,7 @@
 #include <openssl/lhash.h>
 #include <openssl/rand.h>
 #include "internal/thread_once.h"
+#include "internal/hashtable.h"
 #include "crypto/lhash.h"
 #include "crypto/sparse_array.h"
 #include "property_local.h"
@@ -32,6 +34,12 @@
  */
 #define IMPL_CACHE_FLUSH_THRESHOLD  500
 
+/*
+ * Initial number of neighborhoods in the query cache hash table.  It grows
+ * on demand, this merely avoids a few rehashes while the cache warms up.
+ */
+#define IMPL_CACHE_INIT_NEIGHBORHOODS   64
+
 typedef struct {
     void *method;
     int (*up_ref)(void *);
@@ -46,19 +54,34 @@ typedef struct {
 
 DEFINE_STACK_OF(IMPLEMENTATION)
 
+/*
+ * A query cache entry.  Every cached query is stored twice: once keyed
+ * by the provider that supplied the method and once with a NULL provider,
+ * so that lookups which don't care about the provider also hit.
+ */
 typedef struct {
+    int nid;
     const OSSL_PROVIDER *provider;
     const char *query;
     METHOD method;
     char body[1];
 } QUERY;
 
-DEFINE_LHASH_OF_EX(QUERY);
+/*
+ * The query cache key.  The hash table only stores key hashes, so the
+ * query string itself lives in the QUERY and is compared on lookup.
+ */
+HT_START_KEY_DEFN(query_key)
+HT_DEF_KEY_FIELD(nid, int)
+HT_DEF_KEY_FIELD(provider, const OSSL_PROVIDER *)
+HT_DEF_KEY_FIELD(query_hash, unsigned long)
+HT_END_KEY_DEFN(QUERY_KEY)
+
+IMPLEMENT_HT_VALUE_TYPE_FNS(QUERY, cache, static)
 
 typedef struct {
     int nid;
     STACK_OF(IMPLEMENTATION) *impls;
-    LHASH_OF(QUERY) *cache;
 } ALGORITHM;
 
 struct ossl_method_store_st {
@@ -80,7 +103,16 @@ struct ossl_method_store_st {
 
     /* query cache specific values */
 
-    /* Count of the query cache entries for all algs */
+    /*
+     * The query cache for all algs.  It is RCU protected, lookups don't
+     * take |lock|.  Modifications are done with |lock| write locked.
+     */
+    HT *cache;
+
+    /*
+     * The number of cached queries.  Each query has two entries in |cache|,
+     * only those keyed by a provider are counted.
+     */
     size_t cache_nelem;
 
     /* Flag: 1 if query cache entries for all algs need flushing */
@@ -88,8 +120,6 @@ struct ossl_method_store_st {
 };
 
 typedef struct {
-    LHASH_OF(QUERY) *cache;
-    size_t nelem;
     uint32_t seed;
     unsigned char using_global_seed;
 } IMPL_CACHE_FLUSH;
@@ -105,9 +135,8 @@ typedef struct ossl_global_properties_st {
 #endif
 } OSSL_GLOBAL_PROPERTIES;
 
-static void ossl_method_cache_flush_alg(OSSL_METHOD_STORE *store,
-                                        ALGORITHM *alg);
-static void ossl_method_cache_flush(OSSL_METHOD_STORE *store, int nid);
+static void ossl_method_cache_flush_and_unlock(OSSL_METHOD_STORE *store,
+                                               const int *nids, size_t num);
 
 /* Global properties are stored per library context */
 void ossl_ctx_global_properties_free(void *vglobp)
@@ -183,20 +212,19 @@ static int ossl_property_unlock(OSSL_METHOD_STORE *p)
     return p != 0 ? CRYPTO_THREAD_unlock(p->lock) : 0;
 }
 
-static unsigned long query_hash(const QUERY *a)
+static void query_key_init(QUERY_KEY *key, int nid,
+                           const OSSL_PROVIDER *prov, const char *query)
 {
-    return OPENSSL_LH_strhash(a->query);
+    HT_INIT_KEY(key);
+    HT_SET_KEY_FIELD(key, nid, nid);
+    HT_SET_KEY_FIELD(key, provider, prov);
+    HT_SET_KEY_FIELD(key, query_hash, OPENSSL_LH_strhash(query));
 }
 
-static int query_cmp(const QUERY *a, const QUERY *b)
+static int query_match(const QUERY *q, int nid, const OSSL_PROVIDER *prov,
+                       const char *query)
 {
-    int res = strcmp(a->query, b->query);
-
-    if (res == 0 && a->provider != NULL && b->provider != NULL)
-        res = b->provider > a->provider ? 1
-            : b->provider < a->provider ? -1
-            : 0;
-    return res;
+    return q->nid == nid && q->provider == prov && strcmp(q->query, query) == 0;
 }
 
 static void impl_free(IMPLEMENTATION *impl)
@@ -215,10 +243,9 @@ static void impl_cache_free(QUERY *elem)
     }
 }
 
-static void impl_cache_flush_alg(ossl_uintmax_t idx, ALGORITHM *alg)
+static void impl_cache_value_free(HT_VALUE *v)
 {
-    lh_QUERY_doall(alg->cache, &impl_cache_free);
-    lh_QUERY_flush(alg->cache);
+    impl_cache_free(ossl_ht_cache_QUERY_from_value(v));
 }
 
 static void alg_cleanup(ossl_uintmax_t idx, ALGORITHM *a, void *arg)
@@ -227,8 +254,6 @@ static void alg_cleanup(ossl_uintmax_t idx, ALGORITHM *a, void *arg)
 
     if (a != NULL) {
         sk_IMPLEMENTATION_pop_free(a->impls, &impl_free);
-        lh_QUERY_doall(a->cache, &impl_cache_free);
-        lh_QUERY_free(a->cache);
         OPENSSL_free(a);
     }
     if (store != NULL)
@@ -242,11 +267,19 @@ static void alg_cleanup(ossl_uintmax_t idx, ALGORITHM *a, void *arg)
 OSSL_METHOD_STORE *ossl_method_store_new(OSSL_LIB_CTX *ctx)
 {
     OSSL_METHOD_STORE *res;
+    HT_CONFIG cache_conf = {
+        NULL,                           /* ctx, filled in below */
+        impl_cache_value_free,          /* free function */
+        NULL,                           /* default hash function */
+        IMPL_CACHE_INIT_NEIGHBORHOODS   /* initial size */
+    };
 
     res = OPENSSL_zalloc(sizeof(*res));
     if (res != NULL) {
         res->ctx = ctx;
+        cache_conf.ctx = ctx;
         if ((res->algs = ossl_sa_ALGORITHM_new()) == NULL
+            || (res->cache = ossl_ht_new(&cache_conf)) == NULL
             || (res->lock = CRYPTO_THREAD_lock_new()) == NULL
             || (res->biglock = CRYPTO_THREAD_lock_new()) == NULL) {
             ossl_method_store_free(res);
@@ -262,6 +295,7 @@ void ossl_method_store_free(OSSL_METHOD_STORE *store)
         if (store->algs != NULL)
             ossl_sa_ALGORITHM_doall_arg(store->algs, &alg_cleanup, store);
         ossl_sa_ALGORITHM_free(store->algs);
+        ossl_ht_free(store->cache);
         CRYPTO_THREAD_lock_free(store->lock);
         CRYPTO_THREAD_lock_free(store->biglock);
         OPENSSL_free(store);
@@ -324,7 +358,6 @@ int ossl_method_store_add(OSSL_METHOD_STORE *store, const OSSL_PROVIDER *prov,
         OPENSSL_free(impl);
         return 0;
     }
-    ossl_method_cache_flush(store, nid);
     if ((impl->properties = ossl_prop_defn_get(store->ctx, properties)) == NULL) {
         impl->properties = ossl_parse_property(store->ctx, properties);
         if (impl->properties == NULL)
@@ -339,8 +372,7 @@ int ossl_method_store_add(OSSL_METHOD_STORE *store, const OSSL_PROVIDER *prov,
     alg = ossl_method_store_retrieve(store, nid);
     if (alg == NULL) {
         if ((alg = OPENSSL_zalloc(sizeof(*alg))) == NULL
-                || (alg->impls = sk_IMPLEMENTATION_new_null()) == NULL
-                || (alg->cache = lh_QUERY_new(&query_hash, &query_cmp)) == NULL)
+                || (alg->impls = sk_IMPLEMENTATION_new_null()) == NULL)
             goto err;
         alg->nid = nid;
         if (!ossl_method_store_insert(store, alg))
@@ -358,7 +390,10 @@ int ossl_method_store_add(OSSL_METHOD_STORE *store, const OSSL_PROVIDER *prov,
     if (i == sk_IMPLEMENTATION_num(alg->impls)
         && sk_IMPLEMENTATION_push(alg->impls, impl))
         ret = 1;
-    ossl_property_unlock(store);
+    if (ret)
+        ossl_method_cache_flush_and_unlock(store, &nid, 1);
+    else
+        ossl_property_unlock(store);
     if (ret == 0)
         impl_free(impl);
     return ret;
@@ -381,7 +416,6 @@ int ossl_method_store_remove(OSSL_METHOD_STORE *store, int nid,
 
     if (!ossl_property_write_lock(store))
         return 0;
-    ossl_method_cache_flush(store, nid);
     alg = ossl_method_store_retrieve(store, nid);
     if (alg == NULL) {
         ossl_property_unlock(store);
@@ -399,7 +433,7 @@ int ossl_method_store_remove(OSSL_METHOD_STORE *store, int nid,
         if (impl->method.method == method) {
             impl_free(impl);
             (void)sk_IMPLEMENTATION_delete(alg->impls, i);
-            ossl_property_unlock(store);
+            ossl_method_cache_flush_and_unlock(store, &nid, 1);
             return 1;
         }
     }
@@ -410,6 +444,11 @@ int ossl_method_store_remove(OSSL_METHOD_STORE *store, int nid,
 struct alg_cleanup_by_provider_data_st {
     OSSL_METHOD_STORE *store;
     const OSSL_PROVIDER *prov;
+    /* The algorithms which lost an implementation, in ascending order */
+    int *nids;
+    size_t num_nids, alloc_nids;
+    /* Set if |nids| could not be grown, the whole cache is flushed then */
+    int flush_all;
 };
 
 static void
@@ -436,10 +475,23 @@ alg_cleanup_by_provider(ossl_uintmax_t idx, ALGORITHM *alg, void *arg)
      * If we removed any implementation, we also clear the whole associated
      * cache, 'cause that's the sensible thing to do.
      * There's no point flushing the cache entries where we didn't remove
-     * any implementation, though.
+     * any implementation, though.  The flush is done once for all of the
+     * algorithms after the walk, which visits them in ascending nid order.
      */
-    if (count > 0)
-        ossl_method_cache_flush_alg(data->store, alg);
+    if (count == 0 || data->flush_all)
+        return;
+    if (data->num_nids == data->alloc_nids) {
+        size_t n = data->alloc_nids == 0 ? 16 : data->alloc_nids * 2;
+        int *nids = OPENSSL_realloc(data->nids, n * sizeof(*nids));
+
+        if (nids == NULL) {
+            data->flush_all = 1;
+            return;
+        }
+        data->nids = nids;
+        data->alloc_nids = n;
+    }
+    data->nids[data->num_nids++] = alg->nid;
 }
 
 int ossl_method_store_remove_all_provided(OSSL_METHOD_STORE *store,
@@ -447,12 +499,22 @@ int ossl_method_store_remove_all_provided(OSSL_METHOD_STORE *store,
 {
     struct alg_cleanup_by_provider_data_st data;
 
+    memset(&data, 0, sizeof(data));
     if (!ossl_property_write_lock(store))
         return 0;
     data.prov = prov;
     data.store = store;
     ossl_sa_ALGORITHM_doall_arg(store->algs, &alg_cleanup_by_provider, &data);
-    ossl_property_unlock(store);
+    if (data.flush_all) {
+        ossl_ht_write_lock(store->cache);
+        if (ossl_ht_flush(store->cache))
+            store->cache_nelem = 0;
+        ossl_property_unlock(store);
+        ossl_ht_write_unlock(store->cache);
+    } else {
+        ossl_method_cache_flush_and_unlock(store, data.nids, data.num_nids);
+    }
+    OPENSSL_free(data.nids);
     return 1;
 }
 
@@ -587,33 +649,106 @@ fin:
     return ret;
 }
 
-static void ossl_method_cache_flush_alg(OSSL_METHOD_STORE *store,
-                                        ALGORITHM *alg)
+/* Must be called with the cache write locked */
+static void ossl_method_cache_delete(OSSL_METHOD_STORE *store, int nid,
+                                     const OSSL_PROVIDER *prov,
+                                     const char *prop_query)
 {
-    store->cache_nelem -= lh_QUERY_num_items(alg->cache);
-    impl_cache_flush_alg(0, alg);
+    QUERY_KEY key;
+
+    query_key_init(&key, nid, prov, prop_query);
+    if (ossl_ht_delete(store->cache, TO_HT_KEY(&key)) && prov != NULL)
+        store->cache_nelem--;
 }
 
-static void ossl_method_cache_flush(OSSL_METHOD_STORE *store, int nid)
+/*
+ * Delete the entries of a list returned by ossl_ht_filter().  Must be called
+ * with the cache write locked.  The entries themselves are only freed once
+ * all readers have finished with them, so the list stays valid throughout.
+ */
+static void ossl_method_cache_delete_list(OSSL_METHOD_STORE *store,
+                                          HT_VALUE_LIST *list)
 {
-    ALGORITHM *alg = ossl_method_store_retrieve(store, nid);
+    QUERY *q;
+    size_t i;
 
-    if (alg != NULL)
-        ossl_method_cache_flush_alg(store, alg);
+    for (i = 0; i < list->list_len; i++) {
+        q = ossl_ht_cache_QUERY_from_value(list->list[i]);
+        ossl_method_cache_delete(store, q->nid, q->provider, q->query);
+    }
+}
+
+typedef struct {
+    const int *nids;
+    size_t num;
+} IMPL_CACHE_NIDS;
+
+static int impl_cache_nid_cmp(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int impl_cache_filter_nids(HT_VALUE *v, void *arg)
+{
+    IMPL_CACHE_NIDS *nids = arg;
+    QUERY *q = ossl_ht_cache_QUERY_from_value(v);
+
+    if (q == NULL)
+        return 0;
+    if (nids->num == 1)
+        return q->nid == nids->nids[0];
+    return bsearch(&q->nid, nids->nids, nids->num, sizeof(*nids->nids),
+                   &impl_cache_nid_cmp) != NULL;
+}
+
+/*
+ * Flush the cached queries for the |num| algorithms in |nids|, which must be
+ * in ascending order, in a single pass over the cache and release the store,
+ * which must be write locked.  The cache is locked before the store is
+ * released so that no stale query can be cached in between, but as in
+ * ossl_method_store_cache_set() the grace period that unlocking the cache
+ * waits for happens once the store is no longer held.
+ */
+static void ossl_method_cache_flush_and_unlock(OSSL_METHOD_STORE *store,
+                                               const int *nids, size_t num)
+{
+    IMPL_CACHE_NIDS arg;
+    HT_VALUE_LIST *list;
+    size_t count;
+
+    ossl_ht_write_lock(store->cache);
+    count = ossl_ht_count(store->cache);
+    if (num > 0 && count > 0) {
+        arg.nids = nids;
+        arg.num = num;
+        list = ossl_ht_filter(store->cache, count, &impl_cache_filter_nids,
+                              &arg);
+        if (list != NULL) {
+            ossl_method_cache_delete_list(store, list);
+            ossl_ht_value_list_free(list);
+        }
+    }
+    ossl_property_unlock(store);
+    ossl_ht_write_unlock(store->cache);
 }
 
 int ossl_method_store_cache_flush_all(OSSL_METHOD_STORE *store)
 {
+    int res;
+
     if (!ossl_property_write_lock(store))
         return 0;
-    ossl_sa_ALGORITHM_doall(store->algs, &impl_cache_flush_alg);
-    store->cache_nelem = 0;
+    ossl_ht_write_lock(store->cache);
+    res = ossl_ht_flush(store->cache);
+    if (res)
+        store->cache_nelem = 0;
     ossl_property_unlock(store);
-    return 1;
+    ossl_ht_write_unlock(store->cache);
+    return res;
 }
 
-IMPLEMENT_LHASH_DOALL_ARG(QUERY, IMPL_CACHE_FLUSH);
-
 /*
  * Flush an element from the query cache (perhaps).
  *
@@ -630,8 +765,9 @@ IMPLEMENT_LHASH_DOALL_ARG(QUERY, IMPL_CACHE_FLUSH);
  * preferable to a more refined approach that imposes a performance
  * impact.
  */
-static void impl_cache_flush_cache(QUERY *c, IMPL_CACHE_FLUSH *state)
+static int impl_cache_flush_cache(HT_VALUE *v, void *arg)
 {
+    IMPL_CACHE_FLUSH *state = arg;
     uint32_t n;
 
     /*
@@ -647,31 +783,16 @@ static void impl_cache_flush_cache(QUERY *c, IMPL_CACHE_FLUSH *state)
     n ^= n << 5;
     state->seed = n;
 
-    if ((n & 1) != 0)
-        impl_cache_free(lh_QUERY_delete(state->cache, c));
-    else
-        state->nelem++;
-}
-
-static void impl_cache_flush_one_alg(ossl_uintmax_t idx, ALGORITHM *alg,
-                                     void *v)
-{
-    IMPL_CACHE_FLUSH *state = (IMPL_CACHE_FLUSH *)v;
-    unsigned long orig_down_load = lh_QUERY_get_down_load(alg->cache);
-
-    state->cache = alg->cache;
-    lh_QUERY_set_down_load(alg->cache, 0);
-    lh_QUERY_doall_IMPL_CACHE_FLUSH(state->cache, &impl_cache_flush_cache,
-                                    state);
-    lh_QUERY_set_down_load(alg->cache, orig_down_load);
+    return (n & 1) != 0;
 }
 
+/* Must be called with the cache write locked */
 static void ossl_method_cache_flush_some(OSSL_METHOD_STORE *store)
 {
     IMPL_CACHE_FLUSH state;
+    HT_VALUE_LIST *list;
     static TSAN_QUALIFIER uint32_t global_seed = 1;
 
-    state.nelem = 0;
     state.using_global_seed = 0;
     if ((state.seed = OPENSSL_rdtsc()) == 0) {
         /* If there is no timer available, seed another way */
@@ -679,52 +800,90 @@ static void ossl_method_cache_flush_some(OSSL_METHOD_STORE *store)
         state.seed = tsan_load(&global_seed);
     }
     store->cache_need_flush = 0;
-    ossl_sa_ALGORITHM_doall_arg(store->algs, &impl_cache_flush_one_alg, &state);
-    store->cache_nelem = state.nelem;
+    list = ossl_ht_filter(store->cache, ossl_ht_count(store->cache),
+                          &impl_cache_flush_cache, &state);
+    if (list != NULL) {
+        ossl_method_cache_delete_list(store, list);
+        ossl_ht_value_list_free(list);
+    }
     /* Without a timer, update the global seed */
     if (state.using_global_seed)
         tsan_add(&global_seed, state.seed);
 }
 
+/*
+ * Query cache lookups only enter an RCU read side critical section, they
+ * never take the store lock.  This keeps the hot path of every fetch free
+ * of shared lock state.
+ */
 int ossl_method_store_cache_get(OSSL_METHOD_STORE *store, OSSL_PROVIDER *prov,
                                 int nid, const char *prop_query, void **method)
 {
-    ALGORITHM *alg;
-    QUERY elem, *r;
+    QUERY_KEY key;
+    QUERY *r;
+    HT_VALUE *v = NULL;
     int res = 0;
 
     if (nid <= 0 || store == NULL || prop_query == NULL)
         return 0;
 
-    if (!ossl_property_read_lock(store))
-        return 0;
-    alg = ossl_method_store_retrieve(store, nid);
-    if (alg == NULL)
-        goto err;
-
-    elem.query = prop_query;
-    elem.provider = prov;
-    r = lh_QUERY_retrieve(alg->cache, &elem);
-    if (r == NULL)
-        goto err;
-    if (ossl_method_up_ref(&r->method)) {
+    query_key_init(&key, nid, prov, prop_query);
+    ossl_ht_read_lock(store->cache);
+    r = ossl_ht_cache_QUERY_get(store->cache, TO_HT_KEY(&key), &v);
+    if (r != NULL && query_match(r, nid, prov, prop_query)
+            && ossl_method_up_ref(&r->method)) {
         *method = r->method.method;
         res = 1;
     }
-err:
-    ossl_property_unlock(store);
+    ossl_ht_read_unlock(store->cache);
     return res;
 }
 
+/* Must be called with the cache write locked */
+static int ossl_method_cache_insert(OSSL_METHOD_STORE *store, int nid,
+                                    const OSSL_PROVIDER *prov,
+                                    const char *prop_query,
+                                    const METHOD *method)
+{
+    QUERY_KEY key;
+    QUERY *p;
+    size_t len = strlen(prop_query);
+
+    p = OPENSSL_malloc(sizeof(*p) + len);
+    if (p == NULL)
+        return 0;
+    p->nid = nid;
+    p->provider = prov;
+    p->query = p->body;
+    p->method = *method;
+    if (!ossl_method_up_ref(&p->method)) {
+        OPENSSL_free(p);
+        return 0;
+    }
+    memcpy((char *)p->query, prop_query, len + 1);
+
+    /*
+     * Any replaced entry is freed once the readers are done with it, which
+     * the hash table only does for deletions.
+     */
+    ossl_method_cache_delete(store, nid, prov, prop_query);
+    query_key_init(&key, nid, prov, prop_query);
+    if (!ossl_ht_cache_QUERY_insert(store->cache, TO_HT_KEY(&key), p, NULL)) {
+        impl_cache_free(p);
+        return 0;
+    }
+    if (prov != NULL)
+        store->cache_nelem++;
+    return 1;
+}
+
 int ossl_method_store_cache_set(OSSL_METHOD_STORE *store, OSSL_PROVIDER *prov,
                                 int nid, const char *prop_query, void *method,
                                 int (*method_up_ref)(void *),
                                 void (*method_destruct)(void *))
 {
-    QUERY elem, *old, *p = NULL;
-    ALGORITHM *alg;
-    size_t len;
-    int res = 1;
+    METHOD m;
+    int res = 0;
 
     if (nid <= 0 || store == NULL || prop_query == NULL)
         return 0;
@@ -734,46 +893,33 @@ int ossl_method_store_cache_set(OSSL_METHOD_STORE *store, OSSL_PROVIDER *prov,
 
     if (!ossl_property_write_lock(store))
         return 0;
+    ossl_ht_write_lock(store->cache);
     if (store->cache_need_flush)
         ossl_method_cache_flush_some(store);
-    alg = ossl_method_store_retrieve(store, nid);
-    if (alg == NULL)
-        goto err;
+    if (ossl_method_store_retrieve(store, nid) == NULL)
+        goto end;
 
     if (method == NULL) {
-        elem.query = prop_query;
-        elem.provider = prov;
-        if ((old = lh_QUERY_delete(alg->cache, &elem)) != NULL) {
-            impl_cache_free(old);
-            store->cache_nelem--;
-        }
+        ossl_method_cache_delete(store, nid, prov, prop_query);
+        ossl_method_cache_delete(store, nid, NULL, prop_query);
+        res = 1;
         goto end;
     }
-    p = OPENSSL_malloc(sizeof(*p) + (len = strlen(prop_query)));
-    if (p != NULL) {
-        p->query = p->body;
-        p->provider = prov;
-        p->method.method = method;
-        p->method.up_ref = method_up_ref;
-        p->method.free = method_destruct;
-        if (!ossl_method_up_ref(&p->method))
-            goto err;
-        memcpy((char *)p->query, prop_query, len + 1);
-        if ((old = lh_QUERY_insert(alg->cache, p)) != NULL) {
-            impl_cache_free(old);
-            goto end;
-        }
-        if (!lh_QUERY_error(alg->cache)) {
-            if (++store->cache_nelem >= IMPL_CACHE_FLUSH_THRESHOLD)
-                store->cache_need_flush = 1;
-            goto end;
-        }
-        ossl_method_free(&p->method);
+    m.method = method;
+    m.up_ref = method_up_ref;
+    m.free = method_destruct;
+    if (ossl_method_cache_insert(store, nid, prov, prop_query, &m)
+            && ossl_method_cache_insert(store, nid, NULL, prop_query, &m)) {
+        if (store->cache_nelem >= IMPL_CACHE_FLUSH_THRESHOLD)
+            store->cache_need_flush = 1;
+        res = 1;
     }
-err:
-    res = 0;
-    OPENSSL_free(p);
 end:
+    /*
+     * Replaced and flushed entries are freed after a grace period, which
+     * unlocking the cache waits for.  Don't hold up the store meanwhile.
+     */
     ossl_property_unlock(store);
+    ossl_ht_write_unlock(store->cache);
     return res;
 }
@@ -348,6 +348,7 @@ struct evp_cipher_st {
     OSSL_FUNC_cipher_gettable_params_fn *gettable_params;
     OSSL_FUNC_cipher_gettable_ctx_params_fn *gettable_ctx_params;
     OSSL_FUNC_cipher_settable_ctx_params_fn *settable_ctx_params;
+    OSSL_FUNC_cipher_aead_batch_fn *aead_batch;
 } /* EVP_CIPHER */ ;
 
 /* Macros to code block cipher wrappers */
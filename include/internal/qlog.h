@@ -15,9 +15,14 @@
 # include "internal/time.h"
 
 typedef struct qlog_st QLOG;
+typedef struct qlog_writer_st QLOG_WRITER;
 
 # ifndef OPENSSL_NO_QLOG
 
+#  if !defined(OPENSSL_THREADS)
+#   define OPENSSL_NO_QLOG_ASYNC
+#  endif
+
 enum {
     QLOG_EVENT_TYPE_NONE,
 
@@ -36,6 +41,19 @@ typedef struct qlog_trace_info_st {
     void            *now_cb_arg;
     uint64_t        override_process_id;
     const char      *override_impl_name;
+
+    /*
+     * Library context from which random numbers are drawn when deciding
+     * whether to sample a connection. NULL means the default library context.
+     */
+    OSSL_LIB_CTX    *libctx;
+
+    /*
+     * Called by ossl_qlog_new_from_env() to obtain the writer to use if
+     * asynchronous qlog output has been requested. May be NULL.
+     */
+    QLOG_WRITER     *(*get_writer_cb)(void *arg);
+    void            *get_writer_cb_arg;
 } QLOG_TRACE_INFO;
 
 QLOG *ossl_qlog_new(const QLOG_TRACE_INFO *info);
@@ -54,6 +72,35 @@ int ossl_qlog_set_sink_file(QLOG *qlog, FILE *file, int close_flag);
 #  endif
 int ossl_qlog_set_sink_filename(QLOG *qlog, const char *filename);
 
+/*
+ * Asynchronous Output
+ * -------------------
+ *
+ * A QLOG attached to a QLOG_WRITER no longer serializes events to JSON when
+ * they are generated. Instead, each event is recorded in a compact binary form
+ * and appended to a ring buffer belonging to the QLOG. The writer owns a
+ * background thread which drains the ring buffers of all QLOGs attached to it
+ * and does the JSON-SEQ serialization and I/O. If an event does not fit in the
+ * ring buffer it is dropped rather than blocking the caller.
+ *
+ * Events for a given QLOG must still only be generated by one thread at a
+ * time.
+ */
+#  ifndef OPENSSL_NO_QLOG_ASYNC
+QLOG_WRITER *ossl_qlog_writer_new(void);
+void ossl_qlog_writer_free(QLOG_WRITER *w);
+
+/*
+ * Attach a QLOG to a writer. ring_size is the size of the QLOG's ring buffer
+ * in bytes and is rounded up to a power of two; 0 means use a default. The
+ * writer must outlive the QLOG. Must be called before any event is generated.
+ */
+int ossl_qlog_set_writer(QLOG *qlog, QLOG_WRITER *w, size_t ring_size);
+#  endif
+
+/* Number of events dropped because the ring buffer was full. */
+uint64_t ossl_qlog_get_num_dropped(QLOG *qlog);
+
 /* Operations */
 int ossl_qlog_flush(QLOG *qlog);
 
@@ -26,6 +26,17 @@ OSSL_ACKM *ossl_ackm_new(OSSL_TIME (*now)(void *arg),
                          OSSL_CC_DATA *cc_data);
 void ossl_ackm_free(OSSL_ACKM *ackm);
 
+/*
+ * Replaces the congestion controller used by the ACKM. This may only be done
+ * while no packets are in flight. The caller remains responsible for freeing
+ * the old congestion controller instance.
+ *
+ * Returns 1 on success or 0 on failure.
+ */
+int ossl_ackm_set_cc(OSSL_ACKM *ackm,
+                     const OSSL_CC_METHOD *cc_method,
+                     OSSL_CC_DATA *cc_data);
+
 void ossl_ackm_set_loss_detection_deadline_callback(OSSL_ACKM *ackm,
                                                     void (*fn)(OSSL_TIME deadline,
                                                                void *arg),
@@ -126,6 +137,15 @@ struct ossl_ackm_tx_pkt_st {
 
     struct ossl_ackm_tx_pkt_st *anext;
     struct ossl_ackm_tx_pkt_st *lnext;
+
+    /*
+     * Delivery rate estimation state captured when the packet was sent: the
+     * ACKM's total delivered bytes, the time of the last delivery and the send
+     * time of the first packet in the current flight.
+     */
+    uint64_t    delivered;
+    OSSL_TIME   delivered_time;
+    OSSL_TIME   first_tx_time;
 };
 
 int ossl_ackm_on_tx_packet(OSSL_ACKM *ackm, OSSL_ACKM_TX_PKT *pkt);
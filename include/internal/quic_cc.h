@@ -21,6 +21,23 @@ typedef struct ossl_cc_ack_info_st {
 
     /* The size in bytes of the packet being acknowledged. */
     size_t      tx_size;
+
+    /*
+     * Delivery rate sample, as described in
+     * draft-cheng-iccrg-delivery-rate-estimation.
+     *
+     * tx_delivered is the total number of bytes which had been acknowledged on
+     * the connection when the packet was sent. delivered is the number of bytes
+     * acknowledged since then, including this packet, and interval is the time
+     * over which they were delivered. interval is zero if no sample is
+     * available.
+     *
+     * Congestion controllers which do not estimate the delivery rate can
+     * ignore these fields.
+     */
+    uint64_t    tx_delivered;
+    uint64_t    delivered;
+    OSSL_TIME   interval;
 } OSSL_CC_ACK_INFO;
 
 typedef struct ossl_cc_loss_info_st {
@@ -42,6 +59,13 @@ typedef struct ossl_cc_ecn_info_st {
 /* Parameter (read-write): Maximum datagram payload length in bytes. */
 #define OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN        "max_dgram_payload_len"
 
+/*
+ * Parameter (write-only): the current smoothed RTT of the connection, as
+ * OSSL_TIME ticks in a uint64_t. The ACKM passes this in whenever it takes an
+ * RTT sample. Methods which do not need it ignore it.
+ */
+#define OSSL_CC_OPTION_SMOOTHED_RTT                 "smoothed_rtt"
+
 /* Diagnostic (read-only): current congestion window size in bytes. */
 #define OSSL_CC_OPTION_CUR_CWND_SIZE                "cur_cwnd_size"
 
@@ -54,6 +78,18 @@ typedef struct ossl_cc_ecn_info_st {
 /* Diagnostic (read-only): method-specific state value. */
 #define OSSL_CC_OPTION_CUR_STATE                    "cur_state"
 
+/*
+ * Diagnostic (read-only): current pacing rate in bytes per second, or 0 if the
+ * method does not pace. Not all methods support this.
+ */
+#define OSSL_CC_OPTION_CUR_PACING_RATE              "pacing_rate"
+
+/*
+ * Diagnostic (read-only): current estimate of the bottleneck bandwidth in bytes
+ * per second. Not all methods support this.
+ */
+#define OSSL_CC_OPTION_CUR_BW_ESTIMATE              "bw_estimate"
+
 /*
  * Congestion control abstract interface.
  *
@@ -148,6 +184,14 @@ struct ossl_cc_method_st {
      */
     OSSL_TIME (*get_wakeup_deadline)(OSSL_CC_DATA *ccdata);
 
+    /*
+     * Returns the rate in bytes per second at which the TX packetiser should
+     * spread the data allowed by get_tx_allowance() over time, or 0 if data
+     * may be sent as soon as it is allowed. The return value of this method
+     * can vary as time passes.
+     */
+    uint64_t (*get_pacing_rate)(OSSL_CC_DATA *ccdata);
+
     /*
      * The On Data Sent event. num_bytes should be the size of the packet in
      * bytes (or the aggregate size of multiple packets which have just been
@@ -212,6 +256,7 @@ struct ossl_cc_method_st {
 
 extern const OSSL_CC_METHOD ossl_cc_dummy_method;
 extern const OSSL_CC_METHOD ossl_cc_newreno_method;
+extern const OSSL_CC_METHOD ossl_cc_bbr_method;
 
 # endif
 
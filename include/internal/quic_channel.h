@@ -287,6 +287,24 @@ void ossl_quic_channel_on_stateless_reset(QUIC_CHANNEL *ch);
 
 void ossl_quic_channel_inject(QUIC_CHANNEL *ch, QUIC_URXE *e);
 
+/*
+ * Ensures the channel is serviced on the next tick of its port. A port only
+ * ticks channels which have received packets, whose tick deadline has passed,
+ * or for which a tick has been requested using this function, so this must be
+ * called after doing anything to the channel which might require it to do
+ * work, such as queueing data to be sent.
+ */
+void ossl_quic_channel_request_tick(QUIC_CHANNEL *ch);
+
+/*
+ * As for ossl_quic_channel_request_tick(), but also makes the channel's tick
+ * deadline now, both in the engine's timer wheel and in the reactor. This is
+ * for work created while the application handles events explicitly, such as
+ * new data to send, so that SSL_get_event_timeout() reports that events need
+ * handling immediately.
+ */
+void ossl_quic_channel_schedule_tick_now(QUIC_CHANNEL *ch);
+
 /*
  * Queries and Accessors
  * =====================
@@ -445,6 +463,55 @@ uint64_t ossl_quic_channel_get_max_idle_timeout_peer_request(const QUIC_CHANNEL
 /* Get the idle timeout actually negotiated. */
 uint64_t ossl_quic_channel_get_max_idle_timeout_actual(const QUIC_CHANNEL *ch);
 
+/*
+ * Configures the maximum size of a DATAGRAM frame (RFC 9221) we accept, which
+ * we advertise to the peer. 0 (the default) disables receipt of DATAGRAM
+ * frames. This must be set before the transport parameters are generated.
+ */
+void ossl_quic_channel_set_max_datagram_frame_size_request(QUIC_CHANNEL *ch,
+                                                           uint64_t max_size);
+/* Get the configured maximum DATAGRAM frame size we accept. */
+uint64_t ossl_quic_channel_get_max_datagram_frame_size_request(const QUIC_CHANNEL *ch);
+/* Get the maximum DATAGRAM frame size the peer accepts, or 0. */
+uint64_t ossl_quic_channel_get_max_datagram_frame_size_peer_request(const QUIC_CHANNEL *ch);
+
+/*
+ * Returns the largest datagram payload which can currently be sent to the
+ * peer, or 0 if the peer does not accept DATAGRAM frames (or if its transport
+ * parameters have not been received yet).
+ */
+size_t ossl_quic_channel_get_max_datagram_write_size(QUIC_CHANNEL *ch);
+
+/*
+ * Queues of DATAGRAM frame payloads waiting to be sent by the TXP and waiting
+ * to be read by the application, respectively.
+ */
+QUIC_DATAGRAM_QUEUE *ossl_quic_channel_get0_datagram_txq(QUIC_CHANNEL *ch);
+QUIC_DATAGRAM_QUEUE *ossl_quic_channel_get0_datagram_rxq(QUIC_CHANNEL *ch);
+
+/*
+ * Selects the congestion controller to use. This can only be changed before
+ * the channel is started. Returns 1 on success or 0 on failure.
+ */
+int ossl_quic_channel_set_cc_method(QUIC_CHANNEL *ch,
+                                    const OSSL_CC_METHOD *cc_method);
+/* Gets the congestion controller in use. */
+const OSSL_CC_METHOD *ossl_quic_channel_get_cc_method(const QUIC_CHANNEL *ch);
+
+/*
+ * Configures whether a client tries to send 0-RTT data when resuming a session
+ * which permits it. This can only be changed before the channel is started.
+ * Returns 1 on success or 0 on failure.
+ */
+int ossl_quic_channel_set_early_data_enabled(QUIC_CHANNEL *ch, int enabled);
+int ossl_quic_channel_get_early_data_enabled(const QUIC_CHANNEL *ch);
+
+/*
+ * Returns 1 if the handshake is not yet complete but 0-RTT keys are available,
+ * meaning that stream data written now will be sent as 0-RTT data.
+ */
+int ossl_quic_channel_can_send_early_data(const QUIC_CHANNEL *ch);
+
 # endif
 
 #endif
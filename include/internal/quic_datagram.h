@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_QUIC_DATAGRAM_H
+# define OSSL_QUIC_DATAGRAM_H
+
+# include <openssl/ssl.h>
+# include "internal/quic_types.h"
+# include "internal/quic_predef.h"
+
+# ifndef OPENSSL_NO_QUIC
+
+/*
+ * QUIC Datagram Queue
+ * ===================
+ *
+ * A bounded FIFO of application datagrams carried in RFC 9221 DATAGRAM frames.
+ * One queue is used for datagrams waiting to be sent by the TXP and another for
+ * datagrams received but not yet read by the application. Since DATAGRAM
+ * frames are unreliable, a queue never grows beyond its limit: if a datagram is
+ * pushed to a full queue, the oldest datagram in the queue is discarded to make
+ * room for it, as the application is typically more interested in recent data.
+ */
+
+/*
+ * Creates a new queue holding at most max_num datagrams, which must be non-zero.
+ */
+QUIC_DATAGRAM_QUEUE *ossl_quic_datagram_queue_new(size_t max_num);
+
+/* Frees the queue and any datagrams in it. */
+void ossl_quic_datagram_queue_free(QUIC_DATAGRAM_QUEUE *q);
+
+/*
+ * Copies a datagram to the end of the queue, discarding the datagram at the
+ * head of the queue if the queue is full. Returns 1 on success or 0 on
+ * allocation failure, in which case the queue is unchanged.
+ */
+int ossl_quic_datagram_queue_push(QUIC_DATAGRAM_QUEUE *q,
+                                  const unsigned char *data, size_t data_len);
+
+/*
+ * Retrieves the datagram at the head of the queue without removing it. The
+ * pointer written to *data remains valid until the datagram is popped or
+ * discarded. Returns 0 if the queue is empty.
+ */
+int ossl_quic_datagram_queue_peek(QUIC_DATAGRAM_QUEUE *q,
+                                  const unsigned char **data, size_t *data_len);
+
+/* Removes the datagram at the head of the queue, if any. */
+void ossl_quic_datagram_queue_pop(QUIC_DATAGRAM_QUEUE *q);
+
+/* Removes all datagrams from the queue. */
+void ossl_quic_datagram_queue_clear(QUIC_DATAGRAM_QUEUE *q);
+
+/* Returns the number of datagrams in the queue. */
+size_t ossl_quic_datagram_queue_get_num(const QUIC_DATAGRAM_QUEUE *q);
+
+/*
+ * Returns the number of datagrams which have been discarded because the queue
+ * was full. This may roll over.
+ */
+uint64_t ossl_quic_datagram_queue_get_num_dropped(const QUIC_DATAGRAM_QUEUE *q);
+
+# endif
+
+#endif
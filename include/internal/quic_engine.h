@@ -14,6 +14,7 @@
 # include "internal/quic_predef.h"
 # include "internal/quic_port.h"
 # include "internal/thread_arch.h"
+# include "internal/qlog.h"
 
 # ifndef OPENSSL_NO_QUIC
 
@@ -79,6 +80,14 @@ void ossl_quic_engine_set_inhibit_tick(QUIC_ENGINE *qeng, int inhibit);
 /* Gets the reactor which can be used to tick/poll on the port. */
 QUIC_REACTOR *ossl_quic_engine_get0_reactor(QUIC_ENGINE *qeng);
 
+#  if !defined(OPENSSL_NO_QLOG) && !defined(OPENSSL_NO_QLOG_ASYNC)
+/*
+ * Gets the asynchronous qlog writer shared by all channels in the engine,
+ * creating it (and its thread) on first use. Returns NULL on failure.
+ */
+QLOG_WRITER *ossl_quic_engine_get0_qlog_writer(QUIC_ENGINE *qeng);
+#  endif
+
 # endif
 
 #endif
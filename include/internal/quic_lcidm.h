@@ -111,6 +111,18 @@ void ossl_quic_lcidm_free(QUIC_LCIDM *lcidm);
 /* Gets the local CID length this LCIDM was configured to use. */
 size_t ossl_quic_lcidm_get_lcid_len(const QUIC_LCIDM *lcidm);
 
+/*
+ * Sets a routing byte which is placed in the first byte of every LCID
+ * subsequently generated by this LCIDM, with the remaining bytes still chosen
+ * randomly. This allows the LCIDs issued by different LCIDMs to be
+ * distinguished, which is used to route datagrams between the threads of a
+ * multi-threaded server (see QUIC_SHARD_GROUP). Pass -1 to disable. Fails if
+ * the LCID length is zero.
+ *
+ * Returns 1 on success or 0 on failure.
+ */
+int ossl_quic_lcidm_set_routing_byte(QUIC_LCIDM *lcidm, int routing_byte);
+
 /*
  * Determines the number of active LCIDs (i.e,. LCIDs which can be used for
  * reception) currently associated with the given opaque pointer.
@@ -54,6 +54,15 @@ typedef struct quic_port_args_st {
      * for a single connection, so a zero-length local CID can be used.
      */
     int             is_multi_conn;
+
+    /*
+     * If non-NULL, this port is one shard of a multi-threaded server whose
+     * ports share a UDP address using SO_REUSEPORT. shard_idx is the index of
+     * this port in the group and is encoded in all local CIDs issued by the
+     * port. Requires is_multi_conn. See QUIC_SHARD_GROUP.
+     */
+    QUIC_SHARD_GROUP *shard_group;
+    size_t          shard_idx;
 } QUIC_PORT_ARGS;
 
 /* Only QUIC_ENGINE should use this function. */
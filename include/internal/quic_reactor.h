@@ -99,6 +99,22 @@ struct quic_reactor_st {
     void (*tick_cb)(QUIC_TICK_RESULT *res, void *arg, uint32_t flags);
     void *tick_cb_arg;
 
+    /*
+     * Persistent epoll(7) set holding the sockets we currently want to use,
+     * or -1. See ossl_quic_reactor_get_wait_fd(). wait_reg_* record what is
+     * registered in it, so that only changes need to be passed to the kernel.
+     */
+    int wait_fd;
+    int wait_reg_fd[2];
+    uint32_t wait_reg_events[2];
+    size_t num_wait_reg;
+
+    /*
+     * Pipe used by other threads to wake up a thread blocking on this
+     * reactor, or -1 if not enabled. See ossl_quic_reactor_notify().
+     */
+    int notify_fd[2];
+
     /*
      * These are true if we would like to know when we can read or write from
      * the network respectively.
@@ -112,6 +128,9 @@ struct quic_reactor_st {
      */
     unsigned int can_poll_r : 1;
     unsigned int can_poll_w : 1;
+
+    /* Set if wait_fd could not be used; we then don't try again. */
+    unsigned int wait_fd_failed : 1;
 };
 
 void ossl_quic_reactor_init(QUIC_REACTOR *rtor,
@@ -120,6 +139,8 @@ void ossl_quic_reactor_init(QUIC_REACTOR *rtor,
                             void *tick_cb_arg,
                             OSSL_TIME initial_tick_deadline);
 
+void ossl_quic_reactor_cleanup(QUIC_REACTOR *rtor);
+
 void ossl_quic_reactor_set_poll_r(QUIC_REACTOR *rtor,
                                   const BIO_POLL_DESCRIPTOR *r);
 
@@ -140,6 +161,40 @@ int ossl_quic_reactor_net_write_desired(QUIC_REACTOR *rtor);
 
 OSSL_TIME ossl_quic_reactor_get_tick_deadline(QUIC_REACTOR *rtor);
 
+/*
+ * Brings the tick deadline forward to |deadline| if it is earlier. Used when
+ * work is created outside of a tick, so that callers waiting on the deadline
+ * know to tick the reactor before it would otherwise be due.
+ */
+void ossl_quic_reactor_lower_tick_deadline(QUIC_REACTOR *rtor,
+                                           OSSL_TIME deadline);
+
+/*
+ * Gets a file descriptor which becomes readable when any of the network
+ * sockets the reactor currently wants to read from or write to becomes ready,
+ * so that a caller can wait on many reactors with a single poll(2) call. The
+ * descriptor lives as long as the reactor, and is only updated when what the
+ * reactor wants changes. Returns 0 if there is no such descriptor, in which
+ * case the poll descriptors must be waited on directly.
+ */
+int ossl_quic_reactor_get_wait_fd(QUIC_REACTOR *rtor, int *fd);
+
+/*
+ * Enables ossl_quic_reactor_notify() for this reactor. Must be called before
+ * any other thread may call ossl_quic_reactor_notify(). Returns 0 if this is
+ * not supported on this platform, in which case notifications are ignored.
+ */
+int ossl_quic_reactor_enable_notifier(QUIC_REACTOR *rtor);
+
+/*
+ * Wakes up any thread blocking on the reactor, either in
+ * ossl_quic_reactor_block_until_pred() or on the descriptor returned by
+ * ossl_quic_reactor_get_wait_fd(), so that the reactor is ticked. May be called
+ * from any thread without holding the reactor's lock. Notifications made
+ * before the next tick are coalesced.
+ */
+void ossl_quic_reactor_notify(QUIC_REACTOR *rtor);
+
 /*
  * Do whatever work can be done, and as much work as can be done. This involves
  * e.g. seeing if we can read anything from the network (if we want to), seeing
@@ -46,6 +46,13 @@ typedef struct ossl_qrx_args_st {
 
     /* Initial key phase. For debugging use only; always 0 in real use. */
     unsigned char   init_key_phase_bit;
+
+    /*
+     * Whether 0-RTT packets may be processed. Only a server can receive 0-RTT
+     * packets; if this is 0 they are discarded on receipt. Otherwise they are
+     * processed once 0-RTT keys are provided.
+     */
+    unsigned char   allow_0rtt;
 } OSSL_QRX_ARGS;
 
 /* Instantiates a new QRX. */
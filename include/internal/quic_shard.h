@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_INTERNAL_QUIC_SHARD_H
+# define OSSL_INTERNAL_QUIC_SHARD_H
+# pragma once
+
+# include "internal/quic_types.h"
+# include "internal/quic_predef.h"
+
+# ifndef OPENSSL_NO_QUIC
+
+/*
+ * QUIC Shard Group
+ * ================
+ *
+ * A QUIC server can be spread across threads by running one QUIC_ENGINE per
+ * thread, each with a single QUIC_PORT using its own UDP socket, where all of
+ * the sockets are bound to the same address using SO_REUSEPORT (see
+ * BIO_SOCK_REUSEPORT). Each engine then has its own mutex, reactor, demuxer
+ * and set of channels. The kernel spreads incoming datagrams between the
+ * sockets based on their source address, so a connection normally stays with
+ * the port which accepted it, but this is not guaranteed once the peer's
+ * address changes (for example, due to NAT rebinding).
+ *
+ * A shard group ties such ports together. Each port is a shard identified by
+ * an index, which it encodes in the first byte of every local CID it issues.
+ * When a port receives a 1-RTT packet for a CID it does not know, but which
+ * carries the index of another shard, it forwards a copy of the datagram to
+ * that shard and notifies the reactor of the owning port, which collects
+ * forwarded datagrams the next time it is ticked. Thus packets for established
+ * connections are always processed by the thread owning the connection.
+ *
+ * A shard group is thread safe. It must outlive all ports which use it.
+ */
+
+/* Maximum number of shards; the shard index must fit in a CID byte. */
+#  define QUIC_SHARD_GROUP_MAX_SHARDS     256
+
+/*
+ * Creates a new shard group with num_shards shards. Returns NULL on failure.
+ */
+QUIC_SHARD_GROUP *ossl_quic_shard_group_new(size_t num_shards);
+
+/* Frees the shard group, discarding any datagrams not yet collected. */
+void ossl_quic_shard_group_free(QUIC_SHARD_GROUP *grp);
+
+/* Returns the number of shards in the group. */
+size_t ossl_quic_shard_group_get_num_shards(const QUIC_SHARD_GROUP *grp);
+
+/*
+ * Determines which shard issued the given local CID. Returns SIZE_MAX if the
+ * CID does not identify a shard in the group.
+ */
+size_t ossl_quic_shard_group_get_cid_owner(const QUIC_SHARD_GROUP *grp,
+                                           const QUIC_CONN_ID *cid);
+
+/*
+ * Sets the reactor to notify when a datagram is forwarded to the given shard,
+ * or NULL for none. The reactor must have its notifier enabled and must not
+ * be freed before it is unset again.
+ */
+void ossl_quic_shard_group_set_reactor(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                       QUIC_REACTOR *rtor);
+
+/*
+ * Queues a copy of the datagram in e for collection by the given shard. The
+ * caller retains ownership of e. Returns 1 on success or 0 if the datagram was
+ * dropped (for example because the shard's queue is full).
+ */
+int ossl_quic_shard_group_forward(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                  const QUIC_URXE *e);
+
+/*
+ * Injects all datagrams forwarded to the given shard into demux, which must
+ * be the demuxer of the port serving that shard. Returns the number of
+ * datagrams injected.
+ */
+size_t ossl_quic_shard_group_collect(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                     QUIC_DEMUX *demux);
+
+# endif
+
+#endif
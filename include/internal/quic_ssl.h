@@ -28,9 +28,20 @@ __owur int ossl_quic_accept(SSL *s);
 __owur int ossl_quic_connect(SSL *s);
 __owur int ossl_quic_read(SSL *s, void *buf, size_t len, size_t *readbytes);
 __owur int ossl_quic_peek(SSL *s, void *buf, size_t len, size_t *readbytes);
+__owur int ossl_quic_read_peek_zc(SSL *s, SSL_CONST_IOVEC *iov, size_t *num_iov,
+                                  size_t *readbytes);
+__owur int ossl_quic_read_release(SSL *s, size_t len);
 __owur int ossl_quic_write_flags(SSL *s, const void *buf, size_t len,
                                  uint64_t flags, size_t *written);
 __owur int ossl_quic_write(SSL *s, const void *buf, size_t len, size_t *written);
+__owur int ossl_quic_writev(SSL *s, const SSL_CONST_IOVEC *iov, size_t num_iov,
+                            size_t *written);
+__owur int ossl_quic_write_zc(SSL *s, const void *buf, size_t len,
+                              uint64_t flags,
+                              SSL_write_zc_release_cb_fn release_cb, void *arg);
+__owur int ossl_quic_write_datagram(SSL *s, const void *buf, size_t len);
+__owur int ossl_quic_read_datagram(SSL *s, void *buf, size_t len,
+                                   size_t *readbytes);
 __owur long ossl_quic_ctrl(SSL *s, int cmd, long larg, void *parg);
 __owur long ossl_quic_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg);
 __owur long ossl_quic_callback_ctrl(SSL *s, int cmd, void (*fp) (void));
@@ -146,6 +157,21 @@ int ossl_quic_set_diag_title(SSL_CTX *ctx, const char *title);
 int ossl_quic_conn_poll_events(SSL *ssl, uint64_t events, int do_tick,
                                uint64_t *revents);
 
+/*
+ * Gets what must be waited for before the state of the connection |ssl|
+ * belongs to can change: the network poll descriptors it wants to read from
+ * and write to, which are of type BIO_POLL_DESCRIPTOR_TYPE_NONE if it does
+ * not, and the deadline of its next tick. |*key| is set to a value that is
+ * the same for all connections driven by the same reactor, whose state
+ * changes together. |*wait_fd| is set to a descriptor which becomes readable
+ * when any of those network poll descriptors does, or -1 if there is none;
+ * see ossl_quic_reactor_get_wait_fd().
+ */
+int ossl_quic_conn_get_poll_wait(SSL *ssl, const void **key,
+                                 BIO_POLL_DESCRIPTOR *r,
+                                 BIO_POLL_DESCRIPTOR *w,
+                                 int *wait_fd, OSSL_TIME *deadline);
+
 # endif
 
 #endif
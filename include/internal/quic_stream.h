@@ -241,6 +241,32 @@ int ossl_quic_sstream_append(QUIC_SSTREAM *qss,
                              size_t buf_len,
                              size_t *consumed);
 
+/*
+ * Called when a buffer appended using ossl_quic_sstream_append_ref() is no
+ * longer referenced by the stream.
+ */
+typedef void (ossl_quic_sstream_release_fn)(const void *buf, size_t buf_len,
+                                            void *arg);
+
+/*
+ * (Front end use.) Appends user data to the stream without copying it. The
+ * stream references buf until all of its bytes have been acknowledged by the
+ * peer, or until the stream is freed, whichever happens first, and then calls
+ * release_cb (if it is non-NULL). The buffer must not be modified or freed
+ * before then. All of buf_len is always appended on success; the stream does
+ * not apply any buffer size limit to referenced data.
+ *
+ * While referenced data is outstanding, ossl_quic_sstream_append() does not
+ * accept data and reports a backpressure condition (consuming 0 bytes).
+ *
+ * Returns 1 on success or 0 on failure, in which case release_cb is not called.
+ */
+int ossl_quic_sstream_append_ref(QUIC_SSTREAM *qss,
+                                 const unsigned char *buf,
+                                 size_t buf_len,
+                                 ossl_quic_sstream_release_fn *release_cb,
+                                 void *release_arg);
+
 /*
  * Marks a stream as finished. ossl_quic_sstream_append() may not be called anymore
  * after calling this.
@@ -369,6 +395,38 @@ int ossl_quic_rstream_peek(QUIC_RSTREAM *qrs, unsigned char *buf, size_t size,
  */
 int ossl_quic_rstream_available(QUIC_RSTREAM *qrs, size_t *avail, int *fin);
 
+/*
+ * Peeks at the data in the stream storage without copying it. Up to *num_iov
+ * entries of `iov` are filled with pointers to consecutive spans of the
+ * readable data, each span referencing either a decrypted packet or the ring
+ * buffer (data wrapping around the end of the ring buffer takes two spans).
+ * *num_iov is set to the number of entries used and *readbytes to the total
+ * length of the spans. `fin` is set to 1 if the spans reach the end of the
+ * stream, 0 otherwise.
+ *
+ * The spans remain valid until ossl_quic_rstream_release_zc(),
+ * ossl_quic_rstream_read() or ossl_quic_rstream_free() is called. Stream
+ * frames received in the meantime do not replace the data the spans point to,
+ * and the data is not moved to the ring buffer.
+ */
+int ossl_quic_rstream_peek_zc(QUIC_RSTREAM *qrs, SSL_CONST_IOVEC *iov,
+                              size_t *num_iov, size_t *readbytes, int *fin);
+
+/*
+ * Consumes the first `len` bytes of the data returned by the previous
+ * ossl_quic_rstream_peek_zc() call, which must not exceed the total length of
+ * the spans returned. Any spans returned are invalidated, including those for
+ * data not consumed. `fin` is set to 1 if the stream is now finished, 0
+ * otherwise. Returns 1 on success, 0 on error.
+ */
+int ossl_quic_rstream_release_zc(QUIC_RSTREAM *qrs, size_t len, int *fin);
+
+/*
+ * Returns 1 if ossl_quic_rstream_peek_zc() has returned data which has not
+ * yet been released.
+ */
+int ossl_quic_rstream_is_zc_peeked(const QUIC_RSTREAM *qrs);
+
 /*
  * Sets *record to the beginning of the first readable stream data chunk and
  * *reclen to the size of the chunk. *fin is set to 1 if the end of the
@@ -66,8 +66,9 @@ struct quic_stream_list_node_st {
  * Invariants in each state are noted in comments below. In particular, once all
  * data has been read by the application, we don't need to keep the QUIC_RSTREAM
  * and data buffers around. If the receive part is instead reset before it is
- * finished, we also don't need to keep the QUIC_RSTREAM around. Finally, we
- * don't need a QUIC_RSTREAM on a send-only stream.
+ * finished, we also don't need to keep the QUIC_RSTREAM around (except while
+ * the application holds pointers to data obtained using SSL_read_peek_zc()).
+ * Finally, we don't need a QUIC_RSTREAM on a send-only stream.
  */
 #define QUIC_RSTREAM_STATE_NONE         0   /* --- rstream == NULL  */
 #define QUIC_RSTREAM_STATE_RECV         1   /* \                    */
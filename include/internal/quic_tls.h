@@ -95,6 +95,21 @@ int ossl_quic_tls_set_transport_params(QUIC_TLS *qtls,
                                        const unsigned char *transport_params,
                                        size_t transport_params_len);
 
+/*
+ * Sets whether a client should try to send 0-RTT data. 0-RTT is only attempted
+ * if the session being resumed permits it. Must be called before the first
+ * call to ossl_quic_tls_tick().
+ */
+void ossl_quic_tls_set_early_data_enabled(QUIC_TLS *qtls, int enabled);
+
+/*
+ * Retrieves the server transport parameters remembered in the session a client
+ * is resuming. These govern any 0-RTT data sent. Returns 0 if there are none.
+ */
+int ossl_quic_tls_get0_early_transport_params(QUIC_TLS *qtls,
+                                              const unsigned char **params,
+                                              size_t *params_len);
+
 int ossl_quic_tls_get_error(QUIC_TLS *qtls,
                             uint64_t *error_code,
                             const char **error_msg,
@@ -43,6 +43,12 @@ typedef struct quic_tserver_args_st {
     void *now_cb_arg;
     const unsigned char *alpn;
     size_t alpnlen;
+    /*
+     * Optional; if set, the server's port is shard shard_idx of the given
+     * shard group. See QUIC_SHARD_GROUP.
+     */
+    QUIC_SHARD_GROUP *shard_group;
+    size_t shard_idx;
 } QUIC_TSERVER_ARGS;
 
 QUIC_TSERVER *ossl_quic_tserver_new(const QUIC_TSERVER_ARGS *args,
@@ -123,6 +129,12 @@ int ossl_quic_tserver_write(QUIC_TSERVER *srv,
  */
 int ossl_quic_tserver_conclude(QUIC_TSERVER *srv, uint64_t stream_id);
 
+/*
+ * Resets the sending part of the stream with the given application error code.
+ */
+int ossl_quic_tserver_stream_reset(QUIC_TSERVER *srv, uint64_t stream_id,
+                                   uint64_t app_error_code);
+
 /*
  * Create a server-initiated stream. The stream ID of the newly
  * created stream is written to *stream_id.
@@ -215,6 +227,28 @@ int ossl_quic_tserver_set_max_early_data(QUIC_TSERVER *srv,
 void ossl_quic_tserver_set_psk_find_session_cb(QUIC_TSERVER *srv,
                                                SSL_psk_find_session_cb_func cb);
 
+/*
+ * Set the maximum size of a DATAGRAM frame the server accepts. Must be called
+ * before the handshake starts. 0 (the default) disables DATAGRAM frames.
+ */
+void ossl_quic_tserver_set_max_datagram_frame_size(QUIC_TSERVER *srv,
+                                                   uint64_t max_size);
+
+/*
+ * Queue a datagram to be sent to the client in a DATAGRAM frame. Fails if the
+ * client does not accept datagrams of this size.
+ */
+int ossl_quic_tserver_write_datagram(QUIC_TSERVER *srv,
+                                     const unsigned char *buf, size_t buf_len);
+
+/*
+ * Read a datagram received from the client. Returns 0 if no datagram is
+ * available or if it is larger than buf_len, in which case it is not consumed.
+ */
+int ossl_quic_tserver_read_datagram(QUIC_TSERVER *srv,
+                                    unsigned char *buf, size_t buf_len,
+                                    size_t *bytes_read);
+
 # endif
 
 #endif
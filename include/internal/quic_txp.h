@@ -19,6 +19,7 @@
 # include "internal/quic_stream.h"
 # include "internal/quic_stream_map.h"
 # include "internal/quic_fc.h"
+# include "internal/quic_datagram.h"
 # include "internal/bio_addr.h"
 # include "internal/time.h"
 # include "internal/qlog.h"
@@ -46,6 +47,7 @@ typedef struct ossl_quic_tx_packetiser_args_st {
     QUIC_RXFC       *conn_rxfc; /* QUIC Connection-Level RX Flow Controller */
     QUIC_RXFC       *max_streams_bidi_rxfc; /* QUIC RXFC for MAX_STREAMS generation */
     QUIC_RXFC       *max_streams_uni_rxfc;
+    QUIC_DATAGRAM_QUEUE *datagram_txq; /* DATAGRAM frames to send (optional) */
     const OSSL_CC_METHOD *cc_method; /* QUIC Congestion Controller */
     OSSL_CC_DATA    *cc_data;   /* QUIC Congestion Controller Instance */
     OSSL_TIME       (*now)(void *arg);  /* Callback to get current time. */
@@ -124,6 +126,13 @@ int ossl_quic_tx_packetiser_set_initial_token(OSSL_QUIC_TX_PACKETISER *txp,
                                               ossl_quic_initial_token_free_fn *free_cb,
                                               void *free_cb_arg);
 
+/*
+ * Returns the maximum encoded length of a DATAGRAM frame which can be sent in a
+ * 1-RTT packet not coalesced with any other packet, based on our current
+ * understanding of our PMTU. Returns 0 if the 1-RTT EL is not yet provisioned.
+ */
+size_t ossl_quic_tx_packetiser_get_max_datagram_frame_len(OSSL_QUIC_TX_PACKETISER *txp);
+
 /* Change the DCID the TXP uses to send outgoing packets. */
 int ossl_quic_tx_packetiser_set_cur_dcid(OSSL_QUIC_TX_PACKETISER *txp,
                                          const QUIC_CONN_ID *dcid);
@@ -139,6 +148,14 @@ int ossl_quic_tx_packetiser_set_cur_scid(OSSL_QUIC_TX_PACKETISER *txp,
 int ossl_quic_tx_packetiser_set_peer(OSSL_QUIC_TX_PACKETISER *txp,
                                      const BIO_ADDR *peer);
 
+/*
+ * Change the congestion controller the TXP consults. This must be kept in sync
+ * with the congestion controller used by the ACKM.
+ */
+void ossl_quic_tx_packetiser_set_cc(OSSL_QUIC_TX_PACKETISER *txp,
+                                    const OSSL_CC_METHOD *cc_method,
+                                    OSSL_CC_DATA *cc_data);
+
 /*
  * Change the QLOG instance retrieval function in use after instantiation.
  */
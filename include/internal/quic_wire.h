@@ -41,6 +41,9 @@
 #  define OSSL_QUIC_FRAME_TYPE_CONN_CLOSE_TRANSPORT   0x1C
 #  define OSSL_QUIC_FRAME_TYPE_CONN_CLOSE_APP         0x1D
 #  define OSSL_QUIC_FRAME_TYPE_HANDSHAKE_DONE         0x1E
+/* RFC 9221 */
+#  define OSSL_QUIC_FRAME_TYPE_DATAGRAM               0x30
+#  define OSSL_QUIC_FRAME_TYPE_DATAGRAM_LEN           0x31
 
 #  define OSSL_QUIC_FRAME_FLAG_STREAM_FIN         0x01
 #  define OSSL_QUIC_FRAME_FLAG_STREAM_LEN         0x02
@@ -86,6 +89,8 @@
     (((x) & ~(uint64_t)1) == OSSL_QUIC_FRAME_TYPE_STREAMS_BLOCKED_BIDI)
 #  define OSSL_QUIC_FRAME_TYPE_IS_CONN_CLOSE(x) \
     (((x) & ~(uint64_t)1) == OSSL_QUIC_FRAME_TYPE_CONN_CLOSE_TRANSPORT)
+#  define OSSL_QUIC_FRAME_TYPE_IS_DATAGRAM(x) \
+    (((x) & ~(uint64_t)1) == OSSL_QUIC_FRAME_TYPE_DATAGRAM)
 
 const char *ossl_quic_frame_type_to_string(uint64_t frame_type);
 
@@ -122,6 +127,7 @@ ossl_quic_frame_type_is_ack_eliciting(uint64_t frame_type)
 #  define QUIC_TPARAM_ACTIVE_CONN_ID_LIMIT                0x0E
 #  define QUIC_TPARAM_INITIAL_SCID                        0x0F
 #  define QUIC_TPARAM_RETRY_SCID                          0x10
+#  define QUIC_TPARAM_MAX_DATAGRAM_FRAME_SIZE             0x20 /* RFC 9221 */
 
 /*
  * QUIC Frame Logical Representations
@@ -440,6 +446,23 @@ int ossl_quic_wire_encode_frame_conn_close(WPACKET *pkt,
  */
 int ossl_quic_wire_encode_frame_handshake_done(WPACKET *pkt);
 
+/*
+ * Encodes a QUIC DATAGRAM frame (RFC 9221) to the packet writer. If has_len is
+ * 0, the frame is encoded without a length field and must be the last frame in
+ * the packet.
+ */
+int ossl_quic_wire_encode_frame_datagram(WPACKET *pkt,
+                                         const unsigned char *data,
+                                         size_t data_len,
+                                         int has_len);
+
+/*
+ * Returns the encoded length of a DATAGRAM frame with a payload of data_len
+ * bytes.
+ */
+size_t ossl_quic_wire_get_encoded_frame_len_datagram(size_t data_len,
+                                                     int has_len);
+
 /*
  * Encodes a QUIC transport parameter TLV with the given ID into the WPACKET.
  * The payload is an arbitrary buffer.
@@ -726,6 +749,15 @@ int ossl_quic_wire_decode_frame_ping(PACKET *pkt);
  */
 int ossl_quic_wire_decode_frame_handshake_done(PACKET *pkt);
 
+/*
+ * Decodes a DATAGRAM frame (RFC 9221). *data is written with a pointer to the
+ * payload and *data_len with its length in bytes. A DATAGRAM frame without a
+ * length field extends to the end of the packet.
+ */
+int ossl_quic_wire_decode_frame_datagram(PACKET *pkt,
+                                         const unsigned char **data,
+                                         size_t *data_len);
+
 /*
  * Peeks at the ID of the next QUIC transport parameter TLV in the stream.
  * The ID is written to *id.
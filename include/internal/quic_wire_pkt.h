@@ -263,6 +263,36 @@ int ossl_quic_hdr_protector_encrypt_fields(QUIC_HDR_PROTECTOR *hpr,
                                            unsigned char *first_byte,
                                            unsigned char *pn_bytes);
 
+/*
+ * Maximum number of packets which can be passed to
+ * ossl_quic_hdr_protector_decrypt_batch() or
+ * ossl_quic_hdr_protector_encrypt_batch() in one call.
+ */
+#  define QUIC_HDR_PROT_MAX_BATCH         32
+
+/*
+ * Removes header protection from num_ptrs packets, which must not exceed
+ * QUIC_HDR_PROT_MAX_BATCH. This is equivalent to calling
+ * ossl_quic_hdr_protector_decrypt() on each packet in turn, but for AES the
+ * header protection masks for all of the packets are generated in a single
+ * cipher operation, which is substantially cheaper for a burst of packets.
+ *
+ * If this function fails, no data is modified.
+ *
+ * Returns 1 on success and 0 on failure.
+ */
+int ossl_quic_hdr_protector_decrypt_batch(QUIC_HDR_PROTECTOR *hpr,
+                                          QUIC_PKT_HDR_PTRS *ptrs,
+                                          size_t num_ptrs);
+
+/*
+ * Works analogously to ossl_quic_hdr_protector_decrypt_batch, but applies
+ * header protection instead of removing it.
+ */
+int ossl_quic_hdr_protector_encrypt_batch(QUIC_HDR_PROTECTOR *hpr,
+                                          QUIC_PKT_HDR_PTRS *ptrs,
+                                          size_t num_ptrs);
+
 /*
  * QUIC Packet Header
  * ==================
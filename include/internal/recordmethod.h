@@ -61,12 +61,19 @@ typedef struct ossl_record_layer_st OSSL_RECORD_LAYER;
  * Template for creating a record. A record consists of the |type| of data it
  * will contain (e.g. alert, handshake, application data, etc) along with a
  * buffer of payload data in |buf| of length |buflen|.
+ *
+ * Alternatively, if |iov| is not NULL, the payload is gathered from the
+ * |numiov| buffers in |iov| in turn, |buf| is unused and |buflen| is the total
+ * length of those buffers. Only application data records written with the TLS
+ * record method are ever gathered like this.
  */
 struct ossl_record_template_st {
     unsigned char type;
     unsigned int version;
     const unsigned char *buf;
     size_t buflen;
+    const SSL_CONST_IOVEC *iov;
+    size_t numiov;
 };
 
 typedef struct ossl_record_template_st OSSL_RECORD_TEMPLATE;
@@ -326,6 +333,18 @@ struct ossl_record_method_st {
      * data. Buffers are automatically reallocated on next read/write.
      */
     int (*free_buffers)(OSSL_RECORD_LAYER *rl);
+
+    /*
+     * Offer |buf| of |len| bytes as the destination for the payload of the
+     * next record read. If the next call to read_record processes a single
+     * application data record whose payload fits, the record may be decrypted
+     * straight into |buf|, in which case the |*data| returned by read_record
+     * points to the start of |buf|. The offer only applies to the next call to
+     * read_record and |buf| must not be modified while the record is being
+     * processed. May be NULL if not supported.
+     */
+    void (*set_read_dest)(OSSL_RECORD_LAYER *rl, unsigned char *buf,
+                          size_t len);
 };
 
 
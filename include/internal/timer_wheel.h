@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_INTERNAL_TIMER_WHEEL_H
+# define OSSL_INTERNAL_TIMER_WHEEL_H
+# pragma once
+
+# include "internal/time.h"
+
+/*
+ * Hierarchical timer wheel
+ * ========================
+ *
+ * A timer wheel keeps a set of entries, each with an expiry time, such that
+ * adding, rearming and removing an entry are all O(1) and expired entries can
+ * be collected in time proportional to their number plus the number of wheel
+ * slots passed over.
+ *
+ * Time is divided into ticks of a fixed granularity. The wheel has a number of
+ * levels of 64 slots each; a slot on level n covers 64^n ticks. An entry is
+ * filed on the lowest level whose slot can tell it apart from the current
+ * tick and is moved down a level as the wheel turns past the boundary of its
+ * slot. Entries further in the future than the wheel can represent are parked
+ * in the last slot of the top level and refiled when it is reached.
+ *
+ * Entries are embedded in the caller's objects and carry a pointer back to
+ * them. The wheel never allocates or frees entries and is not thread safe;
+ * callers provide their own locking.
+ */
+typedef struct ossl_timer_wheel_st OSSL_TIMER_WHEEL;
+typedef struct ossl_timer_wheel_entry_st OSSL_TIMER_WHEEL_ENTRY;
+
+struct ossl_timer_wheel_entry_st {
+    OSSL_TIMER_WHEEL_ENTRY *prev, *next;
+    OSSL_TIME expiry;
+    void *data;
+    unsigned char armed, level, slot;
+};
+
+/*
+ * Creates a new wheel whose ticks are |granularity| long and whose current
+ * time is |now|. |granularity| must not be zero.
+ */
+OSSL_TIMER_WHEEL *ossl_timer_wheel_new(OSSL_TIME granularity, OSSL_TIME now);
+
+/* Frees a wheel. Any entries still in it are simply forgotten. */
+void ossl_timer_wheel_free(OSSL_TIMER_WHEEL *tw);
+
+/* Initialises an entry that refers back to |data|. */
+void ossl_timer_wheel_entry_init(OSSL_TIMER_WHEEL_ENTRY *e, void *data);
+
+/* Returns 1 if |e| is currently in a wheel. */
+int ossl_timer_wheel_entry_armed(const OSSL_TIMER_WHEEL_ENTRY *e);
+
+/*
+ * Adds |e| to the wheel to expire at |expiry|. If |e| is already in the wheel
+ * it is moved to its new expiry time.
+ */
+void ossl_timer_wheel_add(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e,
+                          OSSL_TIME expiry);
+
+/* Removes |e| from the wheel. This is a no-op if |e| is not in the wheel. */
+void ossl_timer_wheel_remove(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e);
+
+/*
+ * Removes one entry whose expiry time is strictly before |now| and returns
+ * its data pointer, or returns NULL if there are no such entries. The wheel
+ * is turned forward to |now| as a side effect; passing a |now| earlier than
+ * a previous call only finds entries that are already due.
+ */
+void *ossl_timer_wheel_expire(OSSL_TIMER_WHEEL *tw, OSSL_TIME now);
+
+/*
+ * Returns a time no later than the expiry time of any entry in the wheel, or
+ * infinite if the wheel is empty. For entries that are due within the current
+ * level 0 revolution this is the exact expiry time of the earliest one;
+ * otherwise it is the time at which the earliest entries are moved down a
+ * level, after which the query becomes more precise. Calling
+ * ossl_timer_wheel_expire() once this time has passed always makes progress.
+ */
+OSSL_TIME ossl_timer_wheel_next_expiry(const OSSL_TIMER_WHEEL *tw);
+
+/* Returns the number of entries in the wheel. */
+size_t ossl_timer_wheel_num(const OSSL_TIMER_WHEEL *tw);
+
+#endif
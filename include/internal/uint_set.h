@@ -19,8 +19,11 @@
  * Utilities for managing a logical set of unsigned 64-bit integers. The
  * structure tracks each contiguous range of integers using one allocation and
  * is thus optimised for cases where integers tend to appear consecutively.
- * Queries are optimised under the assumption that they will generally be made
- * on integers near the end of the set.
+ * Operations take O(log n) expected time in the number of ranges, and
+ * operations at the end of the set are optimised further.
+ *
+ * The ranges can be iterated in ascending order using the ossl_list_uint_set
+ * functions, but must only be modified using the functions below.
  *
  * Discussion of implementation details can be found in uint_set.c.
  */
@@ -32,6 +35,10 @@ typedef struct uint_set_item_st UINT_SET_ITEM;
 struct uint_set_item_st {
     OSSL_LIST_MEMBER(uint_set, UINT_SET_ITEM);
     UINT_RANGE                  range;
+
+    /* Search tree over the ranges; internal to uint_set.c. */
+    UINT_SET_ITEM               *parent, *left, *right;
+    uint32_t                    prio;
 };
 
 DEFINE_LIST_OF(uint_set, UINT_SET_ITEM);
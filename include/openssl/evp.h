@@ -805,6 +805,12 @@ __owur int EVP_CipherFinal(EVP_CIPHER_CTX *ctx, unsigned char *outm,
                            int *outl);
 __owur int EVP_CipherFinal_ex(EVP_CIPHER_CTX *ctx, unsigned char *outm,
                               int *outl);
+__owur int EVP_CipherAEADBatch(EVP_CIPHER_CTX *ctx, size_t num,
+                               const unsigned char **iv, size_t ivlen,
+                               const unsigned char **aad, const size_t *aadlen,
+                               const unsigned char **in, const size_t *inl,
+                               unsigned char **out, unsigned char **tag,
+                               size_t taglen);
 
 __owur int EVP_SignFinal(EVP_MD_CTX *ctx, unsigned char *md, unsigned int *s,
                          EVP_PKEY *pkey);
@@ -101,6 +101,7 @@
 # define SSL_R_DANE_TLSA_BAD_PUBLIC_KEY                   201
 # define SSL_R_DANE_TLSA_BAD_SELECTOR                     202
 # define SSL_R_DANE_TLSA_NULL_DATA                        203
+# define SSL_R_DATAGRAMS_NOT_NEGOTIATED                   444
 # define SSL_R_DATA_BETWEEN_CCS_AND_FINISHED              145
 # define SSL_R_DATA_LENGTH_TOO_LONG                       146
 # define SSL_R_DECRYPTION_FAILED                          147
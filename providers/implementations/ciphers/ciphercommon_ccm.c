@@ -321,6 +321,71 @@ int ossl_ccm_cipher(void *vctx, unsigned char *out, size_t *outl, size_t outsize
     return 1;
 }
 
+#ifndef FIPS_MODULE
+/*
+ * Seals or opens a batch of independent messages under the current key, each
+ * of which is processed from start to finish before the next. As for GCM this
+ * is left out of the FIPS provider.
+ */
+int ossl_ccm_aead_batch(void *vctx, size_t num,
+                        const unsigned char **iv, size_t ivlen,
+                        const unsigned char **aad, const size_t *aadlen,
+                        const unsigned char **in, const size_t *inl,
+                        unsigned char **out, unsigned char **tag, size_t taglen)
+{
+    PROV_CCM_CTX *ctx = (PROV_CCM_CTX *)vctx;
+    const PROV_CCM_HW *hw = ctx->hw;
+    size_t i, j;
+    int ret = 0;
+
+    if (!ossl_prov_is_running())
+        return 0;
+
+    if (!ctx->key_set || ctx->tls_aad_len != UNINITIALISED_SIZET) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_STATE);
+        return 0;
+    }
+
+    if (ivlen != ccm_get_ivlen(ctx)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+
+    /* The tag length is bound into the key schedule by the M parameter. */
+    if (taglen != ctx->m) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+
+    /* Any message being streamed through this context is abandoned. */
+    ctx->len_set = 0;
+    ctx->tag_set = 0;
+
+    for (i = 0; i < num; ++i) {
+        if (!hw->setiv(ctx, iv[i], ivlen, inl[i])
+            || (aadlen[i] > 0 && !hw->setaad(ctx, aad[i], aadlen[i])))
+            goto err;
+
+        if (ctx->enc) {
+            if (!hw->auth_encrypt(ctx, in[i], out[i], inl[i], tag[i], taglen))
+                goto err;
+        } else if (!hw->auth_decrypt(ctx, in[i], out[i], inl[i], tag[i],
+                                     taglen)) {
+            goto err;
+        }
+    }
+
+    ret = 1;
+err:
+    /* Plaintext must not be released if any message failed to authenticate */
+    if (!ret && !ctx->enc)
+        for (j = 0; j <= i; ++j)
+            if (inl[j] > 0)
+                OPENSSL_cleanse(out[j], inl[j]);
+    return ret;
+}
+#endif
+
 /* Copy the buffered iv */
 static int ccm_set_iv(PROV_CCM_CTX *ctx, size_t mlen)
 {
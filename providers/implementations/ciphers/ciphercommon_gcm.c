@@ -384,6 +384,80 @@ int ossl_gcm_cipher(void *vctx,
     return 1;
 }
 
+#ifndef FIPS_MODULE
+/*
+ * Seals or opens a batch of independent messages under the current key. Each
+ * message is processed from start to finish through the hardware specific
+ * methods before the next, so the per-call overhead of the EVP layer is paid
+ * once for the whole batch. Implementations which interleave several messages
+ * through the cipher at once can be slotted in here.
+ *
+ * This is not offered by the FIPS provider, as it bypasses the IV generation
+ * and usage limit checks which apply to the other functions.
+ */
+int ossl_gcm_aead_batch(void *vctx, size_t num,
+                        const unsigned char **iv, size_t ivlen,
+                        const unsigned char **aad, const size_t *aadlen,
+                        const unsigned char **in, const size_t *inl,
+                        unsigned char **out, unsigned char **tag, size_t taglen)
+{
+    PROV_GCM_CTX *ctx = (PROV_GCM_CTX *)vctx;
+    const PROV_GCM_HW *hw = ctx->hw;
+    unsigned char tagbuf[GCM_TAG_MAX_SIZE];
+    size_t i, j, saved_taglen = ctx->taglen;
+    int ret = 0;
+
+    if (!ossl_prov_is_running())
+        return 0;
+
+    if (!ctx->key_set || ctx->tls_aad_len != UNINITIALISED_SIZET) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_STATE);
+        return 0;
+    }
+
+    if (ivlen == 0 || ivlen > sizeof(ctx->iv)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+
+    if (taglen == 0 || taglen > GCM_TAG_MAX_SIZE) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+
+    /* Any message being streamed through this context is abandoned. */
+    if (ctx->iv_state == IV_STATE_COPIED)
+        ctx->iv_state = IV_STATE_FINISHED;
+
+    ctx->taglen = taglen;
+    for (i = 0; i < num; ++i) {
+        if (!hw->setiv(ctx, iv[i], ivlen)
+            || (aadlen[i] > 0 && !hw->aadupdate(ctx, aad[i], aadlen[i]))
+            || (inl[i] > 0 && !hw->cipherupdate(ctx, in[i], inl[i], out[i])))
+            goto err;
+
+        if (ctx->enc) {
+            if (!hw->cipherfinal(ctx, tagbuf))
+                goto err;
+            memcpy(tag[i], tagbuf, taglen);
+        } else if (!hw->cipherfinal(ctx, tag[i])) {
+            goto err;
+        }
+    }
+
+    ret = 1;
+err:
+    /* Plaintext must not be released if any message failed to authenticate */
+    if (!ret && !ctx->enc)
+        for (j = 0; j <= i; ++j)
+            if (inl[j] > 0)
+                OPENSSL_cleanse(out[j], inl[j]);
+    ctx->taglen = saved_taglen;
+    OPENSSL_cleanse(tagbuf, sizeof(tagbuf));
+    return ret;
+}
+#endif
+
 /*
  * See SP800-38D (GCM) Section 8 "Uniqueness requirement on IVS and keys"
  *
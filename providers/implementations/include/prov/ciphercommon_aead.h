@@ -15,6 +15,17 @@
 
 # define AEAD_FLAGS (PROV_CIPHER_FLAG_AEAD | PROV_CIPHER_FLAG_CUSTOM_IV)
 
+/*
+ * Batched sealing and opening skips the IV generation rules and the usage
+ * limits that the FIPS provider enforces, so it is only offered elsewhere.
+ */
+# ifdef FIPS_MODULE
+#  define AEAD_BATCH_FUNCTION(lc)
+# else
+#  define AEAD_BATCH_FUNCTION(lc)                                              \
+    { OSSL_FUNC_CIPHER_AEAD_BATCH, (void (*)(void))ossl_##lc##_aead_batch },
+# endif
+
 # define IMPLEMENT_aead_cipher(alg, lc, UCMODE, flags, kbits, blkbits, ivbits)  \
 static OSSL_FUNC_cipher_get_params_fn alg##_##kbits##_##lc##_get_params;       \
 static int alg##_##kbits##_##lc##_get_params(OSSL_PARAM params[])              \
@@ -40,6 +51,7 @@ const OSSL_DISPATCH ossl_##alg##kbits##lc##_functions[] = {                    \
     { OSSL_FUNC_CIPHER_UPDATE, (void (*)(void))ossl_##lc##_stream_update },    \
     { OSSL_FUNC_CIPHER_FINAL, (void (*)(void))ossl_##lc##_stream_final },      \
     { OSSL_FUNC_CIPHER_CIPHER, (void (*)(void))ossl_##lc##_cipher },           \
+    AEAD_BATCH_FUNCTION(lc)                                                    \
     { OSSL_FUNC_CIPHER_GET_PARAMS,                                             \
       (void (*)(void)) alg##_##kbits##_##lc##_get_params },                    \
     { OSSL_FUNC_CIPHER_GET_CTX_PARAMS,                                         \
@@ -0,0 +1,894 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "internal/quic_cc.h"
+#include "internal/quic_types.h"
+#include "internal/safe_math.h"
+
+OSSL_SAFE_MATH_UNSIGNED(u64, uint64_t)
+
+/*
+ * BBR Congestion Controller
+ * =========================
+ *
+ * A model-based congestion controller in the style of BBRv2/v3
+ * (draft-cardwell-iccrg-bbr-congestion-control). Rather than treating every
+ * loss as a congestion signal, BBR estimates the bottleneck bandwidth (the
+ * maximum recent delivery rate) and the round-trip propagation delay (the
+ * minimum recent RTT) and sizes the congestion window to a multiple of their
+ * product. This keeps the pipe full on paths with random, non-congestive loss,
+ * where loss-based controllers such as NewReno repeatedly halve their window.
+ *
+ * Loss is still taken into account: if more than BBR_LOSS_THRESH of the data
+ * sent in a round trip is lost, BBR caps the amount of data in flight
+ * (inflight_hi), which is then probed upwards again during ProbeBW.
+ *
+ * Delivery rate samples are produced by the ACKM (see OSSL_CC_ACK_INFO).
+ *
+ * The following simplifications are made relative to the draft:
+ *
+ *   - The lower bounds bw_lo and inflight_lo and the ProbeBW sub-states are
+ *     not modelled separately; ProbeBW uses the classic eight phase gain
+ *     cycle and adjusts inflight_hi.
+ *
+ *   - The ACKM does not know whether the application was limited when a
+ *     packet was sent, so all delivery rate samples are treated as valid. As
+ *     the bandwidth filter is a windowed maximum, app-limited samples can only
+ *     cause the estimate to decay sooner than it would otherwise.
+ */
+
+/* Fixed point unit for gains. */
+#define BBR_UNIT                    1000
+
+#define BBR_STARTUP_PACING_GAIN     2770    /* 4 ln 2 */
+#define BBR_STARTUP_CWND_GAIN       2000
+#define BBR_DRAIN_PACING_GAIN       350
+#define BBR_CWND_GAIN               2000
+
+/* Multiplicative decrease of inflight_hi when loss is too high. */
+#define BBR_BETA                    700
+
+/* Maximum tolerated loss rate in a round trip: 2%. */
+#define BBR_LOSS_THRESH_NUM         1
+#define BBR_LOSS_THRESH_DEN         50
+
+/* The pipe is full when bandwidth grows by less than 25% for 3 rounds. */
+#define BBR_FULL_BW_THRESH          1250
+#define BBR_FULL_BW_COUNT           3
+
+/* Length of the bandwidth filter in round trips. */
+#define BBR_BW_FILTER_LEN           10
+
+/* Length of the min RTT filter and duration of ProbeRTT. */
+#define BBR_MIN_RTT_FILTER_LEN      ossl_seconds2time(10)
+#define BBR_PROBE_RTT_DURATION      ossl_ms2time(200)
+
+/* Initial RTT assumed before the first sample (RFC 9002 s. 6.2.2). */
+#define BBR_INITIAL_RTT             ossl_ms2time(333)
+
+#define BBR_NUM_CYCLE_PHASES        8
+
+static const uint32_t bbr_probe_bw_gains[BBR_NUM_CYCLE_PHASES] = {
+    1250, 750, 1000, 1000, 1000, 1000, 1000, 1000
+};
+
+#define MIN_MAX_INIT_WND_SIZE       14720  /* RFC 9002 s. 7.2 */
+
+enum {
+    BBR_STATE_STARTUP,
+    BBR_STATE_DRAIN,
+    BBR_STATE_PROBE_BW,
+    BBR_STATE_PROBE_RTT
+};
+
+typedef struct ossl_cc_bbr_st {
+    /* Dependencies. */
+    OSSL_TIME   (*now_cb)(void *arg);
+    void        *now_cb_arg;
+
+    /* 'Constants' derived from the maximum datagram size. */
+    uint64_t    k_init_wnd, k_min_wnd;
+
+    /* State. */
+    size_t      max_dgram_size;
+    int         state;
+    uint32_t    pacing_gain, cwnd_gain;
+    uint64_t    bytes_in_flight, cong_wnd, pacing_rate;
+
+    /* Round trip counting. */
+    uint64_t    delivered, next_round_delivered, round_count;
+    int         round_start;
+
+    /* Bandwidth filter: maximum delivery rate seen in each recent round. */
+    uint64_t    bw_samples[BBR_BW_FILTER_LEN];
+    uint64_t    max_bw;
+
+    /* Min RTT filter. */
+    OSSL_TIME   min_rtt, min_rtt_stamp;
+
+    /* Startup. */
+    uint64_t    full_bw;
+    int         full_bw_count, filled_pipe;
+
+    /* ProbeBW. */
+    int         cycle_idx;
+    OSSL_TIME   cycle_stamp;
+
+    /* ProbeRTT. */
+    OSSL_TIME   probe_rtt_done_stamp;
+    int         probe_rtt_round_done;
+    uint64_t    prior_cwnd;
+
+    /* Loss response. */
+    uint64_t    inflight_hi;
+    uint64_t    round_lost, round_start_delivered;
+    int         round_loss_handled;
+
+    /* Unflushed state during multiple on-loss calls. */
+    int         processing_loss;
+
+    /* Diagnostic output locations. */
+    size_t      *p_diag_max_dgram_payload_len;
+    uint64_t    *p_diag_cur_cwnd_size;
+    uint64_t    *p_diag_min_cwnd_size;
+    uint64_t    *p_diag_cur_bytes_in_flight;
+    uint32_t    *p_diag_cur_state;
+    uint64_t    *p_diag_cur_pacing_rate;
+    uint64_t    *p_diag_cur_bw_estimate;
+} OSSL_CC_BBR;
+
+static void bbr_set_max_dgram_size(OSSL_CC_BBR *bbr, size_t max_dgram_size);
+static void bbr_update_diag(OSSL_CC_BBR *bbr);
+static void bbr_reset(OSSL_CC_DATA *cc);
+
+static uint64_t bbr_apply_gain(uint64_t v, uint32_t gain)
+{
+    int err = 0;
+    uint64_t r = safe_muldiv_u64(v, gain, BBR_UNIT, &err);
+
+    return err ? UINT64_MAX : r;
+}
+
+static int bbr_have_model(const OSSL_CC_BBR *bbr)
+{
+    return bbr->max_bw > 0 && !ossl_time_is_infinite(bbr->min_rtt);
+}
+
+/* Returns the estimated bandwidth-delay product scaled by gain. */
+static uint64_t bbr_bdp(const OSSL_CC_BBR *bbr, uint32_t gain)
+{
+    int err = 0;
+    uint64_t bdp;
+
+    if (!bbr_have_model(bbr))
+        return bbr->k_init_wnd;
+
+    bdp = safe_muldiv_u64(bbr->max_bw, ossl_time2ticks(bbr->min_rtt),
+                          OSSL_TIME_SECOND, &err);
+    if (err)
+        return UINT64_MAX;
+
+    return bbr_apply_gain(bdp, gain);
+}
+
+static OSSL_CC_DATA *bbr_new(OSSL_TIME (*now_cb)(void *arg),
+                             void *now_cb_arg)
+{
+    OSSL_CC_BBR *bbr;
+
+    if ((bbr = OPENSSL_zalloc(sizeof(*bbr))) == NULL)
+        return NULL;
+
+    bbr->now_cb         = now_cb;
+    bbr->now_cb_arg     = now_cb_arg;
+
+    bbr_set_max_dgram_size(bbr, QUIC_MIN_INITIAL_DGRAM_LEN);
+    bbr_reset((OSSL_CC_DATA *)bbr);
+
+    return (OSSL_CC_DATA *)bbr;
+}
+
+static void bbr_free(OSSL_CC_DATA *cc)
+{
+    OPENSSL_free(cc);
+}
+
+static void bbr_set_max_dgram_size(OSSL_CC_BBR *bbr, size_t max_dgram_size)
+{
+    size_t max_init_wnd;
+    int is_reduced = (max_dgram_size < bbr->max_dgram_size);
+
+    bbr->max_dgram_size = max_dgram_size;
+
+    max_init_wnd = 2 * max_dgram_size;
+    if (max_init_wnd < MIN_MAX_INIT_WND_SIZE)
+        max_init_wnd = MIN_MAX_INIT_WND_SIZE;
+
+    bbr->k_init_wnd = 10 * max_dgram_size;
+    if (bbr->k_init_wnd > max_init_wnd)
+        bbr->k_init_wnd = max_init_wnd;
+
+    bbr->k_min_wnd = 4 * max_dgram_size;
+
+    if (is_reduced)
+        bbr->cong_wnd = bbr->k_init_wnd;
+
+    bbr_update_diag(bbr);
+}
+
+static void bbr_update_pacing_rate(OSSL_CC_BBR *bbr)
+{
+    uint64_t rate;
+    int err = 0;
+
+    if (bbr->max_bw > 0) {
+        rate = bbr_apply_gain(bbr->max_bw, bbr->pacing_gain);
+    } else {
+        /* No bandwidth sample yet, so pace the initial window over one RTT. */
+        rate = safe_muldiv_u64(bbr->k_init_wnd, OSSL_TIME_SECOND,
+                               ossl_time2ticks(ossl_time_is_infinite(bbr->min_rtt)
+                                               ? BBR_INITIAL_RTT
+                                               : bbr->min_rtt) + 1,
+                               &err);
+        rate = err ? UINT64_MAX : bbr_apply_gain(rate, bbr->pacing_gain);
+    }
+
+    /* Never pace slower than one datagram per initial RTT. */
+    if (rate < bbr->max_dgram_size * 3)
+        rate = bbr->max_dgram_size * 3;
+
+    bbr->pacing_rate = rate;
+}
+
+static void bbr_enter_startup(OSSL_CC_BBR *bbr)
+{
+    bbr->state          = BBR_STATE_STARTUP;
+    bbr->pacing_gain    = BBR_STARTUP_PACING_GAIN;
+    bbr->cwnd_gain      = BBR_STARTUP_CWND_GAIN;
+}
+
+static void bbr_enter_drain(OSSL_CC_BBR *bbr)
+{
+    bbr->state          = BBR_STATE_DRAIN;
+    bbr->pacing_gain    = BBR_DRAIN_PACING_GAIN;
+    bbr->cwnd_gain      = BBR_STARTUP_CWND_GAIN;
+}
+
+static void bbr_set_cycle_phase(OSSL_CC_BBR *bbr, int idx, OSSL_TIME now)
+{
+    bbr->cycle_idx      = idx;
+    bbr->cycle_stamp    = now;
+    bbr->pacing_gain    = bbr_probe_bw_gains[idx];
+
+    /*
+     * At the start of each bandwidth probe, allow more data in flight than the
+     * last level at which loss was too high, so that we discover if more
+     * capacity has become available.
+     */
+    if (idx == 0 && bbr->inflight_hi != UINT64_MAX)
+        bbr->inflight_hi = bbr_apply_gain(bbr->inflight_hi, 1250);
+}
+
+static void bbr_enter_probe_bw(OSSL_CC_BBR *bbr, OSSL_TIME now)
+{
+    bbr->state          = BBR_STATE_PROBE_BW;
+    bbr->cwnd_gain      = BBR_CWND_GAIN;
+
+    /*
+     * Start at a cruising phase chosen from the round count, so that flows
+     * sharing a bottleneck do not probe in lockstep. Never start in the drain
+     * phase (index 1).
+     */
+    bbr_set_cycle_phase(bbr, 2 + (int)(bbr->round_count % (BBR_NUM_CYCLE_PHASES - 2)),
+                        now);
+}
+
+static void bbr_reset(OSSL_CC_DATA *cc)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    bbr->cong_wnd               = bbr->k_init_wnd;
+    bbr->bytes_in_flight        = 0;
+
+    bbr->delivered              = 0;
+    bbr->next_round_delivered   = 0;
+    bbr->round_count            = 0;
+    bbr->round_start            = 0;
+
+    memset(bbr->bw_samples, 0, sizeof(bbr->bw_samples));
+    bbr->max_bw                 = 0;
+
+    bbr->min_rtt                = ossl_time_infinite();
+    bbr->min_rtt_stamp          = ossl_time_zero();
+
+    bbr->full_bw                = 0;
+    bbr->full_bw_count          = 0;
+    bbr->filled_pipe            = 0;
+
+    bbr->cycle_idx              = 0;
+    bbr->cycle_stamp            = ossl_time_zero();
+
+    bbr->probe_rtt_done_stamp   = ossl_time_zero();
+    bbr->probe_rtt_round_done   = 0;
+    bbr->prior_cwnd             = 0;
+
+    bbr->inflight_hi            = UINT64_MAX;
+    bbr->round_lost             = 0;
+    bbr->round_start_delivered  = 0;
+    bbr->round_loss_handled     = 0;
+    bbr->processing_loss        = 0;
+
+    bbr_enter_startup(bbr);
+    bbr_update_pacing_rate(bbr);
+}
+
+static int bbr_set_input_params(OSSL_CC_DATA *cc, const OSSL_PARAM *params)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+    const OSSL_PARAM *p;
+    size_t value;
+
+    p = OSSL_PARAM_locate_const(params, OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN);
+    if (p != NULL) {
+        if (!OSSL_PARAM_get_size_t(p, &value))
+            return 0;
+        if (value < QUIC_MIN_INITIAL_DGRAM_LEN)
+            return 0;
+
+        bbr_set_max_dgram_size(bbr, value);
+    }
+
+    return 1;
+}
+
+static int bind_diag(OSSL_PARAM *params, const char *param_name, size_t len,
+                     void **pp)
+{
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, param_name);
+
+    *pp = NULL;
+
+    if (p == NULL)
+        return 1;
+
+    if (p->data_type != OSSL_PARAM_UNSIGNED_INTEGER
+        || p->data_size != len)
+        return 0;
+
+    *pp = p->data;
+    return 1;
+}
+
+static int bbr_bind_diagnostic(OSSL_CC_DATA *cc, OSSL_PARAM *params)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+    size_t *new_p_max_dgram_payload_len;
+    uint64_t *new_p_cur_cwnd_size;
+    uint64_t *new_p_min_cwnd_size;
+    uint64_t *new_p_cur_bytes_in_flight;
+    uint32_t *new_p_cur_state;
+    uint64_t *new_p_cur_pacing_rate;
+    uint64_t *new_p_cur_bw_estimate;
+
+    if (!bind_diag(params, OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN,
+                   sizeof(size_t), (void **)&new_p_max_dgram_payload_len)
+        || !bind_diag(params, OSSL_CC_OPTION_CUR_CWND_SIZE,
+                      sizeof(uint64_t), (void **)&new_p_cur_cwnd_size)
+        || !bind_diag(params, OSSL_CC_OPTION_MIN_CWND_SIZE,
+                      sizeof(uint64_t), (void **)&new_p_min_cwnd_size)
+        || !bind_diag(params, OSSL_CC_OPTION_CUR_BYTES_IN_FLIGHT,
+                      sizeof(uint64_t), (void **)&new_p_cur_bytes_in_flight)
+        || !bind_diag(params, OSSL_CC_OPTION_CUR_STATE,
+                      sizeof(uint32_t), (void **)&new_p_cur_state)
+        || !bind_diag(params, OSSL_CC_OPTION_CUR_PACING_RATE,
+                      sizeof(uint64_t), (void **)&new_p_cur_pacing_rate)
+        || !bind_diag(params, OSSL_CC_OPTION_CUR_BW_ESTIMATE,
+                      sizeof(uint64_t), (void **)&new_p_cur_bw_estimate))
+        return 0;
+
+    if (new_p_max_dgram_payload_len != NULL)
+        bbr->p_diag_max_dgram_payload_len = new_p_max_dgram_payload_len;
+
+    if (new_p_cur_cwnd_size != NULL)
+        bbr->p_diag_cur_cwnd_size = new_p_cur_cwnd_size;
+
+    if (new_p_min_cwnd_size != NULL)
+        bbr->p_diag_min_cwnd_size = new_p_min_cwnd_size;
+
+    if (new_p_cur_bytes_in_flight != NULL)
+        bbr->p_diag_cur_bytes_in_flight = new_p_cur_bytes_in_flight;
+
+    if (new_p_cur_state != NULL)
+        bbr->p_diag_cur_state = new_p_cur_state;
+
+    if (new_p_cur_pacing_rate != NULL)
+        bbr->p_diag_cur_pacing_rate = new_p_cur_pacing_rate;
+
+    if (new_p_cur_bw_estimate != NULL)
+        bbr->p_diag_cur_bw_estimate = new_p_cur_bw_estimate;
+
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static void unbind_diag(OSSL_PARAM *params, const char *param_name,
+                        void **pp)
+{
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, param_name);
+
+    if (p != NULL)
+        *pp = NULL;
+}
+
+static int bbr_unbind_diagnostic(OSSL_CC_DATA *cc, OSSL_PARAM *params)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    unbind_diag(params, OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN,
+                (void **)&bbr->p_diag_max_dgram_payload_len);
+    unbind_diag(params, OSSL_CC_OPTION_CUR_CWND_SIZE,
+                (void **)&bbr->p_diag_cur_cwnd_size);
+    unbind_diag(params, OSSL_CC_OPTION_MIN_CWND_SIZE,
+                (void **)&bbr->p_diag_min_cwnd_size);
+    unbind_diag(params, OSSL_CC_OPTION_CUR_BYTES_IN_FLIGHT,
+                (void **)&bbr->p_diag_cur_bytes_in_flight);
+    unbind_diag(params, OSSL_CC_OPTION_CUR_STATE,
+                (void **)&bbr->p_diag_cur_state);
+    unbind_diag(params, OSSL_CC_OPTION_CUR_PACING_RATE,
+                (void **)&bbr->p_diag_cur_pacing_rate);
+    unbind_diag(params, OSSL_CC_OPTION_CUR_BW_ESTIMATE,
+                (void **)&bbr->p_diag_cur_bw_estimate);
+    return 1;
+}
+
+static void bbr_update_diag(OSSL_CC_BBR *bbr)
+{
+    if (bbr->p_diag_max_dgram_payload_len != NULL)
+        *bbr->p_diag_max_dgram_payload_len = bbr->max_dgram_size;
+
+    if (bbr->p_diag_cur_cwnd_size != NULL)
+        *bbr->p_diag_cur_cwnd_size = bbr->cong_wnd;
+
+    if (bbr->p_diag_min_cwnd_size != NULL)
+        *bbr->p_diag_min_cwnd_size = bbr->k_min_wnd;
+
+    if (bbr->p_diag_cur_bytes_in_flight != NULL)
+        *bbr->p_diag_cur_bytes_in_flight = bbr->bytes_in_flight;
+
+    if (bbr->p_diag_cur_state != NULL) {
+        switch (bbr->state) {
+        case BBR_STATE_STARTUP:
+            *bbr->p_diag_cur_state = 'S';
+            break;
+        case BBR_STATE_DRAIN:
+            *bbr->p_diag_cur_state = 'D';
+            break;
+        case BBR_STATE_PROBE_BW:
+            *bbr->p_diag_cur_state = 'B';
+            break;
+        case BBR_STATE_PROBE_RTT:
+            *bbr->p_diag_cur_state = 'R';
+            break;
+        }
+    }
+
+    if (bbr->p_diag_cur_pacing_rate != NULL)
+        *bbr->p_diag_cur_pacing_rate = bbr->pacing_rate;
+
+    if (bbr->p_diag_cur_bw_estimate != NULL)
+        *bbr->p_diag_cur_bw_estimate = bbr->max_bw;
+}
+
+static void bbr_update_round(OSSL_CC_BBR *bbr, const OSSL_CC_ACK_INFO *info)
+{
+    bbr->round_start = 0;
+
+    if (info->tx_delivered < bbr->next_round_delivered)
+        return;
+
+    /* A packet sent after the previous round started has been acked. */
+    bbr->next_round_delivered   = bbr->delivered;
+    bbr->round_start            = 1;
+    ++bbr->round_count;
+
+    bbr->bw_samples[bbr->round_count % BBR_BW_FILTER_LEN] = 0;
+
+    bbr->round_lost             = 0;
+    bbr->round_start_delivered  = bbr->delivered;
+    bbr->round_loss_handled     = 0;
+}
+
+static void bbr_update_bw(OSSL_CC_BBR *bbr, const OSSL_CC_ACK_INFO *info)
+{
+    uint64_t bw, *slot;
+    size_t i;
+    int err = 0;
+
+    if (ossl_time_is_zero(info->interval) || info->delivered == 0)
+        return;
+
+    /*
+     * A sample taken over less than the minimum RTT is likely to be inflated
+     * by ACK compression, so ignore it.
+     */
+    if (!ossl_time_is_infinite(bbr->min_rtt)
+        && ossl_time_compare(info->interval, bbr->min_rtt) < 0)
+        return;
+
+    bw = safe_muldiv_u64(info->delivered, OSSL_TIME_SECOND,
+                         ossl_time2ticks(info->interval), &err);
+    if (err)
+        return;
+
+    slot = &bbr->bw_samples[bbr->round_count % BBR_BW_FILTER_LEN];
+    if (bw > *slot)
+        *slot = bw;
+
+    bbr->max_bw = 0;
+    for (i = 0; i < BBR_BW_FILTER_LEN; ++i)
+        if (bbr->bw_samples[i] > bbr->max_bw)
+            bbr->max_bw = bbr->bw_samples[i];
+}
+
+/* Returns 1 if the min RTT estimate has expired. */
+static int bbr_update_min_rtt(OSSL_CC_BBR *bbr, const OSSL_CC_ACK_INFO *info,
+                              OSSL_TIME now)
+{
+    OSSL_TIME rtt = ossl_time_subtract(now, info->tx_time);
+    int expired;
+
+    expired = !ossl_time_is_zero(bbr->min_rtt_stamp)
+        && ossl_time_compare(now, ossl_time_add(bbr->min_rtt_stamp,
+                                                BBR_MIN_RTT_FILTER_LEN)) > 0;
+
+    if (!ossl_time_is_zero(rtt)
+        && (expired || ossl_time_compare(rtt, bbr->min_rtt) < 0)) {
+        bbr->min_rtt        = rtt;
+        bbr->min_rtt_stamp  = now;
+    }
+
+    return expired;
+}
+
+static void bbr_check_full_pipe(OSSL_CC_BBR *bbr)
+{
+    if (bbr->filled_pipe || !bbr->round_start)
+        return;
+
+    if (bbr->max_bw >= bbr_apply_gain(bbr->full_bw, BBR_FULL_BW_THRESH)) {
+        bbr->full_bw        = bbr->max_bw;
+        bbr->full_bw_count  = 0;
+        return;
+    }
+
+    if (++bbr->full_bw_count >= BBR_FULL_BW_COUNT)
+        bbr->filled_pipe = 1;
+}
+
+static void bbr_update_probe_bw_cycle(OSSL_CC_BBR *bbr, OSSL_TIME now)
+{
+    int full_length, advance;
+    OSSL_TIME phase_len;
+
+    phase_len = ossl_time_is_infinite(bbr->min_rtt)
+        ? BBR_INITIAL_RTT : bbr->min_rtt;
+    full_length = ossl_time_compare(ossl_time_subtract(now, bbr->cycle_stamp),
+                                    phase_len) > 0;
+
+    switch (bbr->cycle_idx) {
+    case 0:
+        /*
+         * Probe for more bandwidth until we have actually put the extra data
+         * in flight, or until loss tells us there is no more room. Give up
+         * after two phase lengths in case we are application-limited.
+         */
+        advance = full_length
+            && (bbr->bytes_in_flight >= bbr_bdp(bbr, bbr->pacing_gain)
+                || bbr->round_loss_handled
+                || ossl_time_compare(ossl_time_subtract(now, bbr->cycle_stamp),
+                                     ossl_time_multiply(phase_len, 2)) > 0);
+        break;
+    case 1:
+        /* Drain any queue created by probing. */
+        advance = full_length
+            || bbr->bytes_in_flight <= bbr_bdp(bbr, BBR_UNIT);
+        break;
+    default:
+        advance = full_length;
+        break;
+    }
+
+    if (advance)
+        bbr_set_cycle_phase(bbr, (bbr->cycle_idx + 1) % BBR_NUM_CYCLE_PHASES,
+                            now);
+}
+
+static void bbr_update_probe_rtt(OSSL_CC_BBR *bbr, int min_rtt_expired,
+                                 OSSL_TIME now)
+{
+    if (bbr->state != BBR_STATE_PROBE_RTT) {
+        if (!min_rtt_expired)
+            return;
+
+        /*
+         * We have not seen a new minimum RTT for a while, so briefly reduce
+         * the data in flight to drain any queue and measure the RTT again.
+         */
+        bbr->prior_cwnd             = bbr->cong_wnd;
+        bbr->state                  = BBR_STATE_PROBE_RTT;
+        bbr->pacing_gain            = BBR_UNIT;
+        bbr->cwnd_gain              = BBR_UNIT;
+        bbr->probe_rtt_done_stamp   = ossl_time_zero();
+        bbr->probe_rtt_round_done   = 0;
+        return;
+    }
+
+    if (ossl_time_is_zero(bbr->probe_rtt_done_stamp)) {
+        if (bbr->bytes_in_flight <= bbr->k_min_wnd) {
+            bbr->probe_rtt_done_stamp
+                = ossl_time_add(now, BBR_PROBE_RTT_DURATION);
+            bbr->probe_rtt_round_done   = 0;
+            bbr->next_round_delivered   = bbr->delivered;
+        }
+
+        return;
+    }
+
+    if (bbr->round_start)
+        bbr->probe_rtt_round_done = 1;
+
+    if (!bbr->probe_rtt_round_done
+        || ossl_time_compare(now, bbr->probe_rtt_done_stamp) < 0)
+        return;
+
+    bbr->min_rtt_stamp = now;
+    if (bbr->cong_wnd < bbr->prior_cwnd)
+        bbr->cong_wnd = bbr->prior_cwnd;
+
+    if (bbr->filled_pipe)
+        bbr_enter_probe_bw(bbr, now);
+    else
+        bbr_enter_startup(bbr);
+}
+
+static void bbr_update_cwnd(OSSL_CC_BBR *bbr, uint64_t acked)
+{
+    uint64_t target, cwnd = bbr->cong_wnd;
+    int err = 0;
+
+    if (bbr_have_model(bbr)) {
+        target = safe_add_u64(bbr_bdp(bbr, bbr->cwnd_gain),
+                              3 * bbr->max_dgram_size, &err);
+        if (err)
+            target = UINT64_MAX;
+    } else {
+        target = UINT64_MAX;
+    }
+
+    cwnd = safe_add_u64(cwnd, acked, &err);
+    if (err)
+        cwnd = UINT64_MAX;
+
+    /*
+     * Once the pipe is full, converge on the target. Before that, grow as in
+     * slow start so that the bandwidth estimate can catch up.
+     */
+    if (bbr->filled_pipe && cwnd > target)
+        cwnd = target;
+
+    if (cwnd > bbr->inflight_hi)
+        cwnd = bbr->inflight_hi;
+
+    if (bbr->state == BBR_STATE_PROBE_RTT && cwnd > bbr->k_min_wnd)
+        cwnd = bbr->k_min_wnd;
+
+    if (cwnd < bbr->k_min_wnd)
+        cwnd = bbr->k_min_wnd;
+
+    bbr->cong_wnd = cwnd;
+}
+
+/*
+ * Called when the loss rate in the current round has exceeded BBR_LOSS_THRESH
+ * (or on an ECN-CE signal). Cap the data in flight, at most once per round.
+ */
+static void bbr_on_inflight_too_high(OSSL_CC_BBR *bbr)
+{
+    uint64_t cap;
+
+    if (bbr->round_loss_handled)
+        return;
+
+    bbr->round_loss_handled = 1;
+
+    if (bbr->state == BBR_STATE_STARTUP) {
+        bbr->filled_pipe = 1;
+        bbr_enter_drain(bbr);
+    }
+
+    /*
+     * Do not cap below the estimated BDP: as long as the bandwidth estimate
+     * holds up, the loss is not caused by us overfilling the bottleneck
+     * queue. If the bottleneck really is congested, the delivery rate and thus
+     * the BDP fall as well.
+     */
+    cap = bbr_apply_gain(bbr->cong_wnd, BBR_BETA);
+    if (bbr_have_model(bbr) && cap < bbr_bdp(bbr, BBR_UNIT))
+        cap = bbr_bdp(bbr, BBR_UNIT);
+
+    if (cap < bbr->k_min_wnd)
+        cap = bbr->k_min_wnd;
+
+    bbr->inflight_hi = cap;
+    if (bbr->cong_wnd > cap)
+        bbr->cong_wnd = cap;
+
+    bbr_update_pacing_rate(bbr);
+}
+
+static void bbr_check_loss(OSSL_CC_BBR *bbr)
+{
+    uint64_t round_delivered = bbr->delivered - bbr->round_start_delivered;
+    int err = 0;
+    uint64_t lhs, rhs;
+
+    if (bbr->round_lost == 0)
+        return;
+
+    lhs = safe_mul_u64(bbr->round_lost, BBR_LOSS_THRESH_DEN, &err);
+    rhs = safe_mul_u64(safe_add_u64(bbr->round_lost, round_delivered, &err),
+                       BBR_LOSS_THRESH_NUM, &err);
+
+    if (!err && lhs > rhs)
+        bbr_on_inflight_too_high(bbr);
+}
+
+static uint64_t bbr_get_tx_allowance(OSSL_CC_DATA *cc)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    if (bbr->bytes_in_flight >= bbr->cong_wnd)
+        return 0;
+
+    return bbr->cong_wnd - bbr->bytes_in_flight;
+}
+
+static OSSL_TIME bbr_get_wakeup_deadline(OSSL_CC_DATA *cc)
+{
+    if (bbr_get_tx_allowance(cc) > 0)
+        return ossl_time_zero();
+
+    /* The window only changes in response to acknowledgement or loss. */
+    return ossl_time_infinite();
+}
+
+static uint64_t bbr_get_pacing_rate(OSSL_CC_DATA *cc)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    return bbr->pacing_rate;
+}
+
+static int bbr_on_data_sent(OSSL_CC_DATA *cc, uint64_t num_bytes)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    bbr->bytes_in_flight += num_bytes;
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static int bbr_on_data_acked(OSSL_CC_DATA *cc, const OSSL_CC_ACK_INFO *info)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+    OSSL_TIME now = bbr->now_cb(bbr->now_cb_arg);
+    int min_rtt_expired;
+
+    if (info->tx_size > bbr->bytes_in_flight)
+        return 0;
+
+    bbr->bytes_in_flight -= info->tx_size;
+    bbr->delivered       += info->tx_size;
+
+    bbr_update_round(bbr, info);
+    bbr_update_bw(bbr, info);
+    min_rtt_expired = bbr_update_min_rtt(bbr, info, now);
+
+    bbr_check_full_pipe(bbr);
+
+    if (bbr->state == BBR_STATE_STARTUP && bbr->filled_pipe)
+        bbr_enter_drain(bbr);
+
+    if (bbr->state == BBR_STATE_DRAIN
+        && bbr->bytes_in_flight <= bbr_bdp(bbr, BBR_UNIT))
+        bbr_enter_probe_bw(bbr, now);
+
+    if (bbr->state == BBR_STATE_PROBE_BW)
+        bbr_update_probe_bw_cycle(bbr, now);
+
+    bbr_update_probe_rtt(bbr, min_rtt_expired, now);
+
+    bbr_update_pacing_rate(bbr);
+    bbr_update_cwnd(bbr, info->tx_size);
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static int bbr_on_data_lost(OSSL_CC_DATA *cc, const OSSL_CC_LOSS_INFO *info)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    if (info->tx_size > bbr->bytes_in_flight)
+        return 0;
+
+    bbr->bytes_in_flight    -= info->tx_size;
+    bbr->round_lost         += info->tx_size;
+    bbr->processing_loss     = 1;
+
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static int bbr_on_data_lost_finished(OSSL_CC_DATA *cc, uint32_t flags)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    if (!bbr->processing_loss)
+        return 1;
+
+    bbr->processing_loss = 0;
+
+    bbr_check_loss(bbr);
+
+    /*
+     * Nothing has been delivered for several PTOs. Restart from the minimum
+     * window; it grows back towards the model's target as ACKs arrive.
+     */
+    if ((flags & OSSL_CC_LOST_FLAG_PERSISTENT_CONGESTION) != 0)
+        bbr->cong_wnd = bbr->k_min_wnd;
+
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static int bbr_on_data_invalidated(OSSL_CC_DATA *cc, uint64_t num_bytes)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    bbr->bytes_in_flight -= num_bytes;
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+static int bbr_on_ecn(OSSL_CC_DATA *cc, const OSSL_CC_ECN_INFO *info)
+{
+    OSSL_CC_BBR *bbr = (OSSL_CC_BBR *)cc;
+
+    bbr_on_inflight_too_high(bbr);
+    bbr_update_diag(bbr);
+    return 1;
+}
+
+const OSSL_CC_METHOD ossl_cc_bbr_method = {
+    bbr_new,
+    bbr_free,
+    bbr_reset,
+    bbr_set_input_params,
+    bbr_bind_diagnostic,
+    bbr_unbind_diagnostic,
+    bbr_get_tx_allowance,
+    bbr_get_wakeup_deadline,
+    bbr_get_pacing_rate,
+    bbr_on_data_sent,
+    bbr_on_data_acked,
+    bbr_on_data_lost,
+    bbr_on_data_lost_finished,
+    bbr_on_data_invalidated,
+    bbr_on_ecn,
+};
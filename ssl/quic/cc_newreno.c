@@ -18,6 +18,7 @@ typedef struct ossl_cc_newreno_st {
     size_t      max_dgram_size;
     uint64_t    bytes_in_flight, cong_wnd, slow_start_thresh, bytes_acked;
     OSSL_TIME   cong_recovery_start_time;
+    OSSL_TIME   smoothed_rtt; /* from the ACKM, used only for pacing */
 
     /* Unflushed state during multiple on-loss calls. */
     int         processing_loss; /* 1 if not flushed */
@@ -36,7 +37,16 @@ typedef struct ossl_cc_newreno_st {
 
 #define MIN_MAX_INIT_WND_SIZE    14720  /* RFC 9002 s. 7.2 */
 
-/* TODO(QUIC FUTURE): Pacing support. */
+/*
+ * Pacing gains in percent. RFC 9002 s. 7.7 suggests pacing at 1.25 times
+ * cwnd/smoothed_rtt. We pace faster during slow start so that the pacer does not
+ * limit the growth of the congestion window.
+ */
+#define PACING_GAIN_SLOW_START          200
+#define PACING_GAIN_CONG_AVOIDANCE      125
+
+/* RTT used for pacing before we have an RTT sample (RFC 9002 s. 6.2.2). */
+#define PACING_INITIAL_RTT              ossl_ms2time(333)
 
 static void newreno_set_max_dgram_size(OSSL_CC_NEWRENO *nr,
                                        size_t max_dgram_size);
@@ -103,6 +113,7 @@ static void newreno_reset(OSSL_CC_DATA *cc)
     nr->bytes_acked                 = 0;
     nr->slow_start_thresh           = UINT64_MAX;
     nr->cong_recovery_start_time    = ossl_time_zero();
+    nr->smoothed_rtt                = ossl_time_zero();
 
     nr->processing_loss         = 0;
     nr->tx_time_of_last_loss    = ossl_time_zero();
@@ -114,6 +125,7 @@ static int newreno_set_input_params(OSSL_CC_DATA *cc, const OSSL_PARAM *params)
     OSSL_CC_NEWRENO *nr = (OSSL_CC_NEWRENO *)cc;
     const OSSL_PARAM *p;
     size_t value;
+    uint64_t rtt;
 
     p = OSSL_PARAM_locate_const(params, OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN);
     if (p != NULL) {
@@ -125,6 +137,14 @@ static int newreno_set_input_params(OSSL_CC_DATA *cc, const OSSL_PARAM *params)
         newreno_set_max_dgram_size(nr, value);
     }
 
+    p = OSSL_PARAM_locate_const(params, OSSL_CC_OPTION_SMOOTHED_RTT);
+    if (p != NULL) {
+        if (!OSSL_PARAM_get_uint64(p, &rtt))
+            return 0;
+
+        nr->smoothed_rtt = ossl_ticks2time(rtt);
+    }
+
     return 1;
 }
 
@@ -308,6 +328,26 @@ static OSSL_TIME newreno_get_wakeup_deadline(OSSL_CC_DATA *cc)
     }
 }
 
+static uint64_t newreno_get_pacing_rate(OSSL_CC_DATA *cc)
+{
+    OSSL_CC_NEWRENO *nr = (OSSL_CC_NEWRENO *)cc;
+    OSSL_TIME rtt = nr->smoothed_rtt;
+    uint64_t gain, rate;
+    int err = 0;
+
+    if (ossl_time_is_zero(rtt))
+        rtt = PACING_INITIAL_RTT;
+
+    gain = (nr->cong_wnd < nr->slow_start_thresh)
+        ? PACING_GAIN_SLOW_START : PACING_GAIN_CONG_AVOIDANCE;
+
+    /* rate = cong_wnd * gain / smoothed_rtt */
+    rate = safe_muldiv_u64(nr->cong_wnd, gain * OSSL_TIME_SECOND,
+                           100 * ossl_time2ticks(rtt), &err);
+
+    return err ? UINT64_MAX : rate;
+}
+
 static int newreno_on_data_sent(OSSL_CC_DATA *cc, uint64_t num_bytes)
 {
     OSSL_CC_NEWRENO *nr = (OSSL_CC_NEWRENO *)cc;
@@ -476,6 +516,7 @@ const OSSL_CC_METHOD ossl_cc_newreno_method = {
     newreno_unbind_diagnostic,
     newreno_get_tx_allowance,
     newreno_get_wakeup_deadline,
+    newreno_get_pacing_rate,
     newreno_on_data_sent,
     newreno_on_data_acked,
     newreno_on_data_lost,
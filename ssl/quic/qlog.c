@@ -11,7 +11,10 @@
 #include "internal/json_enc.h"
 #include "internal/common.h"
 #include "internal/cryptlib.h"
+#include "internal/list.h"
+#include "internal/thread_arch.h"
 #include "crypto/ctype.h"
+#include <openssl/rand.h>
 
 #define BITS_PER_WORD (sizeof(size_t) * 8)
 #define NUM_ENABLED_W ((QLOG_EVENT_TYPE_NUM + BITS_PER_WORD - 1) / BITS_PER_WORD)
@@ -31,6 +34,49 @@ static ossl_unused ossl_inline void bit_set(size_t *p, uint32_t bit_no, int enab
         p[bit_no / BITS_PER_WORD] &= ~mask;
 }
 
+/* Default size of the ring buffer of an asynchronous QLOG in bytes. */
+#define QLOG_RING_DEFAULT_SIZE      (64 * 1024)
+
+/* Maximum size of a single binary event record; larger events are dropped. */
+#define QLOG_STAGE_SIZE             (16 * 1024)
+
+/* Interval at which the writer drains ring buffers if not woken earlier. */
+#define QLOG_WRITER_INTERVAL_MS     100
+
+/*
+ * Binary event records. Each record starts with a QLOG_REC_HDR and is followed
+ * by a sequence of operations, each a single opcode byte, optionally followed
+ * by a NUL-terminated field name if QLOG_OP_NAMED is set, then by the value.
+ * Records are only ever read back by the process which wrote them, so
+ * integers are stored in host byte order.
+ */
+typedef struct qlog_rec_hdr_st {
+    uint32_t        len;            /* including this header */
+    uint32_t        event_type;
+    uint64_t        time;           /* ticks */
+} QLOG_REC_HDR;
+
+enum {
+    QLOG_OP_GROUP_BEGIN = 1,
+    QLOG_OP_GROUP_END,
+    QLOG_OP_ARRAY_BEGIN,
+    QLOG_OP_ARRAY_END,
+    QLOG_OP_STR,                    /* uint32_t length, data */
+    QLOG_OP_BIN,                    /* uint32_t length, data */
+    QLOG_OP_U64,                    /* uint64_t */
+    QLOG_OP_I64,                    /* int64_t */
+    QLOG_OP_BOOL                    /* unsigned char */
+};
+
+#define QLOG_OP_NAMED   0x80
+
+static const char *const event_names[QLOG_EVENT_TYPE_NUM] = {
+    NULL,
+#define QLOG_EVENT(e_cat, e_name) #e_cat ":" #e_name,
+#include "internal/qlog_events.h"
+#undef QLOG_EVENT
+};
+
 struct qlog_st {
     QLOG_TRACE_INFO info;
 
@@ -41,8 +87,42 @@ struct qlog_st {
     OSSL_TIME       event_time, prev_event_time;
     OSSL_JSON_ENC   json;
     int             header_done, first_event_done;
+
+    /*
+     * Asynchronous mode state; ring is non-NULL iff attached to a writer. The
+     * producer (the thread generating events) builds each record in stage and
+     * then copies it into the ring, advancing ring_head; the writer advances
+     * ring_tail as it consumes records. Each side only ever reads the other
+     * side's index atomically, so neither blocks the other.
+     */
+    QLOG_WRITER     *writer;
+    OSSL_LIST_MEMBER(qlog, QLOG);
+    CRYPTO_RWLOCK   *ring_lock; /* for CRYPTO_atomic_* without atomics */
+    unsigned char   *ring, *stage;
+    size_t          ring_size, stage_len;
+    uint64_t        ring_head, ring_tail;
+    uint64_t        num_dropped, num_dropped_reported;
+    int             stage_overflow;
 };
 
+DEFINE_LIST_OF(qlog, QLOG);
+
+#define QLOG_ASYNC(qlog)    ((qlog)->ring != NULL)
+
+#ifndef OPENSSL_NO_QLOG_ASYNC
+struct qlog_writer_st {
+    /* Protects qlogs and the JSON encoders and sinks of the QLOGs in it. */
+    CRYPTO_MUTEX        *mutex;
+    CRYPTO_CONDVAR      *cv;
+    CRYPTO_THREAD       *t;
+    OSSL_LIST(qlog)     qlogs;
+    unsigned char       *buf;   /* QLOG_STAGE_SIZE bytes */
+    unsigned int        stop    : 1;
+};
+
+static void qlog_drain(QLOG *qlog, unsigned char *buf);
+#endif
+
 static OSSL_TIME default_now(void *arg)
 {
     return ossl_time_now();
@@ -102,11 +182,67 @@ err:
     return NULL;
 }
 
+/*
+ * Parses a probability given as a decimal fraction in [0, 1] (e.g. "0.01")
+ * into parts per million. Digits beyond the sixth decimal place are ignored.
+ */
+static int parse_probability(const char *s, uint32_t *ppm)
+{
+    uint32_t v = 0, scale = 1000000;
+
+    if (*s == '1') {
+        v = 1000000;
+        if (*++s == '.')
+            for (++s; *s == '0'; ++s);
+    } else {
+        if (*s == '0')
+            ++s;
+
+        if (*s == '.')
+            for (++s; ossl_isdigit(*s); ++s) {
+                scale /= 10;
+                v += (uint32_t)(*s - '0') * scale;
+            }
+    }
+
+    if (*s != '\0')
+        return 0;
+
+    *ppm = v;
+    return 1;
+}
+
+/*
+ * Decides whether a new connection should be logged, given the value of the
+ * OSSL_QLOG_SAMPLE environment variable. A malformed value logs nothing.
+ */
+static int qlog_sample(OSSL_LIB_CTX *libctx, const char *qsample)
+{
+    uint32_t ppm, r;
+
+    if (!parse_probability(qsample, &ppm))
+        return 0;
+
+    if (ppm >= 1000000)
+        return 1;
+
+    if (ppm == 0
+        || RAND_bytes_ex(libctx, (unsigned char *)&r, sizeof(r), 0) <= 0)
+        return 0;
+
+    return r % 1000000 < ppm;
+}
+
 QLOG *ossl_qlog_new_from_env(const QLOG_TRACE_INFO *info)
 {
     QLOG *qlog = NULL;
     const char *qlogdir = ossl_safe_getenv("QLOGDIR");
     const char *qfilter = ossl_safe_getenv("OSSL_QFILTER");
+    const char *qsample = ossl_safe_getenv("OSSL_QLOG_SAMPLE");
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    const char *qasync = ossl_safe_getenv("OSSL_QLOG_ASYNC");
+    QLOG_WRITER *writer;
+#endif
     char qlogdir_sep, *filename = NULL;
     size_t i, l, strl;
 
@@ -117,6 +253,9 @@ QLOG *ossl_qlog_new_from_env(const QLOG_TRACE_INFO *info)
     if (l == 0)
         return NULL;
 
+    if (qsample != NULL && qsample[0] != '\0' && !qlog_sample(info->libctx, qsample))
+        return NULL;
+
     qlogdir_sep = ossl_determine_dirsep(qlogdir);
 
     /* dir; [sep]; ODCID; _; strlen("client" / "server"); strlen(".sqlog"); NUL */
@@ -148,6 +287,14 @@ QLOG *ossl_qlog_new_from_env(const QLOG_TRACE_INFO *info)
     if (!ossl_qlog_set_filter(qlog, qfilter))
         goto err;
 
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    /* Fall back to synchronous output if no writer is available. */
+    if (qasync != NULL && strcmp(qasync, "1") == 0
+        && info->get_writer_cb != NULL
+        && (writer = info->get_writer_cb(info->get_writer_cb_arg)) != NULL)
+        ossl_qlog_set_writer(qlog, writer, 0);
+#endif
+
     OPENSSL_free(filename);
     return qlog;
 
@@ -162,6 +309,18 @@ void ossl_qlog_free(QLOG *qlog)
     if (qlog == NULL)
         return;
 
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    if (qlog->writer != NULL) {
+        ossl_crypto_mutex_lock(qlog->writer->mutex);
+        qlog_drain(qlog, qlog->writer->buf);
+        ossl_list_qlog_remove(&qlog->writer->qlogs, qlog);
+        ossl_crypto_mutex_unlock(qlog->writer->mutex);
+    }
+#endif
+
+    OPENSSL_free(qlog->ring);
+    OPENSSL_free(qlog->stage);
+    CRYPTO_THREAD_lock_free(qlog->ring_lock);
     ossl_json_flush_cleanup(&qlog->json);
     BIO_free_all(qlog->bio);
     OPENSSL_free((char *)qlog->info.title);
@@ -175,15 +334,48 @@ void ossl_qlog_free(QLOG *qlog)
  * Configuration
  * =============
  */
+
+/*
+ * When a QLOG is attached to a writer, its JSON encoder and sink belong to the
+ * writer thread, so anything else touching them must hold the writer mutex.
+ */
+static void qlog_sink_lock(QLOG *qlog)
+{
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    if (qlog->writer != NULL)
+        ossl_crypto_mutex_lock(qlog->writer->mutex);
+#endif
+}
+
+static void qlog_sink_unlock(QLOG *qlog)
+{
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    if (qlog->writer != NULL)
+        ossl_crypto_mutex_unlock(qlog->writer->mutex);
+#endif
+}
+
+static int qlog_flush_locked(QLOG *qlog)
+{
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    if (qlog->writer != NULL)
+        qlog_drain(qlog, qlog->writer->buf);
+#endif
+
+    return ossl_json_flush(&qlog->json);
+}
+
 int ossl_qlog_set_sink_bio(QLOG *qlog, BIO *bio)
 {
     if (qlog == NULL)
         return 0;
 
-    ossl_qlog_flush(qlog); /* best effort */
+    qlog_sink_lock(qlog);
+    qlog_flush_locked(qlog); /* best effort */
     BIO_free_all(qlog->bio);
     qlog->bio = bio;
     ossl_json_set0_sink(&qlog->json, bio);
+    qlog_sink_unlock(qlog);
     return 1;
 }
 
@@ -235,10 +427,15 @@ int ossl_qlog_set_sink_filename(QLOG *qlog, const char *filename)
 
 int ossl_qlog_flush(QLOG *qlog)
 {
+    int ok;
+
     if (qlog == NULL)
         return 1;
 
-    return ossl_json_flush(&qlog->json);
+    qlog_sink_lock(qlog);
+    ok = qlog_flush_locked(qlog);
+    qlog_sink_unlock(qlog);
+    return ok;
 }
 
 int ossl_qlog_set_event_type_enabled(QLOG *qlog, uint32_t event_type,
@@ -359,34 +556,34 @@ static void qlog_event_seq_header(QLOG *qlog)
     qlog->header_done = 1;
 }
 
-static void qlog_event_prologue(QLOG *qlog)
+static void qlog_event_prologue(QLOG *qlog, const char *event_combined_name)
 {
     qlog_event_seq_header(qlog);
 
     ossl_json_object_begin(&qlog->json);
 
     ossl_json_key(&qlog->json, "name");
-    ossl_json_str(&qlog->json, qlog->event_combined_name);
+    ossl_json_str(&qlog->json, event_combined_name);
 
     ossl_json_key(&qlog->json, "data");
     ossl_json_object_begin(&qlog->json);
 }
 
-static void qlog_event_epilogue(QLOG *qlog)
+static void qlog_event_epilogue(QLOG *qlog, OSSL_TIME event_time)
 {
     ossl_json_object_end(&qlog->json);
 
     ossl_json_key(&qlog->json, "time");
     if (!qlog->first_event_done) {
-        ossl_json_u64(&qlog->json, ossl_time2ms(qlog->event_time));
-        qlog->prev_event_time = qlog->event_time;
+        ossl_json_u64(&qlog->json, ossl_time2ms(event_time));
+        qlog->prev_event_time = event_time;
         qlog->first_event_done = 1;
     } else {
-        OSSL_TIME delta = ossl_time_subtract(qlog->event_time,
+        OSSL_TIME delta = ossl_time_subtract(event_time,
                                              qlog->prev_event_time);
 
         ossl_json_u64(&qlog->json, ossl_time2ms(delta));
-        qlog->prev_event_time = qlog->event_time;
+        qlog->prev_event_time = event_time;
     }
 
     ossl_json_object_end(&qlog->json);
@@ -411,25 +608,157 @@ int ossl_qlog_event_try_begin(QLOG *qlog,
     qlog->event_combined_name   = event_combined_name;
     qlog->event_time            = qlog->info.now_cb(qlog->info.now_cb_arg);
 
-    qlog_event_prologue(qlog);
+    if (QLOG_ASYNC(qlog)) {
+        /* The header is filled in by qlog_rec_commit(). */
+        qlog->stage_len         = sizeof(QLOG_REC_HDR);
+        qlog->stage_overflow    = 0;
+        return 1;
+    }
+
+    qlog_event_prologue(qlog, event_combined_name);
     return 1;
 }
 
+static void qlog_rec_commit(QLOG *qlog);
+
 void ossl_qlog_event_end(QLOG *qlog)
 {
     if (!ossl_assert(qlog != NULL && qlog->event_type != QLOG_EVENT_TYPE_NONE))
         return;
 
-    qlog_event_epilogue(qlog);
+    if (QLOG_ASYNC(qlog))
+        qlog_rec_commit(qlog);
+    else
+        qlog_event_epilogue(qlog, qlog->event_time);
+
     qlog->event_type = QLOG_EVENT_TYPE_NONE;
 }
 
+/*
+ * Binary Event Records
+ * ====================
+ */
+static void rec_put(QLOG *qlog, const void *p, size_t len)
+{
+    if (qlog->stage_overflow || QLOG_STAGE_SIZE - qlog->stage_len < len) {
+        qlog->stage_overflow = 1;
+        return;
+    }
+
+    memcpy(qlog->stage + qlog->stage_len, p, len);
+    qlog->stage_len += len;
+}
+
+static void rec_op(QLOG *qlog, unsigned char op, const char *name)
+{
+    if (name != NULL)
+        op |= QLOG_OP_NAMED;
+
+    rec_put(qlog, &op, sizeof(op));
+    if (name != NULL)
+        rec_put(qlog, name, strlen(name) + 1);
+}
+
+static void rec_data(QLOG *qlog, unsigned char op, const char *name,
+                     const void *p, size_t len)
+{
+    uint32_t l = (uint32_t)len;
+
+    if (len > QLOG_STAGE_SIZE) {
+        qlog->stage_overflow = 1;
+        return;
+    }
+
+    rec_op(qlog, op, name);
+    rec_put(qlog, &l, sizeof(l));
+    rec_put(qlog, p, len);
+}
+
+static void ring_copy_in(QLOG *qlog, uint64_t pos,
+                         const unsigned char *p, size_t len)
+{
+    size_t off = (size_t)(pos & (qlog->ring_size - 1));
+    size_t n = qlog->ring_size - off;
+
+    if (n > len)
+        n = len;
+
+    memcpy(qlog->ring + off, p, n);
+    memcpy(qlog->ring, p + n, len - n);
+}
+
+static ossl_unused void ring_copy_out(QLOG *qlog, uint64_t pos,
+                                      unsigned char *p, size_t len)
+{
+    size_t off = (size_t)(pos & (qlog->ring_size - 1));
+    size_t n = qlog->ring_size - off;
+
+    if (n > len)
+        n = len;
+
+    memcpy(p, qlog->ring + off, n);
+    memcpy(p + n, qlog->ring, len - n);
+}
+
+/*
+ * Appends the staged record to the ring buffer. Never blocks: if the record
+ * does not fit, it is dropped and counted.
+ */
+static void qlog_rec_commit(QLOG *qlog)
+{
+    QLOG_REC_HDR hdr;
+    uint64_t head = qlog->ring_head, tail, v;
+
+    if (qlog->stage_overflow
+        || !CRYPTO_atomic_load(&qlog->ring_tail, &tail, qlog->ring_lock)
+        || qlog->ring_size - (size_t)(head - tail) < qlog->stage_len) {
+        CRYPTO_atomic_add64(&qlog->num_dropped, 1, &v, qlog->ring_lock);
+        return;
+    }
+
+    hdr.len         = (uint32_t)qlog->stage_len;
+    hdr.event_type  = qlog->event_type;
+    hdr.time        = ossl_time2ticks(qlog->event_time);
+    memcpy(qlog->stage, &hdr, sizeof(hdr));
+
+    ring_copy_in(qlog, head, qlog->stage, qlog->stage_len);
+    head += qlog->stage_len;
+    qlog->ring_head = head;
+    CRYPTO_atomic_store(&qlog->ring_head, head, qlog->ring_lock);
+
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    /*
+     * Wake the writer early if the ring is more than half full. We do not hold
+     * the writer mutex, so the wakeup may be missed, in which case the writer
+     * still runs at its regular interval.
+     */
+    if ((size_t)(head - tail) > qlog->ring_size / 2)
+        ossl_crypto_condvar_signal(qlog->writer->cv);
+#endif
+}
+
+uint64_t ossl_qlog_get_num_dropped(QLOG *qlog)
+{
+    uint64_t v;
+
+    if (qlog == NULL || !QLOG_ASYNC(qlog)
+        || !CRYPTO_atomic_load(&qlog->num_dropped, &v, qlog->ring_lock))
+        return 0;
+
+    return v;
+}
+
 /*
  * Field Generators
  * ================
  */
 void ossl_qlog_group_begin(QLOG *qlog, const char *name)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_GROUP_BEGIN, name);
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -438,11 +767,21 @@ void ossl_qlog_group_begin(QLOG *qlog, const char *name)
 
 void ossl_qlog_group_end(QLOG *qlog)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_GROUP_END, NULL);
+        return;
+    }
+
     ossl_json_object_end(&qlog->json);
 }
 
 void ossl_qlog_array_begin(QLOG *qlog, const char *name)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_ARRAY_BEGIN, name);
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -451,6 +790,11 @@ void ossl_qlog_array_begin(QLOG *qlog, const char *name)
 
 void ossl_qlog_array_end(QLOG *qlog)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_ARRAY_END, NULL);
+        return;
+    }
+
     ossl_json_array_end(&qlog->json);
 }
 
@@ -461,6 +805,11 @@ void ossl_qlog_override_time(QLOG *qlog, OSSL_TIME event_time)
 
 void ossl_qlog_str(QLOG *qlog, const char *name, const char *value)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_data(qlog, QLOG_OP_STR, name, value, strlen(value));
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -470,6 +819,11 @@ void ossl_qlog_str(QLOG *qlog, const char *name, const char *value)
 void ossl_qlog_str_len(QLOG *qlog, const char *name,
                        const char *value, size_t value_len)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_data(qlog, QLOG_OP_STR, name, value, value_len);
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -478,6 +832,12 @@ void ossl_qlog_str_len(QLOG *qlog, const char *name,
 
 void ossl_qlog_u64(QLOG *qlog, const char *name, uint64_t value)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_U64, name);
+        rec_put(qlog, &value, sizeof(value));
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -486,6 +846,12 @@ void ossl_qlog_u64(QLOG *qlog, const char *name, uint64_t value)
 
 void ossl_qlog_i64(QLOG *qlog, const char *name, int64_t value)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_op(qlog, QLOG_OP_I64, name);
+        rec_put(qlog, &value, sizeof(value));
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -494,6 +860,14 @@ void ossl_qlog_i64(QLOG *qlog, const char *name, int64_t value)
 
 void ossl_qlog_bool(QLOG *qlog, const char *name, int value)
 {
+    if (QLOG_ASYNC(qlog)) {
+        unsigned char b = (value != 0);
+
+        rec_op(qlog, QLOG_OP_BOOL, name);
+        rec_put(qlog, &b, sizeof(b));
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
@@ -503,12 +877,255 @@ void ossl_qlog_bool(QLOG *qlog, const char *name, int value)
 void ossl_qlog_bin(QLOG *qlog, const char *name,
                    const void *value, size_t value_len)
 {
+    if (QLOG_ASYNC(qlog)) {
+        rec_data(qlog, QLOG_OP_BIN, name, value, value_len);
+        return;
+    }
+
     if (name != NULL)
         ossl_json_key(&qlog->json, name);
 
     ossl_json_str_hex(&qlog->json, value, value_len);
 }
 
+#ifndef OPENSSL_NO_QLOG_ASYNC
+
+/*
+ * Asynchronous Writer
+ * ===================
+ */
+
+/* Serializes a binary event record to JSON. Called with the writer mutex. */
+static void qlog_replay(QLOG *qlog, const unsigned char *p, size_t len)
+{
+    const unsigned char *end = p + len;
+    QLOG_REC_HDR hdr;
+    unsigned char op;
+    uint32_t l;
+    uint64_t u;
+    int64_t i;
+
+    memcpy(&hdr, p, sizeof(hdr));
+    p += sizeof(hdr);
+
+    if (!ossl_assert(hdr.event_type != QLOG_EVENT_TYPE_NONE
+                     && hdr.event_type < QLOG_EVENT_TYPE_NUM))
+        return;
+
+    qlog_event_prologue(qlog, event_names[hdr.event_type]);
+
+    while (p < end) {
+        op = *p++;
+        if ((op & QLOG_OP_NAMED) != 0) {
+            ossl_json_key(&qlog->json, (const char *)p);
+            p += strlen((const char *)p) + 1;
+        }
+
+        switch (op & ~QLOG_OP_NAMED) {
+        case QLOG_OP_GROUP_BEGIN:
+            ossl_json_object_begin(&qlog->json);
+            break;
+        case QLOG_OP_GROUP_END:
+            ossl_json_object_end(&qlog->json);
+            break;
+        case QLOG_OP_ARRAY_BEGIN:
+            ossl_json_array_begin(&qlog->json);
+            break;
+        case QLOG_OP_ARRAY_END:
+            ossl_json_array_end(&qlog->json);
+            break;
+        case QLOG_OP_STR:
+        case QLOG_OP_BIN:
+            memcpy(&l, p, sizeof(l));
+            p += sizeof(l);
+            if ((op & ~QLOG_OP_NAMED) == QLOG_OP_STR)
+                ossl_json_str_len(&qlog->json, (const char *)p, l);
+            else
+                ossl_json_str_hex(&qlog->json, p, l);
+            p += l;
+            break;
+        case QLOG_OP_U64:
+            memcpy(&u, p, sizeof(u));
+            p += sizeof(u);
+            ossl_json_u64(&qlog->json, u);
+            break;
+        case QLOG_OP_I64:
+            memcpy(&i, p, sizeof(i));
+            p += sizeof(i);
+            ossl_json_i64(&qlog->json, i);
+            break;
+        case QLOG_OP_BOOL:
+            ossl_json_bool(&qlog->json, *p++);
+            break;
+        default:
+            assert(0);
+            return;
+        }
+    }
+
+    qlog_event_epilogue(qlog, ossl_ticks2time(hdr.time));
+}
+
+/*
+ * Emits a warning event if events have been dropped since the last call, so
+ * that gaps in the log are visible. Called with the writer mutex.
+ */
+static void qlog_report_dropped(QLOG *qlog)
+{
+    uint64_t n;
+    char msg[64];
+
+    if (!CRYPTO_atomic_load(&qlog->num_dropped, &n, qlog->ring_lock)
+        || n == qlog->num_dropped_reported)
+        return;
+
+    BIO_snprintf(msg, sizeof(msg), "%llu qlog events dropped",
+                 (unsigned long long)(n - qlog->num_dropped_reported));
+    qlog->num_dropped_reported = n;
+
+    qlog_event_prologue(qlog, "loglevel:warning");
+    ossl_json_key(&qlog->json, "message");
+    ossl_json_str(&qlog->json, msg);
+    qlog_event_epilogue(qlog, qlog->prev_event_time);
+}
+
+/* Consumes all records in the ring buffer. Called with the writer mutex. */
+static void qlog_drain(QLOG *qlog, unsigned char *buf)
+{
+    QLOG_REC_HDR hdr;
+    uint64_t head, tail = qlog->ring_tail;
+
+    if (!CRYPTO_atomic_load(&qlog->ring_head, &head, qlog->ring_lock))
+        return;
+
+    while (tail != head) {
+        ring_copy_out(qlog, tail, buf, sizeof(hdr));
+        memcpy(&hdr, buf, sizeof(hdr));
+        ring_copy_out(qlog, tail, buf, hdr.len);
+        qlog_replay(qlog, buf, hdr.len);
+
+        tail += hdr.len;
+        qlog->ring_tail = tail;
+        CRYPTO_atomic_store(&qlog->ring_tail, tail, qlog->ring_lock);
+    }
+
+    qlog_report_dropped(qlog);
+}
+
+static CRYPTO_THREAD_RETVAL qlog_writer_main(void *arg)
+{
+    QLOG_WRITER *w = arg;
+    QLOG *qlog;
+    OSSL_TIME deadline;
+
+    ossl_crypto_mutex_lock(w->mutex);
+
+    for (;;) {
+        for (qlog = ossl_list_qlog_head(&w->qlogs); qlog != NULL;
+             qlog = ossl_list_qlog_next(qlog))
+            qlog_flush_locked(qlog);
+
+        if (w->stop)
+            break;
+
+        deadline = ossl_time_add(ossl_time_now(),
+                                 ossl_ms2time(QLOG_WRITER_INTERVAL_MS));
+        ossl_crypto_condvar_wait_timeout(w->cv, w->mutex, deadline);
+    }
+
+    ossl_crypto_mutex_unlock(w->mutex);
+    return 1;
+}
+
+QLOG_WRITER *ossl_qlog_writer_new(void)
+{
+    QLOG_WRITER *w = OPENSSL_zalloc(sizeof(QLOG_WRITER));
+
+    if (w == NULL)
+        return NULL;
+
+    if ((w->buf = OPENSSL_malloc(QLOG_STAGE_SIZE)) == NULL
+        || (w->mutex = ossl_crypto_mutex_new()) == NULL
+        || (w->cv = ossl_crypto_condvar_new()) == NULL)
+        goto err;
+
+    w->t = ossl_crypto_thread_native_start(qlog_writer_main, w, 1);
+    if (w->t == NULL)
+        goto err;
+
+    return w;
+
+err:
+    ossl_crypto_condvar_free(&w->cv);
+    ossl_crypto_mutex_free(&w->mutex);
+    OPENSSL_free(w->buf);
+    OPENSSL_free(w);
+    return NULL;
+}
+
+void ossl_qlog_writer_free(QLOG_WRITER *w)
+{
+    CRYPTO_THREAD_RETVAL rv;
+
+    if (w == NULL)
+        return;
+
+    ossl_crypto_mutex_lock(w->mutex);
+    w->stop = 1;
+    ossl_crypto_condvar_signal(w->cv);
+    ossl_crypto_mutex_unlock(w->mutex);
+
+    ossl_crypto_thread_native_join(w->t, &rv);
+    ossl_crypto_thread_native_clean(w->t);
+
+    /* All QLOGs must have been freed before their writer. */
+    assert(ossl_list_qlog_is_empty(&w->qlogs));
+
+    ossl_crypto_condvar_free(&w->cv);
+    ossl_crypto_mutex_free(&w->mutex);
+    OPENSSL_free(w->buf);
+    OPENSSL_free(w);
+}
+
+int ossl_qlog_set_writer(QLOG *qlog, QLOG_WRITER *w, size_t ring_size)
+{
+    size_t sz = 1;
+
+    if (qlog == NULL || w == NULL || QLOG_ASYNC(qlog)
+        || qlog->event_type != QLOG_EVENT_TYPE_NONE)
+        return 0;
+
+    if (ring_size == 0)
+        ring_size = QLOG_RING_DEFAULT_SIZE;
+
+    while (sz < ring_size) {
+        if (sz > SIZE_MAX / 2)
+            return 0;
+
+        sz <<= 1;
+    }
+
+    if ((qlog->ring_lock = CRYPTO_THREAD_lock_new()) == NULL
+        || (qlog->stage = OPENSSL_malloc(QLOG_STAGE_SIZE)) == NULL
+        || (qlog->ring = OPENSSL_malloc(sz)) == NULL) {
+        OPENSSL_free(qlog->stage);
+        CRYPTO_THREAD_lock_free(qlog->ring_lock);
+        qlog->stage     = NULL;
+        qlog->ring_lock = NULL;
+        return 0;
+    }
+
+    qlog->ring_size = sz;
+
+    ossl_crypto_mutex_lock(w->mutex);
+    qlog->writer = w;
+    ossl_list_qlog_insert_tail(&w->qlogs, qlog);
+    ossl_crypto_mutex_unlock(w->mutex);
+    return 1;
+}
+
+#endif
+
 /*
  * Filter Parsing
  * ==============
@@ -530,6 +530,16 @@ struct ossl_ackm_st {
      */
     uint64_t        ack_eliciting_bytes_in_flight[QUIC_PN_SPACE_NUM];
 
+    /*
+     * Delivery rate estimation state (draft-cheng-iccrg-delivery-rate-
+     * estimation): total bytes acknowledged, the time at which the most recent
+     * packet was acknowledged, and the send time of the most recently sent
+     * packet which has been acknowledged.
+     */
+    uint64_t        delivered;
+    OSSL_TIME       delivered_time;
+    OSSL_TIME       first_tx_time;
+
     /* Count of ECN-CE events. */
     uint64_t        peer_ecnce[QUIC_PN_SPACE_NUM];
 
@@ -985,10 +995,29 @@ static void ackm_on_pkts_acked(OSSL_ACKM *ackm, const OSSL_ACKM_TX_PKT *apkt)
     const OSSL_ACKM_TX_PKT *anext;
     QUIC_PN last_pn_acked = 0;
     OSSL_CC_ACK_INFO ainfo = {0};
+    OSSL_TIME now = ackm->now(ackm->now_arg);
 
     for (; apkt != NULL; apkt = anext) {
         if (apkt->is_inflight) {
             ackm->bytes_in_flight -= apkt->num_bytes;
+
+            /*
+             * Take a delivery rate sample. The interval is the longer of the
+             * send and ACK phases, which guards against underestimating it
+             * when ACKs are compressed.
+             */
+            ackm->delivered         += apkt->num_bytes;
+            ackm->delivered_time     = now;
+            ainfo.tx_delivered       = apkt->delivered;
+            ainfo.delivered          = ackm->delivered - apkt->delivered;
+            ainfo.interval
+                = ossl_time_max(ossl_time_subtract(apkt->time,
+                                                   apkt->first_tx_time),
+                                ossl_time_subtract(now,
+                                                   apkt->delivered_time));
+            ackm->first_tx_time      = ossl_time_max(ackm->first_tx_time,
+                                                     apkt->time);
+
             if (apkt->is_ack_eliciting)
                 ackm->ack_eliciting_bytes_in_flight[apkt->pkt_space]
                     -= apkt->num_bytes;
@@ -1059,6 +1088,18 @@ err:
     return NULL;
 }
 
+int ossl_ackm_set_cc(OSSL_ACKM *ackm,
+                     const OSSL_CC_METHOD *cc_method,
+                     OSSL_CC_DATA *cc_data)
+{
+    if (ackm->bytes_in_flight != 0)
+        return 0;
+
+    ackm->cc_method = cc_method;
+    ackm->cc_data   = cc_data;
+    return 1;
+}
+
 void ossl_ackm_free(OSSL_ACKM *ackm)
 {
     size_t i;
@@ -1103,6 +1144,20 @@ int ossl_ackm_on_tx_packet(OSSL_ACKM *ackm, OSSL_ACKM_TX_PKT *pkt)
                 += pkt->num_bytes;
         }
 
+        /*
+         * If nothing is in flight, the connection has been idle and a new
+         * flight starts now, so do not let the idle period count towards the
+         * delivery rate interval.
+         */
+        if (ackm->bytes_in_flight == 0) {
+            ackm->first_tx_time     = pkt->time;
+            ackm->delivered_time    = pkt->time;
+        }
+
+        pkt->delivered          = ackm->delivered;
+        pkt->delivered_time     = ackm->delivered_time;
+        pkt->first_tx_time      = ackm->first_tx_time;
+
         ackm->bytes_in_flight += pkt->num_bytes;
         ackm_set_loss_detection_timer(ackm);
 
@@ -1142,6 +1197,21 @@ static void ackm_process_ecn(OSSL_ACKM *ackm, const OSSL_QUIC_FRAME_ACK *ack,
     }
 }
 
+/* Passes the new smoothed RTT on to the congestion controller for pacing. */
+static void ackm_update_cc_rtt(OSSL_ACKM *ackm)
+{
+    OSSL_RTT_INFO rtt;
+    OSSL_PARAM params[2];
+    uint64_t smoothed_rtt;
+
+    ossl_statm_get_rtt_info(ackm->statm, &rtt);
+    smoothed_rtt = ossl_time2ticks(rtt.smoothed_rtt);
+    params[0] = OSSL_PARAM_construct_uint64(OSSL_CC_OPTION_SMOOTHED_RTT,
+                                            &smoothed_rtt);
+    params[1] = OSSL_PARAM_construct_end();
+    (void)ackm->cc_method->set_input_params(ackm->cc_data, params);
+}
+
 int ossl_ackm_on_rx_ack_frame(OSSL_ACKM *ackm, const OSSL_QUIC_FRAME_ACK *ack,
                               int pkt_space, OSSL_TIME rx_time)
 {
@@ -1195,6 +1265,7 @@ int ossl_ackm_on_rx_ack_frame(OSSL_ACKM *ackm, const OSSL_QUIC_FRAME_ACK *ack,
 
         ossl_statm_update_rtt(ackm->statm, ack_delay,
                               ossl_time_subtract(now, na_pkts->time));
+        ackm_update_cc_rtt(ackm);
     }
 
     /*
@@ -50,6 +50,7 @@
 #define DEFAULT_MAX_ACK_DELAY   QUIC_DEFAULT_MAX_ACK_DELAY
 
 DEFINE_LIST_OF_IMPL(ch, QUIC_CHANNEL);
+DEFINE_LIST_OF_IMPL(ch_tick, QUIC_CHANNEL);
 
 static void ch_save_err_state(QUIC_CHANNEL *ch);
 static int ch_rx(QUIC_CHANNEL *ch, int channel_only);
@@ -73,6 +74,9 @@ static int ch_on_handshake_yield_secret(uint32_t enc_level, int direction,
                                         const unsigned char *secret,
                                         size_t secret_len,
                                         void *arg);
+static int ch_apply_early_transport_params(QUIC_CHANNEL *ch,
+                                           const unsigned char *params,
+                                           size_t params_len);
 static int ch_on_crypto_recv_record(const unsigned char **buf,
                                     size_t *bytes_read, void *arg);
 static int ch_on_crypto_release_record(size_t bytes_read, void *arg);
@@ -105,6 +109,16 @@ static void ch_record_state_transition(QUIC_CHANNEL *ch, uint32_t new_state);
 
 DEFINE_LHASH_OF_EX(QUIC_SRT_ELEM);
 
+#if !defined(OPENSSL_NO_QLOG) && !defined(OPENSSL_NO_QLOG_ASYNC)
+QUIC_NEEDS_LOCK
+static QLOG_WRITER *ch_get_qlog_writer(void *arg)
+{
+    QUIC_CHANNEL *ch = arg;
+
+    return ossl_quic_engine_get0_qlog_writer(ch->port->engine);
+}
+#endif
+
 QUIC_NEEDS_LOCK
 static QLOG *ch_get_qlog(QUIC_CHANNEL *ch)
 {
@@ -127,6 +141,11 @@ static QLOG *ch_get_qlog(QUIC_CHANNEL *ch)
     qti.is_server   = ch->is_server;
     qti.now_cb      = get_time;
     qti.now_cb_arg  = ch;
+    qti.libctx      = ch->port->engine->libctx;
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    qti.get_writer_cb       = ch_get_qlog_writer;
+    qti.get_writer_cb_arg   = ch;
+#endif
     if ((ch->qlog = ossl_qlog_new_from_env(&qti)) == NULL) {
         ch->use_qlog = 0; /* don't try again */
         return NULL;
@@ -158,6 +177,12 @@ static QLOG *ch_get_qlog_cb(void *arg)
 
 #define DEFAULT_INIT_CONN_MAX_STREAMS           100
 
+/*
+ * Maximum number of DATAGRAM frame payloads we queue for transmission or for
+ * the application to read. When a queue is full the oldest payload is dropped.
+ */
+#define DEFAULT_DATAGRAM_QUEUE_LEN              64
+
 static int ch_init(QUIC_CHANNEL *ch)
 {
     OSSL_QUIC_TX_PACKETISER_ARGS txp_args = {0};
@@ -168,6 +193,8 @@ static int ch_init(QUIC_CHANNEL *ch)
     size_t rx_short_dcid_len;
     size_t tx_init_dcid_len;
 
+    ossl_timer_wheel_entry_init(&ch->tick_timer, ch);
+
     if (ch->port == NULL || ch->lcidm == NULL || ch->srtm == NULL)
         goto err;
 
@@ -201,6 +228,14 @@ static int ch_init(QUIC_CHANNEL *ch)
     if (ch->cfq == NULL)
         goto err;
 
+    ch->datagram_txq = ossl_quic_datagram_queue_new(DEFAULT_DATAGRAM_QUEUE_LEN);
+    if (ch->datagram_txq == NULL)
+        goto err;
+
+    ch->datagram_rxq = ossl_quic_datagram_queue_new(DEFAULT_DATAGRAM_QUEUE_LEN);
+    if (ch->datagram_rxq == NULL)
+        goto err;
+
     if (!ossl_quic_txfc_init(&ch->conn_txfc, NULL))
         goto err;
 
@@ -271,6 +306,7 @@ static int ch_init(QUIC_CHANNEL *ch)
     txp_args.conn_rxfc              = &ch->conn_rxfc;
     txp_args.max_streams_bidi_rxfc  = &ch->max_streams_bidi_rxfc;
     txp_args.max_streams_uni_rxfc   = &ch->max_streams_uni_rxfc;
+    txp_args.datagram_txq           = ch->datagram_txq;
     txp_args.cc_method              = ch->cc_method;
     txp_args.cc_data                = ch->cc_data;
     txp_args.now                    = get_time;
@@ -296,6 +332,7 @@ static int ch_init(QUIC_CHANNEL *ch)
     qrx_args.demux              = ch->port->demux;
     qrx_args.short_conn_id_len  = rx_short_dcid_len;
     qrx_args.max_deferred       = 32;
+    qrx_args.allow_0rtt         = ch->is_server;
 
     if ((ch->qrx = ossl_qrx_new(&qrx_args)) == NULL)
         goto err;
@@ -355,6 +392,7 @@ static int ch_init(QUIC_CHANNEL *ch)
     ch_update_idle(ch);
     ossl_list_ch_insert_tail(&ch->port->channel_list, ch);
     ch->on_port_list = 1;
+    ossl_quic_channel_request_tick(ch);
     return 1;
 
 err:
@@ -377,6 +415,8 @@ static void ch_cleanup(QUIC_CHANNEL *ch)
     ossl_quic_tx_packetiser_free(ch->txp);
     ossl_quic_txpim_free(ch->txpim);
     ossl_quic_cfq_free(ch->cfq);
+    ossl_quic_datagram_queue_free(ch->datagram_txq);
+    ossl_quic_datagram_queue_free(ch->datagram_rxq);
     ossl_qtx_free(ch->qtx);
     if (ch->cc_data != NULL)
         ch->cc_method->free(ch->cc_data);
@@ -402,7 +442,19 @@ static void ch_cleanup(QUIC_CHANNEL *ch)
     OSSL_ERR_STATE_free(ch->err_state);
     OPENSSL_free(ch->ack_range_scratch);
 
+    if (ch->on_tick_list) {
+        ossl_list_ch_tick_remove(&ch->port->tick_list, ch);
+        ch->on_tick_list = 0;
+    }
+
     if (ch->on_port_list) {
+        ossl_timer_wheel_remove(ch->port->engine->tw, &ch->tick_timer);
+
+        if (ch->net_read_desired)
+            --ch->port->num_net_read_desired;
+        if (ch->net_write_desired)
+            --ch->port->num_net_write_desired;
+
         ossl_list_ch_remove(&ch->port->channel_list, ch);
         ch->on_port_list = 0;
     }
@@ -946,6 +998,53 @@ static int ch_on_crypto_release_record(size_t bytes_read, void *arg)
     return ossl_quic_rstream_release_record(rstream, bytes_read);
 }
 
+/*
+ * Called when the handshake layer yields 0-RTT keys. Unlike the other ELs, the
+ * 0-RTT EL carries only application data and does not change the EL of the
+ * crypto streams, so we do not change our TX or RX EL here.
+ */
+static int ch_on_0rtt_secret(QUIC_CHANNEL *ch, int direction,
+                             uint32_t suite_id, EVP_MD *md,
+                             const unsigned char *secret, size_t secret_len)
+{
+    const unsigned char *params;
+    size_t params_len;
+
+    /* Clients only ever send 0-RTT data and servers only ever receive it. */
+    if (ch->have_0rtt_keys || direction != !ch->is_server)
+        return 0;
+
+    if (direction) {
+        /*
+         * RFC 9000 s. 7.4.1: 0-RTT data must respect the limits in the
+         * transport parameters the server sent in the connection in which we
+         * got the ticket. If we do not know what these were, we cannot send
+         * 0-RTT data, but we can still carry on with the handshake.
+         */
+        if (!ossl_quic_tls_get0_early_transport_params(ch->qtls, &params,
+                                                       &params_len)
+            || !ch_apply_early_transport_params(ch, params, params_len)) {
+            EVP_MD_free(md);
+            return 1;
+        }
+
+        if (!ossl_qtx_provide_secret(ch->qtx, QUIC_ENC_LEVEL_0RTT,
+                                     suite_id, md,
+                                     secret, secret_len))
+            return 0;
+    } else {
+        if (!ossl_qrx_provide_secret(ch->qrx, QUIC_ENC_LEVEL_0RTT,
+                                     suite_id, md,
+                                     secret, secret_len))
+            return 0;
+
+        ch->have_new_rx_secret = 1;
+    }
+
+    ch->have_0rtt_keys = 1;
+    return 1;
+}
+
 static int ch_on_handshake_yield_secret(uint32_t enc_level, int direction,
                                         uint32_t suite_id, EVP_MD *md,
                                         const unsigned char *secret,
@@ -959,6 +1058,9 @@ static int ch_on_handshake_yield_secret(uint32_t enc_level, int direction,
         /* Invalid EL. */
         return 0;
 
+    if (enc_level == QUIC_ENC_LEVEL_0RTT)
+        return ch_on_0rtt_secret(ch, direction, suite_id, md,
+                                 secret, secret_len);
 
     if (direction) {
         /* TX */
@@ -1009,6 +1111,22 @@ static int ch_on_handshake_yield_secret(uint32_t enc_level, int direction,
     return 1;
 }
 
+/*
+ * Treats all 0-RTT packets we have sent as lost, causing any data in them to be
+ * sent again at the current EL. Only 0-RTT packets have been sent in the
+ * Application PN space at the times this is called.
+ */
+static void ch_mark_0rtt_lost(QUIC_CHANNEL *ch)
+{
+    QUIC_PN pn, next_pn;
+
+    next_pn = ossl_quic_tx_packetiser_get_next_pn(ch->txp, QUIC_PN_SPACE_APP);
+
+    /* Best effort; packets already acknowledged or declared lost are skipped. */
+    for (pn = 0; pn < next_pn; ++pn)
+        ossl_ackm_mark_packet_pseudo_lost(ch->ackm, QUIC_PN_SPACE_APP, pn);
+}
+
 static int ch_on_handshake_complete(void *arg)
 {
     QUIC_CHANNEL *ch = arg;
@@ -1040,6 +1158,23 @@ static int ch_on_handshake_complete(void *arg)
     /* Tell TXP the handshake is complete. */
     ossl_quic_tx_packetiser_notify_handshake_complete(ch->txp);
 
+    if (ch->have_0rtt_keys) {
+        /*
+         * RFC 9001 s. 4.6.2: If the server rejected our 0-RTT data, we must
+         * send it again in 1-RTT packets.
+         */
+        if (!ch->is_server
+            && SSL_get_early_data_status(ch->tls) != SSL_EARLY_DATA_ACCEPTED)
+            ch_mark_0rtt_lost(ch);
+    }
+
+    /*
+     * We no longer send 0-RTT packets now that we have 1-RTT keys. A server
+     * also drops any 0-RTT packets it has not yet been able to process, for
+     * example because it rejected 0-RTT.
+     */
+    ch_discard_el(ch, QUIC_ENC_LEVEL_0RTT);
+
     ch->handshake_complete = 1;
 
     if (ch->is_server) {
@@ -1181,6 +1316,7 @@ static int ch_on_transport_params(const unsigned char *params,
     int got_max_idle_timeout = 0;
     int got_active_conn_id_limit = 0;
     int got_disable_active_migration = 0;
+    int got_max_datagram_frame_size = 0;
     QUIC_CONN_ID cid;
     const char *reason = "bad transport parameter";
     ossl_unused uint64_t rx_max_idle_timeout = 0;
@@ -1409,7 +1545,7 @@ static int ch_on_transport_params(const unsigned char *params,
                 goto malformed;
             }
 
-            assert(ch->max_local_streams_bidi == 0);
+            /* May replace a value remembered for 0-RTT. */
             ch->max_local_streams_bidi = v;
             got_initial_max_streams_bidi = 1;
             break;
@@ -1427,7 +1563,7 @@ static int ch_on_transport_params(const unsigned char *params,
                 goto malformed;
             }
 
-            assert(ch->max_local_streams_uni == 0);
+            /* May replace a value remembered for 0-RTT. */
             ch->max_local_streams_uni = v;
             got_initial_max_streams_uni = 1;
             break;
@@ -1472,6 +1608,22 @@ static int ch_on_transport_params(const unsigned char *params,
             got_max_udp_payload_size    = 1;
             break;
 
+        case QUIC_TPARAM_MAX_DATAGRAM_FRAME_SIZE:
+            if (got_max_datagram_frame_size) {
+                /* must not appear more than once */
+                reason = TP_REASON_DUP("MAX_DATAGRAM_FRAME_SIZE");
+                goto malformed;
+            }
+
+            if (!ossl_quic_wire_decode_transport_param_int(&pkt, &id, &v)) {
+                reason = TP_REASON_MALFORMED("MAX_DATAGRAM_FRAME_SIZE");
+                goto malformed;
+            }
+
+            ch->rx_max_datagram_frame_size  = v;
+            got_max_datagram_frame_size     = 1;
+            break;
+
         case QUIC_TPARAM_ACTIVE_CONN_ID_LIMIT:
             if (got_active_conn_id_limit) {
                 /* must not appear more than once */
@@ -1655,6 +1807,8 @@ static int ch_on_transport_params(const unsigned char *params,
             QLOG_U64("max_idle_timeout", rx_max_idle_timeout);
         if (got_active_conn_id_limit)
             QLOG_U64("active_connection_id_limit", ch->rx_active_conn_id_limit);
+        if (got_max_datagram_frame_size)
+            QLOG_U64("max_datagram_frame_size", ch->rx_max_datagram_frame_size);
         if (got_stateless_reset_token)
             QLOG_BIN("stateless_reset_token", stateless_reset_token_p,
                      QUIC_STATELESS_RESET_TOKEN_LEN);
@@ -1696,6 +1850,70 @@ malformed:
     return 0;
 }
 
+/*
+ * Applies the limits from the transport parameters a server sent in a previous
+ * connection, which a client uses to send 0-RTT data (RFC 9000 s. 7.4.1). Only
+ * the flow control and stream count limits are remembered; everything else is
+ * taken from the transport parameters the server sends in this connection,
+ * which replace these values when they arrive. Returns 0 if the parameters are
+ * malformed, in which case 0-RTT must not be used.
+ */
+static int ch_apply_early_transport_params(QUIC_CHANNEL *ch,
+                                           const unsigned char *params,
+                                           size_t params_len)
+{
+    PACKET pkt;
+    uint64_t id, v;
+    size_t len;
+
+    if (!PACKET_buf_init(&pkt, params, params_len))
+        return 0;
+
+    while (PACKET_remaining(&pkt) > 0) {
+        if (!ossl_quic_wire_peek_transport_param(&pkt, &id))
+            return 0;
+
+        switch (id) {
+        case QUIC_TPARAM_INITIAL_MAX_DATA:
+        case QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_LOCAL:
+        case QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_REMOTE:
+        case QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_UNI:
+        case QUIC_TPARAM_INITIAL_MAX_STREAMS_BIDI:
+        case QUIC_TPARAM_INITIAL_MAX_STREAMS_UNI:
+            if (!ossl_quic_wire_decode_transport_param_int(&pkt, &id, &v))
+                return 0;
+            break;
+
+        default:
+            if (ossl_quic_wire_decode_transport_param_bytes(&pkt, &id,
+                                                            &len) == NULL)
+                return 0;
+            continue;
+        }
+
+        if (id == QUIC_TPARAM_INITIAL_MAX_DATA) {
+            ossl_quic_txfc_bump_cwm(&ch->conn_txfc, v);
+        } else if (id == QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_LOCAL) {
+            ch->rx_init_max_stream_data_bidi_remote = v;
+        } else if (id == QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_REMOTE) {
+            ch->rx_init_max_stream_data_bidi_local = v;
+            ossl_quic_stream_map_visit(&ch->qsm, txfc_bump_cwm_bidi, &v);
+        } else if (id == QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_UNI) {
+            ch->rx_init_max_stream_data_uni = v;
+            ossl_quic_stream_map_visit(&ch->qsm, txfc_bump_cwm_uni, &v);
+        } else if (v > (((uint64_t)1) << 60)) {
+            return 0;
+        } else if (id == QUIC_TPARAM_INITIAL_MAX_STREAMS_BIDI) {
+            ch->max_local_streams_bidi = v;
+        } else {
+            ch->max_local_streams_uni = v;
+        }
+    }
+
+    ossl_quic_stream_map_visit(&ch->qsm, do_update, ch);
+    return 1;
+}
+
 /*
  * Called when we want to generate transport parameters. This is called
  * immediately at instantiation time for a client and after we receive the
@@ -1781,6 +1999,11 @@ static int ch_generate_transport_params(QUIC_CHANNEL *ch)
                                                    ossl_quic_rxfc_get_cwm(&ch->max_streams_uni_rxfc)))
         goto err;
 
+    if (ch->tx_max_datagram_frame_size != 0
+        && !ossl_quic_wire_encode_transport_param_int(&wpkt, QUIC_TPARAM_MAX_DATAGRAM_FRAME_SIZE,
+                                                      ch->tx_max_datagram_frame_size))
+        goto err;
+
     if (!WPACKET_finish(&wpkt))
         goto err;
 
@@ -1822,6 +2045,8 @@ static int ch_generate_transport_params(QUIC_CHANNEL *ch)
                  ossl_quic_rxfc_get_cwm(&ch->max_streams_bidi_rxfc));
         QLOG_U64("initial_max_streams_uni",
                  ossl_quic_rxfc_get_cwm(&ch->max_streams_uni_rxfc));
+        if (ch->tx_max_datagram_frame_size != 0)
+            QLOG_U64("max_datagram_frame_size", ch->tx_max_datagram_frame_size);
     QLOG_EVENT_END()
 #endif
 
@@ -2263,10 +2488,11 @@ static void ch_rx_handle_packet(QUIC_CHANNEL *ch, int channel_only)
             return;
 
         /*
-         * TODO(QUIC 0RTT): Implement 0-RTT on the server side. We currently
-         * do not need to implement this as a client can only do 0-RTT if we
-         * have given it permission to in a previous session.
+         * The QRX only yields 0-RTT packets once we have 0-RTT keys, which we
+         * only get if we accepted 0-RTT, and the RXDP ensures only frames
+         * permitted in 0-RTT packets are processed.
          */
+        ossl_quic_handle_frames(ch, ch->qrx_pkt); /* best effort */
         break;
 
     case QUIC_PKT_TYPE_INITIAL:
@@ -2617,6 +2843,7 @@ int ossl_quic_channel_start(QUIC_CHANNEL *ch)
     if (!ch_tick_tls(ch, /*channel_only=*/0))
         return 0;
 
+    ossl_quic_channel_request_tick(ch);
     ossl_quic_reactor_tick(ossl_quic_port_get0_reactor(ch->port), 0); /* best effort */
     return 1;
 }
@@ -2698,6 +2925,14 @@ static int ch_retry(QUIC_CHANNEL *ch,
                                            /*PN=*/0))
         return 0;
 
+    /*
+     * The server also discarded any 0-RTT packets we sent, so any data in them
+     * must be sent again. We keep our 0-RTT keys as the 0-RTT secret does not
+     * depend on the DCID.
+     */
+    if (ch->have_0rtt_keys)
+        ch_mark_0rtt_lost(ch);
+
     /*
      * Plug in new secrets for the Initial EL. This is the only time we change
      * the secrets for an EL after we already provisioned it.
@@ -2871,6 +3106,17 @@ static void ch_start_terminating(QUIC_CHANNEL *ch,
 
         ossl_qlog_event_connectivity_connection_closed(ch_get_qlog(ch), tcause);
 
+        /*
+         * QUIC has no TLS close_notify, so tell the handshake layer about a
+         * clean close. Otherwise libssl assumes the connection failed and
+         * removes its session from the session cache, which prevents a server
+         * from resuming the single-use tickets it issues for 0-RTT.
+         */
+        if (ch->handshake_complete
+            && (tcause->app || tcause->error_code == OSSL_QUIC_ERR_NO_ERROR))
+            SSL_set_shutdown(ch->tls,
+                             SSL_get_shutdown(ch->tls) | SSL_SENT_SHUTDOWN);
+
         if (!force_immediate) {
             ch_record_state_transition(ch, tcause->remote
                                            ? QUIC_CHANNEL_STATE_TERMINATING_DRAINING
@@ -3128,6 +3374,30 @@ static void ch_save_err_state(QUIC_CHANNEL *ch)
 void ossl_quic_channel_inject(QUIC_CHANNEL *ch, QUIC_URXE *e)
 {
     ossl_qrx_inject_urxe(ch->qrx, e);
+    ossl_quic_channel_request_tick(ch);
+}
+
+void ossl_quic_channel_request_tick(QUIC_CHANNEL *ch)
+{
+    if (ch->on_tick_list || !ch->on_port_list)
+        return;
+
+    ossl_list_ch_tick_insert_tail(&ch->port->tick_list, ch);
+    ch->on_tick_list = 1;
+}
+
+void ossl_quic_channel_schedule_tick_now(QUIC_CHANNEL *ch)
+{
+    OSSL_TIME now;
+
+    if (!ch->on_port_list)
+        return;
+
+    now = get_time(ch);
+    ossl_quic_channel_request_tick(ch);
+    ossl_timer_wheel_add(ch->port->engine->tw, &ch->tick_timer, now);
+    ossl_quic_reactor_lower_tick_deadline(ossl_quic_port_get0_reactor(ch->port),
+                                          now);
 }
 
 void ossl_quic_channel_on_stateless_reset(QUIC_CHANNEL *ch)
@@ -3137,6 +3407,7 @@ void ossl_quic_channel_on_stateless_reset(QUIC_CHANNEL *ch)
     tcause.error_code   = OSSL_QUIC_ERR_NO_ERROR;
     tcause.remote       = 1;
     ch_start_terminating(ch, &tcause, 0);
+    ossl_quic_channel_request_tick(ch);
 }
 
 void ossl_quic_channel_raise_net_error(QUIC_CHANNEL *ch)
@@ -3157,6 +3428,7 @@ void ossl_quic_channel_raise_net_error(QUIC_CHANNEL *ch)
      * send CONNECTION_CLOSE if we cannot communicate.
      */
     ch_start_terminating(ch, &tcause, 1);
+    ossl_quic_channel_request_tick(ch);
 }
 
 int ossl_quic_channel_net_error(QUIC_CHANNEL *ch)
@@ -3406,10 +3678,11 @@ static int ch_init_new_stream(QUIC_CHANNEL *ch, QUIC_STREAM *qs,
     if (!ossl_quic_txfc_init(&qs->txfc, &ch->conn_txfc))
         goto err;
 
-    if (ch->got_remote_transport_params) {
+    if (ch->got_remote_transport_params || ch->have_0rtt_keys) {
         /*
-         * If we already got peer TPs we need to apply the initial CWM credit
-         * now. If we didn't already get peer TPs this will be done
+         * If we already got peer TPs, or remembered them from a previous
+         * connection in order to send 0-RTT data, we need to apply the initial
+         * CWM credit now. If we didn't already get peer TPs this will be done
          * automatically for all extant streams when we do.
          */
         if (can_send) {
@@ -3702,3 +3975,112 @@ uint64_t ossl_quic_channel_get_max_idle_timeout_actual(const QUIC_CHANNEL *ch)
 {
     return ch->max_idle_timeout;
 }
+
+void ossl_quic_channel_set_max_datagram_frame_size_request(QUIC_CHANNEL *ch,
+                                                           uint64_t max_size)
+{
+    ch->tx_max_datagram_frame_size = max_size;
+}
+
+uint64_t ossl_quic_channel_get_max_datagram_frame_size_request(const QUIC_CHANNEL *ch)
+{
+    return ch->tx_max_datagram_frame_size;
+}
+
+uint64_t ossl_quic_channel_get_max_datagram_frame_size_peer_request(const QUIC_CHANNEL *ch)
+{
+    return ch->rx_max_datagram_frame_size;
+}
+
+size_t ossl_quic_channel_get_max_datagram_write_size(QUIC_CHANNEL *ch)
+{
+    uint64_t limit = ch->rx_max_datagram_frame_size;
+    size_t len, max_frame_len;
+
+    if (!ch->got_remote_transport_params)
+        return 0;
+
+    /*
+     * The largest payload we can send is limited both by the peer and by the
+     * largest DATAGRAM frame which fits in a packet.
+     */
+    max_frame_len = ossl_quic_tx_packetiser_get_max_datagram_frame_len(ch->txp);
+    if (limit > max_frame_len)
+        limit = max_frame_len;
+
+    if (limit < ossl_quic_wire_get_encoded_frame_len_datagram(0, 1))
+        return 0;
+
+    len = (size_t)limit - ossl_quic_wire_get_encoded_frame_len_datagram(0, 1);
+    while (len > 0
+           && ossl_quic_wire_get_encoded_frame_len_datagram(len, 1) > limit)
+        --len;
+
+    return len;
+}
+
+QUIC_DATAGRAM_QUEUE *ossl_quic_channel_get0_datagram_txq(QUIC_CHANNEL *ch)
+{
+    return ch->datagram_txq;
+}
+
+QUIC_DATAGRAM_QUEUE *ossl_quic_channel_get0_datagram_rxq(QUIC_CHANNEL *ch)
+{
+    return ch->datagram_rxq;
+}
+
+int ossl_quic_channel_set_cc_method(QUIC_CHANNEL *ch,
+                                    const OSSL_CC_METHOD *cc_method)
+{
+    OSSL_CC_DATA *cc_data;
+
+    if (cc_method == ch->cc_method)
+        return 1;
+
+    if (ch->state != QUIC_CHANNEL_STATE_IDLE)
+        return 0;
+
+    if ((cc_data = cc_method->new(get_time, ch)) == NULL)
+        return 0;
+
+    if (!ossl_ackm_set_cc(ch->ackm, cc_method, cc_data)) {
+        cc_method->free(cc_data);
+        return 0;
+    }
+
+    ossl_quic_tx_packetiser_set_cc(ch->txp, cc_method, cc_data);
+
+    ch->cc_method->free(ch->cc_data);
+    ch->cc_method   = cc_method;
+    ch->cc_data     = cc_data;
+    return 1;
+}
+
+const OSSL_CC_METHOD *ossl_quic_channel_get_cc_method(const QUIC_CHANNEL *ch)
+{
+    return ch->cc_method;
+}
+
+int ossl_quic_channel_set_early_data_enabled(QUIC_CHANNEL *ch, int enabled)
+{
+    if (ch->is_server || ch->state != QUIC_CHANNEL_STATE_IDLE)
+        return 0;
+
+    ch->early_data_enabled = (enabled != 0);
+    ossl_quic_tls_set_early_data_enabled(ch->qtls, enabled);
+    return 1;
+}
+
+int ossl_quic_channel_get_early_data_enabled(const QUIC_CHANNEL *ch)
+{
+    return ch->early_data_enabled;
+}
+
+int ossl_quic_channel_can_send_early_data(const QUIC_CHANNEL *ch)
+{
+    return !ch->is_server
+        && !ch->handshake_complete
+        && ch->have_0rtt_keys
+        && (ch->el_discarded & (1U << QUIC_ENC_LEVEL_0RTT)) == 0
+        && ossl_quic_channel_is_active(ch);
+}
@@ -10,6 +10,7 @@
 #  include "internal/quic_predef.h"
 #  include "internal/quic_fc.h"
 #  include "internal/quic_stream_map.h"
+#  include "internal/timer_wheel.h"
 
 /*
  * QUIC Channel Structure
@@ -36,6 +37,15 @@ struct quic_channel_st {
      */
     OSSL_LIST_MEMBER(ch, struct quic_channel_st);
 
+    /*
+     * Channels which need to be ticked are also kept on a list by the port, so
+     * that a tick of the port need not visit every channel.
+     */
+    OSSL_LIST_MEMBER(ch_tick, struct quic_channel_st);
+
+    /* Timer in the engine's timer wheel which fires at our tick deadline. */
+    OSSL_TIMER_WHEEL_ENTRY          tick_timer;
+
     /*
      * The associated TLS 1.3 connection data. Used to provide the handshake
      * layer; its 'network' side is plugged into the crypto stream for each EL
@@ -173,6 +183,20 @@ struct quic_channel_st {
     /* Maximum active CID limit, as negotiated by transport parameters. */
     uint64_t                        rx_active_conn_id_limit;
 
+    /*
+     * Maximum size of a DATAGRAM frame (RFC 9221) we accept, which we send to
+     * the peer as a transport parameter, and the maximum size of a DATAGRAM
+     * frame the peer accepts. 0 means DATAGRAM frames are not supported.
+     */
+    uint64_t                        tx_max_datagram_frame_size;
+    uint64_t                        rx_max_datagram_frame_size;
+
+    /*
+     * Queues of DATAGRAM frame payloads waiting to be sent and waiting to be
+     * read by the application.
+     */
+    QUIC_DATAGRAM_QUEUE             *datagram_txq, *datagram_rxq;
+
     /*
      * Used to allocate stream IDs. This is a stream ordinal, i.e., a stream ID
      * without the low two bits designating type and initiator. Shift and or in
@@ -434,9 +458,29 @@ struct quic_channel_st {
     /* Are we on the QUIC_PORT linked list of channels? */
     unsigned int                    on_port_list                        : 1;
 
+    /* Are we on the QUIC_PORT linked list of channels to be ticked? */
+    unsigned int                    on_tick_list                        : 1;
+
+    /*
+     * The network I/O wants reported by our last tick, which the port keeps
+     * count of.
+     */
+    unsigned int                    net_read_desired                    : 1;
+    unsigned int                    net_write_desired                   : 1;
+
     /* Has qlog been requested? */
     unsigned int                    use_qlog                            : 1;
 
+    /* Should we try to send 0-RTT data? (client only) */
+    unsigned int                    early_data_enabled                  : 1;
+
+    /*
+     * Have we provisioned 0-RTT keys? For a client these are TX keys and mean
+     * we may be sending 0-RTT data; for a server these are RX keys and mean
+     * we accepted 0-RTT data.
+     */
+    unsigned int                    have_0rtt_keys                      : 1;
+
     /* Saved error stack in case permanent error was encountered */
     ERR_STATE                       *err_state;
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include "internal/quic_datagram.h"
+#include "internal/list.h"
+
+typedef struct quic_datagram_st QUIC_DATAGRAM;
+
+struct quic_datagram_st {
+    OSSL_LIST_MEMBER(dgq, QUIC_DATAGRAM);
+    size_t              data_len;
+
+    /* data_len bytes of datagram data follow this structure. */
+};
+
+DEFINE_LIST_OF(dgq, QUIC_DATAGRAM);
+
+struct quic_datagram_queue_st {
+    OSSL_LIST(dgq)      list;
+    size_t              max_num;
+    uint64_t            num_dropped;
+};
+
+static ossl_inline unsigned char *dg_data(const QUIC_DATAGRAM *d)
+{
+    return (unsigned char *)(d + 1);
+}
+
+QUIC_DATAGRAM_QUEUE *ossl_quic_datagram_queue_new(size_t max_num)
+{
+    QUIC_DATAGRAM_QUEUE *q;
+
+    if (max_num == 0)
+        return NULL;
+
+    if ((q = OPENSSL_zalloc(sizeof(*q))) == NULL)
+        return NULL;
+
+    ossl_list_dgq_init(&q->list);
+    q->max_num = max_num;
+    return q;
+}
+
+void ossl_quic_datagram_queue_free(QUIC_DATAGRAM_QUEUE *q)
+{
+    if (q == NULL)
+        return;
+
+    ossl_quic_datagram_queue_clear(q);
+    OPENSSL_free(q);
+}
+
+int ossl_quic_datagram_queue_push(QUIC_DATAGRAM_QUEUE *q,
+                                  const unsigned char *data, size_t data_len)
+{
+    QUIC_DATAGRAM *d;
+
+    if (data_len > SIZE_MAX - sizeof(*d))
+        return 0;
+
+    if ((d = OPENSSL_malloc(sizeof(*d) + data_len)) == NULL)
+        return 0;
+
+    ossl_list_dgq_init_elem(d);
+    d->data_len = data_len;
+    if (data_len > 0)
+        memcpy(dg_data(d), data, data_len);
+
+    if (ossl_list_dgq_num(&q->list) >= q->max_num) {
+        ossl_quic_datagram_queue_pop(q);
+        ++q->num_dropped;
+    }
+
+    ossl_list_dgq_insert_tail(&q->list, d);
+    return 1;
+}
+
+int ossl_quic_datagram_queue_peek(QUIC_DATAGRAM_QUEUE *q,
+                                  const unsigned char **data, size_t *data_len)
+{
+    QUIC_DATAGRAM *d = ossl_list_dgq_head(&q->list);
+
+    if (d == NULL)
+        return 0;
+
+    *data       = dg_data(d);
+    *data_len   = d->data_len;
+    return 1;
+}
+
+void ossl_quic_datagram_queue_pop(QUIC_DATAGRAM_QUEUE *q)
+{
+    QUIC_DATAGRAM *d = ossl_list_dgq_head(&q->list);
+
+    if (d == NULL)
+        return;
+
+    ossl_list_dgq_remove(&q->list, d);
+    OPENSSL_free(d);
+}
+
+void ossl_quic_datagram_queue_clear(QUIC_DATAGRAM_QUEUE *q)
+{
+    while (!ossl_list_dgq_is_empty(&q->list))
+        ossl_quic_datagram_queue_pop(q);
+}
+
+size_t ossl_quic_datagram_queue_get_num(const QUIC_DATAGRAM_QUEUE *q)
+{
+    return ossl_list_dgq_num(&q->list);
+}
+
+uint64_t ossl_quic_datagram_queue_get_num_dropped(const QUIC_DATAGRAM_QUEUE *q)
+{
+    return q->num_dropped;
+}
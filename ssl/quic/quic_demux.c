@@ -21,6 +21,16 @@
 
 #define DEMUX_DEFAULT_MTU        1500
 
+/*
+ * When UDP GRO is in use, the kernel may coalesce several datagrams into a
+ * single receive, so buffers must be able to hold the largest UDP payload.
+ * Fewer messages are received per call to bound the memory this requires. The
+ * large buffers never leave the free list; the datagrams are copied out of
+ * them into URXEs of the usual size.
+ */
+#define DEMUX_GRO_BUF_LEN           65535
+#define DEMUX_GRO_MAX_MSGS_PER_CALL 8
+
 struct quic_demux_st {
     /* The underlying transport BIO with datagram semantics. */
     BIO                        *net_bio;
@@ -66,6 +76,9 @@ struct quic_demux_st {
 
     /* Whether to use local address support. */
     char                        use_local_addr;
+
+    /* Whether the BIO may return datagrams coalesced by UDP GRO. */
+    char                        use_gro;
 };
 
 QUIC_DEMUX *ossl_quic_demux_new(BIO *net_bio,
@@ -91,6 +104,9 @@ QUIC_DEMUX *ossl_quic_demux_new(BIO *net_bio,
         && BIO_dgram_set_local_addr_enable(net_bio, 1))
         demux->use_local_addr = 1;
 
+    if (net_bio != NULL && BIO_dgram_set_gro_enable(net_bio, 1))
+        demux->use_gro = 1;
+
     return demux;
 }
 
@@ -122,8 +138,13 @@ void ossl_quic_demux_set_bio(QUIC_DEMUX *demux, BIO *net_bio)
     unsigned int mtu;
 
     demux->net_bio = net_bio;
+    demux->use_gro = 0;
 
     if (net_bio != NULL) {
+        /* Use UDP GRO if the BIO supports it. */
+        if (BIO_dgram_set_gro_enable(net_bio, 1))
+            demux->use_gro = 1;
+
         /*
          * Try to determine our MTU if possible. The BIO is not required to
          * support this, in which case we remain at the last known MTU, or our
@@ -223,6 +244,64 @@ static int demux_ensure_free_urxe(QUIC_DEMUX *demux, size_t min_num_free)
     return 1;
 }
 
+/*
+ * Gets a URXE able to hold alloc_len bytes for a datagram copied out of a GRO
+ * receive buffer, reusing one from the tail of the free list if it is not one
+ * of the receive buffers. The URXE is not on any list on return.
+ */
+static QUIC_URXE *demux_get_copy_urxe(QUIC_DEMUX *demux, size_t alloc_len)
+{
+    QUIC_URXE *e = ossl_list_urxe_tail(&demux->urx_free);
+
+    if (e != NULL && e->alloc_len >= alloc_len
+            && e->alloc_len < DEMUX_GRO_BUF_LEN) {
+        ossl_list_urxe_remove(&demux->urx_free, e);
+        return e;
+    }
+
+    return demux_alloc_urxe(alloc_len > demux->mtu ? alloc_len : demux->mtu);
+}
+
+/*
+ * Copies the datagrams received into the GRO receive buffer urxe into one
+ * URXE each, which are appended to the pending list. If seg_len is non-zero,
+ * the kernel coalesced several datagrams, each of which except the last is
+ * seg_len bytes long. urxe itself stays on the free list.
+ *
+ * Returns 1 on success or 0 on failure.
+ */
+static int demux_split_gro(QUIC_DEMUX *demux, QUIC_URXE *urxe, size_t seg_len)
+{
+    QUIC_URXE *e;
+    const unsigned char *p = ossl_quic_urxe_data(urxe);
+    size_t off, len;
+
+    if (seg_len == 0)
+        seg_len = urxe->data_len;
+
+    for (off = 0; off < urxe->data_len; off += len) {
+        len = urxe->data_len - off;
+        if (len > seg_len)
+            len = seg_len;
+
+        e = demux_get_copy_urxe(demux, len);
+        if (e == NULL)
+            return 0;
+
+        memcpy(ossl_quic_urxe_data(e), p + off, len);
+        e->data_len     = len;
+        e->peer         = urxe->peer;
+        e->local        = urxe->local;
+        e->time         = urxe->time;
+        e->datagram_id  = demux->next_datagram_id++;
+        ossl_list_urxe_insert_tail(&demux->urx_pending, e);
+        e->demux_state  = URXE_DEMUX_STATE_PENDING;
+    }
+
+    urxe->data_len = 0;
+    return 1;
+}
+
 /*
  * Receive datagrams from network, placing them into URXEs.
  *
@@ -234,7 +313,7 @@ static int demux_ensure_free_urxe(QUIC_DEMUX *demux, size_t min_num_free)
 static int demux_recv(QUIC_DEMUX *demux)
 {
     BIO_MSG msg[DEMUX_MAX_MSGS_PER_CALL];
-    size_t rd, i;
+    size_t rd, i, max_msgs, buf_len;
     QUIC_URXE *urxe = ossl_list_urxe_head(&demux->urx_free), *unext;
     OSSL_TIME now;
 
@@ -248,12 +327,19 @@ static int demux_recv(QUIC_DEMUX *demux)
          */
         return QUIC_DEMUX_PUMP_RES_TRANSIENT_FAIL;
 
+    if (demux->use_gro) {
+        max_msgs = DEMUX_GRO_MAX_MSGS_PER_CALL;
+        buf_len  = DEMUX_GRO_BUF_LEN;
+    } else {
+        max_msgs = OSSL_NELEM(msg);
+        buf_len  = demux->mtu;
+    }
+
     /*
      * Opportunistically receive as many messages as possible in a single
      * syscall, determined by how many free URXEs are available.
      */
-    for (i = 0; i < (ossl_ssize_t)OSSL_NELEM(msg);
-            ++i, urxe = ossl_list_urxe_next(urxe)) {
+    for (i = 0; i < max_msgs; ++i, urxe = ossl_list_urxe_next(urxe)) {
         if (urxe == NULL) {
             /* We need at least one URXE to receive into. */
             if (!ossl_assert(i > 0))
@@ -263,7 +349,7 @@ static int demux_recv(QUIC_DEMUX *demux)
         }
 
         /* Ensure the URXE is big enough. */
-        urxe = demux_reserve_urxe(demux, urxe, demux->mtu);
+        urxe = demux_reserve_urxe(demux, urxe, buf_len);
         if (urxe == NULL)
             /* Allocation error, fail. */
             return QUIC_DEMUX_PUMP_RES_PERMANENT_FAIL;
@@ -303,6 +389,14 @@ static int demux_recv(QUIC_DEMUX *demux)
         urxe->data_len      = msg[i].data_len;
         /* Time we received datagram. */
         urxe->time          = now;
+
+        if (demux->use_gro) {
+            if (!demux_split_gro(demux, urxe,
+                                 BIO_MSG_SEGMENT_SIZE(msg[i].flags)))
+                return QUIC_DEMUX_PUMP_RES_PERMANENT_FAIL;
+            continue;
+        }
+
         urxe->datagram_id   = demux->next_datagram_id++;
         /* Move from free list to pending list. */
         ossl_list_urxe_remove(&demux->urx_free, urxe);
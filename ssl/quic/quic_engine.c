@@ -9,6 +9,7 @@
 
 #include "internal/quic_engine.h"
 #include "internal/quic_port.h"
+#include "internal/quic_channel.h"
 #include "quic_engine_local.h"
 #include "quic_port_local.h"
 #include "../ssl_local.h"
@@ -55,6 +56,11 @@ void ossl_quic_engine_free(QUIC_ENGINE *qeng)
 
 static int qeng_init(QUIC_ENGINE *qeng)
 {
+    qeng->tw = ossl_timer_wheel_new(ossl_ms2time(1),
+                                    ossl_quic_engine_get_time(qeng));
+    if (qeng->tw == NULL)
+        return 0;
+
     ossl_quic_reactor_init(&qeng->rtor, qeng_tick, qeng, ossl_time_zero());
     return 1;
 }
@@ -62,6 +68,11 @@ static int qeng_init(QUIC_ENGINE *qeng)
 static void qeng_cleanup(QUIC_ENGINE *qeng)
 {
     assert(ossl_list_port_num(&qeng->port_list) == 0);
+    ossl_quic_reactor_cleanup(&qeng->rtor);
+    ossl_timer_wheel_free(qeng->tw);
+#if !defined(OPENSSL_NO_QLOG) && !defined(OPENSSL_NO_QLOG_ASYNC)
+    ossl_qlog_writer_free(qeng->qlog_writer);
+#endif
 }
 
 QUIC_REACTOR *ossl_quic_engine_get0_reactor(QUIC_ENGINE *qeng)
@@ -74,6 +85,16 @@ CRYPTO_MUTEX *ossl_quic_engine_get0_mutex(QUIC_ENGINE *qeng)
     return qeng->mutex;
 }
 
+#if !defined(OPENSSL_NO_QLOG) && !defined(OPENSSL_NO_QLOG_ASYNC)
+QLOG_WRITER *ossl_quic_engine_get0_qlog_writer(QUIC_ENGINE *qeng)
+{
+    if (qeng->qlog_writer == NULL)
+        qeng->qlog_writer = ossl_qlog_writer_new();
+
+    return qeng->qlog_writer;
+}
+#endif
+
 OSSL_TIME ossl_quic_engine_get_time(QUIC_ENGINE *qeng)
 {
     if (qeng->now_cb == NULL)
@@ -122,6 +143,8 @@ static void qeng_tick(QUIC_TICK_RESULT *res, void *arg, uint32_t flags)
 {
     QUIC_ENGINE *qeng = arg;
     QUIC_PORT *port;
+    QUIC_CHANNEL *ch;
+    OSSL_TIME now, deadline;
 
     res->net_read_desired   = 0;
     res->net_write_desired  = 0;
@@ -130,6 +153,15 @@ static void qeng_tick(QUIC_TICK_RESULT *res, void *arg, uint32_t flags)
     if (qeng->inhibit_tick)
         return;
 
+    /*
+     * Queue the channels whose tick deadlines have passed for servicing. The
+     * wheel only gives up entries which expire strictly before the time it is
+     * given, so look one tick ahead to include deadlines which are exactly now.
+     */
+    now = ossl_time_add(ossl_quic_engine_get_time(qeng), ossl_ticks2time(1));
+    while ((ch = ossl_timer_wheel_expire(qeng->tw, now)) != NULL)
+        ossl_quic_channel_request_tick(ch);
+
     /* Iterate through all ports and service them. */
     LIST_FOREACH(port, port, &qeng->port_list) {
         QUIC_TICK_RESULT subr = {0};
@@ -137,4 +169,11 @@ static void qeng_tick(QUIC_TICK_RESULT *res, void *arg, uint32_t flags)
         ossl_quic_port_subtick(port, &subr, flags);
         ossl_quic_tick_result_merge_into(res, &subr);
     }
+
+    /*
+     * Channels which were not serviced on this tick are not included in the
+     * results from the ports, but their deadlines are all in the wheel.
+     */
+    deadline = ossl_timer_wheel_next_expiry(qeng->tw);
+    res->tick_deadline = ossl_time_min(res->tick_deadline, deadline);
 }
@@ -12,6 +12,7 @@
 
 # include "internal/quic_engine.h"
 # include "internal/quic_reactor.h"
+# include "internal/timer_wheel.h"
 
 # ifndef OPENSSL_NO_QUIC
 
@@ -50,6 +51,18 @@ struct quic_engine_st {
     /* List of all child ports. */
     OSSL_LIST(port)                 port_list;
 
+    /*
+     * Timer wheel holding the tick deadline of every channel in the engine,
+     * so that the engine can find the channels which need to be ticked and its
+     * own next tick deadline without visiting every channel.
+     */
+    OSSL_TIMER_WHEEL                *tw;
+
+#  if !defined(OPENSSL_NO_QLOG) && !defined(OPENSSL_NO_QLOG_ASYNC)
+    /* Asynchronous qlog writer, created on demand. */
+    QLOG_WRITER                     *qlog_writer;
+#  endif
+
     /* Inhibit tick for testing purposes? */
     unsigned int                    inhibit_tick                    : 1;
 };
@@ -17,6 +17,8 @@
 #include "internal/quic_error.h"
 #include "internal/quic_engine.h"
 #include "internal/quic_port.h"
+#include "internal/quic_cc.h"
+#include "internal/quic_datagram.h"
 #include "internal/time.h"
 
 typedef struct qctx_st QCTX;
@@ -30,6 +32,7 @@ static void quic_lock(QUIC_CONNECTION *qc);
 static void quic_unlock(QUIC_CONNECTION *qc);
 static void quic_lock_for_io(QCTX *ctx);
 static int quic_do_handshake(QCTX *ctx);
+static int quic_do_handshake_for_write(QCTX *ctx);
 static void qc_update_reject_policy(QUIC_CONNECTION *qc);
 static void qc_touch_default_xso(QUIC_CONNECTION *qc);
 static void qc_set_default_xso(QUIC_CONNECTION *qc, QUIC_XSO *xso, int touch);
@@ -48,6 +51,25 @@ static int qctx_should_autotick(QCTX *ctx);
  * ========================================
  */
 
+struct block_pred_args {
+    QUIC_CONNECTION *qc;
+    int             (*pred)(void *arg);
+    void            *pred_arg;
+};
+
+/*
+ * Predicates may act on the channel, for example by queueing more data to be
+ * sent, so the channel is serviced on every tick made while blocking.
+ */
+static int block_pred(void *arg)
+{
+    struct block_pred_args *args = arg;
+    int res = args->pred(args->pred_arg);
+
+    ossl_quic_channel_request_tick(args->qc->ch);
+    return res;
+}
+
 /*
  * Block until a predicate is met.
  *
@@ -60,6 +82,7 @@ static int block_until_pred(QUIC_CONNECTION *qc,
                             uint32_t flags)
 {
     QUIC_REACTOR *rtor;
+    struct block_pred_args args;
 
     assert(qc->ch != NULL);
 
@@ -69,8 +92,13 @@ static int block_until_pred(QUIC_CONNECTION *qc,
      */
     ossl_quic_engine_set_inhibit_tick(qc->engine, 0);
 
+    args.qc         = qc;
+    args.pred       = pred;
+    args.pred_arg   = pred_arg;
+
+    ossl_quic_channel_request_tick(qc->ch);
     rtor = ossl_quic_channel_get_reactor(qc->ch);
-    return ossl_quic_reactor_block_until_pred(rtor, pred, pred_arg, flags,
+    return ossl_quic_reactor_block_until_pred(rtor, block_pred, &args, flags,
                                               qc->mutex);
 }
 
@@ -260,7 +288,8 @@ static int ossl_unused expect_quic_with_stream_lock(const SSL *s, int remote_ini
         }
 
         /* If we haven't finished the handshake, try to advance it. */
-        if (quic_do_handshake(ctx) < 1)
+        if ((remote_init == 0 ? quic_do_handshake_for_write(ctx)
+                              : quic_do_handshake(ctx)) < 1)
             /* ossl_quic_do_handshake raised error here */
             goto err;
 
@@ -1065,8 +1094,10 @@ int ossl_quic_handle_events(SSL *s)
         return 0;
 
     quic_lock(ctx.qc);
-    if (ctx.qc->started)
+    if (ctx.qc->started) {
+        ossl_quic_channel_request_tick(ctx.qc->ch);
         ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(ctx.qc->ch), 0);
+    }
     quic_unlock(ctx.qc);
     return 1;
 }
@@ -1571,8 +1602,13 @@ static int ensure_channel_started(QCTX *ctx)
     return 1;
 }
 
+/*
+ * Advances the handshake. If allow_early_data is set, this also returns 1 once
+ * 0-RTT data can be sent, so that the caller can write application data before
+ * the handshake is complete.
+ */
 QUIC_NEEDS_LOCK
-static int quic_do_handshake(QCTX *ctx)
+static int quic_do_handshake_ex(QCTX *ctx, int allow_early_data)
 {
     int ret;
     QUIC_CONNECTION *qc = ctx->qc;
@@ -1680,6 +1716,13 @@ static int quic_do_handshake(QCTX *ctx)
         /* The handshake is now done. */
         return 1;
 
+    /*
+     * 0-RTT keys are available as soon as the channel is started, so there is
+     * no need to wait for them, even in blocking mode.
+     */
+    if (allow_early_data && ossl_quic_channel_can_send_early_data(qc->ch))
+        return 1;
+
     if (!qc_blocking_mode(qc)) {
         /* Try to advance the reactor. */
         qctx_maybe_autotick(ctx);
@@ -1688,6 +1731,9 @@ static int quic_do_handshake(QCTX *ctx)
             /* The handshake is now done. */
             return 1;
 
+        if (allow_early_data && ossl_quic_channel_can_send_early_data(qc->ch))
+            return 1;
+
         if (ossl_quic_channel_is_term_any(qc->ch)) {
             QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
             return 0;
@@ -1745,6 +1791,19 @@ static int quic_do_handshake(QCTX *ctx)
     return -1; /* Non-protocol error */
 }
 
+QUIC_NEEDS_LOCK
+static int quic_do_handshake(QCTX *ctx)
+{
+    return quic_do_handshake_ex(ctx, /*allow_early_data=*/0);
+}
+
+/* Used by stream write operations, which may send 0-RTT data. */
+QUIC_NEEDS_LOCK
+static int quic_do_handshake_for_write(QCTX *ctx)
+{
+    return quic_do_handshake_ex(ctx, /*allow_early_data=*/1);
+}
+
 QUIC_TAKES_LOCK
 int ossl_quic_do_handshake(SSL *s)
 {
@@ -2198,8 +2257,17 @@ static void quic_post_write(QUIC_XSO *xso, int did_append,
      * TODO(QUIC FUTURE): It is probably inefficient to try and do this
      * immediately, plus we should eventually consider Nagle's algorithm.
      */
-    if (do_tick)
+    if (do_tick) {
+        ossl_quic_channel_request_tick(xso->conn->ch);
         ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(xso->conn->ch), 0);
+    } else if (did_append
+               || (did_append_all && (flags & SSL_WRITE_FLAG_CONCLUDE) != 0)) {
+        /*
+         * The application handles events explicitly, so make sure it is told
+         * to do so now that there is something to send.
+         */
+        ossl_quic_channel_schedule_tick_now(xso->conn->ch);
+    }
 }
 
 struct quic_write_again_args {
@@ -2560,9 +2628,10 @@ int ossl_quic_write_flags(SSL *s, const void *buf, size_t len,
 
     /*
      * If we haven't finished the handshake, try to advance it.
-     * We don't accept writes until the handshake is completed.
+     * We don't accept writes until the handshake is completed, unless we can
+     * send them as 0-RTT data.
      */
-    if (quic_do_handshake(&ctx) < 1) {
+    if (quic_do_handshake_for_write(&ctx) < 1) {
         ret = 0;
         goto out;
     }
@@ -2600,6 +2669,218 @@ int ossl_quic_write(SSL *s, const void *buf, size_t len, size_t *written)
     return ossl_quic_write_flags(s, buf, len, 0, written);
 }
 
+/*
+ * SSL_writev
+ * ----------
+ *
+ * Scatter-gather write. The buffers are appended to the stream one after the
+ * other, so they are packetised as if they had been a single buffer. The write
+ * has the same blocking and partial write semantics as SSL_write_ex(); for an
+ * AON write in progress, the iovec array takes the place of the buffer.
+ */
+QUIC_NEEDS_LOCK
+static int xso_sstream_append_iov(QUIC_XSO *xso, const SSL_CONST_IOVEC *iov,
+                                  size_t num_iov, size_t pos,
+                                  size_t *actual_written)
+{
+    size_t i, n, total = 0;
+
+    for (i = 0; i < num_iov; i++) {
+        if (pos >= iov[i].buf_len) {
+            /* Already written */
+            pos -= iov[i].buf_len;
+            continue;
+        }
+
+        if (!xso_sstream_append(xso, (const unsigned char *)iov[i].buf + pos,
+                                iov[i].buf_len - pos, &n))
+            return 0;
+
+        total += n;
+        if (n < iov[i].buf_len - pos)
+            break;
+        pos = 0;
+    }
+
+    *actual_written = total;
+    return 1;
+}
+
+QUIC_NEEDS_LOCK
+static int quic_writev_nonblocking(QCTX *ctx, const SSL_CONST_IOVEC *iov,
+                                   size_t num_iov, size_t len, int aon,
+                                   size_t *written)
+{
+    QUIC_XSO *xso = ctx->xso;
+    const unsigned char *base = (const unsigned char *)iov;
+    size_t pos = 0, actual_written = 0;
+    int accept_moving_buffer
+        = ((xso->ssl_mode & SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER) != 0);
+
+    if (xso->aon_write_in_progress) {
+        if (!aon
+            || (!accept_moving_buffer && xso->aon_buf_base != base)
+            || len != xso->aon_buf_len)
+            return QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_BAD_WRITE_RETRY, NULL);
+
+        pos = xso->aon_buf_pos;
+    }
+
+    if (!xso_sstream_append_iov(xso, iov, num_iov, pos, &actual_written)) {
+        /* Stream already finished or allocation error. */
+        *written = 0;
+        return QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_INTERNAL_ERROR, NULL);
+    }
+
+    quic_post_write(xso, actual_written > 0, pos + actual_written == len, 0,
+                    qctx_should_autotick(ctx));
+
+    if (pos + actual_written == len) {
+        if (xso->aon_write_in_progress)
+            aon_write_finish(xso);
+        *written = len;
+        return 1;
+    }
+
+    if (!aon) {
+        *written = actual_written;
+        if (actual_written == 0)
+            return QUIC_RAISE_NORMAL_ERROR(ctx, SSL_ERROR_WANT_WRITE);
+        return 1;
+    }
+
+    if (xso->aon_write_in_progress)
+        xso->aon_buf_pos += actual_written;
+    else if (actual_written > 0)
+        aon_write_begin(xso, base, len, actual_written);
+
+    *written = 0;
+    return QUIC_RAISE_NORMAL_ERROR(ctx, SSL_ERROR_WANT_WRITE);
+}
+
+QUIC_TAKES_LOCK
+int ossl_quic_writev(SSL *s, const SSL_CONST_IOVEC *iov, size_t num_iov,
+                     size_t *written)
+{
+    int ret, err, partial_write;
+    QCTX ctx;
+    size_t i, n, len = 0;
+
+    *written = 0;
+
+    for (i = 0; i < num_iov; i++)
+        len += iov[i].buf_len;
+
+    if (len == 0)
+        return ossl_quic_write_flags(s, NULL, 0, 0, written);
+
+    if (!expect_quic_with_stream_lock(s, /*remote_init=*/0, /*io=*/1, &ctx))
+        return 0;
+
+    partial_write = ((ctx.xso->ssl_mode & SSL_MODE_ENABLE_PARTIAL_WRITE) != 0);
+
+    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/0)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+        goto out;
+    }
+
+    if (quic_do_handshake_for_write(&ctx) < 1) {
+        ret = 0;
+        goto out;
+    }
+
+    if (!quic_validate_for_write(ctx.xso, &err)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, err, NULL);
+        goto out;
+    }
+
+    if (xso_blocking_mode(ctx.xso)) {
+        ret = 1;
+        for (i = 0; i < num_iov && ret > 0; i++) {
+            if (iov[i].buf_len == 0)
+                continue;
+            ret = quic_write_blocking(&ctx, iov[i].buf, iov[i].buf_len, 0, &n);
+            if (ret > 0)
+                *written += n;
+        }
+    } else {
+        ret = quic_writev_nonblocking(&ctx, iov, num_iov, len, !partial_write,
+                                      written);
+    }
+
+out:
+    quic_unlock(ctx.qc);
+    return ret;
+}
+
+/*
+ * SSL_write_zc
+ * ------------
+ *
+ * Zero-copy write. The buffer is referenced by the stream rather than copied
+ * into the stream's ring buffer, so the only copy made is during packet
+ * encryption. The whole buffer is always accepted, regardless of blocking and
+ * partial write modes, as no buffer space is needed; flow control is applied
+ * when the data is packetised.
+ */
+QUIC_TAKES_LOCK
+int ossl_quic_write_zc(SSL *s, const void *buf, size_t len, uint64_t flags,
+                       SSL_write_zc_release_cb_fn release_cb, void *arg)
+{
+    int ret, err;
+    QCTX ctx;
+
+    if (len == 0) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+
+    if (!expect_quic_with_stream_lock(s, /*remote_init=*/0, /*io=*/1, &ctx))
+        return 0;
+
+    if ((flags & ~SSL_WRITE_FLAG_CONCLUDE) != 0) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_UNSUPPORTED_WRITE_FLAG, NULL);
+        goto out;
+    }
+
+    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/0)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+        goto out;
+    }
+
+    if (quic_do_handshake_for_write(&ctx) < 1) {
+        ret = 0;
+        goto out;
+    }
+
+    if (!quic_validate_for_write(ctx.xso, &err)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, err, NULL);
+        goto out;
+    }
+
+    /*
+     * The rest of an incomplete all-or-nothing SSL_write must be appended
+     * before any other data.
+     */
+    if (ctx.xso->aon_write_in_progress) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_BAD_WRITE_RETRY, NULL);
+        goto out;
+    }
+
+    if (!ossl_quic_sstream_append_ref(ctx.xso->stream->sstream, buf, len,
+                                      release_cb, arg)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+        goto out;
+    }
+
+    quic_post_write(ctx.xso, 1, 1, flags, qctx_should_autotick(&ctx));
+    ret = 1;
+
+out:
+    quic_unlock(ctx.qc);
+    return ret;
+}
+
 /*
  * SSL_read
  * --------
@@ -2609,6 +2890,8 @@ struct quic_read_again_args {
     QUIC_STREAM     *stream;
     void            *buf;
     size_t          len;
+    SSL_CONST_IOVEC *iov;
+    size_t          *num_iov;
     size_t          *bytes_read;
     int             peek;
 };
@@ -2655,6 +2938,7 @@ QUIC_NEEDS_LOCK
 static int quic_read_actual(QCTX *ctx,
                             QUIC_STREAM *stream,
                             void *buf, size_t buf_len,
+                            SSL_CONST_IOVEC *iov, size_t *num_iov,
                             size_t *bytes_read,
                             int peek)
 {
@@ -2670,7 +2954,17 @@ static int quic_read_actual(QCTX *ctx,
         }
     }
 
-    if (peek) {
+    if (iov != NULL) {
+        size_t n = *num_iov;
+
+        /* Zero-copy peek; *num_iov keeps its capacity until data arrives. */
+        if (!ossl_quic_rstream_peek_zc(stream->rstream, iov, &n,
+                                       bytes_read, &is_fin))
+            return QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_INTERNAL_ERROR, NULL);
+
+        if (*bytes_read > 0)
+            *num_iov = n;
+    } else if (peek) {
         if (!ossl_quic_rstream_peek(stream->rstream, buf, buf_len,
                                     bytes_read, &is_fin))
             return QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_INTERNAL_ERROR, NULL);
@@ -2729,8 +3023,8 @@ static int quic_read_again(void *arg)
     }
 
     if (!quic_read_actual(args->ctx, args->stream,
-                          args->buf, args->len, args->bytes_read,
-                          args->peek))
+                          args->buf, args->len, args->iov, args->num_iov,
+                          args->bytes_read, args->peek))
         return -1;
 
     if (*args->bytes_read > 0)
@@ -2741,7 +3035,9 @@ static int quic_read_again(void *arg)
 }
 
 QUIC_TAKES_LOCK
-static int quic_read(SSL *s, void *buf, size_t len, size_t *bytes_read, int peek)
+static int quic_read(SSL *s, void *buf, size_t len,
+                     SSL_CONST_IOVEC *iov, size_t *num_iov,
+                     size_t *bytes_read, int peek)
 {
     int ret, res;
     QCTX ctx;
@@ -2780,7 +3076,8 @@ static int quic_read(SSL *s, void *buf, size_t len, size_t *bytes_read, int peek
         ctx.xso = ctx.qc->default_xso;
     }
 
-    if (!quic_read_actual(&ctx, ctx.xso->stream, buf, len, bytes_read, peek)) {
+    if (!quic_read_actual(&ctx, ctx.xso->stream, buf, len, iov, num_iov,
+                          bytes_read, peek)) {
         ret = 0; /* quic_read_actual raised error here */
         goto out;
     }
@@ -2802,6 +3099,8 @@ static int quic_read(SSL *s, void *buf, size_t len, size_t *bytes_read, int peek
         args.stream     = ctx.xso->stream;
         args.buf        = buf;
         args.len        = len;
+        args.iov        = iov;
+        args.num_iov    = num_iov;
         args.bytes_read = bytes_read;
         args.peek       = peek;
 
@@ -2823,7 +3122,8 @@ static int quic_read(SSL *s, void *buf, size_t len, size_t *bytes_read, int peek
         qctx_maybe_autotick(&ctx);
 
         /* Try the read again. */
-        if (!quic_read_actual(&ctx, ctx.xso->stream, buf, len, bytes_read, peek)) {
+        if (!quic_read_actual(&ctx, ctx.xso->stream, buf, len, iov, num_iov,
+                          bytes_read, peek)) {
             ret = 0; /* quic_read_actual raised error here */
             goto out;
         }
@@ -2841,102 +3141,353 @@ out:
 
 int ossl_quic_read(SSL *s, void *buf, size_t len, size_t *bytes_read)
 {
-    return quic_read(s, buf, len, bytes_read, 0);
+    return quic_read(s, buf, len, NULL, NULL, bytes_read, 0);
 }
 
 int ossl_quic_peek(SSL *s, void *buf, size_t len, size_t *bytes_read)
 {
-    return quic_read(s, buf, len, bytes_read, 1);
+    return quic_read(s, buf, len, NULL, NULL, bytes_read, 1);
 }
 
-/*
- * SSL_pending
- * -----------
- */
+int ossl_quic_read_peek_zc(SSL *s, SSL_CONST_IOVEC *iov, size_t *num_iov,
+                           size_t *bytes_read)
+{
+    return quic_read(s, NULL, 0, iov, num_iov, bytes_read, 1);
+}
 
 QUIC_TAKES_LOCK
-static size_t ossl_quic_pending_int(const SSL *s, int check_channel)
+int ossl_quic_read_release(SSL *s, size_t len)
 {
+    int ret = 0, is_fin = 0;
     QCTX ctx;
-    size_t avail = 0;
+    QUIC_STREAM *qs;
+    QUIC_STREAM_MAP *qsm;
+    OSSL_RTT_INFO rtt_info;
 
-    if (!expect_quic(s, &ctx))
+    if (!expect_quic_with_stream_lock(s, /*remote_init=*/-1, /*io=*/1, &ctx))
         return 0;
 
-    quic_lock(ctx.qc);
+    qs  = ctx.xso->stream;
+    qsm = ossl_quic_channel_get_qsm(ctx.qc->ch);
 
-    if (!ctx.qc->started)
+    if (qs->rstream == NULL || !ossl_quic_rstream_is_zc_peeked(qs->rstream)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_PASSED_INVALID_ARGUMENT,
+                                          NULL);
         goto out;
+    }
 
-    if (ctx.xso == NULL) {
-        /* No XSO yet, but there might be a default XSO eligible to be created. */
-        if (qc_wait_for_default_xso_for_read(&ctx, /*peek=*/1)) {
-            ctx.xso = ctx.qc->default_xso;
-        } else {
-            QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_NO_STREAM, NULL);
-            goto out;
-        }
+    if (ossl_quic_stream_recv_is_reset(qs)) {
+        /*
+         * The receive part was reset while the application held pointers into
+         * it, so the QUIC_RSTREAM was kept alive until now. The data is
+         * discarded; the reset is reported by the next read.
+         */
+        ossl_quic_rstream_free(qs->rstream);
+        qs->rstream = NULL;
+        ret = 1;
+        goto out;
     }
 
-    if (ctx.xso->stream == NULL) {
-        QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+    if (!ossl_quic_rstream_release_zc(qs->rstream, len, &is_fin)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_PASSED_INVALID_ARGUMENT,
+                                          NULL);
         goto out;
     }
 
-    if (check_channel)
-        avail = ossl_quic_stream_recv_pending(ctx.xso->stream,
-                                              /*include_fin=*/1)
-             || ossl_quic_channel_has_pending(ctx.qc->ch)
-             || ossl_quic_channel_is_term_any(ctx.qc->ch);
-    else
-        avail = ossl_quic_stream_recv_pending(ctx.xso->stream,
-                                              /*include_fin=*/0);
+    if (len > 0) {
+        ossl_statm_get_rtt_info(ossl_quic_channel_get_statm(ctx.qc->ch),
+                                &rtt_info);
 
-out:
-    quic_unlock(ctx.qc);
-    return avail;
-}
+        if (!ossl_quic_rxfc_on_retire(&qs->rxfc, len,
+                                      rtt_info.smoothed_rtt)) {
+            ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+            goto out;
+        }
+    }
 
-size_t ossl_quic_pending(const SSL *s)
-{
-    return ossl_quic_pending_int(s, /*check_channel=*/0);
-}
+    if (is_fin)
+        ossl_quic_stream_map_notify_totally_read(qsm, qs);
 
-int ossl_quic_has_pending(const SSL *s)
-{
-    /* Do we have app-side pending data or pending URXEs or RXEs? */
-    return ossl_quic_pending_int(s, /*check_channel=*/1) > 0;
+    if (len > 0)
+        ossl_quic_stream_map_update_state(qsm, qs);
+
+    qctx_maybe_autotick(&ctx);
+    ret = 1;
+
+out:
+    quic_unlock(ctx.qc);
+    return ret;
 }
 
 /*
- * SSL_stream_conclude
- * -------------------
+ * SSL_write_datagram, SSL_read_datagram
+ * -------------------------------------
+ *
+ * Unreliable datagrams carried in RFC 9221 DATAGRAM frames. These are sent and
+ * received on the connection rather than on a stream. Datagrams are queued for
+ * transmission without blocking and are not retransmitted if lost. Both the
+ * TX and RX queues are bounded and the oldest datagram is dropped when a queue
+ * is full, so datagrams are dropped rather than queued indefinitely when
+ * congestion control or the application cannot keep up.
  */
 QUIC_TAKES_LOCK
-int ossl_quic_conn_stream_conclude(SSL *s)
+int ossl_quic_write_datagram(SSL *s, const void *buf, size_t len)
 {
+    int ret;
     QCTX ctx;
-    QUIC_STREAM *qs;
-    int err;
 
-    if (!expect_quic_with_stream_lock(s, /*remote_init=*/0, /*io=*/0, &ctx))
+    if (!expect_quic_conn_only(s, &ctx))
         return 0;
 
-    qs = ctx.xso->stream;
+    quic_lock_for_io(&ctx);
 
-    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/1)) {
-        quic_unlock(ctx.qc);
-        return QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/0)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+        goto out;
     }
 
-    if (!quic_validate_for_write(ctx.xso, &err)) {
-        quic_unlock(ctx.qc);
-        return QUIC_RAISE_NON_NORMAL_ERROR(&ctx, err, NULL);
+    if (quic_do_handshake(&ctx) < 1) {
+        ret = 0;
+        goto out;
     }
 
-    if (ossl_quic_sstream_get_final_size(qs->sstream, NULL)) {
-        quic_unlock(ctx.qc);
-        return 1;
+    if (ossl_quic_channel_get_max_datagram_frame_size_peer_request(ctx.qc->ch) == 0) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_DATAGRAMS_NOT_NEGOTIATED,
+                                          NULL);
+        goto out;
+    }
+
+    if (len > ossl_quic_channel_get_max_datagram_write_size(ctx.qc->ch)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_DATA_LENGTH_TOO_LONG, NULL);
+        goto out;
+    }
+
+    if (!ossl_quic_datagram_queue_push(ossl_quic_channel_get0_datagram_txq(ctx.qc->ch),
+                                       buf, len)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+        goto out;
+    }
+
+    qctx_maybe_autotick(&ctx);
+    ret = 1;
+
+out:
+    quic_unlock(ctx.qc);
+    return ret;
+}
+
+struct quic_read_datagram_args {
+    QCTX            *ctx;
+    void            *buf;
+    size_t          len;
+    size_t          *bytes_read;
+};
+
+/*
+ * Tries to read a datagram. Returns 1 if a datagram was read, 0 if there is no
+ * datagram available, or -1 on error.
+ */
+QUIC_NEEDS_LOCK
+static int quic_read_datagram_actual(QCTX *ctx, void *buf, size_t len,
+                                     size_t *bytes_read)
+{
+    QUIC_DATAGRAM_QUEUE *q = ossl_quic_channel_get0_datagram_rxq(ctx->qc->ch);
+    const unsigned char *data;
+    size_t data_len;
+
+    if (!ossl_quic_datagram_queue_peek(q, &data, &data_len))
+        return 0;
+
+    /* Fail without consuming the datagram so the caller can retry. */
+    if (data_len > len) {
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_BAD_LENGTH, NULL);
+        return -1;
+    }
+
+    if (data_len > 0)
+        memcpy(buf, data, data_len);
+
+    *bytes_read = data_len;
+    ossl_quic_datagram_queue_pop(q);
+    return 1;
+}
+
+QUIC_NEEDS_LOCK
+static int quic_read_datagram_again(void *arg)
+{
+    struct quic_read_datagram_args *args = arg;
+
+    if (!quic_mutation_allowed(args->ctx->qc, /*req_active=*/1)) {
+        /* If connection is torn down due to an error while blocking, stop. */
+        QUIC_RAISE_NON_NORMAL_ERROR(args->ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+        return -1;
+    }
+
+    return quic_read_datagram_actual(args->ctx, args->buf, args->len,
+                                     args->bytes_read);
+}
+
+QUIC_TAKES_LOCK
+int ossl_quic_read_datagram(SSL *s, void *buf, size_t len, size_t *bytes_read)
+{
+    int ret, res;
+    QCTX ctx;
+    struct quic_read_datagram_args args;
+
+    *bytes_read = 0;
+
+    if (!expect_quic_conn_only(s, &ctx))
+        return 0;
+
+    quic_lock_for_io(&ctx);
+
+    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/0)) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+        goto out;
+    }
+
+    if (quic_do_handshake(&ctx) < 1) {
+        ret = 0;
+        goto out;
+    }
+
+    if (ossl_quic_channel_get_max_datagram_frame_size_request(ctx.qc->ch) == 0) {
+        ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_DATAGRAMS_NOT_NEGOTIATED,
+                                          NULL);
+        goto out;
+    }
+
+    res = quic_read_datagram_actual(&ctx, buf, len, bytes_read);
+    if (res < 0) {
+        ret = 0;
+        goto out;
+    }
+
+    if (res == 0 && qc_blocking_mode(ctx.qc)) {
+        args.ctx        = &ctx;
+        args.buf        = buf;
+        args.len        = len;
+        args.bytes_read = bytes_read;
+
+        res = block_until_pred(ctx.qc, quic_read_datagram_again, &args, 0);
+        if (res == 0) {
+            ret = QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+            goto out;
+        } else if (res < 0) {
+            ret = 0; /* quic_read_datagram_again raised error here */
+            goto out;
+        }
+    } else if (res == 0) {
+        /* Tick to see if this delivers any datagrams, then try again. */
+        qctx_maybe_autotick(&ctx);
+
+        res = quic_read_datagram_actual(&ctx, buf, len, bytes_read);
+        if (res < 0) {
+            ret = 0;
+            goto out;
+        } else if (res == 0) {
+            ret = QUIC_RAISE_NORMAL_ERROR(&ctx, SSL_ERROR_WANT_READ);
+            goto out;
+        }
+    } else {
+        qctx_maybe_autotick(&ctx);
+    }
+
+    ret = 1;
+
+out:
+    quic_unlock(ctx.qc);
+    return ret;
+}
+
+/*
+ * SSL_pending
+ * -----------
+ */
+
+QUIC_TAKES_LOCK
+static size_t ossl_quic_pending_int(const SSL *s, int check_channel)
+{
+    QCTX ctx;
+    size_t avail = 0;
+
+    if (!expect_quic(s, &ctx))
+        return 0;
+
+    quic_lock(ctx.qc);
+
+    if (!ctx.qc->started)
+        goto out;
+
+    if (ctx.xso == NULL) {
+        /* No XSO yet, but there might be a default XSO eligible to be created. */
+        if (qc_wait_for_default_xso_for_read(&ctx, /*peek=*/1)) {
+            ctx.xso = ctx.qc->default_xso;
+        } else {
+            QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_NO_STREAM, NULL);
+            goto out;
+        }
+    }
+
+    if (ctx.xso->stream == NULL) {
+        QUIC_RAISE_NON_NORMAL_ERROR(&ctx, ERR_R_INTERNAL_ERROR, NULL);
+        goto out;
+    }
+
+    if (check_channel)
+        avail = ossl_quic_stream_recv_pending(ctx.xso->stream,
+                                              /*include_fin=*/1)
+             || ossl_quic_channel_has_pending(ctx.qc->ch)
+             || ossl_quic_channel_is_term_any(ctx.qc->ch);
+    else
+        avail = ossl_quic_stream_recv_pending(ctx.xso->stream,
+                                              /*include_fin=*/0);
+
+out:
+    quic_unlock(ctx.qc);
+    return avail;
+}
+
+size_t ossl_quic_pending(const SSL *s)
+{
+    return ossl_quic_pending_int(s, /*check_channel=*/0);
+}
+
+int ossl_quic_has_pending(const SSL *s)
+{
+    /* Do we have app-side pending data or pending URXEs or RXEs? */
+    return ossl_quic_pending_int(s, /*check_channel=*/1) > 0;
+}
+
+/*
+ * SSL_stream_conclude
+ * -------------------
+ */
+QUIC_TAKES_LOCK
+int ossl_quic_conn_stream_conclude(SSL *s)
+{
+    QCTX ctx;
+    QUIC_STREAM *qs;
+    int err;
+
+    if (!expect_quic_with_stream_lock(s, /*remote_init=*/0, /*io=*/0, &ctx))
+        return 0;
+
+    qs = ctx.xso->stream;
+
+    if (!quic_mutation_allowed(ctx.qc, /*req_active=*/1)) {
+        quic_unlock(ctx.qc);
+        return QUIC_RAISE_NON_NORMAL_ERROR(&ctx, SSL_R_PROTOCOL_IS_SHUTDOWN, NULL);
+    }
+
+    if (!quic_validate_for_write(ctx.xso, &err)) {
+        quic_unlock(ctx.qc);
+        return QUIC_RAISE_NON_NORMAL_ERROR(&ctx, err, NULL);
+    }
+
+    if (ossl_quic_sstream_get_final_size(qs->sstream, NULL)) {
+        quic_unlock(ctx.qc);
+        return 1;
     }
 
     ossl_quic_sstream_fin(qs->sstream);
@@ -3347,6 +3898,7 @@ static void qctx_maybe_autotick(QCTX *ctx)
     if (!qctx_should_autotick(ctx))
         return;
 
+    ossl_quic_channel_request_tick(ctx->qc->ch);
     ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(ctx->qc->ch), 0);
 }
 
@@ -3398,6 +3950,201 @@ err:
     return ret;
 }
 
+QUIC_TAKES_LOCK
+static int qc_getset_datagram_max_frame_size(QCTX *ctx, uint32_t class_,
+                                             uint64_t *p_value_out,
+                                             uint64_t *p_value_in)
+{
+    int ret = 0;
+    uint64_t value_out = 0, value_in;
+
+    quic_lock(ctx->qc);
+
+    switch (class_) {
+    case SSL_VALUE_CLASS_FEATURE_REQUEST:
+        value_out = ossl_quic_channel_get_max_datagram_frame_size_request(ctx->qc->ch);
+
+        if (p_value_in != NULL) {
+            value_in = *p_value_in;
+            if (value_in > OSSL_QUIC_VLINT_MAX) {
+                QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_PASSED_INVALID_ARGUMENT,
+                                            NULL);
+                goto err;
+            }
+
+            if (ossl_quic_channel_have_generated_transport_params(ctx->qc->ch)) {
+                QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_FEATURE_NOT_RENEGOTIABLE,
+                                            NULL);
+                goto err;
+            }
+
+            ossl_quic_channel_set_max_datagram_frame_size_request(ctx->qc->ch,
+                                                                  value_in);
+        }
+        break;
+
+    case SSL_VALUE_CLASS_FEATURE_PEER_REQUEST:
+        if (p_value_in != NULL) {
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_UNSUPPORTED_CONFIG_VALUE_OP,
+                                        NULL);
+            goto err;
+        }
+
+        if (!ossl_quic_channel_is_handshake_complete(ctx->qc->ch)) {
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_FEATURE_NEGOTIATION_NOT_COMPLETE,
+                                        NULL);
+            goto err;
+        }
+
+        value_out = ossl_quic_channel_get_max_datagram_frame_size_peer_request(ctx->qc->ch);
+        break;
+
+    default:
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_UNSUPPORTED_CONFIG_VALUE_CLASS,
+                                    NULL);
+        goto err;
+    }
+
+    ret = 1;
+err:
+    quic_unlock(ctx->qc);
+    if (ret && p_value_out != NULL)
+        *p_value_out = value_out;
+
+    return ret;
+}
+
+QUIC_TAKES_LOCK
+static int qc_get_datagram_max_write_size(QCTX *ctx, uint32_t class_,
+                                          uint64_t *p_value_out)
+{
+    int ret = 0;
+
+    quic_lock(ctx->qc);
+
+    if (class_ != SSL_VALUE_CLASS_GENERIC) {
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_UNSUPPORTED_CONFIG_VALUE_CLASS,
+                                    NULL);
+        goto err;
+    }
+
+    if (!ossl_quic_channel_is_handshake_complete(ctx->qc->ch)) {
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_FEATURE_NEGOTIATION_NOT_COMPLETE,
+                                    NULL);
+        goto err;
+    }
+
+    *p_value_out = ossl_quic_channel_get_max_datagram_write_size(ctx->qc->ch);
+    ret = 1;
+err:
+    quic_unlock(ctx->qc);
+    return ret;
+}
+
+QUIC_TAKES_LOCK
+static int qc_getset_cc_algorithm(QCTX *ctx, uint32_t class_,
+                                  uint64_t *p_value_out,
+                                  uint64_t *p_value_in)
+{
+    int ret = 0;
+    uint64_t value_out = 0;
+    const OSSL_CC_METHOD *cc_method = NULL;
+
+    quic_lock(ctx->qc);
+
+    if (class_ != SSL_VALUE_CLASS_GENERIC) {
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_UNSUPPORTED_CONFIG_VALUE_CLASS,
+                                    NULL);
+        goto err;
+    }
+
+    if (p_value_in != NULL) {
+        switch (*p_value_in) {
+        case SSL_VALUE_QUIC_CC_ALGORITHM_NEWRENO:
+            cc_method = &ossl_cc_newreno_method;
+            break;
+        case SSL_VALUE_QUIC_CC_ALGORITHM_BBR:
+            cc_method = &ossl_cc_bbr_method;
+            break;
+        default:
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_PASSED_INVALID_ARGUMENT,
+                                        NULL);
+            goto err;
+        }
+
+        /* The algorithm cannot be changed once the connection has started. */
+        if (!ossl_quic_channel_set_cc_method(ctx->qc->ch, cc_method)) {
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_FEATURE_NOT_RENEGOTIABLE,
+                                        NULL);
+            goto err;
+        }
+
+        value_out = *p_value_in;
+    } else {
+        cc_method = ossl_quic_channel_get_cc_method(ctx->qc->ch);
+        value_out = cc_method == &ossl_cc_bbr_method
+            ? SSL_VALUE_QUIC_CC_ALGORITHM_BBR
+            : SSL_VALUE_QUIC_CC_ALGORITHM_NEWRENO;
+    }
+
+    ret = 1;
+err:
+    quic_unlock(ctx->qc);
+    if (ret && p_value_out != NULL)
+        *p_value_out = value_out;
+
+    return ret;
+}
+
+QUIC_TAKES_LOCK
+static int qc_getset_early_data(QCTX *ctx, uint32_t class_,
+                                uint64_t *p_value_out,
+                                uint64_t *p_value_in)
+{
+    int ret = 0;
+    uint64_t value_out = 0;
+
+    quic_lock(ctx->qc);
+
+    if (class_ != SSL_VALUE_CLASS_GENERIC) {
+        QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_UNSUPPORTED_CONFIG_VALUE_CLASS,
+                                    NULL);
+        goto err;
+    }
+
+    if (p_value_in != NULL) {
+        if (*p_value_in > 1) {
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, ERR_R_PASSED_INVALID_ARGUMENT,
+                                        NULL);
+            goto err;
+        }
+
+        /*
+         * Only a client can send early data, and this cannot be changed once
+         * the connection has started.
+         */
+        if (ctx->qc->as_server
+            || !ossl_quic_channel_set_early_data_enabled(ctx->qc->ch,
+                                                         (int)*p_value_in)) {
+            QUIC_RAISE_NON_NORMAL_ERROR(ctx, SSL_R_FEATURE_NOT_RENEGOTIABLE,
+                                        NULL);
+            goto err;
+        }
+
+        value_out = *p_value_in;
+    } else {
+        value_out = ossl_quic_channel_get_early_data_enabled(ctx->qc->ch);
+    }
+
+    ret = 1;
+err:
+    quic_unlock(ctx->qc);
+    if (ret && p_value_out != NULL)
+        *p_value_out = value_out;
+
+    return ret;
+}
+
 QUIC_TAKES_LOCK
 static int qc_get_stream_write_buf_stat(QCTX *ctx, uint32_t class_,
                                         uint64_t *p_value_out,
@@ -3477,6 +4224,17 @@ int ossl_quic_get_value_uint(SSL *s, uint32_t class_, uint32_t id,
     case SSL_VALUE_EVENT_HANDLING_MODE:
         return qc_getset_event_handling(&ctx, class_, value, NULL);
 
+    case SSL_VALUE_QUIC_CC_ALGORITHM:
+        return qc_getset_cc_algorithm(&ctx, class_, value, NULL);
+
+    case SSL_VALUE_QUIC_EARLY_DATA:
+        return qc_getset_early_data(&ctx, class_, value, NULL);
+
+    case SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE:
+        return qc_getset_datagram_max_frame_size(&ctx, class_, value, NULL);
+    case SSL_VALUE_QUIC_DATAGRAM_MAX_WRITE_SIZE:
+        return qc_get_datagram_max_write_size(&ctx, class_, value);
+
     case SSL_VALUE_STREAM_WRITE_BUF_SIZE:
         return qc_get_stream_write_buf_stat(&ctx, class_, value,
                                             ossl_quic_sstream_get_buffer_size);
@@ -3511,6 +4269,15 @@ int ossl_quic_set_value_uint(SSL *s, uint32_t class_, uint32_t id,
     case SSL_VALUE_EVENT_HANDLING_MODE:
         return qc_getset_event_handling(&ctx, class_, NULL, &value);
 
+    case SSL_VALUE_QUIC_CC_ALGORITHM:
+        return qc_getset_cc_algorithm(&ctx, class_, NULL, &value);
+
+    case SSL_VALUE_QUIC_EARLY_DATA:
+        return qc_getset_early_data(&ctx, class_, NULL, &value);
+
+    case SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE:
+        return qc_getset_datagram_max_frame_size(&ctx, class_, NULL, &value);
+
     default:
         return QUIC_RAISE_NON_NORMAL_ERROR(&ctx,
                                            SSL_R_UNSUPPORTED_CONFIG_VALUE, NULL);
@@ -4108,8 +4875,10 @@ int ossl_quic_conn_poll_events(SSL *ssl, uint64_t events, int do_tick,
         goto end;
     }
 
-    if (do_tick)
+    if (do_tick) {
+        ossl_quic_channel_request_tick(ctx.qc->ch);
         ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(ctx.qc->ch), 0);
+    }
 
     if (ctx.xso != NULL) {
         /* SSL object has a stream component. */
@@ -4163,6 +4932,44 @@ int ossl_quic_conn_poll_events(SSL *ssl, uint64_t events, int do_tick,
     return 1;
 }
 
+QUIC_TAKES_LOCK
+int ossl_quic_conn_get_poll_wait(SSL *ssl, const void **key,
+                                 BIO_POLL_DESCRIPTOR *r,
+                                 BIO_POLL_DESCRIPTOR *w,
+                                 int *wait_fd, OSSL_TIME *deadline)
+{
+    QCTX ctx;
+    QUIC_REACTOR *rtor;
+
+    if (!expect_quic(ssl, &ctx))
+        return 0;
+
+    quic_lock(ctx.qc);
+
+    *key        = ctx.qc;
+    r->type     = BIO_POLL_DESCRIPTOR_TYPE_NONE;
+    w->type     = BIO_POLL_DESCRIPTOR_TYPE_NONE;
+    *wait_fd    = -1;
+    *deadline   = ossl_time_infinite();
+
+    /* Nothing happens on a connection that has not been started */
+    if (ctx.qc->started) {
+        rtor = ossl_quic_channel_get_reactor(ctx.qc->ch);
+
+        *key = rtor;
+        if (ossl_quic_reactor_net_read_desired(rtor))
+            *r = *ossl_quic_reactor_get_poll_r(rtor);
+        if (ossl_quic_reactor_net_write_desired(rtor))
+            *w = *ossl_quic_reactor_get_poll_w(rtor);
+        if (!ossl_quic_reactor_get_wait_fd(rtor, wait_fd))
+            *wait_fd = -1;
+        *deadline = ossl_quic_reactor_get_tick_deadline(rtor);
+    }
+
+    quic_unlock(ctx.qc);
+    return 1;
+}
+
 /*
  * Internal Testing APIs
  * =====================
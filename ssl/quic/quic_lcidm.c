@@ -11,6 +11,7 @@
 #include "internal/quic_types.h"
 #include "internal/quic_vlint.h"
 #include "internal/common.h"
+#include "crypto/siphash.h"
 #include <openssl/lhash.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
@@ -32,6 +33,9 @@ typedef struct quic_lcid_st {
     QUIC_CONN_ID                cid;
     uint64_t                    seq_num;
 
+    /* Keyed hash of cid; see lcidm_cid_hash(). */
+    uint64_t                    hash;
+
     /* Back-pointer to the owning QUIC_LCIDM_CONN structure. */
     QUIC_LCIDM_CONN             *conn;
 
@@ -58,30 +62,62 @@ struct quic_lcidm_st {
     LHASH_OF(QUIC_LCID)         *lcids; /* (QUIC_CONN_ID) -> (QUIC_LCID *)  */
     LHASH_OF(QUIC_LCIDM_CONN)   *conns; /* (void *opaque) -> (QUIC_LCIDM_CONN *) */
     size_t                      lcid_len; /* Length in bytes for all LCIDs */
+    int                         routing_byte; /* First LCID byte or -1 */
+#ifndef OPENSSL_NO_SIPHASH
+    SIPHASH                     siphash; /* Keyed, initialised SipHash-2-4 */
+#endif
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
     QUIC_CONN_ID                next_lcid;
 #endif
 };
 
-static unsigned long bin_hash(const unsigned char *buf, size_t buf_len)
+/*
+ * The CIDs we look up come off the wire, and at least the ODCID is chosen by
+ * the peer, so an unkeyed hash would let a client pick CIDs which all land in
+ * the same bucket. Instead we hash the CID, padded to its fixed maximum length,
+ * under a random per-LCIDM SipHash key. The hash is computed once when a
+ * QUIC_LCID is created (or a lookup key is built) and cached in the object,
+ * since the LHASH callbacks have no way to reach the key.
+ */
+static uint64_t lcidm_cid_hash(const QUIC_LCIDM *lcidm, const QUIC_CONN_ID *cid)
 {
-    unsigned long hash = 0;
+    unsigned char buf[1 + QUIC_MAX_CONN_ID_LEN] = {0};
+#ifndef OPENSSL_NO_SIPHASH
+    SIPHASH siphash = lcidm->siphash;
+    unsigned char out[SIPHASH_MIN_DIGEST_SIZE];
+#else
+    uint64_t hash = 0;
     size_t i;
+#endif
+
+    buf[0] = cid->id_len;
+    memcpy(buf + 1, cid->id, cid->id_len);
+
+#ifndef OPENSSL_NO_SIPHASH
+    SipHash_Update(&siphash, buf, sizeof(buf));
+    if (!SipHash_Final(&siphash, out, sizeof(out)))
+        return 0;
 
-    for (i = 0; i < buf_len; ++i)
-        hash ^= ((unsigned long)buf[i]) << (8 * (i % sizeof(unsigned long)));
+    return (uint64_t)out[0]       | (uint64_t)out[1] << 8
+        | (uint64_t)out[2] << 16  | (uint64_t)out[3] << 24
+        | (uint64_t)out[4] << 32  | (uint64_t)out[5] << 40
+        | (uint64_t)out[6] << 48  | (uint64_t)out[7] << 56;
+#else
+    for (i = 0; i < sizeof(buf); ++i)
+        hash ^= ((uint64_t)buf[i]) << (8 * (i % sizeof(uint64_t)));
 
     return hash;
+#endif
 }
 
 static unsigned long lcid_hash(const QUIC_LCID *lcid_obj)
 {
-    return bin_hash(lcid_obj->cid.id, lcid_obj->cid.id_len);
+    return (unsigned long)lcid_obj->hash;
 }
 
 static int lcid_comp(const QUIC_LCID *a, const QUIC_LCID *b)
 {
-    return !ossl_quic_conn_id_eq(&a->cid, &b->cid);
+    return a->hash != b->hash || !ossl_quic_conn_id_eq(&a->cid, &b->cid);
 }
 
 static unsigned long lcidm_conn_hash(const QUIC_LCIDM_CONN *conn)
@@ -97,6 +133,9 @@ static int lcidm_conn_comp(const QUIC_LCIDM_CONN *a, const QUIC_LCIDM_CONN *b)
 QUIC_LCIDM *ossl_quic_lcidm_new(OSSL_LIB_CTX *libctx, size_t lcid_len)
 {
     QUIC_LCIDM *lcidm = NULL;
+#ifndef OPENSSL_NO_SIPHASH
+    unsigned char siphash_key[SIPHASH_KEY_SIZE];
+#endif
 
     if (lcid_len > QUIC_MAX_CONN_ID_LEN)
         goto err;
@@ -104,6 +143,17 @@ QUIC_LCIDM *ossl_quic_lcidm_new(OSSL_LIB_CTX *libctx, size_t lcid_len)
     if ((lcidm = OPENSSL_zalloc(sizeof(*lcidm))) == NULL)
         goto err;
 
+#ifndef OPENSSL_NO_SIPHASH
+    if (RAND_bytes_ex(libctx, siphash_key, sizeof(siphash_key), 0) <= 0)
+        goto err;
+
+    if (!SipHash_set_hash_size(&lcidm->siphash, SIPHASH_MIN_DIGEST_SIZE)
+        || !SipHash_Init(&lcidm->siphash, siphash_key, 0, 0))
+        goto err;
+
+    OPENSSL_cleanse(siphash_key, sizeof(siphash_key));
+#endif
+
     if ((lcidm->lcids = lh_QUIC_LCID_new(lcid_hash, lcid_comp)) == NULL)
         goto err;
 
@@ -111,8 +161,9 @@ QUIC_LCIDM *ossl_quic_lcidm_new(OSSL_LIB_CTX *libctx, size_t lcid_len)
                                                lcidm_conn_comp)) == NULL)
         goto err;
 
-    lcidm->libctx   = libctx;
-    lcidm->lcid_len = lcid_len;
+    lcidm->libctx       = libctx;
+    lcidm->lcid_len     = lcid_len;
+    lcidm->routing_byte = -1;
     return lcidm;
 
 err:
@@ -159,18 +210,19 @@ void ossl_quic_lcidm_free(QUIC_LCIDM *lcidm)
 
     lh_QUIC_LCID_free(lcidm->lcids);
     lh_QUIC_LCIDM_CONN_free(lcidm->conns);
-    OPENSSL_free(lcidm);
+    OPENSSL_clear_free(lcidm, sizeof(*lcidm));
 }
 
 static QUIC_LCID *lcidm_get0_lcid(const QUIC_LCIDM *lcidm, const QUIC_CONN_ID *lcid)
 {
     QUIC_LCID key;
 
-    key.cid = *lcid;
-
-    if (key.cid.id_len > QUIC_MAX_CONN_ID_LEN)
+    if (lcid->id_len > QUIC_MAX_CONN_ID_LEN)
         return NULL;
 
+    key.cid  = *lcid;
+    key.hash = lcidm_cid_hash(lcidm, lcid);
+
     return lh_QUIC_LCID_retrieve(lcidm->lcids, &key);
 }
 
@@ -250,6 +302,7 @@ static QUIC_LCID *lcidm_conn_new_lcid(QUIC_LCIDM *lcidm, QUIC_LCIDM_CONN *conn,
         goto err;
 
     lcid_obj->cid = *lcid;
+    lcid_obj->hash = lcidm_cid_hash(lcidm, lcid);
     lcid_obj->conn = conn;
 
     lh_QUIC_LCID_insert(conn->lcids, lcid_obj);
@@ -275,6 +328,16 @@ size_t ossl_quic_lcidm_get_lcid_len(const QUIC_LCIDM *lcidm)
     return lcidm->lcid_len;
 }
 
+int ossl_quic_lcidm_set_routing_byte(QUIC_LCIDM *lcidm, int routing_byte)
+{
+    if (routing_byte > 0xff
+        || (routing_byte >= 0 && lcidm->lcid_len == 0))
+        return 0;
+
+    lcidm->routing_byte = routing_byte < 0 ? -1 : routing_byte;
+    return 1;
+}
+
 size_t ossl_quic_lcidm_get_num_active_lcid(const QUIC_LCIDM *lcidm,
                                            void *opaque)
 {
@@ -302,7 +365,13 @@ static int lcidm_generate_cid(QUIC_LCIDM *lcidm,
 
     return 1;
 #else
-    return ossl_quic_gen_rand_conn_id(lcidm->libctx, lcidm->lcid_len, cid);
+    if (!ossl_quic_gen_rand_conn_id(lcidm->libctx, lcidm->lcid_len, cid))
+        return 0;
+
+    if (lcidm->routing_byte >= 0)
+        cid->id[0] = (unsigned char)lcidm->routing_byte;
+
+    return 1;
 #endif
 }
 
@@ -313,7 +382,7 @@ static int lcidm_generate(QUIC_LCIDM *lcidm,
                           uint64_t *seq_num)
 {
     QUIC_LCIDM_CONN *conn;
-    QUIC_LCID key, *lcid_obj;
+    QUIC_LCID *lcid_obj;
     size_t i;
 #define MAX_RETRIES 8
 
@@ -336,9 +405,8 @@ static int lcidm_generate(QUIC_LCIDM *lcidm,
         if (!lcidm_generate_cid(lcidm, lcid_out))
             return 0;
 
-        key.cid = *lcid_out;
         /* If a collision occurs, retry. */
-    } while (lh_QUIC_LCID_retrieve(lcidm->lcids, &key) != NULL);
+    } while (lcidm_get0_lcid(lcidm, lcid_out) != NULL);
 
     if ((lcid_obj = lcidm_conn_new_lcid(lcidm, conn, lcid_out)) == NULL)
         return 0;
@@ -358,7 +426,7 @@ int ossl_quic_lcidm_enrol_odcid(QUIC_LCIDM *lcidm,
                                 const QUIC_CONN_ID *initial_odcid)
 {
     QUIC_LCIDM_CONN *conn;
-    QUIC_LCID key, *lcid_obj;
+    QUIC_LCID *lcid_obj;
 
     if (initial_odcid == NULL || initial_odcid->id_len < QUIC_MIN_ODCID_LEN
         || initial_odcid->id_len > QUIC_MAX_CONN_ID_LEN)
@@ -370,8 +438,7 @@ int ossl_quic_lcidm_enrol_odcid(QUIC_LCIDM *lcidm,
     if (conn->done_odcid)
         return 0;
 
-    key.cid = *initial_odcid;
-    if (lh_QUIC_LCID_retrieve(lcidm->lcids, &key) != NULL)
+    if (lcidm_get0_lcid(lcidm, initial_odcid) != NULL)
         return 0;
 
     if ((lcid_obj = lcidm_conn_new_lcid(lcidm, conn, initial_odcid)) == NULL)
@@ -520,10 +587,9 @@ int ossl_quic_lcidm_lookup(QUIC_LCIDM *lcidm,
 int ossl_quic_lcidm_debug_remove(QUIC_LCIDM *lcidm,
                                  const QUIC_CONN_ID *lcid)
 {
-    QUIC_LCID key, *lcid_obj;
+    QUIC_LCID *lcid_obj;
 
-    key.cid = *lcid;
-    if ((lcid_obj = lh_QUIC_LCID_retrieve(lcidm->lcids, &key)) == NULL)
+    if ((lcid_obj = lcidm_get0_lcid(lcidm, lcid)) == NULL)
         return 0;
 
     lcidm_delete_conn_lcid(lcidm, lcid_obj);
@@ -535,7 +601,7 @@ int ossl_quic_lcidm_debug_add(QUIC_LCIDM *lcidm, void *opaque,
                               uint64_t seq_num)
 {
     QUIC_LCIDM_CONN *conn;
-    QUIC_LCID key, *lcid_obj;
+    QUIC_LCID *lcid_obj;
 
     if (lcid == NULL || lcid->id_len > QUIC_MAX_CONN_ID_LEN)
         return 0;
@@ -543,8 +609,7 @@ int ossl_quic_lcidm_debug_add(QUIC_LCIDM *lcidm, void *opaque,
     if ((conn = lcidm_upsert_conn(lcidm, opaque)) == NULL)
         return 0;
 
-    key.cid = *lcid;
-    if (lh_QUIC_LCID_retrieve(lcidm->lcids, &key) != NULL)
+    if (lcidm_get0_lcid(lcidm, lcid) != NULL)
         return 0;
 
     if ((lcid_obj = lcidm_conn_new_lcid(lcidm, conn, lcid)) == NULL)
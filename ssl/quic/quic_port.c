@@ -11,6 +11,7 @@
 #include "internal/quic_channel.h"
 #include "internal/quic_lcidm.h"
 #include "internal/quic_srtm.h"
+#include "internal/quic_shard.h"
 #include "quic_port_local.h"
 #include "quic_channel_local.h"
 #include "quic_engine_local.h"
@@ -30,6 +31,7 @@ static void port_default_packet_handler(QUIC_URXE *e, void *arg,
 static void port_rx_pre(QUIC_PORT *port);
 
 DEFINE_LIST_OF_IMPL(ch, QUIC_CHANNEL);
+DEFINE_LIST_OF_IMPL(ch_tick, QUIC_CHANNEL);
 DEFINE_LIST_OF_IMPL(port, QUIC_PORT);
 
 QUIC_PORT *ossl_quic_port_new(const QUIC_PORT_ARGS *args)
@@ -42,6 +44,8 @@ QUIC_PORT *ossl_quic_port_new(const QUIC_PORT_ARGS *args)
     port->engine        = args->engine;
     port->channel_ctx   = args->channel_ctx;
     port->is_multi_conn = args->is_multi_conn;
+    port->shard_group   = args->shard_group;
+    port->shard_idx     = args->shard_idx;
 
     if (!port_init(port)) {
         OPENSSL_free(port);
@@ -67,6 +71,12 @@ static int port_init(QUIC_PORT *port)
     if (port->engine == NULL || port->channel_ctx == NULL)
         goto err;
 
+    if (port->shard_group != NULL
+        && (!port->is_multi_conn
+            || port->shard_idx
+               >= ossl_quic_shard_group_get_num_shards(port->shard_group)))
+        goto err;
+
     if ((port->err_state = OSSL_ERR_STATE_new()) == NULL)
         goto err;
 
@@ -87,6 +97,19 @@ static int port_init(QUIC_PORT *port)
                                            rx_short_dcid_len)) == NULL)
         goto err;
 
+    if (port->shard_group != NULL
+        && !ossl_quic_lcidm_set_routing_byte(port->lcidm, (int)port->shard_idx))
+        goto err;
+
+    if (port->shard_group != NULL
+        && ossl_quic_reactor_enable_notifier(&port->engine->rtor))
+        /*
+         * If the platform has no notifier, forwarded datagrams simply wait for
+         * our next tick.
+         */
+        ossl_quic_shard_group_set_reactor(port->shard_group, port->shard_idx,
+                                          &port->engine->rtor);
+
     port->rx_short_dcid_len = (unsigned char)rx_short_dcid_len;
     port->tx_init_dcid_len  = INIT_DCID_LEN;
     port->state             = QUIC_PORT_STATE_RUNNING;
@@ -104,6 +127,10 @@ static void port_cleanup(QUIC_PORT *port)
 {
     assert(ossl_list_ch_num(&port->channel_list) == 0);
 
+    if (port->shard_group != NULL)
+        ossl_quic_shard_group_set_reactor(port->shard_group, port->shard_idx,
+                                          NULL);
+
     ossl_quic_demux_free(port->demux);
     port->demux = NULL;
 
@@ -358,10 +385,46 @@ QUIC_CHANNEL *ossl_quic_port_create_incoming(QUIC_PORT *port, SSL *tls)
  * Tick function for this port. This does everything related to network I/O for
  * this port's network BIOs, and services child channels.
  */
+/*
+ * Services a single child channel. Its tick deadline is recorded in the
+ * engine's timer wheel so that it is not visited again until that deadline
+ * passes or something else happens to it, and its network I/O wants are added
+ * to the totals for the port.
+ */
+static void port_tick_channel(QUIC_PORT *port, QUIC_CHANNEL *ch,
+                              QUIC_TICK_RESULT *res, uint32_t flags)
+{
+    QUIC_TICK_RESULT subr = {0};
+
+    ossl_quic_channel_subtick(ch, &subr, flags);
+    if (ossl_time_is_infinite(subr.tick_deadline))
+        ossl_timer_wheel_remove(port->engine->tw, &ch->tick_timer);
+    else
+        ossl_timer_wheel_add(port->engine->tw, &ch->tick_timer,
+                             subr.tick_deadline);
+
+    if (ch->net_read_desired)
+        --port->num_net_read_desired;
+    if (ch->net_write_desired)
+        --port->num_net_write_desired;
+
+    ch->net_read_desired    = (subr.net_read_desired != 0);
+    ch->net_write_desired   = (subr.net_write_desired != 0);
+
+    if (ch->net_read_desired)
+        ++port->num_net_read_desired;
+    if (ch->net_write_desired)
+        ++port->num_net_write_desired;
+
+    ossl_quic_tick_result_merge_into(res, &subr);
+}
+
 void ossl_quic_port_subtick(QUIC_PORT *port, QUIC_TICK_RESULT *res,
                             uint32_t flags)
 {
     QUIC_CHANNEL *ch;
+    OSSL_LIST(ch_tick) write_list;
+    size_t n;
 
     res->net_read_desired   = 0;
     res->net_write_desired  = 0;
@@ -372,13 +435,41 @@ void ossl_quic_port_subtick(QUIC_PORT *port, QUIC_TICK_RESULT *res,
         if (ossl_quic_port_is_running(port))
             port_rx_pre(port);
 
-        /* Iterate through all channels and service them. */
-        LIST_FOREACH(ch, ch, &port->channel_list) {
-            QUIC_TICK_RESULT subr = {0};
+        /*
+         * Service the channels which need it. Channels requesting a tick while
+         * we do this are serviced on the next tick, so only visit the channels
+         * which were on the list to begin with.
+         */
+        ossl_list_ch_tick_init(&write_list);
+        for (n = ossl_list_ch_tick_num(&port->tick_list); n > 0; --n) {
+            ch = ossl_list_ch_tick_head(&port->tick_list);
+            ossl_list_ch_tick_remove(&port->tick_list, ch);
+            ch->on_tick_list = 0;
+
+            port_tick_channel(port, ch, res, flags);
+
+            /*
+             * A channel with datagrams waiting to be written must be serviced
+             * again once the network BIO becomes writeable.
+             */
+            if (ch->net_write_desired && !ch->on_tick_list) {
+                ossl_list_ch_tick_insert_tail(&write_list, ch);
+                ch->on_tick_list = 1;
+            }
+        }
 
-            ossl_quic_channel_subtick(ch, &subr, flags);
-            ossl_quic_tick_result_merge_into(res, &subr);
+        /* Channels which requested a tick meanwhile need one immediately. */
+        if (!ossl_list_ch_tick_is_empty(&port->tick_list))
+            res->tick_deadline = ossl_time_zero();
+
+        while ((ch = ossl_list_ch_tick_head(&write_list)) != NULL) {
+            ossl_list_ch_tick_remove(&write_list, ch);
+            ossl_list_ch_tick_insert_tail(&port->tick_list, ch);
         }
+
+        /* Channels which were not serviced still want their network I/O. */
+        res->net_read_desired   = (port->num_net_read_desired > 0);
+        res->net_write_desired  = (port->num_net_write_desired > 0);
     }
 }
 
@@ -387,6 +478,15 @@ static void port_rx_pre(QUIC_PORT *port)
 {
     int ret;
 
+    /*
+     * Pick up any datagrams which other ports in our shard group received for
+     * connections belonging to this port. This does not touch the network so
+     * it is safe to do before the check below.
+     */
+    if (port->shard_group != NULL)
+        ossl_quic_shard_group_collect(port->shard_group, port->shard_idx,
+                                      port->demux);
+
     /*
      * Originally, this check (don't RX before we have sent anything if we are
      * not a server, because there can't be anything) was just intended as a
@@ -515,6 +615,22 @@ static void port_default_packet_handler(QUIC_URXE *e, void *arg,
         return;
     }
 
+    /*
+     * A 1-RTT packet for a CID issued by another port in our shard group, e.g.
+     * because the kernel's SO_REUSEPORT hashing steered the datagram to us
+     * after the peer's address changed. Hand it to the owning port.
+     */
+    if (port->shard_group != NULL && dcid != NULL && e->data_len > 0
+        && (ossl_quic_urxe_data(e)[0] & 0x80) == 0) {
+        size_t owner = ossl_quic_shard_group_get_cid_owner(port->shard_group,
+                                                           dcid);
+
+        if (owner != SIZE_MAX && owner != port->shard_idx)
+            ossl_quic_shard_group_forward(port->shard_group, owner, e);
+
+        goto undesirable;
+    }
+
     /*
      * If we have an incoming packet which doesn't match any existing connection
      * we assume this is an attempt to make a new connection. Currently we
@@ -573,7 +689,7 @@ static void port_default_packet_handler(QUIC_URXE *e, void *arg,
     port_on_new_conn(port, &e->peer, &hdr.src_conn_id, &hdr.dst_conn_id,
                      &new_ch);
     if (new_ch != NULL)
-        ossl_qrx_inject_urxe(new_ch->qrx, e);
+        ossl_quic_channel_inject(new_ch, e);
 
     return;
 
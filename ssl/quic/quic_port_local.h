@@ -26,6 +26,7 @@
  * Other components should not include this header.
  */
 DECLARE_LIST_OF(ch, QUIC_CHANNEL);
+DECLARE_LIST_OF(ch_tick, QUIC_CHANNEL);
 
 /* A port is always in one of the following states: */
 enum {
@@ -62,6 +63,18 @@ struct quic_port_st {
     /* List of all child channels. */
     OSSL_LIST(ch)                   channel_list;
 
+    /*
+     * List of child channels which need to be ticked on the next tick of the
+     * port, because they have received packets, have been acted on by the
+     * application or their tick deadline has passed. Other channels are not
+     * visited when the port is ticked.
+     */
+    OSSL_LIST(ch_tick)              tick_list;
+
+    /* Number of child channels which want to read or write to the network. */
+    size_t                          num_net_read_desired;
+    size_t                          num_net_write_desired;
+
     /* Special TSERVER channel. To be removed in the future. */
     QUIC_CHANNEL                    *tserver_ch;
 
@@ -71,6 +84,13 @@ struct quic_port_st {
     /* SRTM used for incoming packet routing by SRT. */
     QUIC_SRTM                       *srtm;
 
+    /*
+     * Shard group this port belongs to, if any, and our index within it.
+     * Not owned by the port.
+     */
+    QUIC_SHARD_GROUP                *shard_group;
+    size_t                          shard_idx;
+
     /* Port-level permanent errors (causing failure state) are stored here. */
     ERR_STATE                       *err_state;
 
@@ -10,6 +10,17 @@
 #include "internal/common.h"
 #include "internal/thread_arch.h"
 
+#if defined(OPENSSL_SYS_LINUX)
+# include <sys/epoll.h>
+# define RTOR_USE_EPOLL
+#endif
+#if defined(OPENSSL_SYS_UNIX)
+# include <errno.h>
+# include <unistd.h>
+# include <fcntl.h>
+# define RTOR_USE_NOTIFIER
+#endif
+
 /*
  * Core I/O Reactor Framework
  * ==========================
@@ -30,6 +41,98 @@ void ossl_quic_reactor_init(QUIC_REACTOR *rtor,
 
     rtor->tick_cb           = tick_cb;
     rtor->tick_cb_arg       = tick_cb_arg;
+
+    rtor->wait_fd           = -1;
+    rtor->num_wait_reg      = 0;
+    rtor->wait_fd_failed    = 0;
+    rtor->notify_fd[0]      = -1;
+    rtor->notify_fd[1]      = -1;
+}
+
+static void rtor_close_wait_fd(QUIC_REACTOR *rtor)
+{
+#ifdef RTOR_USE_EPOLL
+    if (rtor->wait_fd >= 0)
+        close(rtor->wait_fd);
+#endif
+    rtor->wait_fd       = -1;
+    rtor->num_wait_reg  = 0;
+}
+
+void ossl_quic_reactor_cleanup(QUIC_REACTOR *rtor)
+{
+    rtor_close_wait_fd(rtor);
+#ifdef RTOR_USE_NOTIFIER
+    if (rtor->notify_fd[0] >= 0) {
+        close(rtor->notify_fd[0]);
+        close(rtor->notify_fd[1]);
+    }
+#endif
+    rtor->notify_fd[0] = -1;
+    rtor->notify_fd[1] = -1;
+}
+
+int ossl_quic_reactor_enable_notifier(QUIC_REACTOR *rtor)
+{
+#ifdef RTOR_USE_NOTIFIER
+    int fds[2];
+
+    if (rtor->notify_fd[0] >= 0)
+        return 1;
+
+    if (pipe(fds) < 0)
+        return 0;
+
+    if (fcntl(fds[0], F_SETFL, O_NONBLOCK) < 0
+            || fcntl(fds[1], F_SETFL, O_NONBLOCK) < 0
+            || fcntl(fds[0], F_SETFD, FD_CLOEXEC) < 0
+            || fcntl(fds[1], F_SETFD, FD_CLOEXEC) < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+
+    rtor->notify_fd[0] = fds[0];
+    rtor->notify_fd[1] = fds[1];
+
+    /* The wait descriptor must be recreated to include the notifier */
+    rtor_close_wait_fd(rtor);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void ossl_quic_reactor_notify(QUIC_REACTOR *rtor)
+{
+#ifdef RTOR_USE_NOTIFIER
+    static const unsigned char b = 0;
+    ssize_t res;
+
+    if (rtor->notify_fd[1] < 0)
+        return;
+
+    /* If the pipe is full, a wakeup is already pending */
+    do
+        res = write(rtor->notify_fd[1], &b, 1);
+    while (res < 0 && errno == EINTR);
+#endif
+}
+
+/* Consumes pending notifications; called before each tick */
+static void rtor_drain_notifier(QUIC_REACTOR *rtor)
+{
+#ifdef RTOR_USE_NOTIFIER
+    unsigned char buf[64];
+    ssize_t res;
+
+    if (rtor->notify_fd[0] < 0)
+        return;
+
+    do
+        res = read(rtor->notify_fd[0], buf, sizeof(buf));
+    while (res == (ssize_t)sizeof(buf) || (res < 0 && errno == EINTR));
+#endif
 }
 
 void ossl_quic_reactor_set_poll_r(QUIC_REACTOR *rtor, const BIO_POLL_DESCRIPTOR *r)
@@ -39,6 +142,8 @@ void ossl_quic_reactor_set_poll_r(QUIC_REACTOR *rtor, const BIO_POLL_DESCRIPTOR
     else
         rtor->poll_r = *r;
 
+    /* A new socket may reuse the number of one that is registered */
+    rtor_close_wait_fd(rtor);
     rtor->can_poll_r
         = ossl_quic_reactor_can_support_poll_descriptor(rtor, &rtor->poll_r);
 }
@@ -50,6 +155,7 @@ void ossl_quic_reactor_set_poll_w(QUIC_REACTOR *rtor, const BIO_POLL_DESCRIPTOR
     else
         rtor->poll_w = *w;
 
+    rtor_close_wait_fd(rtor);
     rtor->can_poll_w
         = ossl_quic_reactor_can_support_poll_descriptor(rtor, &rtor->poll_w);
 }
@@ -95,6 +201,95 @@ OSSL_TIME ossl_quic_reactor_get_tick_deadline(QUIC_REACTOR *rtor)
     return rtor->tick_deadline;
 }
 
+void ossl_quic_reactor_lower_tick_deadline(QUIC_REACTOR *rtor,
+                                           OSSL_TIME deadline)
+{
+    rtor->tick_deadline = ossl_time_min(rtor->tick_deadline, deadline);
+}
+
+int ossl_quic_reactor_get_wait_fd(QUIC_REACTOR *rtor, int *fd)
+{
+#ifdef RTOR_USE_EPOLL
+    struct epoll_event ev = {0};
+    int reg_fd[2], rfd = -1, wfd = -1, ok = 1;
+    uint32_t reg_events[2];
+    size_t num_reg = 0, i, j;
+
+    if (rtor->wait_fd_failed)
+        return 0;
+
+    if (rtor->net_read_desired && rtor->can_poll_r)
+        rfd = rtor->poll_r.value.fd;
+    if (rtor->net_write_desired && rtor->can_poll_w)
+        wfd = rtor->poll_w.value.fd;
+
+    if (rfd >= 0 && rfd == wfd) {
+        reg_fd[num_reg]         = rfd;
+        reg_events[num_reg++]   = EPOLLIN | EPOLLOUT;
+    } else {
+        if (rfd >= 0) {
+            reg_fd[num_reg]         = rfd;
+            reg_events[num_reg++]   = EPOLLIN;
+        }
+        if (wfd >= 0) {
+            reg_fd[num_reg]         = wfd;
+            reg_events[num_reg++]   = EPOLLOUT;
+        }
+    }
+
+    if (rtor->wait_fd < 0) {
+        if ((rtor->wait_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+            goto err;
+
+        ev.events = EPOLLIN;
+        if (rtor->notify_fd[0] >= 0
+                && epoll_ctl(rtor->wait_fd, EPOLL_CTL_ADD, rtor->notify_fd[0],
+                             &ev) < 0)
+            goto err;
+    }
+
+    /* Only pass on what has changed since the last call */
+    for (i = 0; i < rtor->num_wait_reg; i++) {
+        for (j = 0; j < num_reg && reg_fd[j] != rtor->wait_reg_fd[i]; j++)
+            continue;
+        if (j == num_reg)
+            ok &= epoll_ctl(rtor->wait_fd, EPOLL_CTL_DEL,
+                            rtor->wait_reg_fd[i], NULL) == 0;
+    }
+
+    for (j = 0; j < num_reg; j++) {
+        for (i = 0; i < rtor->num_wait_reg && rtor->wait_reg_fd[i] != reg_fd[j];
+             i++)
+            continue;
+        ev.events = reg_events[j];
+        if (i == rtor->num_wait_reg)
+            ok &= epoll_ctl(rtor->wait_fd, EPOLL_CTL_ADD, reg_fd[j], &ev) == 0;
+        else if (rtor->wait_reg_events[i] != reg_events[j])
+            ok &= epoll_ctl(rtor->wait_fd, EPOLL_CTL_MOD, reg_fd[j], &ev) == 0;
+    }
+
+    memcpy(rtor->wait_reg_fd, reg_fd, num_reg * sizeof(*reg_fd));
+    memcpy(rtor->wait_reg_events, reg_events, num_reg * sizeof(*reg_events));
+    rtor->num_wait_reg = num_reg;
+    if (!ok)
+        goto err;
+
+    *fd = rtor->wait_fd;
+    return 1;
+
+ err:
+    /*
+     * For example the same socket may be used for two purposes epoll cannot
+     * tell apart. Let the caller wait on the sockets directly from now on.
+     */
+    rtor_close_wait_fd(rtor);
+    rtor->wait_fd_failed = 1;
+    return 0;
+#else
+    return 0;
+#endif
+}
+
 int ossl_quic_reactor_tick(QUIC_REACTOR *rtor, uint32_t flags)
 {
     QUIC_TICK_RESULT res = {0};
@@ -106,6 +301,7 @@ int ossl_quic_reactor_tick(QUIC_REACTOR *rtor, uint32_t flags)
      * best effort. If something fatal happens with a connection we can report
      * it on the next actual application I/O call.
      */
+    rtor_drain_notifier(rtor);
     rtor->tick_cb(&res, rtor->tick_cb_arg, flags);
 
     rtor->net_read_desired  = res.net_read_desired;
@@ -145,7 +341,8 @@ int ossl_quic_reactor_tick(QUIC_REACTOR *rtor, uint32_t flags)
  * -1. If rfd_want_read is 1, rfd is polled for readability, and if
  * wfd_want_write is 1, wfd is polled for writability. Note that since any
  * passed FD is always polled for error conditions, setting rfd_want_read=0 and
- * wfd_want_write=0 is not the same as passing -1 for both FDs.
+ * wfd_want_write=0 is not the same as passing -1 for both FDs. If nfd is not
+ * -1, it is the reactor's notifier and is also polled for readability.
  *
  * deadline is a timestamp to return at. If it is ossl_time_infinite(), the call
  * never times out.
@@ -162,7 +359,7 @@ int ossl_quic_reactor_tick(QUIC_REACTOR *rtor, uint32_t flags)
  *                   CRYPTO_THREAD_write_lock fails)
  */
 static int poll_two_fds(int rfd, int rfd_want_read,
-                        int wfd, int wfd_want_write,
+                        int wfd, int wfd_want_write, int nfd,
                         OSSL_TIME deadline,
                         CRYPTO_MUTEX *mutex)
 {
@@ -177,7 +374,7 @@ static int poll_two_fds(int rfd, int rfd_want_read,
      * On Windows there is no relevant limit to the magnitude of a fd value (see
      * above). On *NIX the fd_set uses a bitmap and we must check the limit.
      */
-    if (rfd >= FD_SETSIZE || wfd >= FD_SETSIZE)
+    if (rfd >= FD_SETSIZE || wfd >= FD_SETSIZE || nfd >= FD_SETSIZE)
         return 0;
 # endif
 
@@ -189,6 +386,8 @@ static int poll_two_fds(int rfd, int rfd_want_read,
         openssl_fdset(rfd, &rfd_set);
     if (wfd != -1 && wfd_want_write)
         openssl_fdset(wfd, &wfd_set);
+    if (nfd != -1)
+        openssl_fdset(nfd, &rfd_set);
 
     /* Always check for error conditions. */
     if (rfd != -1)
@@ -199,6 +398,8 @@ static int poll_two_fds(int rfd, int rfd_want_read,
     maxfd = rfd;
     if (wfd > maxfd)
         maxfd = wfd;
+    if (nfd > maxfd)
+        maxfd = nfd;
 
     if (!ossl_assert(rfd != -1 || wfd != -1
                      || !ossl_time_is_infinite(deadline)))
@@ -241,7 +442,7 @@ static int poll_two_fds(int rfd, int rfd_want_read,
 #else
     int pres, timeout_ms;
     OSSL_TIME now, timeout;
-    struct pollfd pfds[2] = {0};
+    struct pollfd pfds[3] = {0};
     size_t npfd = 0;
 
     if (rfd == wfd) {
@@ -262,6 +463,12 @@ static int poll_two_fds(int rfd, int rfd_want_read,
             ++npfd;
     }
 
+    if (nfd >= 0) {
+        pfds[npfd].fd     = nfd;
+        pfds[npfd].events = POLLIN;
+        ++npfd;
+    }
+
     if (!ossl_assert(npfd != 0 || !ossl_time_is_infinite(deadline)))
         /* Do not block forever; should not happen. */
         return 0;
@@ -320,7 +527,7 @@ static int poll_descriptor_to_fd(const BIO_POLL_DESCRIPTOR *d, int *fd)
  */
 static int poll_two_descriptors(const BIO_POLL_DESCRIPTOR *r, int r_want_read,
                                 const BIO_POLL_DESCRIPTOR *w, int w_want_write,
-                                OSSL_TIME deadline,
+                                int nfd, OSSL_TIME deadline,
                                 CRYPTO_MUTEX *mutex)
 {
     int rfd, wfd;
@@ -329,7 +536,8 @@ static int poll_two_descriptors(const BIO_POLL_DESCRIPTOR *r, int r_want_read,
         || !poll_descriptor_to_fd(w, &wfd))
         return 0;
 
-    return poll_two_fds(rfd, r_want_read, wfd, w_want_write, deadline, mutex);
+    return poll_two_fds(rfd, r_want_read, wfd, w_want_write, nfd, deadline,
+                        mutex);
 }
 
 /*
@@ -364,6 +572,7 @@ int ossl_quic_reactor_block_until_pred(QUIC_REACTOR *rtor,
                                   ossl_quic_reactor_net_read_desired(rtor),
                                   ossl_quic_reactor_get_poll_w(rtor),
                                   ossl_quic_reactor_net_write_desired(rtor),
+                                  rtor->notify_fd[0],
                                   ossl_quic_reactor_get_tick_deadline(rtor),
                                   mutex))
             /*
@@ -167,6 +167,9 @@ struct ossl_qrx_st {
     /* Are we allowed to process 1-RTT packets yet? */
     unsigned char                   allow_1rtt;
 
+    /* Are we allowed to process 0-RTT packets at all? */
+    unsigned char                   allow_0rtt;
+
     /* Message callback related arguments */
     ossl_msg_cb msg_callback;
     void *msg_callback_arg;
@@ -193,6 +196,7 @@ OSSL_QRX *ossl_qrx_new(const OSSL_QRX_ARGS *args)
     qrx->demux                  = args->demux;
     qrx->short_conn_id_len      = args->short_conn_id_len;
     qrx->init_key_phase_bit     = args->init_key_phase_bit;
+    qrx->allow_0rtt             = args->allow_0rtt;
     qrx->max_deferred           = args->max_deferred;
     return qrx;
 }
@@ -502,7 +506,7 @@ static int qrx_validate_hdr_early(OSSL_QRX *qrx, RXE *rxe,
         return 0;
 
     /* Clients should never receive 0-RTT packets. */
-    if (rxe->hdr.type == QUIC_PKT_TYPE_0RTT)
+    if (rxe->hdr.type == QUIC_PKT_TYPE_0RTT && !qrx->allow_0rtt)
         return 0;
 
     /* Version negotiation and retry packets must be the first packet. */
@@ -1195,11 +1199,88 @@ static int qrx_process_one_urxe(OSSL_QRX *qrx, QUIC_URXE *e)
     return 1;
 }
 
+/*
+ * Finds the 1-RTT packet in a datagram, if it has one which still needs header
+ * protection removed. A 1-RTT packet is always the last packet in a datagram.
+ */
+static int qrx_find_1rtt_pkt(OSSL_QRX *qrx, QUIC_URXE *e,
+                             QUIC_PKT_HDR_PTRS *ptrs, size_t *pkt_idx)
+{
+    PACKET pkt;
+    QUIC_PKT_HDR hdr;
+    size_t i;
+
+    if (!PACKET_buf_init(&pkt, ossl_quic_urxe_data(e), e->data_len))
+        return 0;
+
+    for (i = 0; PACKET_remaining(&pkt) >= QUIC_MIN_VALID_PKT_LEN
+                && i < QUIC_MAX_PKT_PER_URXE; ++i) {
+        if (!ossl_quic_wire_decode_pkt_hdr(&pkt, qrx->short_conn_id_len,
+                                           1, 0, &hdr, ptrs))
+            return 0;
+
+        if (hdr.type != QUIC_PKT_TYPE_1RTT)
+            continue;
+
+        if (pkt_is_marked(&e->processed, i)
+            || pkt_is_marked(&e->hpr_removed, i)
+            || ptrs->raw_sample_len < 16)
+            return 0;
+
+        *pkt_idx = i;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Removes header protection from the 1-RTT packets in all pending URXEs ahead
+ * of processing them, so that the header protection masks for a burst of
+ * datagrams received together are generated in as few cipher calls as
+ * possible. Packets which are skipped here, or for which this fails, have
+ * header protection removed individually as they are processed.
+ */
+static void qrx_remove_hdr_prot_batch(OSSL_QRX *qrx)
+{
+    QUIC_PKT_HDR_PTRS ptrs[QUIC_HDR_PROT_MAX_BATCH];
+    QUIC_URXE *urxe[QUIC_HDR_PROT_MAX_BATCH];
+    size_t pkt_idx[QUIC_HDR_PROT_MAX_BATCH];
+    OSSL_QRL_ENC_LEVEL *el;
+    QUIC_URXE *e;
+    size_t i, n = 0;
+
+    if (ossl_list_urxe_num(&qrx->urx_pending) < 2 || !qrx->allow_1rtt)
+        return;
+
+    el = ossl_qrl_enc_level_set_get(&qrx->el_set, QUIC_ENC_LEVEL_1RTT, 1);
+    if (el == NULL)
+        return;
+
+    for (e = ossl_list_urxe_head(&qrx->urx_pending); e != NULL;
+         e = ossl_list_urxe_next(e)) {
+        if (qrx_find_1rtt_pkt(qrx, e, &ptrs[n], &pkt_idx[n]))
+            urxe[n++] = e;
+
+        if (n == 0
+            || (n < QUIC_HDR_PROT_MAX_BATCH && ossl_list_urxe_next(e) != NULL))
+            continue;
+
+        if (ossl_quic_hdr_protector_decrypt_batch(&el->hpr, ptrs, n))
+            for (i = 0; i < n; ++i)
+                pkt_mark(&urxe[i]->hpr_removed, pkt_idx[i]);
+
+        n = 0;
+    }
+}
+
 /* Process any pending URXEs to generate pending RXEs. */
 static int qrx_process_pending_urxl(OSSL_QRX *qrx)
 {
     QUIC_URXE *e;
 
+    qrx_remove_hdr_prot_batch(qrx);
+
     while ((e = ossl_list_urxe_head(&qrx->urx_pending)) != NULL)
         if (!qrx_process_one_urxe(qrx, e))
             return 0;
@@ -47,6 +47,22 @@ static ossl_inline unsigned char *txe_data(const TXE *e)
     return (unsigned char *)(e + 1);
 }
 
+/*
+ * Packet awaiting protection. The plaintext payload has been copied into a TXE
+ * after the packet header, and is sealed in place, followed by its tag, once
+ * the packet is protected.
+ */
+typedef struct qtx_pend_st {
+    QUIC_PKT_HDR_PTRS   ptrs;
+    const unsigned char *hdr;
+    size_t              hdr_len;
+    unsigned char       *payload;
+    size_t              payload_len;
+    QUIC_PN             pn;
+    uint32_t            enc_level;
+    unsigned int        sealed : 1;
+} QTX_PEND;
+
 /*
  * QTX
  * ===
@@ -68,6 +84,15 @@ struct ossl_qtx_st {
     /* TX maximum datagram payload length. */
     size_t                      mdpl;
 
+    /*
+     * Maximum number of datagrams which may be coalesced into a single UDP GSO
+     * send, or 0 if the BIO does not support segmentation offload.
+     */
+    size_t                      gso_max_segs;
+
+    /* Staging buffer for GSO super-datagrams. Allocated on first use. */
+    unsigned char              *gso_buf;
+
     /*
      * List of TXEs which are not currently in use. These are moved to the
      * pending list (possibly via tx_cons first) as they are filled.
@@ -90,6 +115,15 @@ struct ossl_qtx_st {
     TXE                        *cons;
     size_t                      cons_count; /* num packets */
 
+    /*
+     * Packets which have been written into TXEs but which are not yet
+     * protected. Their payloads are sealed and header protection is applied to
+     * them in batches before any TXE containing them is transmitted, which
+     * allows a burst of packets to be processed in a few cipher calls.
+     */
+    QTX_PEND                    pend[QUIC_HDR_PROT_MAX_BATCH];
+    size_t                      pend_count;
+
     /*
      * Number of packets transmitted in this key epoch. Used to enforce AEAD
      * confidentiality limit.
@@ -109,6 +143,19 @@ struct ossl_qtx_st {
     SSL *msg_callback_ssl;
 };
 
+/* Maximum size of the GSO super-datagrams built by a QTX per send call. */
+#define QTX_GSO_BUF_LEN     65000
+
+static void qtx_update_gso(OSSL_QTX *qtx)
+{
+    int max_segs = 0;
+
+    if (qtx->bio != NULL)
+        max_segs = BIO_dgram_get_gso_cap(qtx->bio);
+
+    qtx->gso_max_segs = max_segs > 1 ? (size_t)max_segs : 0;
+}
+
 /* Instantiates a new QTX. */
 OSSL_QTX *ossl_qtx_new(const OSSL_QTX_ARGS *args)
 {
@@ -127,10 +174,134 @@ OSSL_QTX *ossl_qtx_new(const OSSL_QTX_ARGS *args)
     qtx->mdpl               = args->mdpl;
     qtx->get_qlog_cb        = args->get_qlog_cb;
     qtx->get_qlog_cb_arg    = args->get_qlog_cb_arg;
+    qtx_update_gso(qtx);
 
     return qtx;
 }
 
+/*
+ * Seals the payloads of num packets at an EL in a single AEAD batch operation.
+ */
+static int qtx_seal_batch(OSSL_QRL_ENC_LEVEL *el, QTX_PEND **pend, size_t num)
+{
+    unsigned char nonce[QUIC_HDR_PROT_MAX_BATCH][EVP_MAX_IV_LENGTH];
+    const unsigned char *iv[QUIC_HDR_PROT_MAX_BATCH];
+    const unsigned char *aad[QUIC_HDR_PROT_MAX_BATCH];
+    const unsigned char *in[QUIC_HDR_PROT_MAX_BATCH];
+    unsigned char *out[QUIC_HDR_PROT_MAX_BATCH];
+    unsigned char *tag[QUIC_HDR_PROT_MAX_BATCH];
+    size_t aad_len[QUIC_HDR_PROT_MAX_BATCH];
+    size_t in_len[QUIC_HDR_PROT_MAX_BATCH];
+    size_t i, j;
+    int nonce_len;
+    /*
+     * TX key update is simpler than for RX; once we initiate a key update, we
+     * never need the old keys, as we never deliberately send a packet with old
+     * keys. Thus the EL always uses keyslot 0 for the TX side.
+     */
+    EVP_CIPHER_CTX *cctx = el->cctx[0];
+
+    if (!ossl_assert(cctx != NULL)) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    nonce_len = EVP_CIPHER_CTX_get_iv_length(cctx);
+    if (!ossl_assert(nonce_len >= (int)sizeof(QUIC_PN))) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    for (i = 0; i < num; ++i) {
+        /* Construct nonce (nonce=IV ^ PN). */
+        memcpy(nonce[i], el->iv[0], (size_t)nonce_len);
+        for (j = 0; j < sizeof(QUIC_PN); ++j)
+            nonce[i][nonce_len - j - 1]
+                ^= (unsigned char)(pend[i]->pn >> (j * 8));
+
+        iv[i]       = nonce[i];
+        aad[i]      = pend[i]->hdr;
+        aad_len[i]  = pend[i]->hdr_len;
+        in[i]       = pend[i]->payload;
+        in_len[i]   = pend[i]->payload_len;
+        out[i]      = pend[i]->payload;
+        tag[i]      = pend[i]->payload + pend[i]->payload_len;
+    }
+
+#ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+    /* Leave the plaintext in place; the peer ignores the tag. */
+    for (i = 0; i < num; ++i)
+        memset(tag[i], 0, el->tag_len);
+#else
+    /* The key will already have been setup; select encryption. */
+    if (EVP_CipherInit_ex(cctx, NULL, NULL, NULL, NULL, /*enc=*/1) != 1
+        || !EVP_CipherAEADBatch(cctx, num, iv, (size_t)nonce_len, aad, aad_len,
+                                in, in_len, out, tag, el->tag_len)) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+/*
+ * Protects all packets awaiting it, sealing their payloads and then applying
+ * header protection, which samples the sealed payload. Returns 0 if this fails
+ * for any packet; such packets remain awaiting protection and must not be
+ * transmitted.
+ */
+static int qtx_protect_pending(OSSL_QTX *qtx)
+{
+    QTX_PEND *pend[QUIC_HDR_PROT_MAX_BATCH];
+    QUIC_PKT_HDR_PTRS ptrs[QUIC_HDR_PROT_MAX_BATCH];
+    OSSL_QRL_ENC_LEVEL *el;
+    uint32_t enc_level;
+    size_t i, j, n, n_unsealed;
+    int ok = 1;
+
+    for (enc_level = 0; enc_level < QUIC_ENC_LEVEL_NUM; ++enc_level) {
+        /* Gather packets at this EL, those not yet sealed first. */
+        for (i = 0, n = 0; i < qtx->pend_count; ++i)
+            if (qtx->pend[i].enc_level == enc_level && !qtx->pend[i].sealed)
+                pend[n++] = &qtx->pend[i];
+
+        n_unsealed = n;
+        for (i = 0; i < qtx->pend_count; ++i)
+            if (qtx->pend[i].enc_level == enc_level && qtx->pend[i].sealed)
+                pend[n++] = &qtx->pend[i];
+
+        if (n == 0)
+            continue;
+
+        el = ossl_qrl_enc_level_set_get(&qtx->el_set, enc_level, 1);
+        if (el == NULL
+            || (n_unsealed > 0 && !qtx_seal_batch(el, pend, n_unsealed))) {
+            ok = 0;
+            continue;
+        }
+
+        for (i = 0; i < n; ++i) {
+            pend[i]->sealed = 1;
+            ptrs[i] = pend[i]->ptrs;
+        }
+
+        if (!ossl_quic_hdr_protector_encrypt_batch(&el->hpr, ptrs, n)) {
+            ok = 0;
+            continue;
+        }
+
+        /* Remove the packets we have protected. */
+        for (i = 0, j = 0; i < qtx->pend_count; ++i)
+            if (qtx->pend[i].enc_level != enc_level)
+                qtx->pend[j++] = qtx->pend[i];
+
+        qtx->pend_count = j;
+    }
+
+    return ok;
+}
+
 static void qtx_cleanup_txl(TXE_LIST *l)
 {
     TXE *e, *enext;
@@ -153,6 +324,7 @@ void ossl_qtx_free(OSSL_QTX *qtx)
     qtx_cleanup_txl(&qtx->pending);
     qtx_cleanup_txl(&qtx->free);
     OPENSSL_free(qtx->cons);
+    OPENSSL_free(qtx->gso_buf);
 
     /* Drop keying material and crypto resources. */
     for (i = 0; i < QUIC_ENC_LEVEL_NUM; ++i)
@@ -204,6 +376,9 @@ int ossl_qtx_discard_enc_level(OSSL_QTX *qtx, uint32_t enc_level)
     if (enc_level >= QUIC_ENC_LEVEL_NUM)
         return 0;
 
+    /* Packets already written must be protected using the keys of the EL. */
+    qtx_protect_pending(qtx);
+
     ossl_qrl_enc_level_set_discard(&qtx->el_set, enc_level);
     return 1;
 }
@@ -270,6 +445,13 @@ static TXE *qtx_resize_txe(OSSL_QTX *qtx, TXE_LIST *txl, TXE *txe, size_t n)
     if (n >= SIZE_MAX - sizeof(TXE))
         return NULL;
 
+    /*
+     * Packets awaiting protection are referenced by pointer, so must not be
+     * moved.
+     */
+    if (!qtx_protect_pending(qtx))
+        return NULL;
+
     /* Remove the item from the list to avoid accessing freed memory */
     p = ossl_list_txe_prev(txe);
     ossl_list_txe_remove(txl, txe);
@@ -490,12 +672,11 @@ static int qtx_encrypt_into_txe(OSSL_QTX *qtx, struct iovec_cur *cur, TXE *txe,
                                 const unsigned char *hdr, size_t hdr_len,
                                 QUIC_PKT_HDR_PTRS *ptrs)
 {
-    int l = 0, l2 = 0, nonce_len;
     OSSL_QRL_ENC_LEVEL *el
         = ossl_qrl_enc_level_set_get(&qtx->el_set, enc_level, 1);
-    unsigned char nonce[EVP_MAX_IV_LENGTH];
-    size_t i;
-    EVP_CIPHER_CTX *cctx = NULL;
+    QTX_PEND *pend;
+    unsigned char *payload;
+    size_t payload_len;
 
     /* We should not have been called if we do not have key material. */
     if (!ossl_assert(el != NULL)) {
@@ -503,6 +684,11 @@ static int qtx_encrypt_into_txe(OSSL_QTX *qtx, struct iovec_cur *cur, TXE *txe,
         return 0;
     }
 
+    /* Make room to defer protection of this packet. */
+    if (qtx->pend_count == QUIC_HDR_PROT_MAX_BATCH
+        && !qtx_protect_pending(qtx))
+        return 0;
+
     /*
      * Have we already encrypted the maximum number of packets using the current
      * key?
@@ -513,40 +699,10 @@ static int qtx_encrypt_into_txe(OSSL_QTX *qtx, struct iovec_cur *cur, TXE *txe,
     }
 
     /*
-     * TX key update is simpler than for RX; once we initiate a key update, we
-     * never need the old keys, as we never deliberately send a packet with old
-     * keys. Thus the EL always uses keyslot 0 for the TX side.
+     * Copy the plaintext into the TXE, where it will be sealed in place along
+     * with the other packets written before the next transmission.
      */
-    cctx = el->cctx[0];
-    if (!ossl_assert(cctx != NULL)) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
-        return 0;
-    }
-
-    /* Construct nonce (nonce=IV ^ PN). */
-    nonce_len = EVP_CIPHER_CTX_get_iv_length(cctx);
-    if (!ossl_assert(nonce_len >= (int)sizeof(QUIC_PN))) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
-        return 0;
-    }
-
-    memcpy(nonce, el->iv[0], (size_t)nonce_len);
-    for (i = 0; i < sizeof(QUIC_PN); ++i)
-        nonce[nonce_len - i - 1] ^= (unsigned char)(pn >> (i * 8));
-
-    /* type and key will already have been setup; feed the IV. */
-    if (EVP_CipherInit_ex(cctx, NULL, NULL, NULL, nonce, /*enc=*/1) != 1) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
-        return 0;
-    }
-
-    /* Feed AAD data. */
-    if (EVP_CipherUpdate(cctx, NULL, &l, hdr, hdr_len) != 1) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
-        return 0;
-    }
-
-    /* Encrypt plaintext directly into TXE. */
+    payload = txe_data(txe) + txe->data_len;
     for (;;) {
         const unsigned char *src;
         size_t src_len;
@@ -555,38 +711,22 @@ static int qtx_encrypt_into_txe(OSSL_QTX *qtx, struct iovec_cur *cur, TXE *txe,
         if (src_len == 0)
             break;
 
-        if (EVP_CipherUpdate(cctx, txe_data(txe) + txe->data_len,
-                             &l, src, src_len) != 1) {
-            ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
-            return 0;
-        }
-
-#ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
-        /* Ignore what we just encrypted and overwrite it with the plaintext */
-        memcpy(txe_data(txe) + txe->data_len, src, l);
-#endif
-
-        assert(l > 0 && src_len == (size_t)l);
+        memcpy(txe_data(txe) + txe->data_len, src, src_len);
         txe->data_len += src_len;
     }
 
-    /* Finalise and get tag. */
-    if (EVP_CipherFinal_ex(cctx, NULL, &l2) != 1) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
-        return 0;
-    }
-
-    if (EVP_CIPHER_CTX_ctrl(cctx, EVP_CTRL_AEAD_GET_TAG,
-                            el->tag_len, txe_data(txe) + txe->data_len) != 1) {
-        ERR_raise(ERR_LIB_SSL, ERR_R_EVP_LIB);
-        return 0;
-    }
-
+    payload_len = txe_data(txe) + txe->data_len - payload;
     txe->data_len += el->tag_len;
 
-    /* Apply header protection. */
-    if (!ossl_quic_hdr_protector_encrypt(&el->hpr, ptrs))
-        return 0;
+    pend = &qtx->pend[qtx->pend_count++];
+    pend->ptrs          = *ptrs;
+    pend->hdr           = hdr;
+    pend->hdr_len       = hdr_len;
+    pend->payload       = payload;
+    pend->payload_len   = payload_len;
+    pend->pn            = pn;
+    pend->enc_level     = enc_level;
+    pend->sealed        = 0;
 
     ++el->op_count;
     return 1;
@@ -929,12 +1069,65 @@ static void txe_to_msg(TXE *txe, BIO_MSG *msg)
 
 #define MAX_MSGS_PER_SEND   32
 
+/*
+ * Tries to coalesce txe and the pending datagrams following it into a single
+ * UDP GSO super-datagram, which is described by msg. Only datagrams with the
+ * same addresses can be coalesced, and all of them must be the same size
+ * except for the last, which may be shorter. The super-datagram is staged in
+ * gso_buf at offset *buf_used. Returns the number of datagrams msg covers.
+ */
+static size_t qtx_coalesce_gso(OSSL_QTX *qtx, TXE *txe, BIO_MSG *msg,
+                               size_t *buf_used)
+{
+    TXE *e;
+    size_t i, n = 1, seg_len = txe->data_len, last_len = seg_len;
+    size_t total = seg_len;
+    unsigned char *p;
+
+    if (seg_len > BIO_MSG_SEGMENT_SIZE_MASK)
+        return 1;
+
+    for (e = ossl_list_txe_next(txe);
+         e != NULL && n < qtx->gso_max_segs && last_len == seg_len;
+         e = ossl_list_txe_next(e)) {
+        if (e->data_len > seg_len
+            || *buf_used + total + e->data_len > QTX_GSO_BUF_LEN
+            || !addr_eq(&e->peer, &txe->peer)
+            || !addr_eq(&e->local, &txe->local))
+            break;
+
+        last_len = e->data_len;
+        total += last_len;
+        ++n;
+    }
+
+    if (n == 1)
+        return 1;
+
+    if (qtx->gso_buf == NULL
+        && (qtx->gso_buf = OPENSSL_malloc(QTX_GSO_BUF_LEN)) == NULL)
+        return 1;
+
+    p = qtx->gso_buf + *buf_used;
+    for (e = txe, i = 0; i < n; e = ossl_list_txe_next(e), ++i) {
+        memcpy(p, txe_data(e), e->data_len);
+        p += e->data_len;
+    }
+
+    msg->data       = qtx->gso_buf + *buf_used;
+    msg->data_len   = total;
+    msg->flags      = seg_len;
+    *buf_used      += total;
+    return n;
+}
+
 int ossl_qtx_flush_net(OSSL_QTX *qtx)
 {
     BIO_MSG msg[MAX_MSGS_PER_SEND];
-    size_t wr, i, total_written = 0;
+    size_t nseg[MAX_MSGS_PER_SEND];
+    size_t wr, i, j, buf_used, total_written = 0;
     TXE *txe;
-    int res;
+    int res, used_gso;
 
     if (ossl_list_txe_head(&qtx->pending) == NULL)
         return QTX_FLUSH_NET_RES_OK; /* Nothing to send. */
@@ -942,11 +1135,24 @@ int ossl_qtx_flush_net(OSSL_QTX *qtx)
     if (qtx->bio == NULL)
         return QTX_FLUSH_NET_RES_PERMANENT_FAIL;
 
+    if (!qtx_protect_pending(qtx))
+        return QTX_FLUSH_NET_RES_PERMANENT_FAIL;
+
     for (;;) {
+        buf_used = 0;
+        used_gso = 0;
         for (txe = ossl_list_txe_head(&qtx->pending), i = 0;
              txe != NULL && i < OSSL_NELEM(msg);
-             txe = ossl_list_txe_next(txe), ++i)
+             ++i) {
             txe_to_msg(txe, &msg[i]);
+            nseg[i] = qtx->gso_max_segs > 0
+                ? qtx_coalesce_gso(qtx, txe, &msg[i], &buf_used) : 1;
+            if (nseg[i] > 1)
+                used_gso = 1;
+
+            for (j = 0; j < nseg[i]; ++j)
+                txe = ossl_list_txe_next(txe);
+        }
 
         if (!i)
             /* Nothing to send. */
@@ -969,6 +1175,15 @@ int ossl_qtx_flush_net(OSSL_QTX *qtx)
                 /* Transient error, just stop for now, clearing the error. */
                 ERR_pop_to_mark();
                 break;
+            } else if (used_gso) {
+                /*
+                 * The kernel may advertise UDP_SEGMENT but be unable to use it
+                 * on the outgoing interface. Stop using segmentation offload
+                 * and retry with individual datagrams.
+                 */
+                ERR_pop_to_mark();
+                qtx->gso_max_segs = 0;
+                continue;
             } else {
                 /* Non-transient error, fail and do not clear the error. */
                 ERR_clear_last_mark();
@@ -982,15 +1197,19 @@ int ossl_qtx_flush_net(OSSL_QTX *qtx)
          * Remove everything which was successfully sent from the pending queue.
          */
         for (i = 0; i < wr; ++i) {
-            if (qtx->msg_callback != NULL)
-                qtx->msg_callback(1, OSSL_QUIC1_VERSION, SSL3_RT_QUIC_DATAGRAM,
-                                msg[i].data, msg[i].data_len,
-                                qtx->msg_callback_ssl,
-                                qtx->msg_callback_arg);
-            qtx_pending_to_free(qtx);
-        }
+            for (j = 0; j < nseg[i]; ++j) {
+                txe = ossl_list_txe_head(&qtx->pending);
+                if (qtx->msg_callback != NULL)
+                    qtx->msg_callback(1, OSSL_QUIC1_VERSION,
+                                      SSL3_RT_QUIC_DATAGRAM,
+                                      txe_data(txe), txe->data_len,
+                                      qtx->msg_callback_ssl,
+                                      qtx->msg_callback_arg);
+                qtx_pending_to_free(qtx);
+            }
 
-        total_written += wr;
+            total_written += nseg[i];
+        }
     }
 
     return total_written > 0
@@ -1002,7 +1221,7 @@ int ossl_qtx_pop_net(OSSL_QTX *qtx, BIO_MSG *msg)
 {
     TXE *txe = ossl_list_txe_head(&qtx->pending);
 
-    if (txe == NULL)
+    if (txe == NULL || !qtx_protect_pending(qtx))
         return 0;
 
     txe_to_msg(txe, msg);
@@ -1013,6 +1232,7 @@ int ossl_qtx_pop_net(OSSL_QTX *qtx, BIO_MSG *msg)
 void ossl_qtx_set_bio(OSSL_QTX *qtx, BIO *bio)
 {
     qtx->bio = bio;
+    qtx_update_gso(qtx);
 }
 
 int ossl_qtx_set_mdpl(OSSL_QTX *qtx, size_t mdpl)
@@ -1051,6 +1271,10 @@ size_t ossl_qtx_get_unflushed_pkt_count(OSSL_QTX *qtx)
 
 int ossl_qtx_trigger_key_update(OSSL_QTX *qtx)
 {
+    /* Packets already written must be sealed using the current key. */
+    if (!qtx_protect_pending(qtx))
+        return 0;
+
     return ossl_qrl_enc_level_set_key_update(&qtx->el_set,
                                              QUIC_ENC_LEVEL_1RTT);
 }
@@ -19,6 +19,12 @@ struct quic_rstream_st {
     OSSL_STATM *statm;
     UINT_RANGE head_range;
     struct ring_buf rbuf;
+    /*
+     * End of the data returned by ossl_quic_rstream_peek_zc() and not yet
+     * released. Only valid if zc_peeked is set.
+     */
+    uint64_t zc_end;
+    unsigned int zc_peeked : 1;
 };
 
 QUIC_RSTREAM *ossl_quic_rstream_new(QUIC_RXFC *rxfc,
@@ -67,6 +73,27 @@ int ossl_quic_rstream_queue_data(QUIC_RSTREAM *qrs, OSSL_QRX_PKT *pkt,
         return 0;
     }
 
+    if (qrs->zc_peeked && offset < qrs->zc_end) {
+        uint64_t skip;
+
+        /*
+         * The application holds pointers to the frames up to zc_end, so they
+         * must not be replaced. The data there is already held in full, so
+         * the overlapping part of the new frame is simply dropped.
+         */
+        if (offset + data_len < qrs->zc_end)
+            return 1;
+
+        skip = qrs->zc_end - offset;
+        if (data != NULL)
+            data += skip;
+        data_len -= skip;
+        offset = qrs->zc_end;
+
+        if (data_len == 0 && !fin)
+            return 1;
+    }
+
     range.start = offset;
     range.end = offset + data_len;
 
@@ -122,6 +149,7 @@ static int read_internal(QUIC_RSTREAM *qrs, unsigned char *buf, size_t size,
     }
 
     if (drop && offset != 0) {
+        qrs->zc_peeked = 0;
         ret = ossl_sframe_list_drop_frames(&qrs->fl, offset);
         ring_buf_cpop_range(&qrs->rbuf, 0, offset - 1, qrs->fl.cleanse);
     }
@@ -188,6 +216,107 @@ int ossl_quic_rstream_available(QUIC_RSTREAM *qrs, size_t *avail, int *fin)
     return 1;
 }
 
+int ossl_quic_rstream_peek_zc(QUIC_RSTREAM *qrs, SSL_CONST_IOVEC *iov,
+                              size_t *num_iov, size_t *readbytes, int *fin)
+{
+    void *iter = NULL;
+    UINT_RANGE range;
+    const unsigned char *data;
+    uint64_t offset = qrs->fl.offset;
+    size_t n = 0, readbytes_ = 0, l, max_len;
+    int fin_ = 0;
+
+    while (n < *num_iov
+           && ossl_sframe_list_peek(&qrs->fl, &iter, &range, &data, &fin_)) {
+        l = (size_t)(range.end - range.start);
+        if (l == 0)
+            break;
+
+        if (data == NULL) {
+            data = ring_buf_get_ptr(&qrs->rbuf, range.start, &max_len);
+            if (!ossl_assert(data != NULL))
+                return 0;
+
+            if (max_len < l) {
+                /* The data wraps around the end of the ring buffer. */
+                iov[n].buf      = data;
+                iov[n].buf_len  = max_len;
+                readbytes_     += max_len;
+                range.start    += max_len;
+                l              -= max_len;
+
+                if (++n == *num_iov) {
+                    fin_ = 0;
+                    break;
+                }
+
+                data = ring_buf_get_ptr(&qrs->rbuf, range.start, &max_len);
+                if (!ossl_assert(data != NULL) || !ossl_assert(max_len >= l))
+                    return 0;
+            }
+        }
+
+        iov[n].buf      = data;
+        iov[n].buf_len  = l;
+        readbytes_     += l;
+        range.start    += l;
+        ++n;
+    }
+
+    if (n == *num_iov && ossl_sframe_list_peek(&qrs->fl, &iter, &range, &data,
+                                               &fin_))
+        /* More data follows the spans returned. */
+        fin_ = 0;
+
+    offset += readbytes_;
+
+    qrs->zc_peeked  = readbytes_ > 0;
+    qrs->zc_end     = offset;
+
+    *num_iov    = n;
+    *readbytes  = readbytes_;
+    *fin        = fin_;
+    return 1;
+}
+
+int ossl_quic_rstream_release_zc(QUIC_RSTREAM *qrs, size_t len, int *fin)
+{
+    void *iter = NULL;
+    UINT_RANGE range;
+    const unsigned char *data;
+    uint64_t offset;
+
+    if (!qrs->zc_peeked || len > qrs->zc_end - qrs->fl.offset)
+        return 0;
+
+    offset = qrs->fl.offset + len;
+    if (!ossl_sframe_list_drop_frames(&qrs->fl, offset))
+        return 0;
+
+    if (offset > 0)
+        ring_buf_cpop_range(&qrs->rbuf, 0, offset - 1, qrs->fl.cleanse);
+
+    qrs->zc_peeked = 0;
+
+    if (qrs->rxfc != NULL && len > 0) {
+        OSSL_TIME rtt = get_rtt(qrs);
+
+        if (!ossl_quic_rxfc_on_retire(qrs->rxfc, len, rtt))
+            return 0;
+    }
+
+    /* The stream is finished if no more data is available or pending. */
+    if (ossl_sframe_list_peek(&qrs->fl, &iter, &range, &data, fin))
+        *fin = 0;
+
+    return 1;
+}
+
+int ossl_quic_rstream_is_zc_peeked(const QUIC_RSTREAM *qrs)
+{
+    return qrs->zc_peeked;
+}
+
 int ossl_quic_rstream_get_record(QUIC_RSTREAM *qrs,
                                  const unsigned char **record, size_t *rec_len,
                                  int *fin)
@@ -272,7 +401,7 @@ static int write_at_ring_buf_cb(uint64_t logical_offset,
 
 int ossl_quic_rstream_move_to_rbuf(QUIC_RSTREAM *qrs)
 {
-    if (ring_buf_avail(&qrs->rbuf) == 0)
+    if (ring_buf_avail(&qrs->rbuf) == 0 || qrs->zc_peeked)
         return 0;
     return ossl_sframe_list_move_data(&qrs->fl,
                                       write_at_ring_buf_cb, &qrs->rbuf);
@@ -280,7 +409,7 @@ int ossl_quic_rstream_move_to_rbuf(QUIC_RSTREAM *qrs)
 
 int ossl_quic_rstream_resize_rbuf(QUIC_RSTREAM *qrs, size_t rbuf_size)
 {
-    if (ossl_sframe_list_is_head_locked(&qrs->fl))
+    if (ossl_sframe_list_is_head_locked(&qrs->fl) || qrs->zc_peeked)
         return 0;
 
     if (!ring_buf_resize(&qrs->rbuf, rbuf_size, qrs->fl.cleanse))
@@ -15,6 +15,7 @@
 #include "internal/quic_rx_depack.h"
 #include "internal/quic_error.h"
 #include "internal/quic_fc.h"
+#include "internal/quic_datagram.h"
 #include "internal/quic_channel.h"
 #include "internal/sockets.h"
 
@@ -1040,6 +1041,63 @@ static int depack_do_frame_handshake_done(PACKET *pkt,
     return 1;
 }
 
+static int depack_do_frame_datagram(PACKET *pkt, QUIC_CHANNEL *ch,
+                                    uint64_t frame_type,
+                                    OSSL_ACKM_RX_PKT *ackm_data)
+{
+    const unsigned char *sof = PACKET_data(pkt);
+    const unsigned char *data;
+    size_t data_len;
+
+    /*
+     * RFC 9221 s. 3: An endpoint that receives a DATAGRAM frame when it has
+     * not indicated support via the transport parameter MUST terminate the
+     * connection with an error of type PROTOCOL_VIOLATION.
+     */
+    if (ch->tx_max_datagram_frame_size == 0) {
+        ossl_quic_channel_raise_protocol_error(ch,
+                                               OSSL_QUIC_ERR_PROTOCOL_VIOLATION,
+                                               frame_type,
+                                               "DATAGRAM frames not supported");
+        return 0;
+    }
+
+    if (!ossl_quic_wire_decode_frame_datagram(pkt, &data, &data_len)) {
+        ossl_quic_channel_raise_protocol_error(ch,
+                                               OSSL_QUIC_ERR_FRAME_ENCODING_ERROR,
+                                               frame_type,
+                                               "decode error");
+        return 0;
+    }
+
+    /*
+     * RFC 9221 s. 3: An endpoint that receives a DATAGRAM frame that is larger
+     * than the value it sent in its max_datagram_frame_size transport parameter
+     * MUST terminate the connection with an error of type PROTOCOL_VIOLATION.
+     */
+    if ((uint64_t)(PACKET_data(pkt) - sof) > ch->tx_max_datagram_frame_size) {
+        ossl_quic_channel_raise_protocol_error(ch,
+                                               OSSL_QUIC_ERR_PROTOCOL_VIOLATION,
+                                               frame_type,
+                                               "DATAGRAM frame too large");
+        return 0;
+    }
+
+    /*
+     * The queue is bounded; if the application is not reading datagrams fast
+     * enough, the oldest are dropped.
+     */
+    if (!ossl_quic_datagram_queue_push(ch->datagram_rxq, data, data_len)) {
+        ossl_quic_channel_raise_protocol_error(ch,
+                                               OSSL_QUIC_ERR_INTERNAL_ERROR,
+                                               frame_type,
+                                               "internal error (datagram queue)");
+        return 0;
+    }
+
+    return 1;
+}
+
 /* Main frame processor */
 
 static int depack_process_frames(QUIC_CHANNEL *ch, PACKET *pkt,
@@ -1375,6 +1433,21 @@ static int depack_process_frames(QUIC_CHANNEL *ch, PACKET *pkt,
                 return 0;
             break;
 
+        case OSSL_QUIC_FRAME_TYPE_DATAGRAM:
+        case OSSL_QUIC_FRAME_TYPE_DATAGRAM_LEN:
+            /* DATAGRAM frames are valid in 0RTT and 1RTT packets */
+            if (pkt_type != QUIC_PKT_TYPE_0RTT
+                && pkt_type != QUIC_PKT_TYPE_1RTT) {
+                ossl_quic_channel_raise_protocol_error(ch,
+                                                       OSSL_QUIC_ERR_PROTOCOL_VIOLATION,
+                                                       frame_type,
+                                                       "DATAGRAM valid only in 0/1-RTT");
+                return 0;
+            }
+            if (!depack_do_frame_datagram(pkt, ch, frame_type, ackm_data))
+                return 0;
+            break;
+
         default:
             /* Unknown frame type */
             ossl_quic_channel_raise_protocol_error(ch,
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/crypto.h>
+#include "internal/quic_shard.h"
+#include "internal/quic_demux.h"
+#include "internal/quic_reactor.h"
+#include "internal/list.h"
+
+/*
+ * QUIC Shard Group
+ * ================
+ */
+
+/*
+ * Maximum number of forwarded datagrams queued for a shard. Datagrams forwarded
+ * while the queue is full are dropped, as if lost by the network.
+ */
+#define SHARD_MAX_QUEUED    256
+
+typedef struct shard_dgram_st SHARD_DGRAM;
+
+struct shard_dgram_st {
+    OSSL_LIST_MEMBER(sdg, SHARD_DGRAM);
+    BIO_ADDR            peer, local;
+    size_t              data_len;
+
+    /* data_len bytes of datagram data follow this structure. */
+};
+
+DEFINE_LIST_OF(sdg, SHARD_DGRAM);
+
+typedef struct quic_shard_st {
+    /* Protects queue and rtor. */
+    CRYPTO_RWLOCK       *lock;
+
+    /* Reactor of the port serving this shard, notified on forwarding. */
+    QUIC_REACTOR        *rtor;
+
+    /* Datagrams forwarded to this shard and not yet collected. */
+    OSSL_LIST(sdg)      queue;
+
+    /* Number of queued datagrams; can be read without holding lock. */
+    int                 num_queued;
+} QUIC_SHARD;
+
+struct quic_shard_group_st {
+    size_t              num_shards;
+    QUIC_SHARD          *shards;
+};
+
+static ossl_inline unsigned char *sdg_data(const SHARD_DGRAM *d)
+{
+    return (unsigned char *)(d + 1);
+}
+
+static void shard_free_queue(OSSL_LIST(sdg) *l)
+{
+    SHARD_DGRAM *d, *dnext;
+
+    for (d = ossl_list_sdg_head(l); d != NULL; d = dnext) {
+        dnext = ossl_list_sdg_next(d);
+        ossl_list_sdg_remove(l, d);
+        OPENSSL_free(d);
+    }
+}
+
+QUIC_SHARD_GROUP *ossl_quic_shard_group_new(size_t num_shards)
+{
+    QUIC_SHARD_GROUP *grp;
+    size_t i;
+
+    if (num_shards == 0 || num_shards > QUIC_SHARD_GROUP_MAX_SHARDS)
+        return NULL;
+
+    if ((grp = OPENSSL_zalloc(sizeof(*grp))) == NULL)
+        return NULL;
+
+    if ((grp->shards = OPENSSL_zalloc(sizeof(QUIC_SHARD) * num_shards)) == NULL)
+        goto err;
+
+    grp->num_shards = num_shards;
+    for (i = 0; i < num_shards; ++i)
+        if ((grp->shards[i].lock = CRYPTO_THREAD_lock_new()) == NULL)
+            goto err;
+
+    return grp;
+
+err:
+    ossl_quic_shard_group_free(grp);
+    return NULL;
+}
+
+void ossl_quic_shard_group_free(QUIC_SHARD_GROUP *grp)
+{
+    size_t i;
+
+    if (grp == NULL)
+        return;
+
+    for (i = 0; i < grp->num_shards; ++i) {
+        shard_free_queue(&grp->shards[i].queue);
+        CRYPTO_THREAD_lock_free(grp->shards[i].lock);
+    }
+
+    OPENSSL_free(grp->shards);
+    OPENSSL_free(grp);
+}
+
+size_t ossl_quic_shard_group_get_num_shards(const QUIC_SHARD_GROUP *grp)
+{
+    return grp->num_shards;
+}
+
+size_t ossl_quic_shard_group_get_cid_owner(const QUIC_SHARD_GROUP *grp,
+                                           const QUIC_CONN_ID *cid)
+{
+    if (cid->id_len == 0 || cid->id[0] >= grp->num_shards)
+        return SIZE_MAX;
+
+    return cid->id[0];
+}
+
+void ossl_quic_shard_group_set_reactor(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                       QUIC_REACTOR *rtor)
+{
+    QUIC_SHARD *shard;
+
+    if (shard_idx >= grp->num_shards)
+        return;
+
+    shard = &grp->shards[shard_idx];
+    if (!CRYPTO_THREAD_write_lock(shard->lock))
+        return;
+
+    shard->rtor = rtor;
+    CRYPTO_THREAD_unlock(shard->lock);
+}
+
+int ossl_quic_shard_group_forward(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                  const QUIC_URXE *e)
+{
+    QUIC_SHARD *shard;
+    SHARD_DGRAM *d;
+    int n;
+
+    if (shard_idx >= grp->num_shards)
+        return 0;
+
+    shard = &grp->shards[shard_idx];
+
+    if ((d = OPENSSL_malloc(sizeof(SHARD_DGRAM) + e->data_len)) == NULL)
+        return 0;
+
+    ossl_list_sdg_init_elem(d);
+    d->peer     = e->peer;
+    d->local    = e->local;
+    d->data_len = e->data_len;
+    memcpy(sdg_data(d), ossl_quic_urxe_data(e), e->data_len);
+
+    if (!CRYPTO_THREAD_write_lock(shard->lock)) {
+        OPENSSL_free(d);
+        return 0;
+    }
+
+    if (ossl_list_sdg_num(&shard->queue) >= SHARD_MAX_QUEUED) {
+        CRYPTO_THREAD_unlock(shard->lock);
+        OPENSSL_free(d);
+        return 0;
+    }
+
+    ossl_list_sdg_insert_tail(&shard->queue, d);
+    CRYPTO_atomic_add(&shard->num_queued, 1, &n, NULL);
+
+    /* Wake the owning thread if it is blocked waiting for the network. */
+    if (shard->rtor != NULL)
+        ossl_quic_reactor_notify(shard->rtor);
+
+    CRYPTO_THREAD_unlock(shard->lock);
+    return 1;
+}
+
+size_t ossl_quic_shard_group_collect(QUIC_SHARD_GROUP *grp, size_t shard_idx,
+                                     QUIC_DEMUX *demux)
+{
+    QUIC_SHARD *shard;
+    OSSL_LIST(sdg) queue;
+    SHARD_DGRAM *d, *dnext;
+    size_t num_injected = 0;
+    int n = 0;
+
+    if (shard_idx >= grp->num_shards)
+        return 0;
+
+    shard = &grp->shards[shard_idx];
+
+    /* Avoid taking the lock in the common case where nothing is queued. */
+    if (!CRYPTO_atomic_load_int(&shard->num_queued, &n, NULL) || n == 0)
+        return 0;
+
+    if (!CRYPTO_THREAD_write_lock(shard->lock))
+        return 0;
+
+    /* Take the whole queue so that the lock is not held while injecting. */
+    queue = shard->queue;
+    ossl_list_sdg_init(&shard->queue);
+    CRYPTO_atomic_add(&shard->num_queued, -(int)ossl_list_sdg_num(&queue),
+                      &n, NULL);
+    CRYPTO_THREAD_unlock(shard->lock);
+
+    for (d = ossl_list_sdg_head(&queue); d != NULL; d = dnext) {
+        dnext = ossl_list_sdg_next(d);
+        ossl_list_sdg_remove(&queue, d);
+
+        if (ossl_quic_demux_inject(demux, sdg_data(d), d->data_len,
+                                   &d->peer, &d->local))
+            ++num_injected;
+
+        OPENSSL_free(d);
+    }
+
+    return num_injected;
+}
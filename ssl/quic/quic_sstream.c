@@ -11,14 +11,45 @@
 #include "internal/uint_set.h"
 #include "internal/common.h"
 #include "internal/ring_buf.h"
+#include "internal/list.h"
 
 /*
  * ==================================================================
  * QUIC Send Stream
  */
+
+/*
+ * A range of the stream whose data is held in a buffer owned by the
+ * application (see ossl_quic_sstream_append_ref()) rather than in the ring
+ * buffer.
+ */
+typedef struct qss_ref_st QSS_REF;
+
+struct qss_ref_st {
+    OSSL_LIST_MEMBER(qss_ref, QSS_REF);
+    uint64_t                        start;  /* logical offset of buf[0] */
+    const unsigned char             *buf;
+    size_t                          buf_len;
+    ossl_quic_sstream_release_fn    *release_cb;
+    void                            *release_arg;
+};
+
+DEFINE_LIST_OF(qss_ref, QSS_REF);
+
 struct quic_sstream_st {
     struct ring_buf ring_buf;
 
+    /*
+     * Referenced (zero-copy) ranges of the stream, in ascending order of
+     * logical offset. Referenced data is always appended after all data in the
+     * ring buffer, and no data is pushed to the ring buffer while this list is
+     * non-empty, so the ring buffer never needs to store a gap.
+     */
+    OSSL_LIST(qss_ref) refs;
+
+    /* Current size of the stream, including referenced data. */
+    uint64_t        cur_size;
+
     /*
      * Any logical byte in the stream is in one of these states:
      *
@@ -46,8 +77,8 @@ struct quic_sstream_st {
     UINT_SET        new_set, acked_set;
 
     /*
-     * The current size of the stream is ring_buf.head_offset. If
-     * have_final_size is true, this is also the final size of the stream.
+     * The current size of the stream is cur_size. If have_final_size is true,
+     * this is also the final size of the stream.
      */
     unsigned int    have_final_size     : 1;
     unsigned int    sent_final_size     : 1;
@@ -74,20 +105,64 @@ QUIC_SSTREAM *ossl_quic_sstream_new(size_t init_buf_size)
 
     ossl_uint_set_init(&qss->new_set);
     ossl_uint_set_init(&qss->acked_set);
+    ossl_list_qss_ref_init(&qss->refs);
     return qss;
 }
 
+static void qss_ref_release(QUIC_SSTREAM *qss, QSS_REF *ref)
+{
+    ossl_list_qss_ref_remove(&qss->refs, ref);
+
+    if (ref->release_cb != NULL)
+        ref->release_cb(ref->buf, ref->buf_len, ref->release_arg);
+
+    OPENSSL_free(ref);
+}
+
 void ossl_quic_sstream_free(QUIC_SSTREAM *qss)
 {
+    QSS_REF *ref;
+
     if (qss == NULL)
         return;
 
+    while ((ref = ossl_list_qss_ref_head(&qss->refs)) != NULL)
+        qss_ref_release(qss, ref);
+
     ossl_uint_set_destroy(&qss->new_set);
     ossl_uint_set_destroy(&qss->acked_set);
     ring_buf_destroy(&qss->ring_buf, qss->cleanse);
     OPENSSL_free(qss);
 }
 
+/*
+ * Retrieves a contiguous span of stream data starting at the given logical
+ * offset, either from a referenced buffer or from the ring buffer. *buf_len is
+ * set to 0 if there is no data at the offset.
+ */
+static int qss_get_buf_at(QUIC_SSTREAM *qss, uint64_t logical_offset,
+                          const unsigned char **buf, size_t *buf_len)
+{
+    QSS_REF *ref;
+
+    for (ref = ossl_list_qss_ref_head(&qss->refs);
+         ref != NULL && ref->start <= logical_offset;
+         ref = ossl_list_qss_ref_next(ref))
+        if (logical_offset - ref->start < ref->buf_len) {
+            *buf        = ref->buf + (size_t)(logical_offset - ref->start);
+            *buf_len    = ref->buf_len - (size_t)(logical_offset - ref->start);
+            return 1;
+        }
+
+    if (logical_offset >= qss->ring_buf.head_offset) {
+        *buf        = NULL;
+        *buf_len    = 0;
+        return 1;
+    }
+
+    return ring_buf_get_buf_at(&qss->ring_buf, logical_offset, buf, buf_len);
+}
+
 int ossl_quic_sstream_get_stream_frame(QUIC_SSTREAM *qss,
                                        size_t skip,
                                        OSSL_QUIC_FRAME_STREAM *hdr,
@@ -114,7 +189,7 @@ int ossl_quic_sstream_get_stream_frame(QUIC_SSTREAM *qss,
         if (!qss->have_final_size || qss->sent_final_size)
             return 0;
 
-        hdr->offset = qss->ring_buf.head_offset;
+        hdr->offset = qss->cur_size;
         hdr->len    = 0;
         hdr->is_fin = 1;
         *num_iov    = 0;
@@ -130,20 +205,17 @@ int ossl_quic_sstream_get_stream_frame(QUIC_SSTREAM *qss,
      */
     max_len = range->range.end - range->range.start + 1;
 
-    for (i = 0;; ++i) {
+    for (i = 0; i < *num_iov; ++i) {
         if (total_len >= max_len)
             break;
 
-        if (!ring_buf_get_buf_at(&qss->ring_buf,
-                                 range->range.start + total_len,
-                                 &src, &src_len))
+        if (!qss_get_buf_at(qss, range->range.start + total_len,
+                            &src, &src_len))
             return 0;
 
         if (src_len == 0)
             break;
 
-        assert(i < 2);
-
         if (total_len + src_len > max_len)
             src_len = (size_t)(max_len - total_len);
 
@@ -157,7 +229,7 @@ int ossl_quic_sstream_get_stream_frame(QUIC_SSTREAM *qss,
     hdr->offset = range->range.start;
     hdr->len    = total_len;
     hdr->is_fin = qss->have_final_size
-        && hdr->offset + hdr->len == qss->ring_buf.head_offset;
+        && hdr->offset + hdr->len == qss->cur_size;
 
     *num_iov    = num_iov_;
     return 1;
@@ -174,7 +246,7 @@ int ossl_quic_sstream_has_pending(QUIC_SSTREAM *qss)
 
 uint64_t ossl_quic_sstream_get_cur_size(QUIC_SSTREAM *qss)
 {
-    return qss->ring_buf.head_offset;
+    return qss->cur_size;
 }
 
 int ossl_quic_sstream_mark_transmitted(QUIC_SSTREAM *qss,
@@ -199,7 +271,7 @@ int ossl_quic_sstream_mark_transmitted_fin(QUIC_SSTREAM *qss,
      * We do not really need final_size since we already know the size of the
      * stream, but this serves as a sanity check.
      */
-    if (!qss->have_final_size || final_size != qss->ring_buf.head_offset)
+    if (!qss->have_final_size || final_size != qss->cur_size)
         return 0;
 
     qss->sent_final_size = 1;
@@ -274,7 +346,7 @@ int ossl_quic_sstream_get_final_size(QUIC_SSTREAM *qss, uint64_t *final_size)
         return 0;
 
     if (final_size != NULL)
-        *final_size = qss->ring_buf.head_offset;
+        *final_size = qss->cur_size;
 
     return 1;
 }
@@ -293,16 +365,25 @@ int ossl_quic_sstream_append(QUIC_SSTREAM *qss,
         return 0;
     }
 
+    /*
+     * Referenced data is still outstanding; the ring buffer cannot accept data
+     * until it has been released (see qss_cull).
+     */
+    if (!ossl_list_qss_ref_is_empty(&qss->refs)
+        || qss->ring_buf.head_offset != qss->cur_size) {
+        *consumed = 0;
+        return 1;
+    }
+
     /*
      * Note: It is assumed that ossl_quic_sstream_append will be called during a
      * call to e.g. SSL_write and this function is therefore designed to support
      * such semantics. In particular, the buffer pointed to by buf is only
      * assumed to be valid for the duration of this call, therefore we must copy
      * the data here. We will later copy-and-encrypt the data during packet
-     * encryption, so this is a two-copy design. Supporting a one-copy design in
-     * the future will require applications to use a different kind of API.
-     * Supporting such changes in future will require corresponding enhancements
-     * to this code.
+     * encryption, so this is a two-copy design. Applications which can keep
+     * the buffer valid until it is acknowledged can use the one-copy design
+     * provided by ossl_quic_sstream_append_ref() instead.
      */
     while (buf_len > 0) {
         l = ring_buf_push(&qss->ring_buf, buf, buf_len);
@@ -323,15 +404,52 @@ int ossl_quic_sstream_append(QUIC_SSTREAM *qss,
             *consumed = 0;
             return 0;
         }
+
+        qss->cur_size = qss->ring_buf.head_offset;
     }
 
     *consumed = consumed_;
     return 1;
 }
 
+int ossl_quic_sstream_append_ref(QUIC_SSTREAM *qss,
+                                 const unsigned char *buf,
+                                 size_t buf_len,
+                                 ossl_quic_sstream_release_fn *release_cb,
+                                 void *release_arg)
+{
+    QSS_REF *ref;
+    UINT_RANGE r;
+
+    if (qss->have_final_size || buf_len == 0
+        || buf_len > MAX_OFFSET - qss->cur_size)
+        return 0;
+
+    if ((ref = OPENSSL_zalloc(sizeof(*ref))) == NULL)
+        return 0;
+
+    r.start = qss->cur_size;
+    r.end   = r.start + buf_len - 1;
+    if (!ossl_uint_set_insert(&qss->new_set, &r)) {
+        OPENSSL_free(ref);
+        return 0;
+    }
+
+    ref->start          = qss->cur_size;
+    ref->buf            = buf;
+    ref->buf_len        = buf_len;
+    ref->release_cb     = release_cb;
+    ref->release_arg    = release_arg;
+    ossl_list_qss_ref_insert_tail(&qss->refs, ref);
+
+    qss->cur_size += buf_len;
+    return 1;
+}
+
 static void qss_cull(QUIC_SSTREAM *qss)
 {
     UINT_SET_ITEM *h = ossl_list_uint_set_head(&qss->acked_set);
+    QSS_REF *ref;
 
     /*
      * Potentially cull data from our ring buffer. This can happen once data has
@@ -349,9 +467,20 @@ static void qss_cull(QUIC_SSTREAM *qss)
      * We only need to check the first range entry in the integer set because we
      * can only cull contiguous areas at the start of the ring buffer anyway.
      */
-    if (h != NULL)
-        ring_buf_cpop_range(&qss->ring_buf, h->range.start, h->range.end,
-                            qss->cleanse);
+    if (h == NULL)
+        return;
+
+    ring_buf_cpop_range(&qss->ring_buf, h->range.start, h->range.end,
+                        qss->cleanse);
+
+    /*
+     * Release referenced buffers once they are entirely acknowledged. As with
+     * the ring buffer, we release them in order.
+     */
+    while ((ref = ossl_list_qss_ref_head(&qss->refs)) != NULL
+           && ref->start >= h->range.start
+           && ref->start + ref->buf_len - 1 <= h->range.end)
+        qss_ref_release(qss, ref);
 }
 
 int ossl_quic_sstream_set_buffer_size(QUIC_SSTREAM *qss, size_t num_bytes)
@@ -389,7 +518,7 @@ int ossl_quic_sstream_is_totally_acked(QUIC_SSTREAM *qss)
         return 0;
 
     r = ossl_list_uint_set_head(&qss->acked_set)->range;
-    cur_size = qss->ring_buf.head_offset;
+    cur_size = qss->cur_size;
 
     /*
      * The invariants of UINT_SET guarantee a single list element if we have a
@@ -615,9 +615,15 @@ int ossl_quic_stream_map_notify_reset_recv_part(QUIC_STREAM_MAP *qsm,
         /* RFC 9000 s. 3.3: No point sending STOP_SENDING if already reset. */
         qs->want_stop_sending       = 0;
 
-        /* QUIC_RSTREAM is no longer needed */
-        ossl_quic_rstream_free(qs->rstream);
-        qs->rstream = NULL;
+        /*
+         * QUIC_RSTREAM is no longer needed, unless the application still holds
+         * pointers into it obtained using SSL_read_peek_zc(). In that case it
+         * is freed when the application releases them.
+         */
+        if (!ossl_quic_rstream_is_zc_peeked(qs->rstream)) {
+            ossl_quic_rstream_free(qs->rstream);
+            qs->rstream = NULL;
+        }
 
         ossl_quic_stream_map_update_state(qsm, qs);
         return 1;
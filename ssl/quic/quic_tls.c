@@ -11,6 +11,7 @@
 #include "internal/quic_tls.h"
 #include "../ssl_local.h"
 #include "internal/quic_error.h"
+#include "internal/quic_wire.h"
 
 #define QUIC_TLS_FATAL(rl, ad, err) \
     do { \
@@ -51,6 +52,9 @@ struct quic_tls_st {
 
     /* Set if the handshake has completed */
     unsigned int complete : 1;
+
+    /* Set if a client should try to send 0-RTT data */
+    unsigned int early_data_enabled : 1;
 };
 
 struct ossl_record_layer_st {
@@ -623,6 +627,20 @@ static int parse_transport_params_cb(SSL *s, unsigned int ext_type,
                                      int *al, void *parse_arg)
 {
     QUIC_TLS *qtls = parse_arg;
+    SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(s);
+
+    /*
+     * A client remembers the server's transport parameters so that they can be
+     * stored in any session tickets we receive and used for 0-RTT later.
+     */
+    if (!qtls->args.is_server) {
+        OPENSSL_free(sc->ext.peer_quic_transport_params);
+        sc->ext.peer_quic_transport_params_len = 0;
+        sc->ext.peer_quic_transport_params = OPENSSL_memdup(in, inlen);
+        if (sc->ext.peer_quic_transport_params == NULL)
+            return 0;
+        sc->ext.peer_quic_transport_params_len = inlen;
+    }
 
     return qtls->args.got_transport_params_cb(in, inlen,
                                               qtls->args.got_transport_params_cb_arg);
@@ -698,6 +716,46 @@ static int raise_error(QUIC_TLS *qtls, uint64_t error_code,
 #define RAISE_INTERNAL_ERROR(qtls) \
     RAISE_ERROR((qtls), OSSL_QUIC_ERR_INTERNAL_ERROR, "internal error")
 
+/*
+ * Returns 1 if the session a client is about to resume can be used for 0-RTT.
+ * RFC 9001 s. 4.6.1 requires the ticket to have a max_early_data_size of
+ * 0xffffffff, and RFC 9000 s. 7.4.1 requires us to have remembered the
+ * server's transport parameters.
+ */
+static int quic_tls_session_allows_early_data(const SSL_CONNECTION *sc)
+{
+    const SSL_SESSION *sess = sc->session;
+
+    return sess != NULL
+        && sess->ssl_version == TLS1_3_VERSION
+        && sess->ext.max_early_data == 0xffffffff
+        && sess->ext.quic_transport_params != NULL;
+}
+
+/*
+ * libssl pauses the handshake where an application would normally read or
+ * write early data using TLS records. QUIC carries 0-RTT data in 0-RTT packets
+ * instead, so when we reach that point we mark the TLS early data as finished
+ * and carry on with the handshake. Returns 1 if the handshake should be
+ * resumed.
+ */
+static int quic_tls_end_early_data(SSL_CONNECTION *sc)
+{
+    if (sc->statem.hand_state != TLS_ST_EARLY_DATA)
+        return 0;
+
+    switch (sc->early_data_state) {
+    case SSL_EARLY_DATA_CONNECTING:
+        sc->early_data_state = SSL_EARLY_DATA_FINISHED_WRITING;
+        return 1;
+    case SSL_EARLY_DATA_ACCEPTING:
+        sc->early_data_state = SSL_EARLY_DATA_FINISHED_READING;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 int ossl_quic_tls_tick(QUIC_TLS *qtls)
 {
     int ret, err;
@@ -782,18 +840,35 @@ int ossl_quic_tls_tick(QUIC_TLS *qtls)
         else
             SSL_set_connect_state(qtls->args.s);
 
+        /*
+         * A server accepts 0-RTT if the application has configured it to issue
+         * tickets permitting early data. A client only attempts it if asked to.
+         */
+        if (qtls->args.is_server) {
+            if (sc->max_early_data > 0)
+                sc->early_data_state = SSL_EARLY_DATA_ACCEPTING;
+        } else if (qtls->early_data_enabled
+                   && quic_tls_session_allows_early_data(sc)) {
+            sc->early_data_state = SSL_EARLY_DATA_CONNECTING;
+        }
+
         qtls->configured = 1;
     }
 
-    if (qtls->complete)
+    if (qtls->complete) {
         /*
          * There should never be app data to read, but calling SSL_read() will
          * ensure any post-handshake messages are processed.
          */
         ret = SSL_read(qtls->args.s, NULL, 0);
-    else
+    } else {
         ret = SSL_do_handshake(qtls->args.s);
 
+        if (ret > 0
+            && quic_tls_end_early_data(SSL_CONNECTION_FROM_SSL(qtls->args.s)))
+            ret = SSL_do_handshake(qtls->args.s);
+    }
+
     if (ret <= 0) {
         err = ossl_ssl_get_error(qtls->args.s, ret,
                                  /*check_err=*/ERR_count_to_mark() > 0);
@@ -828,12 +903,123 @@ int ossl_quic_tls_tick(QUIC_TLS *qtls)
     return 1;
 }
 
+/*
+ * The transport parameters which a client remembers for 0-RTT and which a
+ * server must not change if it accepts 0-RTT (RFC 9000 s. 7.4.1, RFC 9221
+ * s. 3), with their default values.
+ */
+static const struct {
+    uint64_t id, def;
+} quic_tls_early_tparams[] = {
+    { QUIC_TPARAM_ACTIVE_CONN_ID_LIMIT,                 2 },
+    { QUIC_TPARAM_INITIAL_MAX_DATA,                     0 },
+    { QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_LOCAL,   0 },
+    { QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_BIDI_REMOTE,  0 },
+    { QUIC_TPARAM_INITIAL_MAX_STREAM_DATA_UNI,          0 },
+    { QUIC_TPARAM_INITIAL_MAX_STREAMS_BIDI,             0 },
+    { QUIC_TPARAM_INITIAL_MAX_STREAMS_UNI,              0 },
+    { QUIC_TPARAM_MAX_DATAGRAM_FRAME_SIZE,              0 },
+};
+
+/*
+ * Picks the parameters listed in quic_tls_early_tparams out of the server's
+ * transport parameters and stores them for libssl in a fixed order, with the
+ * defaults filled in, so that they can be compared byte for byte against the
+ * ones in the session a client resumes.
+ */
+static int quic_tls_set_early_tparams(QUIC_TLS *qtls,
+                                      const unsigned char *params,
+                                      size_t params_len)
+{
+    SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(qtls->args.s);
+    uint64_t values[OSSL_NELEM(quic_tls_early_tparams)];
+    /* Each one is at most a 1 byte ID, a 1 byte length and an 8 byte value */
+    unsigned char buf[OSSL_NELEM(quic_tls_early_tparams) * 10];
+    unsigned char *out;
+    PACKET pkt;
+    WPACKET wpkt;
+    uint64_t id;
+    size_t i, len;
+
+    if (sc == NULL)
+        return 0;
+
+    for (i = 0; i < OSSL_NELEM(quic_tls_early_tparams); i++)
+        values[i] = quic_tls_early_tparams[i].def;
+
+    if (!PACKET_buf_init(&pkt, params, params_len))
+        return 0;
+    while (PACKET_remaining(&pkt) > 0) {
+        if (!ossl_quic_wire_peek_transport_param(&pkt, &id))
+            return 0;
+        for (i = 0; i < OSSL_NELEM(quic_tls_early_tparams); i++)
+            if (quic_tls_early_tparams[i].id == id)
+                break;
+        if (i < OSSL_NELEM(quic_tls_early_tparams)) {
+            if (!ossl_quic_wire_decode_transport_param_int(&pkt, &id,
+                                                           &values[i]))
+                return 0;
+        } else if (ossl_quic_wire_decode_transport_param_bytes(&pkt, &id,
+                                                               &len) == NULL) {
+            return 0;
+        }
+    }
+
+    if (!WPACKET_init_static_len(&wpkt, buf, sizeof(buf), 0))
+        return 0;
+    for (i = 0; i < OSSL_NELEM(quic_tls_early_tparams); i++)
+        if (!ossl_quic_wire_encode_transport_param_int(&wpkt,
+                                                       quic_tls_early_tparams[i].id,
+                                                       values[i])) {
+            WPACKET_cleanup(&wpkt);
+            return 0;
+        }
+    if (!WPACKET_get_total_written(&wpkt, &len)
+            || !WPACKET_finish(&wpkt)
+            || (out = OPENSSL_memdup(buf, len)) == NULL)
+        return 0;
+
+    OPENSSL_free(sc->ext.quic_early_transport_params);
+    sc->ext.quic_early_transport_params = out;
+    sc->ext.quic_early_transport_params_len = len;
+    return 1;
+}
+
 int ossl_quic_tls_set_transport_params(QUIC_TLS *qtls,
                                        const unsigned char *transport_params,
                                        size_t transport_params_len)
 {
     qtls->local_transport_params       = transport_params;
     qtls->local_transport_params_len   = transport_params_len;
+
+    /*
+     * A server decides whether to accept 0-RTT based on these, so it needs
+     * them before libssl has finished processing the ClientHello.
+     */
+    if (qtls->args.is_server
+            && !quic_tls_set_early_tparams(qtls, transport_params,
+                                           transport_params_len))
+        return 0;
+    return 1;
+}
+
+void ossl_quic_tls_set_early_data_enabled(QUIC_TLS *qtls, int enabled)
+{
+    qtls->early_data_enabled = (enabled != 0);
+}
+
+int ossl_quic_tls_get0_early_transport_params(QUIC_TLS *qtls,
+                                              const unsigned char **params,
+                                              size_t *params_len)
+{
+    const SSL_SESSION *sess = SSL_get0_session(qtls->args.s);
+
+    if (qtls->args.is_server || sess == NULL
+        || sess->ext.quic_transport_params == NULL)
+        return 0;
+
+    *params     = sess->ext.quic_transport_params;
+    *params_len = sess->ext.quic_transport_params_len;
     return 1;
 }
 
@@ -392,6 +392,19 @@ static int frame_conn_closed(BIO *bio, PACKET *pkt)
     return 1;
 }
 
+static int frame_datagram(BIO *bio, PACKET *pkt)
+{
+    const unsigned char *data;
+    size_t data_len;
+
+    if (!ossl_quic_wire_decode_frame_datagram(pkt, &data, &data_len))
+        return 0;
+
+    BIO_printf(bio, "    Len: %zu\n", data_len);
+
+    return 1;
+}
+
 static int trace_frame_data(BIO *bio, PACKET *pkt)
 {
     uint64_t frame_type;
@@ -546,6 +559,13 @@ static int trace_frame_data(BIO *bio, PACKET *pkt)
             return 0;
         break;
 
+    case OSSL_QUIC_FRAME_TYPE_DATAGRAM:
+    case OSSL_QUIC_FRAME_TYPE_DATAGRAM_LEN:
+        BIO_puts(bio, "Datagram\n");
+        if (!frame_datagram(bio, pkt))
+            return 0;
+        break;
+
     default:
         return 0;
     }
@@ -12,6 +12,7 @@
 #include "internal/quic_statm.h"
 #include "internal/quic_port.h"
 #include "internal/quic_engine.h"
+#include "internal/quic_datagram.h"
 #include "internal/common.h"
 #include "internal/time.h"
 #include "quic_local.h"
@@ -83,6 +84,7 @@ QUIC_TSERVER *ossl_quic_tserver_new(const QUIC_TSERVER_ARGS *args,
     QUIC_ENGINE_ARGS engine_args = {0};
     QUIC_PORT_ARGS port_args = {0};
     QUIC_CONNECTION *qc = NULL;
+    SSL_CONNECTION *sc;
 
     if (args->net_rbio == NULL || args->net_wbio == NULL)
         goto err;
@@ -116,9 +118,12 @@ QUIC_TSERVER *ossl_quic_tserver_new(const QUIC_TSERVER_ARGS *args,
     SSL_CTX_set_alpn_select_cb(srv->ctx, alpn_select_cb, srv);
 
     srv->tls = SSL_new(srv->ctx);
-    if (srv->tls == NULL)
+    if (srv->tls == NULL || (sc = SSL_CONNECTION_FROM_SSL(srv->tls)) == NULL)
         goto err;
 
+    /* Apply the QUIC-specific handshake rules (e.g. for 0-RTT). */
+    sc->s3.flags |= TLS1_FLAGS_QUIC;
+
     engine_args.libctx          = srv->args.libctx;
     engine_args.propq           = srv->args.propq;
     engine_args.mutex           = srv->mutex;
@@ -130,6 +135,8 @@ QUIC_TSERVER *ossl_quic_tserver_new(const QUIC_TSERVER_ARGS *args,
 
     port_args.channel_ctx       = srv->ctx;
     port_args.is_multi_conn     = 1;
+    port_args.shard_group       = args->shard_group;
+    port_args.shard_idx         = args->shard_idx;
 
     if ((srv->port = ossl_quic_engine_create_port(srv->engine, &port_args)) == NULL)
         goto err;
@@ -210,6 +217,7 @@ int ossl_quic_tserver_set_handshake_mutator(QUIC_TSERVER *srv,
 
 int ossl_quic_tserver_tick(QUIC_TSERVER *srv)
 {
+    ossl_quic_channel_request_tick(srv->ch);
     ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(srv->ch), 0);
 
     if (ossl_quic_channel_is_active(srv->ch))
@@ -410,6 +418,27 @@ int ossl_quic_tserver_conclude(QUIC_TSERVER *srv, uint64_t stream_id)
     return 1;
 }
 
+int ossl_quic_tserver_stream_reset(QUIC_TSERVER *srv, uint64_t stream_id,
+                                   uint64_t app_error_code)
+{
+    QUIC_STREAM_MAP *qsm;
+    QUIC_STREAM *qs;
+
+    if (!ossl_quic_channel_is_active(srv->ch))
+        return 0;
+
+    qsm = ossl_quic_channel_get_qsm(srv->ch);
+    qs = ossl_quic_stream_map_get_by_id(qsm, stream_id);
+    if (qs == NULL || !ossl_quic_stream_has_send(qs))
+        return 0;
+
+    if (!ossl_quic_stream_map_reset_stream_send_part(qsm, qs, app_error_code))
+        return 0;
+
+    ossl_quic_tserver_tick(srv);
+    return 1;
+}
+
 int ossl_quic_tserver_stream_new(QUIC_TSERVER *srv,
                                  int is_uni,
                                  uint64_t *stream_id)
@@ -530,6 +559,7 @@ int ossl_quic_tserver_shutdown(QUIC_TSERVER *srv, uint64_t app_error_code)
     if (ossl_quic_channel_is_terminated(srv->ch))
         return 1;
 
+    ossl_quic_channel_request_tick(srv->ch);
     ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(srv->ch), 0);
 
     return ossl_quic_channel_is_terminated(srv->ch);
@@ -543,6 +573,7 @@ int ossl_quic_tserver_ping(QUIC_TSERVER *srv)
     if (!ossl_quic_channel_ping(srv->ch))
         return 0;
 
+    ossl_quic_channel_request_tick(srv->ch);
     ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(srv->ch), 0);
     return 1;
 }
@@ -581,3 +612,44 @@ void ossl_quic_tserver_set_psk_find_session_cb(QUIC_TSERVER *srv,
 {
     SSL_set_psk_find_session_callback(srv->tls, cb);
 }
+
+void ossl_quic_tserver_set_max_datagram_frame_size(QUIC_TSERVER *srv,
+                                                   uint64_t max_size)
+{
+    ossl_quic_channel_set_max_datagram_frame_size_request(srv->ch, max_size);
+}
+
+int ossl_quic_tserver_write_datagram(QUIC_TSERVER *srv,
+                                     const unsigned char *buf, size_t buf_len)
+{
+    if (!ossl_quic_channel_is_active(srv->ch)
+        || ossl_quic_channel_get_max_datagram_frame_size_peer_request(srv->ch) == 0
+        || buf_len > ossl_quic_channel_get_max_datagram_write_size(srv->ch))
+        return 0;
+
+    if (!ossl_quic_datagram_queue_push(ossl_quic_channel_get0_datagram_txq(srv->ch),
+                                       buf, buf_len))
+        return 0;
+
+    ossl_quic_channel_request_tick(srv->ch);
+    ossl_quic_reactor_tick(ossl_quic_channel_get_reactor(srv->ch), 0);
+    return 1;
+}
+
+int ossl_quic_tserver_read_datagram(QUIC_TSERVER *srv,
+                                    unsigned char *buf, size_t buf_len,
+                                    size_t *bytes_read)
+{
+    QUIC_DATAGRAM_QUEUE *q = ossl_quic_channel_get0_datagram_rxq(srv->ch);
+    const unsigned char *data;
+    size_t data_len;
+
+    if (!ossl_quic_datagram_queue_peek(q, &data, &data_len)
+        || data_len > buf_len)
+        return 0;
+
+    memcpy(buf, data, data_len);
+    *bytes_read = data_len;
+    ossl_quic_datagram_queue_pop(q);
+    return 1;
+}
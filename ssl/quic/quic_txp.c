@@ -12,8 +12,11 @@
 #include "internal/quic_stream_map.h"
 #include "internal/quic_error.h"
 #include "internal/common.h"
+#include "internal/safe_math.h"
 #include <openssl/err.h>
 
+OSSL_SAFE_MATH_UNSIGNED(u64, uint64_t)
+
 #define MIN_CRYPTO_HDR_SIZE             3
 
 #define MIN_FRAME_SIZE_HANDSHAKE_DONE   1
@@ -67,6 +70,15 @@ struct ossl_quic_tx_packetiser_st {
     uint64_t        next_pn[QUIC_PN_SPACE_NUM]; /* Next PN to use in given PN space. */
     OSSL_TIME       last_tx_time;               /* Last time a packet was generated, or 0. */
 
+    /*
+     * Internal state - pacing. pacing_credit is the number of bytes of
+     * in-flight packets we may send now; it may go negative by up to one
+     * datagram. It was last refilled at pacing_time, or pacing_time is 0 if
+     * we have not started pacing.
+     */
+    int64_t         pacing_credit;
+    OSSL_TIME       pacing_time;
+
     /* Internal state - frame (re)generation flags. */
     unsigned int    want_handshake_done     : 1;
     unsigned int    want_max_data           : 1;
@@ -450,6 +462,8 @@ static int txp_pkt_commit(OSSL_QUIC_TX_PACKETISER *txp, struct txp_pkt *pkt,
                           uint32_t archetype, int *txpim_pkt_reffed);
 static uint32_t txp_determine_archetype(OSSL_QUIC_TX_PACKETISER *txp,
                                         uint64_t cc_limit);
+static int txp_pacing_can_send(OSSL_QUIC_TX_PACKETISER *txp);
+static void txp_pacing_on_sent(OSSL_QUIC_TX_PACKETISER *txp, uint64_t num_bytes);
 
 OSSL_QUIC_TX_PACKETISER *ossl_quic_tx_packetiser_new(const OSSL_QUIC_TX_PACKETISER_ARGS *args)
 {
@@ -475,6 +489,7 @@ OSSL_QUIC_TX_PACKETISER *ossl_quic_tx_packetiser_new(const OSSL_QUIC_TX_PACKETIS
 
     txp->args           = *args;
     txp->last_tx_time   = ossl_time_zero();
+    txp->pacing_time    = ossl_time_zero();
 
     if (!ossl_quic_fifd_init(&txp->fifd,
                              txp->args.cfq, txp->args.ackm, txp->args.txpim,
@@ -617,6 +632,14 @@ int ossl_quic_tx_packetiser_set_peer(OSSL_QUIC_TX_PACKETISER *txp,
     return 1;
 }
 
+void ossl_quic_tx_packetiser_set_cc(OSSL_QUIC_TX_PACKETISER *txp,
+                                    const OSSL_CC_METHOD *cc_method,
+                                    OSSL_CC_DATA *cc_data)
+{
+    txp->args.cc_method = cc_method;
+    txp->args.cc_data   = cc_data;
+}
+
 void ossl_quic_tx_packetiser_set_ack_tx_cb(OSSL_QUIC_TX_PACKETISER *txp,
                                            void (*cb)(const OSSL_QUIC_FRAME_ACK *ack,
                                                       uint32_t pn_space,
@@ -671,6 +694,119 @@ void ossl_quic_tx_packetiser_schedule_ack(OSSL_QUIC_TX_PACKETISER *txp,
     txp->want_ack |= (1UL << pn_space);
 }
 
+/*
+ * Packet Pacing
+ * =============
+ *
+ * If the congestion controller provides a pacing rate, we spread the in-flight
+ * packets it allows us to send over time rather than sending them in a single
+ * burst, which could overflow shallow buffers on the path. We use a token
+ * bucket which fills at the pacing rate and holds enough credit for a burst of
+ * about a millisecond of data, so that datagrams can still be batched (e.g.
+ * using GSO) at high rates. Packets which are not in flight (e.g. ACK-only
+ * packets) and probes are not paced.
+ */
+#define TXP_PACING_INITIAL_BURST    10  /* datagrams (RFC 9002 s. 7.7) */
+#define TXP_PACING_MIN_BURST        2   /* datagrams */
+#define TXP_PACING_BURST_TIME       ossl_ms2time(1)
+
+static uint64_t txp_pacing_get_max_credit(OSSL_QUIC_TX_PACKETISER *txp,
+                                          uint64_t rate)
+{
+    uint64_t max_credit, min_credit = TXP_PACING_MIN_BURST * txp_get_mdpl(txp);
+    int err = 0;
+
+    max_credit = safe_muldiv_u64(rate, ossl_time2ticks(TXP_PACING_BURST_TIME),
+                                 OSSL_TIME_SECOND, &err);
+    if (err || max_credit > INT64_MAX / 2)
+        max_credit = INT64_MAX / 2;
+
+    return max_credit < min_credit ? min_credit : max_credit;
+}
+
+static void txp_pacing_refill(OSSL_QUIC_TX_PACKETISER *txp, uint64_t rate)
+{
+    OSSL_TIME now = txp->args.now(txp->args.now_arg), elapsed;
+    uint64_t max_credit = txp_pacing_get_max_credit(txp, rate), needed;
+    int err = 0;
+
+    if (ossl_time_is_zero(txp->pacing_time)) {
+        /* Allow an initial burst when we first start to send. */
+        txp->pacing_credit = TXP_PACING_INITIAL_BURST * txp_get_mdpl(txp);
+        txp->pacing_time   = now;
+        return;
+    }
+
+    if (txp->pacing_credit >= (int64_t)max_credit
+        || ossl_time_compare(now, txp->pacing_time) <= 0) {
+        txp->pacing_time = ossl_time_max(now, txp->pacing_time);
+        return;
+    }
+
+    /*
+     * If enough time has passed to fill the bucket, do so without computing
+     * the exact amount of credit accrued, which could overflow.
+     */
+    elapsed = ossl_time_subtract(now, txp->pacing_time);
+    needed  = (uint64_t)((int64_t)max_credit - txp->pacing_credit);
+
+    if (ossl_time_compare(elapsed, ossl_seconds2time(1)) >= 0
+        || ossl_time2ticks(elapsed)
+           >= safe_muldiv_u64(needed, OSSL_TIME_SECOND, rate, &err)
+        || err)
+        txp->pacing_credit = (int64_t)max_credit;
+    else
+        txp->pacing_credit
+            += (int64_t)(ossl_time2ticks(elapsed) * rate / OSSL_TIME_SECOND);
+
+    txp->pacing_time = now;
+}
+
+static int txp_pacing_can_send(OSSL_QUIC_TX_PACKETISER *txp)
+{
+    uint64_t rate = txp->args.cc_method->get_pacing_rate(txp->args.cc_data);
+
+    if (rate == 0)
+        return 1;
+
+    txp_pacing_refill(txp, rate);
+    return txp->pacing_credit > 0;
+}
+
+static void txp_pacing_on_sent(OSSL_QUIC_TX_PACKETISER *txp, uint64_t num_bytes)
+{
+    if (ossl_time_is_zero(txp->pacing_time))
+        /* Pacing not in use. */
+        return;
+
+    txp->pacing_credit -= (int64_t)num_bytes;
+}
+
+/*
+ * Returns the time at which the pacer will next allow us to send an in-flight
+ * packet, or ossl_time_infinite() if it is not currently preventing us from
+ * doing so.
+ */
+static OSSL_TIME txp_pacing_get_deadline(OSSL_QUIC_TX_PACKETISER *txp)
+{
+    uint64_t rate = txp->args.cc_method->get_pacing_rate(txp->args.cc_data);
+    uint64_t needed, ticks;
+    int err = 0;
+
+    if (rate == 0
+        || ossl_time_is_zero(txp->pacing_time)
+        || txp->pacing_credit > 0)
+        return ossl_time_infinite();
+
+    /* Time until credit becomes positive, rounded up. */
+    needed  = (uint64_t)(1 - txp->pacing_credit);
+    ticks   = safe_muldiv_u64(needed, OSSL_TIME_SECOND, rate, &err);
+    if (err)
+        return ossl_time_infinite();
+
+    return ossl_time_add(txp->pacing_time, ossl_ticks2time(ticks + 1));
+}
+
 #define TXP_ERR_INTERNAL     0  /* Internal (e.g. alloc) error */
 #define TXP_ERR_SUCCESS      1  /* Success */
 #define TXP_ERR_SPACE        2  /* Not enough room for another packet */
@@ -772,6 +908,14 @@ int ossl_quic_tx_packetiser_generate(OSSL_QUIC_TX_PACKETISER *txp,
     uint64_t cc_limit = txp->args.cc_method->get_tx_allowance(txp->args.cc_data);
     int need_padding = 0, txpim_pkt_reffed;
 
+    /*
+     * Pacing restricts in-flight packets in the same way as the CC. We do not
+     * reduce cc_limit to the remaining pacing credit, as that would cause us to
+     * generate small packets; instead we allow one datagram to overdraw it.
+     */
+    if (cc_limit > 0 && !txp_pacing_can_send(txp))
+        cc_limit = 0;
+
     for (enc_level = QUIC_ENC_LEVEL_INITIAL;
          enc_level < QUIC_ENC_LEVEL_NUM;
          ++enc_level)
@@ -912,6 +1056,9 @@ int ossl_quic_tx_packetiser_generate(OSSL_QUIC_TX_PACKETISER *txp,
                        && pkt[enc_level].h.bytes_appended > 0);
         }
 
+        if (rc && pkt[enc_level].tpkt->ackm_pkt.is_inflight)
+            txp_pacing_on_sent(txp, pkt[enc_level].tpkt->ackm_pkt.num_bytes);
+
         if (txpim_pkt_reffed)
             pkt[enc_level].tpkt = NULL; /* don't free */
 
@@ -1462,7 +1609,14 @@ static int txp_should_try_staging(OSSL_QUIC_TX_PACKETISER *txp,
             }
        }
 
-    if (a.allow_stream_rel && txp->handshake_complete) {
+    /* Are there any DATAGRAM frames waiting to be sent? */
+    if (a.allow_stream_rel && txp->handshake_complete
+        && txp->args.datagram_txq != NULL
+        && ossl_quic_datagram_queue_get_num(txp->args.datagram_txq) > 0)
+        return 1;
+
+    if (a.allow_stream_rel
+        && (txp->handshake_complete || enc_level == QUIC_ENC_LEVEL_0RTT)) {
         QUIC_STREAM_ITER it;
 
         /* If there are any active streams, 0/1-RTT wants to produce a packet.
@@ -1522,6 +1676,26 @@ static size_t txp_get_mdpl(OSSL_QUIC_TX_PACKETISER *txp)
     return ossl_qtx_get_mdpl(txp->args.qtx);
 }
 
+size_t ossl_quic_tx_packetiser_get_max_datagram_frame_len(OSSL_QUIC_TX_PACKETISER *txp)
+{
+    QUIC_PKT_HDR phdr = {0};
+    size_t hdr_len, ppl;
+
+    phdr.type           = QUIC_PKT_TYPE_1RTT;
+    phdr.pn_len         = txp_determine_pn_len(txp);
+    phdr.fixed          = 1;
+    phdr.dst_conn_id    = txp->args.cur_dcid;
+
+    hdr_len = ossl_quic_wire_get_encoded_pkt_hdr_len(phdr.dst_conn_id.id_len,
+                                                     &phdr);
+    if (hdr_len == 0
+        || !txp_determine_ppl_from_pl(txp, txp_get_mdpl(txp),
+                                      QUIC_ENC_LEVEL_1RTT, hdr_len, &ppl))
+        return 0;
+
+    return ppl;
+}
+
 static QUIC_SSTREAM *get_sstream_by_id(uint64_t stream_id, uint32_t pn_space,
                                        void *arg)
 {
@@ -2562,6 +2736,57 @@ static int txp_generate_stream_related(OSSL_QUIC_TX_PACKETISER *txp,
     return 1;
 }
 
+static int txp_generate_datagram_frames(OSSL_QUIC_TX_PACKETISER *txp,
+                                        struct txp_pkt *pkt,
+                                        int *have_ack_eliciting)
+{
+    struct tx_helper *h = &pkt->h;
+    QUIC_DATAGRAM_QUEUE *q = txp->args.datagram_txq;
+    const unsigned char *data;
+    size_t data_len, frame_len;
+    WPACKET *wpkt;
+
+    while (ossl_quic_datagram_queue_peek(q, &data, &data_len)) {
+        frame_len = ossl_quic_wire_get_encoded_frame_len_datagram(data_len, 1);
+
+        if (frame_len > ossl_quic_tx_packetiser_get_max_datagram_frame_len(txp)) {
+            /*
+             * The datagram cannot fit in any packet we could send. The API
+             * prevents such datagrams from being queued, but discard it rather
+             * than blocking the queue in case the path MTU has shrunk.
+             */
+            ossl_quic_datagram_queue_pop(q);
+            continue;
+        }
+
+        /* DATAGRAM frames cannot be split, so leave it for the next packet. */
+        if (frame_len > tx_helper_get_space_left(h))
+            break;
+
+        if ((wpkt = tx_helper_begin(h)) == NULL)
+            return 0;
+
+        if (!ossl_quic_wire_encode_frame_datagram(wpkt, data, data_len, 1)) {
+            tx_helper_rollback(h);
+            break;
+        }
+
+        if (!tx_helper_commit(h))
+            return 0;
+
+        /*
+         * The frame has been copied into the packet, so the datagram can be
+         * discarded now. DATAGRAM frames are never retransmitted, so the
+         * datagram is simply lost if the packet is lost, or if it is not sent.
+         */
+        ossl_quic_datagram_queue_pop(q);
+        tx_helper_unrestrict(h); /* no longer need PING */
+        *have_ack_eliciting = 1;
+    }
+
+    return 1;
+}
+
 static int txp_generate_for_el(OSSL_QUIC_TX_PACKETISER *txp,
                                struct txp_pkt *pkt,
                                int chosen_for_conn_close)
@@ -2783,8 +3008,23 @@ static int txp_generate_for_el(OSSL_QUIC_TX_PACKETISER *txp,
         if (!txp_generate_crypto_frames(txp, pkt, &have_ack_eliciting))
             goto fatal_err;
 
-    /* Stream-specific frames */
-    if (a.allow_stream_rel && txp->handshake_complete)
+    /*
+     * DATAGRAM frames. These are sent ahead of stream data as they are intended
+     * for latency-sensitive data. They are governed by the same rules as
+     * stream-related frames.
+     */
+    if (a.allow_stream_rel && txp->handshake_complete
+        && txp->args.datagram_txq != NULL)
+        if (!txp_generate_datagram_frames(txp, pkt, &have_ack_eliciting))
+            goto fatal_err;
+
+    /*
+     * Stream-specific frames. Before the handshake is complete these may only
+     * be sent in 0-RTT packets, which we only have keys for if the server
+     * permitted it in a previous connection.
+     */
+    if (a.allow_stream_rel
+        && (txp->handshake_complete || enc_level == QUIC_ENC_LEVEL_0RTT))
         if (!txp_generate_stream_related(txp, pkt,
                                          &have_ack_eliciting,
                                          &pkt->stream_head))
@@ -3150,6 +3390,9 @@ OSSL_TIME ossl_quic_tx_packetiser_get_deadline(OSSL_QUIC_TX_PACKETISER *txp)
     if (txp->args.cc_method->get_tx_allowance(txp->args.cc_data) == 0)
         deadline = ossl_time_min(deadline,
                                  txp->args.cc_method->get_wakeup_deadline(txp->args.cc_data));
+    else
+        /* When will the pacer let us send more? */
+        deadline = ossl_time_min(deadline, txp_pacing_get_deadline(txp));
 
     return deadline;
 }
@@ -392,6 +392,26 @@ int ossl_quic_wire_encode_frame_handshake_done(WPACKET *pkt)
     return encode_frame_hdr(pkt, OSSL_QUIC_FRAME_TYPE_HANDSHAKE_DONE);
 }
 
+int ossl_quic_wire_encode_frame_datagram(WPACKET *pkt,
+                                         const unsigned char *data,
+                                         size_t data_len,
+                                         int has_len)
+{
+    if (!encode_frame_hdr(pkt, has_len ? OSSL_QUIC_FRAME_TYPE_DATAGRAM_LEN
+                                       : OSSL_QUIC_FRAME_TYPE_DATAGRAM)
+            || (has_len && !WPACKET_quic_write_vlint(pkt, data_len))
+            || !WPACKET_memcpy(pkt, data, data_len))
+        return 0;
+
+    return 1;
+}
+
+size_t ossl_quic_wire_get_encoded_frame_len_datagram(size_t data_len,
+                                                     int has_len)
+{
+    return 1 + (has_len ? ossl_quic_vlint_encode_len(data_len) : 0) + data_len;
+}
+
 unsigned char *ossl_quic_wire_encode_transport_param_bytes(WPACKET *pkt,
                                                            uint64_t id,
                                                            const unsigned char *value,
@@ -909,6 +929,33 @@ int ossl_quic_wire_decode_frame_handshake_done(PACKET *pkt)
     return expect_frame_header(pkt, OSSL_QUIC_FRAME_TYPE_HANDSHAKE_DONE);
 }
 
+int ossl_quic_wire_decode_frame_datagram(PACKET *pkt,
+                                         const unsigned char **data,
+                                         size_t *data_len)
+{
+    uint64_t frame_type, data_len_;
+
+    if (!expect_frame_header_mask(pkt, OSSL_QUIC_FRAME_TYPE_DATAGRAM,
+                                  1, &frame_type))
+        return 0;
+
+    if (frame_type == OSSL_QUIC_FRAME_TYPE_DATAGRAM_LEN) {
+        if (!PACKET_get_quic_vlint(pkt, &data_len_)
+                || data_len_ > PACKET_remaining(pkt))
+            return 0;
+    } else {
+        data_len_ = PACKET_remaining(pkt);
+    }
+
+    *data       = PACKET_data(pkt);
+    *data_len   = (size_t)data_len_;
+
+    if (!PACKET_forward(pkt, (size_t)data_len_))
+        return 0;
+
+    return 1;
+}
+
 int ossl_quic_wire_peek_transport_param(PACKET *pkt, uint64_t *id)
 {
     return PACKET_peek_quic_vlint(pkt, id);
@@ -1036,6 +1083,8 @@ ossl_quic_frame_type_to_string(uint64_t frame_type)
     X(CONN_CLOSE_TRANSPORT)
     X(CONN_CLOSE_APP)
     X(HANDSHAKE_DONE)
+    X(DATAGRAM)
+    X(DATAGRAM_LEN)
     X(STREAM)
     X(STREAM_FIN)
     X(STREAM_LEN)
@@ -33,15 +33,27 @@
  * track integer ranges rather than individual integers. The data structure
  * manages a list of integer ranges [[start, end]...]. Internally this is
  * implemented as a doubly linked sorted list of range structures, which are
- * automatically split and merged as necessary.
+ * automatically split and merged as necessary. The list is what callers
+ * iterate.
  *
- * This data structure requires O(n) traversal of the list for insertion,
- * removal and query when we are not adding/removing ranges which are near the
- * beginning or end of the set of ranges. For the applications for which this
- * data structure is used (e.g. QUIC PN tracking for ACK generation), it is
- * expected that the number of integer ranges needed at any given time will
- * generally be small and that most operations will be close to the beginning or
- * end of the range.
+ * The same range structures are also linked into a binary search tree ordered
+ * by value, so that the range containing or preceding a given integer can be
+ * found in O(log n) time rather than by walking the list. Under heavy loss and
+ * reordering, the number of disjoint ranges (for example, of received PNs
+ * tracked for ACK generation) can become large, and O(n) list traversal on
+ * every operation would be expensive.
+ *
+ * The tree is a treap: each node has a pseudorandom priority derived from its
+ * address, and the tree is kept in heap order by priority using rotations,
+ * which keeps its expected depth logarithmic without any stored balance
+ * information. The root is not stored; it is reached by walking up from the
+ * tail of the list, which in a treap also takes O(log n) expected time. Since
+ * ranges never overlap, adjusting the bounds of a range in place never changes
+ * its position in the ordering, so the tree only needs updating when ranges
+ * are created or destroyed.
+ *
+ * Operations on the last range in the set (the common case when tracking
+ * increasing PNs or stream offsets) are handled without searching the tree.
  *
  * Invariant: The data structure is always sorted in ascending order by value.
  *
@@ -56,6 +68,9 @@
  * Invariant: Since ranges are represented using inclusive bounds, no range
  *            item inside the data structure can represent a span of zero
  *            integers.
+ *
+ * Invariant: The in-order traversal of the tree visits the ranges in list
+ *            order, and no node has a higher priority than its parent.
  */
 void ossl_uint_set_init(UINT_SET *s)
 {
@@ -72,46 +87,147 @@ void ossl_uint_set_destroy(UINT_SET *s)
     }
 }
 
-/* Possible merge of x, prev(x) */
-static void uint_set_merge_adjacent(UINT_SET *s, UINT_SET_ITEM *x)
+static uint64_t u64_min(uint64_t x, uint64_t y)
 {
-    UINT_SET_ITEM *xprev = ossl_list_uint_set_prev(x);
+    return x < y ? x : y;
+}
 
-    if (xprev == NULL)
-        return;
+static uint64_t u64_max(uint64_t x, uint64_t y)
+{
+    return x > y ? x : y;
+}
+
+/* Returns 1 if the range [start, end] overlaps or borders range x. */
+static int uint_range_touches(const UINT_RANGE *x, uint64_t start,
+                              uint64_t end)
+{
+    return (x->end == UINT64_MAX || start <= x->end + 1)
+        && (end == UINT64_MAX || x->start <= end + 1);
+}
+
+/*
+ * Tree Maintenance
+ * ----------------
+ */
+static UINT_SET_ITEM *tree_root(const UINT_SET *s)
+{
+    UINT_SET_ITEM *x = ossl_list_uint_set_tail(s);
+
+    if (x != NULL)
+        while (x->parent != NULL)
+            x = x->parent;
 
-    if (x->range.start - 1 != xprev->range.end)
+    return x;
+}
+
+/* Replaces the link from the parent of x (if any) to x with a link to y. */
+static void tree_replace(UINT_SET_ITEM *x, UINT_SET_ITEM *y)
+{
+    UINT_SET_ITEM *p = x->parent;
+
+    if (y != NULL)
+        y->parent = p;
+
+    if (p == NULL)
         return;
 
-    x->range.start = xprev->range.start;
-    ossl_list_uint_set_remove(s, xprev);
-    OPENSSL_free(xprev);
+    if (p->left == x)
+        p->left = y;
+    else
+        p->right = y;
 }
 
-static uint64_t u64_min(uint64_t x, uint64_t y)
+/* Rotates x above its parent, preserving the ordering. */
+static void tree_rotate_up(UINT_SET_ITEM *x)
 {
-    return x < y ? x : y;
+    UINT_SET_ITEM *p = x->parent;
+
+    tree_replace(p, x);
+
+    if (p->left == x) {
+        p->left = x->right;
+        if (p->left != NULL)
+            p->left->parent = p;
+        x->right = p;
+    } else {
+        p->right = x->left;
+        if (p->right != NULL)
+            p->right->parent = p;
+        x->left = p;
+    }
+
+    p->parent = x;
 }
 
-static uint64_t u64_max(uint64_t x, uint64_t y)
+/*
+ * Links x into the tree. x must already have been inserted into the list, so
+ * that its list neighbours are its in-order neighbours.
+ */
+static void tree_insert(UINT_SET_ITEM *x)
 {
-    return x > y ? x : y;
+    UINT_SET_ITEM *prev = ossl_list_uint_set_prev(x);
+    UINT_SET_ITEM *next = ossl_list_uint_set_next(x);
+
+    /*
+     * Attach x as a leaf between its neighbours. Of the two neighbours, one
+     * is always a descendant of the other; x goes below whichever is deeper,
+     * which has a free link on the side facing x.
+     */
+    if (prev != NULL && prev->right == NULL) {
+        prev->right = x;
+        x->parent   = prev;
+    } else if (next != NULL) {
+        assert(next->left == NULL);
+        next->left  = x;
+        x->parent   = next;
+    }
+
+    while (x->parent != NULL && x->parent->prio < x->prio)
+        tree_rotate_up(x);
+}
+
+/* Unlinks x from the tree. */
+static void tree_remove(UINT_SET_ITEM *x)
+{
+    /* Rotate x down until it has at most one child. */
+    while (x->left != NULL && x->right != NULL)
+        tree_rotate_up(x->left->prio > x->right->prio ? x->left : x->right);
+
+    tree_replace(x, x->left != NULL ? x->left : x->right);
+    x->parent = x->left = x->right = NULL;
 }
 
 /*
- * Returns 1 if there exists an integer x which falls within both ranges a and
- * b.
+ * Returns the range with the greatest start value not exceeding v, or NULL if
+ * there is no such range.
  */
-static int uint_range_overlaps(const UINT_RANGE *a,
-                               const UINT_RANGE *b)
+static UINT_SET_ITEM *uint_set_find_floor(const UINT_SET *s, uint64_t v)
 {
-    return u64_min(a->end, b->end)
-        >= u64_max(a->start, b->start);
+    UINT_SET_ITEM *x, *z = ossl_list_uint_set_tail(s);
+
+    /* Fast path for the last range. */
+    if (z == NULL || z->range.start <= v)
+        return z;
+
+    for (z = NULL, x = tree_root(s); x != NULL;)
+        if (x->range.start <= v) {
+            z = x;
+            x = x->right;
+        } else {
+            x = x->left;
+        }
+
+    return z;
 }
 
+/*
+ * Range Items
+ * -----------
+ */
 static UINT_SET_ITEM *create_set_item(uint64_t start, uint64_t end)
 {
     UINT_SET_ITEM *x = OPENSSL_malloc(sizeof(UINT_SET_ITEM));
+    uint64_t h;
 
     if (x == NULL)
         return NULL;
@@ -119,137 +235,84 @@ static UINT_SET_ITEM *create_set_item(uint64_t start, uint64_t end)
     ossl_list_uint_set_init_elem(x);
     x->range.start = start;
     x->range.end   = end;
+    x->parent = x->left = x->right = NULL;
+
+    /* Derive a pseudorandom priority from the address (SplitMix64 mixer). */
+    h = (uint64_t)(uintptr_t)x;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    x->prio = (uint32_t)((h ^ (h >> 31)) >> 32);
     return x;
 }
 
+/* Inserts x into the set after p, or at the start of the set if p is NULL. */
+static void insert_set_item(UINT_SET *s, UINT_SET_ITEM *p, UINT_SET_ITEM *x)
+{
+    if (p == NULL)
+        ossl_list_uint_set_insert_head(s, x);
+    else
+        ossl_list_uint_set_insert_after(s, p, x);
+
+    tree_insert(x);
+}
+
+static void remove_set_item(UINT_SET *s, UINT_SET_ITEM *x)
+{
+    tree_remove(x);
+    ossl_list_uint_set_remove(s, x);
+    OPENSSL_free(x);
+}
+
 int ossl_uint_set_insert(UINT_SET *s, const UINT_RANGE *range)
 {
-    UINT_SET_ITEM *x, *xnext, *z, *zprev, *f;
+    UINT_SET_ITEM *x, *z, *znext;
     uint64_t start = range->start, end = range->end;
 
     if (!ossl_assert(start <= end))
         return 0;
 
-    if (ossl_list_uint_set_is_empty(s)) {
-        /* Nothing in the set yet, so just add this range. */
-        x = create_set_item(start, end);
-        if (x == NULL)
-            return 0;
-        ossl_list_uint_set_insert_head(s, x);
-        return 1;
-    }
-
-    z = ossl_list_uint_set_tail(s);
-    if (start > z->range.end) {
-        /*
-         * Range is after the latest range in the set, so append.
-         *
-         * Note: The case where the range is before the earliest range in the
-         * set is handled as a degenerate case of the final case below. See
-         * optimization note (*) below.
-         */
-        if (z->range.end + 1 == start) {
-            z->range.end = end;
-            return 1;
-        }
-
-        x = create_set_item(start, end);
-        if (x == NULL)
-            return 0;
-        ossl_list_uint_set_insert_tail(s, x);
-        return 1;
-    }
-
-    f = ossl_list_uint_set_head(s);
-    if (start <= f->range.start && end >= z->range.end) {
-        /*
-         * New range dwarfs all ranges in our set.
-         *
-         * Free everything except the first range in the set, which we scavenge
-         * and reuse.
-         */
-        x = ossl_list_uint_set_head(s);
-        x->range.start = start;
-        x->range.end = end;
-        for (x = ossl_list_uint_set_next(x); x != NULL; x = xnext) {
-            xnext = ossl_list_uint_set_next(x);
-            ossl_list_uint_set_remove(s, x);
-        }
-        return 1;
-    }
-
     /*
-     * Walk backwards since we will most often be inserting at the end. As an
-     * optimization, test the head node first and skip iterating over the
-     * entire list if we are inserting at the start. The assumption is that
-     * insertion at the start and end of the space will be the most common
-     * operations. (*)
+     * Find the first range which overlaps or borders the new range, if any.
+     * Only the range starting at or before the new range and the one after it
+     * are candidates.
      */
-    z = end < f->range.start ? f : z;
-
-    for (; z != NULL; z = zprev) {
-        zprev = ossl_list_uint_set_prev(z);
+    z = uint_set_find_floor(s, start);
+    if (z == NULL || !uint_range_touches(&z->range, start, end)) {
+        x = (z == NULL) ? ossl_list_uint_set_head(s)
+                        : ossl_list_uint_set_next(z);
 
-        /* An existing range dwarfs our new range (optimisation). */
-        if (z->range.start <= start && z->range.end >= end)
-            return 1;
-
-        if (uint_range_overlaps(&z->range, range)) {
+        if (x == NULL || !uint_range_touches(&x->range, start, end)) {
             /*
-             * Our new range overlaps an existing range, or possibly several
-             * existing ranges.
+             * The new range is between ranges (or before or after all ranges)
+             * without overlapping or touching them, so insert between,
+             * preserving sort.
              */
-            UINT_SET_ITEM *ovend = z;
+            x = create_set_item(start, end);
+            if (x == NULL)
+                return 0;
 
-            ovend->range.end = u64_max(end, z->range.end);
-
-            /* Get earliest overlapping range. */
-            while (zprev != NULL && uint_range_overlaps(&zprev->range, range)) {
-                z = zprev;
-                zprev = ossl_list_uint_set_prev(z);
-            }
+            insert_set_item(s, z, x);
+            return 1;
+        }
 
-            ovend->range.start = u64_min(start, z->range.start);
+        z = x;
+    }
 
-            /* Replace sequence of nodes z..ovend with updated ovend only. */
-            while (z != ovend) {
-                z = ossl_list_uint_set_next(x = z);
-                ossl_list_uint_set_remove(s, x);
-                OPENSSL_free(x);
-            }
-            break;
-        } else if (end < z->range.start
-                    && (zprev == NULL || start > zprev->range.end)) {
-            if (z->range.start == end + 1) {
-                /* We can extend the following range backwards. */
-                z->range.start = start;
-
-                /*
-                 * If this closes a gap we now need to merge
-                 * consecutive nodes.
-                 */
-                uint_set_merge_adjacent(s, z);
-            } else if (zprev != NULL && zprev->range.end + 1 == start) {
-                /* We can extend the preceding range forwards. */
-                zprev->range.end = end;
-
-                /*
-                 * If this closes a gap we now need to merge
-                 * consecutive nodes.
-                 */
-                uint_set_merge_adjacent(s, z);
-            } else {
-                /*
-                 * The new interval is between intervals without overlapping or
-                 * touching them, so insert between, preserving sort.
-                 */
-                x = create_set_item(start, end);
-                if (x == NULL)
-                    return 0;
-                ossl_list_uint_set_insert_before(s, z, x);
-            }
-            break;
-        }
+    /*
+     * Extend z to cover the new range. This cannot change its position in the
+     * ordering as it does not overlap the ranges either side of it.
+     */
+    z->range.start  = u64_min(z->range.start, start);
+    z->range.end    = u64_max(z->range.end, end);
+
+    /* Absorb any following ranges which z now overlaps or borders. */
+    for (x = ossl_list_uint_set_next(z);
+         x != NULL && uint_range_touches(&z->range, x->range.start,
+                                         x->range.end);
+         x = znext) {
+        znext = ossl_list_uint_set_next(x);
+        z->range.end = u64_max(z->range.end, x->range.end);
+        remove_set_item(s, x);
     }
 
     return 1;
@@ -257,58 +320,62 @@ int ossl_uint_set_insert(UINT_SET *s, const UINT_RANGE *range)
 
 int ossl_uint_set_remove(UINT_SET *s, const UINT_RANGE *range)
 {
-    UINT_SET_ITEM *z, *zprev, *y;
+    UINT_SET_ITEM *z, *znext, *y;
     uint64_t start = range->start, end = range->end;
 
     if (!ossl_assert(start <= end))
         return 0;
 
-    /* Walk backwards since we will most often be removing at the end. */
-    for (z = ossl_list_uint_set_tail(s); z != NULL; z = zprev) {
-        zprev = ossl_list_uint_set_prev(z);
+    /* Find the first range which overlaps the range being removed, if any. */
+    z = uint_set_find_floor(s, start);
+    if (z == NULL)
+        z = ossl_list_uint_set_head(s);
+    else if (z->range.end < start)
+        z = ossl_list_uint_set_next(z);
 
-        if (start > z->range.end)
-            /* No overlapping ranges can exist beyond this point, so stop. */
-            break;
+    if (z == NULL || z->range.start > end)
+        /* Nothing to remove. */
+        return 1;
 
-        if (start <= z->range.start && end >= z->range.end) {
-            /*
-             * The range being removed dwarfs this range, so it should be
-             * removed.
-             */
-            ossl_list_uint_set_remove(s, z);
-            OPENSSL_free(z);
-        } else if (start <= z->range.start && end >= z->range.start) {
+    if (start > z->range.start && end < z->range.end) {
+        /*
+         * The range being removed falls entirely in this range, so cut it
+         * into two. Cases where a zero-length range would be created are
+         * handled below.
+         */
+        y = create_set_item(end + 1, z->range.end);
+        if (y == NULL)
+            return 0;
+
+        z->range.end = start - 1;
+        insert_set_item(s, z, y);
+        return 1;
+    }
+
+    for (; z != NULL && z->range.start <= end; z = znext) {
+        znext = ossl_list_uint_set_next(z);
+
+        if (start > z->range.start) {
             /*
-             * The range being removed includes start of this range, but does
-             * not cover the entire range (as this would be caught by the case
-             * above). Shorten the range.
+             * The range being removed includes the end of this range, but
+             * does not cover the entire range. Shorten the range.
              */
-            assert(end < z->range.end);
-            z->range.start = end + 1;
+            assert(end >= z->range.end);
+            z->range.end = start - 1;
         } else if (end >= z->range.end) {
             /*
-             * The range being removed includes the end of this range, but does
-             * not cover the entire range (as this would be caught by the case
-             * above). Shorten the range. We can also stop iterating.
+             * The range being removed dwarfs this range, so it should be
+             * removed.
              */
-            assert(start > z->range.start);
-            assert(start > 0);
-            z->range.end = start - 1;
-            break;
-        } else if (start > z->range.start && end < z->range.end) {
+            remove_set_item(s, z);
+        } else {
             /*
-             * The range being removed falls entirely in this range, so cut it
-             * into two. Cases where a zero-length range would be created are
-             * handled by the above cases.
+             * The range being removed includes the start of this range, but
+             * does not cover the entire range. Shorten the range. We can also
+             * stop iterating.
              */
-            y = create_set_item(end + 1, z->range.end);
-            ossl_list_uint_set_insert_after(s, z, y);
-            z->range.end = start - 1;
+            z->range.start = end + 1;
             break;
-        } else {
-            /* Assert no partial overlap; all cases should be covered above. */
-            assert(!uint_range_overlaps(&z->range, range));
         }
     }
 
@@ -317,16 +384,7 @@ int ossl_uint_set_remove(UINT_SET *s, const UINT_RANGE *range)
 
 int ossl_uint_set_query(const UINT_SET *s, uint64_t v)
 {
-    UINT_SET_ITEM *x;
-
-    if (ossl_list_uint_set_is_empty(s))
-        return 0;
-
-    for (x = ossl_list_uint_set_tail(s); x != NULL; x = ossl_list_uint_set_prev(x))
-        if (x->range.start <= v && x->range.end >= v)
-            return 1;
-        else if (x->range.end < v)
-            return 0;
+    UINT_SET_ITEM *x = uint_set_find_floor(s, v);
 
-    return 0;
+    return x != NULL && x->range.end >= v;
 }
@@ -469,6 +469,12 @@ static int ktls_initialise_write_packets(OSSL_RECORD_LAYER *rl,
 {
     TLS_BUFFER *wb;
 
+    /* Scatter-gather writes are split into one record per buffer for KTLS */
+    if (!ossl_assert(templates[0].iov == NULL)) {
+        RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
     /*
      * We just use the application buffer directly and don't use any WPACKET
      * structures
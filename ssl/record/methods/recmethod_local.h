@@ -76,6 +76,9 @@ typedef struct tls_rl_record_st {
     /* sequence number, needed by DTLS1 */
     /* r */
     unsigned char seq_num[SEQ_NUM_SIZE];
+    /* set if |data| points into the caller's read_dest buffer */
+    /* r */
+    int in_read_dest;
 } TLS_RL_RECORD;
 
 /* Macros/functions provided by the TLS_RL_RECORD component */
@@ -299,6 +302,25 @@ struct ossl_record_layer_st {
     /* Explicit IV length */
     size_t eivlen;
 
+    /*
+     * Set if the cipher function can seal several application data records in
+     * a single AEAD batch operation
+     */
+    int aead_batch;
+
+    /*
+     * Set if the cipher function can decrypt a record to a different location
+     * than its ciphertext, so that it can be decrypted straight into read_dest
+     */
+    int direct_read;
+
+    /*
+     * Caller supplied buffer that the next application data record read may be
+     * decrypted into. Only valid for the next call to read_record.
+     */
+    unsigned char *read_dest;
+    size_t read_dest_len;
+
     /* used for mac generation */
     EVP_MD_CTX *md_ctx;
 
@@ -365,6 +387,8 @@ struct ossl_record_layer_st {
     OSSL_FUNC_rlayer_msg_callback_fn *msg_callback;
     OSSL_FUNC_rlayer_security_fn *security;
     OSSL_FUNC_rlayer_padding_fn *padding;
+    OSSL_FUNC_rlayer_buffer_alloc_fn *buffer_alloc;
+    OSSL_FUNC_rlayer_buffer_free_fn *buffer_free;
 
     size_t max_pipelines;
 
@@ -412,6 +436,7 @@ int ossl_set_tls_provider_parameters(OSSL_RECORD_LAYER *rl,
 int tls_increment_sequence_ctr(OSSL_RECORD_LAYER *rl);
 int tls_alloc_buffers(OSSL_RECORD_LAYER *rl);
 int tls_free_buffers(OSSL_RECORD_LAYER *rl);
+void tls_set_read_dest(OSSL_RECORD_LAYER *rl, unsigned char *buf, size_t len);
 
 int tls_default_read_n(OSSL_RECORD_LAYER *rl, size_t n, size_t max, int extend,
                        int clearold, size_t *readbytes);
@@ -521,6 +546,7 @@ int tls_post_encryption_processing_default(OSSL_RECORD_LAYER *rl,
 int tls_write_records_default(OSSL_RECORD_LAYER *rl,
                               OSSL_RECORD_TEMPLATE *templates,
                               size_t numtempl);
+int tls_copy_template_payload(WPACKET *pkt, const OSSL_RECORD_TEMPLATE *templ);
 
 /* Macros/functions provided by the TLS_BUFFER component */
 
@@ -78,10 +78,102 @@ static int tls13_set_crypto_state(OSSL_RECORD_LAYER *rl, int level,
         ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
         return OSSL_RECORD_RETURN_FATAL;
     }
+    rl->aead_batch = enc;
+    rl->direct_read = !enc;
  end:
     return OSSL_RECORD_RETURN_SUCCESS;
 }
 
+/*
+ * Protects or deprotects several records in a single AEAD batch operation. The
+ * records must all be ciphertext records for an AEAD cipher.
+ */
+static int tls13_cipher_batch(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
+                              size_t n_recs, int sending)
+{
+    unsigned char nonces[SSL_MAX_PIPELINES][EVP_MAX_IV_LENGTH];
+    unsigned char recheaders[SSL_MAX_PIPELINES][SSL3_RT_HEADER_LENGTH];
+    const unsigned char *iv[SSL_MAX_PIPELINES];
+    const unsigned char *aad[SSL_MAX_PIPELINES];
+    const unsigned char *in[SSL_MAX_PIPELINES];
+    unsigned char *out[SSL_MAX_PIPELINES];
+    unsigned char *tag[SSL_MAX_PIPELINES];
+    size_t aadlen[SSL_MAX_PIPELINES];
+    size_t inl[SSL_MAX_PIPELINES];
+    size_t nonce_len, offset, loop, hdrlen, i;
+    unsigned char *staticiv = rl->iv;
+    unsigned char *seq = rl->sequence;
+    TLS_RL_RECORD *rec;
+    WPACKET wpkt;
+    int ivlen;
+
+    ivlen = EVP_CIPHER_CTX_get_iv_length(rl->enc_ctx);
+    if (ivlen < SEQ_NUM_SIZE || ivlen > EVP_MAX_IV_LENGTH) {
+        /* Should not happen */
+        RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    nonce_len = (size_t)ivlen;
+    offset = nonce_len - SEQ_NUM_SIZE;
+
+    for (i = 0; i < n_recs; i++) {
+        rec = &recs[i];
+
+        if (!sending) {
+            /* There must be at least one byte of content type and the tag */
+            if (rec->length < rl->taglen + 1)
+                return 0;
+            rec->length -= rl->taglen;
+        }
+
+        /* Set up nonce: part of static IV followed by sequence number */
+        memcpy(nonces[i], staticiv, offset);
+        for (loop = 0; loop < SEQ_NUM_SIZE; loop++)
+            nonces[i][offset + loop] = staticiv[offset + loop] ^ seq[loop];
+
+        if (!tls_increment_sequence_ctr(rl)) {
+            /* RLAYERfatal already called */
+            return 0;
+        }
+
+        /* Set up the AAD */
+        if (!WPACKET_init_static_len(&wpkt, recheaders[i],
+                                     SSL3_RT_HEADER_LENGTH, 0)
+                || !WPACKET_put_bytes_u8(&wpkt, rec->type)
+                || !WPACKET_put_bytes_u16(&wpkt, rec->rec_version)
+                || !WPACKET_put_bytes_u16(&wpkt, rec->length + rl->taglen)
+                || !WPACKET_get_total_written(&wpkt, &hdrlen)
+                || hdrlen != SSL3_RT_HEADER_LENGTH
+                || !WPACKET_finish(&wpkt)) {
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            WPACKET_cleanup(&wpkt);
+            return 0;
+        }
+
+        iv[i] = nonces[i];
+        aad[i] = recheaders[i];
+        aadlen[i] = SSL3_RT_HEADER_LENGTH;
+        in[i] = rec->input;
+        inl[i] = rec->length;
+        out[i] = rec->data;
+        /* When decrypting the tag follows the ciphertext */
+        tag[i] = (sending ? rec->data : rec->input) + rec->length;
+    }
+
+    if (!EVP_CipherAEADBatch(rl->enc_ctx, n_recs, iv, nonce_len, aad, aadlen,
+                             in, inl, out, tag, rl->taglen)) {
+        if (sending)
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    if (sending)
+        for (i = 0; i < n_recs; i++)
+            recs[i].length += rl->taglen;
+
+    return 1;
+}
+
 static int tls13_cipher(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
                         size_t n_recs, int sending, SSL_MAC_BUF *mac,
                         size_t macsize)
@@ -100,6 +192,10 @@ static int tls13_cipher(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
     EVP_MAC_CTX *mac_ctx = NULL;
     int mode;
 
+    if (n_recs > 1 && n_recs <= SSL_MAX_PIPELINES
+            && rl->enc_ctx != NULL && rl->mac_ctx == NULL)
+        return tls13_cipher_batch(rl, recs, n_recs, sending);
+
     if (n_recs != 1) {
         /* Should not happen */
         RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
@@ -215,7 +311,7 @@ static int tls13_cipher(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
     if (EVP_CipherInit_ex(enc_ctx, NULL, NULL, NULL, nonce, sending) <= 0
         || (!sending && EVP_CIPHER_CTX_ctrl(enc_ctx, EVP_CTRL_AEAD_SET_TAG,
                                             rl->taglen,
-                                            rec->data + rec->length) <= 0)) {
+                                            rec->input + rec->length) <= 0)) {
         RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
         return 0;
     }
@@ -414,8 +510,8 @@ const struct record_functions_st tls_1_3_funcs = {
     tls_get_more_records,
     tls13_validate_record_header,
     tls13_post_process_record,
-    tls_get_max_records_default,
-    tls_write_records_default,
+    tls_get_max_records_multiblock,
+    tls_write_records_multiblock, /* Defined in tls_multib.c */
     tls_allocate_write_buffers_default,
     tls_initialise_write_packets_default,
     tls13_get_record_type,
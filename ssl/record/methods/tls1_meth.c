@@ -150,9 +150,129 @@ static int tls1_set_crypto_state(OSSL_RECORD_LAYER *rl, int level,
         rl->eivlen = (size_t)eivlen;
     }
 
+    /*
+     * Records for provided GCM and ChaCha20-Poly1305 ciphers can be sealed in
+     * a batch, see tls1_cipher_batch(). ChaCha20-Poly1305 nonces are derived
+     * from the static IV, so we need to keep it.
+     */
+    if (enc && !rl->isdtls
+            && EVP_CIPHER_get0_provider(EVP_CIPHER_CTX_get0_cipher(ciph_ctx))
+               != NULL) {
+        if (EVP_CIPHER_get_mode(ciph) == EVP_CIPH_GCM_MODE
+                && rl->eivlen == EVP_GCM_TLS_EXPLICIT_IV_LEN) {
+            rl->aead_batch = 1;
+        } else if (EVP_CIPHER_get_nid(ciph) == NID_chacha20_poly1305
+                   && ivlen == (size_t)EVP_CIPHER_CTX_get_iv_length(ciph_ctx)
+                   && ivlen >= SEQ_NUM_SIZE) {
+            if ((rl->iv = OPENSSL_memdup(iv, ivlen)) == NULL) {
+                ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+                return OSSL_RECORD_RETURN_FATAL;
+            }
+            rl->aead_batch = 1;
+        }
+    }
+
     return OSSL_RECORD_RETURN_SUCCESS;
 }
 
+/*
+ * Seals several application data records in a single AEAD batch operation.
+ * The nonces are the ones the cipher would use if the records were sealed one
+ * at a time: for GCM the explicit part comes from the cipher's invocation
+ * counter and is written in front of the ciphertext, and for
+ * ChaCha20-Poly1305 it is the static IV XORed with the sequence number.
+ */
+static int tls1_cipher_batch(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
+                             size_t n_recs)
+{
+    unsigned char nonces[SSL_MAX_PIPELINES][EVP_MAX_IV_LENGTH];
+    unsigned char aadbufs[SSL_MAX_PIPELINES][EVP_AEAD_TLS1_AAD_LEN];
+    const unsigned char *iv[SSL_MAX_PIPELINES];
+    const unsigned char *aad[SSL_MAX_PIPELINES];
+    const unsigned char *in[SSL_MAX_PIPELINES];
+    unsigned char *out[SSL_MAX_PIPELINES];
+    unsigned char *tag[SSL_MAX_PIPELINES];
+    size_t aadlen[SSL_MAX_PIPELINES];
+    size_t inl[SSL_MAX_PIPELINES];
+    EVP_CIPHER_CTX *ds = rl->enc_ctx;
+    int gcm = EVP_CIPHER_CTX_get_mode(ds) == EVP_CIPH_GCM_MODE;
+    size_t nonce_len, eivlen, offset, loop, i;
+    TLS_RL_RECORD *rec;
+    int ivlen, ret;
+
+    ivlen = EVP_CIPHER_CTX_get_iv_length(ds);
+    if (n_recs > SSL_MAX_PIPELINES
+            || ivlen < SEQ_NUM_SIZE || ivlen > EVP_MAX_IV_LENGTH) {
+        /* Should not happen */
+        RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+    nonce_len = (size_t)ivlen;
+    offset = nonce_len - SEQ_NUM_SIZE;
+    eivlen = gcm ? EVP_GCM_TLS_EXPLICIT_IV_LEN : 0;
+
+    for (i = 0; i < n_recs; i++) {
+        rec = &recs[i];
+
+        if (rec->length < eivlen || rec->data != rec->input) {
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            return 0;
+        }
+
+        if (gcm) {
+            if (EVP_CIPHER_CTX_ctrl(ds, EVP_CTRL_GCM_IV_GEN, ivlen,
+                                    nonces[i]) <= 0) {
+                RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+                return 0;
+            }
+            memcpy(rec->data, nonces[i] + nonce_len - eivlen, eivlen);
+        } else {
+            memcpy(nonces[i], rl->iv, nonce_len);
+            for (loop = 0; loop < SEQ_NUM_SIZE; loop++)
+                nonces[i][offset + loop] ^= rl->sequence[loop];
+        }
+
+        memcpy(aadbufs[i], rl->sequence, SEQ_NUM_SIZE);
+        if (!tls_increment_sequence_ctr(rl)) {
+            /* RLAYERfatal already called */
+            return 0;
+        }
+        aadbufs[i][8] = rec->type;
+        aadbufs[i][9] = (unsigned char)(rl->version >> 8);
+        aadbufs[i][10] = (unsigned char)(rl->version);
+        aadbufs[i][11] = (unsigned char)((rec->length - eivlen) >> 8);
+        aadbufs[i][12] = (unsigned char)((rec->length - eivlen) & 0xff);
+
+        iv[i] = nonces[i];
+        aad[i] = aadbufs[i];
+        aadlen[i] = EVP_AEAD_TLS1_AAD_LEN;
+        in[i] = rec->input + eivlen;
+        inl[i] = rec->length - eivlen;
+        out[i] = rec->data + eivlen;
+        tag[i] = out[i] + inl[i];
+    }
+
+    ret = EVP_CipherAEADBatch(ds, n_recs, iv, nonce_len, aad, aadlen, in, inl,
+                              out, tag, rl->taglen);
+
+    /*
+     * Setting a nonce replaces the static IV that ChaCha20-Poly1305 uses for
+     * records sealed one at a time, so put it back.
+     */
+    if (!gcm && EVP_CipherInit_ex(ds, NULL, NULL, NULL, rl->iv, -1) <= 0)
+        ret = 0;
+
+    if (!ret) {
+        RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        return 0;
+    }
+
+    for (i = 0; i < n_recs; i++)
+        recs[i].length += rl->taglen;
+
+    return 1;
+}
+
 #define MAX_PADDING 256
 /*-
  * tls1_cipher encrypts/decrypts |n_recs| in |recs|. Calls RLAYERfatal on
@@ -182,6 +302,9 @@ static int tls1_cipher(OSSL_RECORD_LAYER *rl, TLS_RL_RECORD *recs,
         return 0;
     }
 
+    if (n_recs > 1 && sending && rl->aead_batch)
+        return tls1_cipher_batch(rl, recs, n_recs);
+
     if (EVP_MD_CTX_get0_md(rl->md_ctx)) {
         int n = EVP_MD_CTX_get_size(rl->md_ctx);
 
@@ -621,6 +744,8 @@ int tls1_initialise_write_packets(OSSL_RECORD_LAYER *rl,
         prefixtempl->buf = NULL;
         prefixtempl->version = templates[0].version;
         prefixtempl->buflen = 0;
+        prefixtempl->iov = NULL;
+        prefixtempl->numiov = 0;
         prefixtempl->type = SSL3_RT_APPLICATION_DATA;
 
         wb = &bufs[0];
@@ -29,6 +29,33 @@ void ossl_tls_buffer_release(TLS_BUFFER *b)
     b->buf = NULL;
 }
 
+/*
+ * Record buffers come from the buffer_alloc callback if one was provided, so
+ * that they can be shared between connections.
+ */
+static unsigned char *tls_buffer_alloc(OSSL_RECORD_LAYER *rl, size_t len)
+{
+    if (rl->buffer_alloc != NULL)
+        return rl->buffer_alloc(rl->cbarg, len);
+    return OPENSSL_malloc(len);
+}
+
+static void tls_buffer_free(OSSL_RECORD_LAYER *rl, TLS_BUFFER *b)
+{
+    if (rl->buffer_free != NULL)
+        rl->buffer_free(rl->cbarg, b->buf, b->len);
+    else
+        OPENSSL_free(b->buf);
+    b->buf = NULL;
+}
+
+/*
+ * Whether buffers should be given back as soon as they are drained. This is
+ * always the case if they are shared with other connections.
+ */
+#define TLS_RELEASE_BUFFERS(rl) \
+    (((rl)->mode & SSL_MODE_RELEASE_BUFFERS) != 0 || (rl)->buffer_free != NULL)
+
 static void TLS_RL_RECORD_release(TLS_RL_RECORD *r, size_t num_recs)
 {
     size_t i;
@@ -133,7 +160,7 @@ static void tls_release_write_buffer_int(OSSL_RECORD_LAYER *rl, size_t start)
         if (TLS_BUFFER_is_app_buffer(wb))
             TLS_BUFFER_set_app_buffer(wb, 0);
         else
-            OPENSSL_free(wb->buf);
+            tls_buffer_free(rl, wb);
         wb->buf = NULL;
         pipes--;
     }
@@ -186,14 +213,12 @@ int tls_setup_write_buffer(OSSL_RECORD_LAYER *rl, size_t numwpipes,
         if (len == 0)
             len = defltlen;
 
-        if (thiswb->len != len) {
-            OPENSSL_free(thiswb->buf);
-            thiswb->buf = NULL;         /* force reallocation */
-        }
+        if (thiswb->len != len && thiswb->buf != NULL)
+            tls_buffer_free(rl, thiswb); /* force reallocation */
 
         p = thiswb->buf;
         if (p == NULL) {
-            p = OPENSSL_malloc(len);
+            p = tls_buffer_alloc(rl, len);
             if (p == NULL) {
                 if (rl->numwpipes < currpipe)
                     rl->numwpipes = currpipe;
@@ -258,7 +283,7 @@ int tls_setup_read_buffer(OSSL_RECORD_LAYER *rl)
         if (b->default_len > len)
             len = b->default_len;
 
-        if ((p = OPENSSL_malloc(len)) == NULL) {
+        if ((p = tls_buffer_alloc(rl, len)) == NULL) {
             /*
              * We've got a malloc failure, and we're still initialising buffers.
              * We assume we're so doomed that we won't even be able to send an
@@ -281,8 +306,7 @@ static int tls_release_read_buffer(OSSL_RECORD_LAYER *rl)
     b = &rl->rbuf;
     if ((rl->options & SSL_OP_CLEANSE_PLAINTEXT) != 0)
         OPENSSL_cleanse(b->buf, b->len);
-    OPENSSL_free(b->buf);
-    b->buf = NULL;
+    tls_buffer_free(rl, b);
     rl->packet = NULL;
     rl->packet_length = 0;
     return 1;
@@ -430,7 +454,7 @@ int tls_default_read_n(OSSL_RECORD_LAYER *rl, size_t n, size_t max, int extend,
 
         if (ret <= OSSL_RECORD_RETURN_RETRY) {
             rb->left = left;
-            if ((rl->mode & SSL_MODE_RELEASE_BUFFERS) != 0 && !rl->isdtls)
+            if (TLS_RELEASE_BUFFERS(rl) && !rl->isdtls)
                 if (len + left == 0)
                     tls_release_read_buffer(rl);
             return ret;
@@ -720,6 +744,7 @@ int tls_get_more_records(OSSL_RECORD_LAYER *rl)
 
         /* decrypt in place in 'thisrr->input' */
         thisrr->data = thisrr->input;
+        thisrr->in_read_dest = 0;
         thisrr->orig_len = thisrr->length;
 
         num_recs++;
@@ -816,9 +841,31 @@ int tls_get_more_records(OSSL_RECORD_LAYER *rl)
         }
     }
 
+    /*
+     * If the caller has offered a buffer for the payload and this single
+     * application data record is sure to fit in it, decrypt it straight into
+     * that buffer and save copying it out of the read buffer later.
+     */
+    if (num_recs == 1
+            && rl->read_dest != NULL
+            && rl->direct_read
+            && rr[0].type == SSL3_RT_APPLICATION_DATA
+            && rr[0].length > rl->taglen
+            && rr[0].length - rl->taglen <= rl->read_dest_len) {
+        rr[0].data = rl->read_dest;
+        rr[0].in_read_dest = 1;
+    }
+
     ERR_set_mark();
     enc_err = rl->funcs->cipher(rl, rr, num_recs, 0, macbufs, mac_size);
 
+    if (enc_err == 0 && rr[0].in_read_dest) {
+        /* Don't leave unauthenticated plaintext in the caller's buffer */
+        OPENSSL_cleanse(rr[0].data, rr[0].orig_len - rl->taglen);
+        rr[0].data = rr[0].input;
+        rr[0].in_read_dest = 0;
+    }
+
     /*-
      * enc_err is:
      *    0: if the record is publicly invalid, or an internal error, or AEAD
@@ -923,6 +970,18 @@ int tls_get_more_records(OSSL_RECORD_LAYER *rl)
             goto end;
         }
 
+        /*
+         * Only application data may be returned in the caller's buffer. Any
+         * other content type is moved back to the read buffer.
+         */
+        if (thisrr->in_read_dest
+                && thisrr->type != SSL3_RT_APPLICATION_DATA) {
+            memcpy(thisrr->input, thisrr->data, thisrr->length);
+            OPENSSL_cleanse(thisrr->data, thisrr->length);
+            thisrr->data = thisrr->input;
+            thisrr->in_read_dest = 0;
+        }
+
         /*
          * Record overflow checking (e.g. checking if
          * thisrr->length > SSL3_RT_MAX_PLAIN_LENGTH) is the responsibility of
@@ -1129,9 +1188,13 @@ int tls_read_record(OSSL_RECORD_LAYER *rl, void **rechandle, int *rversion,
 
         ret = rl->funcs->get_more_records(rl);
 
-        if (ret != OSSL_RECORD_RETURN_SUCCESS)
+        if (ret != OSSL_RECORD_RETURN_SUCCESS) {
+            tls_set_read_dest(rl, NULL, 0);
             return ret;
+        }
     }
+    /* The read destination is only offered for a single call */
+    tls_set_read_dest(rl, NULL, 0);
 
     /*
      * We have now got rl->num_recs records buffered in rl->rrec. rl->curr_rec
@@ -1169,7 +1232,8 @@ int tls_release_record(OSSL_RECORD_LAYER *rl, void *rechandle, size_t length)
         return OSSL_RECORD_RETURN_FATAL;
     }
 
-    if ((rl->options & SSL_OP_CLEANSE_PLAINTEXT) != 0)
+    /* Data in the caller's buffer is the caller's to cleanse */
+    if ((rl->options & SSL_OP_CLEANSE_PLAINTEXT) != 0 && !rec->in_read_dest)
         OPENSSL_cleanse(rec->data + rec->off, length);
 
     rec->off += length;
@@ -1181,7 +1245,7 @@ int tls_release_record(OSSL_RECORD_LAYER *rl, void *rechandle, size_t length)
     rl->num_released++;
 
     if (rl->curr_rec == rl->num_released
-            && (rl->mode & SSL_MODE_RELEASE_BUFFERS) != 0
+            && TLS_RELEASE_BUFFERS(rl)
             && TLS_BUFFER_get_left(&rl->rbuf) == 0)
         tls_release_read_buffer(rl);
 
@@ -1349,6 +1413,13 @@ tls_int_new_record_layer(OSSL_LIB_CTX *libctx, const char *propq, int vers,
                 break;
             case OSSL_FUNC_RLAYER_PADDING:
                 rl->padding = OSSL_FUNC_rlayer_padding(fns);
+                break;
+            case OSSL_FUNC_RLAYER_BUFFER_ALLOC:
+                rl->buffer_alloc = OSSL_FUNC_rlayer_buffer_alloc(fns);
+                break;
+            case OSSL_FUNC_RLAYER_BUFFER_FREE:
+                rl->buffer_free = OSSL_FUNC_rlayer_buffer_free(fns);
+                break;
             default:
                 /* Just ignore anything we don't understand */
                 break;
@@ -1443,7 +1514,8 @@ static void tls_int_free(OSSL_RECORD_LAYER *rl)
     BIO_free(rl->prev);
     BIO_free(rl->bio);
     BIO_free(rl->next);
-    ossl_tls_buffer_release(&rl->rbuf);
+    if (rl->rbuf.buf != NULL)
+        tls_buffer_free(rl, &rl->rbuf);
 
     tls_release_write_buffer(rl);
 
@@ -1741,6 +1813,24 @@ int tls_post_encryption_processing_default(OSSL_RECORD_LAYER *rl,
     return 1;
 }
 
+/*
+ * Copy the payload of |templ| into |pkt|, gathering it from the buffers of a
+ * scatter-gather template.
+ */
+int tls_copy_template_payload(WPACKET *pkt, const OSSL_RECORD_TEMPLATE *templ)
+{
+    size_t i;
+
+    if (templ->iov == NULL)
+        return WPACKET_memcpy(pkt, templ->buf, templ->buflen);
+
+    for (i = 0; i < templ->numiov; i++)
+        if (!WPACKET_memcpy(pkt, templ->iov[i].buf, templ->iov[i].buf_len))
+            return 0;
+
+    return 1;
+}
+
 int tls_write_records_default(OSSL_RECORD_LAYER *rl,
                               OSSL_RECORD_TEMPLATE *templates,
                               size_t numtempl)
@@ -1816,13 +1906,18 @@ int tls_write_records_default(OSSL_RECORD_LAYER *rl,
 
         /* first we compress */
         if (rl->compctx != NULL) {
+            /* Scatter-gather writes are never used with compression */
+            if (!ossl_assert(thistempl->iov == NULL)) {
+                RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+                goto err;
+            }
             if (!tls_do_compress(rl, thiswr)
                     || !WPACKET_allocate_bytes(thispkt, thiswr->length, NULL)) {
                 RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, SSL_R_COMPRESSION_FAILURE);
                 goto err;
             }
         } else if (compressdata != NULL) {
-            if (!WPACKET_memcpy(thispkt, thiswr->input, thiswr->length)) {
+            if (!tls_copy_template_payload(thispkt, thistempl)) {
                 RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
                 goto err;
             }
@@ -1957,8 +2052,7 @@ int tls_retry_write_records(OSSL_RECORD_LAYER *rl)
             if (++(rl->nextwbuf) < rl->numwpipes)
                 continue;
 
-            if (rl->nextwbuf == rl->numwpipes
-                    && (rl->mode & SSL_MODE_RELEASE_BUFFERS) != 0)
+            if (rl->nextwbuf == rl->numwpipes && TLS_RELEASE_BUFFERS(rl))
                 tls_release_write_buffer(rl);
             return OSSL_RECORD_RETURN_SUCCESS;
         } else if (i <= 0) {
@@ -1969,7 +2063,7 @@ int tls_retry_write_records(OSSL_RECORD_LAYER *rl)
                  */
                 TLS_BUFFER_set_left(thiswb, 0);
                 if (++(rl->nextwbuf) == rl->numwpipes
-                        && (rl->mode & SSL_MODE_RELEASE_BUFFERS) != 0)
+                        && TLS_RELEASE_BUFFERS(rl))
                     tls_release_write_buffer(rl);
 
             }
@@ -2152,6 +2246,12 @@ int tls_free_buffers(OSSL_RECORD_LAYER *rl)
     return tls_release_read_buffer(rl);
 }
 
+void tls_set_read_dest(OSSL_RECORD_LAYER *rl, unsigned char *buf, size_t len)
+{
+    rl->read_dest = buf;
+    rl->read_dest_len = len;
+}
+
 const OSSL_RECORD_METHOD ossl_tls_record_method = {
     tls_new_record_layer,
     tls_free,
@@ -2177,5 +2277,6 @@ const OSSL_RECORD_METHOD ossl_tls_record_method = {
     NULL,
     tls_increment_sequence_ctr,
     tls_alloc_buffers,
-    tls_free_buffers
+    tls_free_buffers,
+    tls_set_read_dest
 };
@@ -38,6 +38,19 @@ static int tls_is_multiblock_capable(OSSL_RECORD_LAYER *rl, uint8_t type,
     return 0;
 }
 
+/*
+ * Records for AEAD ciphers are written back to back into a single buffer and
+ * sealed in one batch by the cipher function.
+ */
+static int tls_is_aead_batch_capable(OSSL_RECORD_LAYER *rl, uint8_t type)
+{
+    return type == SSL3_RT_APPLICATION_DATA
+           && rl->aead_batch
+           && !rl->isdtls
+           && rl->compctx == NULL
+           && !BIO_get_ktls_send(rl->bio);
+}
+
 size_t tls_get_max_records_multiblock(OSSL_RECORD_LAYER *rl, uint8_t type,
                                       size_t len, size_t maxfrag,
                                       size_t *preffrag)
@@ -53,6 +66,31 @@ size_t tls_get_max_records_multiblock(OSSL_RECORD_LAYER *rl, uint8_t type,
         return 4;
     }
 
+    if (tls_is_aead_batch_capable(rl, type)) {
+        size_t pipes;
+
+        /*
+         * If we have been configured to use pipelines then split the data as
+         * for any other pipeline capable cipher. Otherwise only large writes
+         * are split, and only into full records, so that what goes on the
+         * wire is the same as if the records had been written one by one.
+         */
+        if (rl->max_pipelines > 1) {
+            if (len == 0)
+                return 1;
+            pipes = ((len - 1) / *preffrag) + 1;
+
+            return (pipes < rl->max_pipelines) ? pipes : rl->max_pipelines;
+        }
+
+        if (len >= 8 * (*preffrag))
+            return 8;
+        if (len >= 4 * (*preffrag))
+            return 4;
+
+        return 1;
+    }
+
     return tls_get_max_records_default(rl, type, len, maxfrag, preffrag);
 }
 
@@ -82,8 +120,11 @@ static int tls_write_records_multiblock_int(OSSL_RECORD_LAYER *rl,
      * Check templates have contiguous buffers and are all the same type and
      * length
      */
+    if (templates[0].iov != NULL)
+        return 0;
     for (i = 1; i < numtempl; i++) {
-        if (templates[i - 1].type != templates[i].type
+        if (templates[i].iov != NULL
+                || templates[i - 1].type != templates[i].type
                 || templates[i - 1].buflen != templates[i].buflen
                 || templates[i - 1].buf + templates[i - 1].buflen
                    != templates[i].buf)
@@ -164,6 +205,142 @@ static int tls_write_records_multiblock_int(OSSL_RECORD_LAYER *rl,
 #endif
 }
 
+/*
+ * Write records for an AEAD cipher back to back into a single write buffer.
+ * They are sealed with a single call to the cipher function and then sent with
+ * a single BIO_write().
+ *
+ * Returns 1 on success, 0 if this isn't suitable (non-fatal error), or -1 on
+ * fatal error.
+ */
+static int tls_write_records_aead_batch(OSSL_RECORD_LAYER *rl,
+                                        OSSL_RECORD_TEMPLATE *templates,
+                                        size_t numtempl)
+{
+    WPACKET pkt[SSL_MAX_PIPELINES];
+    TLS_RL_RECORD wr[SSL_MAX_PIPELINES];
+    unsigned char *recstart[SSL_MAX_PIPELINES];
+    unsigned char *compressdata, *recend = NULL;
+    size_t j, len, align = 0, off, written, wpinited = 0;
+    TLS_BUFFER *wb;
+    uint8_t rectype;
+    int ret = -1;
+
+    if (numtempl < 2 || numtempl > SSL_MAX_PIPELINES)
+        return 0;
+
+    for (j = 0; j < numtempl; j++)
+        if (!tls_is_aead_batch_capable(rl, templates[j].type))
+            return 0;
+
+    /*
+     * Make room for every record to be of maximum size, so that the buffer
+     * stays the same from one write to the next.
+     */
+    len = numtempl * (SSL3_RT_HEADER_LENGTH + rl->eivlen + rl->max_frag_len
+                      + 1 + SSL3_RT_SEND_MAX_ENCRYPTED_OVERHEAD);
+#if defined(SSL3_ALIGN_PAYLOAD) && SSL3_ALIGN_PAYLOAD != 0
+    len += SSL3_ALIGN_PAYLOAD - 1;
+#endif
+    if (!tls_setup_write_buffer(rl, 1, len, len)) {
+        /* RLAYERfatal() already called */
+        return -1;
+    }
+    wb = &rl->wbuf[0];
+    wb->type = templates[0].type;
+
+#if defined(SSL3_ALIGN_PAYLOAD) && SSL3_ALIGN_PAYLOAD != 0
+    align = (size_t)TLS_BUFFER_get_buf(wb) + SSL3_RT_HEADER_LENGTH;
+    align = SSL3_ALIGN_PAYLOAD - 1 - ((align - 1) % SSL3_ALIGN_PAYLOAD);
+#endif
+    TLS_BUFFER_set_offset(wb, align);
+    off = align;
+
+    memset(wr, 0, sizeof(wr));
+    for (j = 0; j < numtempl; j++) {
+        recstart[j] = TLS_BUFFER_get_buf(wb) + off;
+        if (!WPACKET_init_static_len(&pkt[j], recstart[j],
+                                     TLS_BUFFER_get_len(wb) - off, 0)) {
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+        wpinited++;
+
+        if (rl->funcs->get_record_type != NULL)
+            rectype = rl->funcs->get_record_type(rl, &templates[j]);
+        else
+            rectype = templates[j].type;
+
+        TLS_RL_RECORD_set_type(&wr[j], rectype);
+        TLS_RL_RECORD_set_rec_version(&wr[j], templates[j].version);
+
+        if (!rl->funcs->prepare_record_header(rl, &pkt[j], &templates[j],
+                                              rectype, &compressdata)) {
+            /* RLAYERfatal() already called */
+            goto err;
+        }
+
+        TLS_RL_RECORD_set_data(&wr[j], compressdata);
+        TLS_RL_RECORD_set_length(&wr[j], templates[j].buflen);
+        TLS_RL_RECORD_set_input(&wr[j], (unsigned char *)templates[j].buf);
+
+        if (compressdata != NULL) {
+            if (!tls_copy_template_payload(&pkt[j], &templates[j])) {
+                RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+                goto err;
+            }
+            TLS_RL_RECORD_reset_input(&wr[j]);
+        }
+
+        if (rl->funcs->add_record_padding != NULL
+                && !rl->funcs->add_record_padding(rl, &templates[j], &pkt[j],
+                                                  &wr[j])) {
+            /* RLAYERfatal() already called */
+            goto err;
+        }
+
+        if (!rl->funcs->prepare_for_encryption(rl, 0, &pkt[j], &wr[j])) {
+            /* RLAYERfatal() already called */
+            goto err;
+        }
+
+        /* The next record starts right after the tag of this one */
+        if (!WPACKET_get_total_written(&pkt[j], &written)) {
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+        off += written + rl->taglen;
+    }
+
+    if (rl->funcs->cipher(rl, wr, numtempl, 1, NULL, 0) < 1) {
+        if (rl->alert == SSL_AD_NO_ALERT)
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+        goto err;
+    }
+
+    for (j = 0; j < numtempl; j++) {
+        if (!rl->funcs->post_encryption_processing(rl, 0, &templates[j],
+                                                   &pkt[j], &wr[j])) {
+            /* RLAYERfatal() already called */
+            goto err;
+        }
+
+        /* Check that the cipher added exactly the tag we made room for */
+        recend = recstart[j] + TLS_RL_RECORD_get_length(&wr[j]);
+        if (j + 1 < numtempl && !ossl_assert(recend == recstart[j + 1])) {
+            RLAYERfatal(rl, SSL_AD_INTERNAL_ERROR, ERR_R_INTERNAL_ERROR);
+            goto err;
+        }
+    }
+
+    TLS_BUFFER_set_left(wb, recend - recstart[0]);
+    ret = 1;
+ err:
+    for (j = 0; j < wpinited; j++)
+        WPACKET_cleanup(&pkt[j]);
+    return ret;
+}
+
 int tls_write_records_multiblock(OSSL_RECORD_LAYER *rl,
                                  OSSL_RECORD_TEMPLATE *templates,
                                  size_t numtempl)
@@ -171,6 +348,8 @@ int tls_write_records_multiblock(OSSL_RECORD_LAYER *rl,
     int ret;
 
     ret = tls_write_records_multiblock_int(rl, templates, numtempl);
+    if (ret == 0)
+        ret = tls_write_records_aead_batch(rl, templates, numtempl);
     if (ret < 0) {
         /* RLAYERfatal already called */
         return 0;
@@ -655,6 +655,8 @@ int do_dtls1_write(SSL_CONNECTION *sc, uint8_t type, const unsigned char *buf,
         tmpl.version = sc->version;
     tmpl.buf = buf;
     tmpl.buflen = len;
+    tmpl.iov = NULL;
+    tmpl.numiov = 0;
 
     ret = HANDLE_RLAYER_WRITE_RETURN(sc,
               sc->rlayer.wrlmethod->write_records(sc->rlayer.wrl, &tmpl, 1));
@@ -262,18 +262,80 @@ static int tls_write_check_pending(SSL_CONNECTION *s, uint8_t type,
 }
 
 /*
- * Call this to write data in records of type 'type' It will return <= 0 if
- * not all data has been sent or non-blocking IO.
+ * Point |tmpl| at the payload of a record of up to |len| bytes, starting |off|
+ * bytes into the data being written. That data is either in |buf| or, for a
+ * scatter-gather write, in the |iovcnt| buffers in |iov|. In the latter case
+ * the record is gathered from up to SSL3_MAX_RECORD_IOV of those buffers,
+ * described in |segs|, or only from the buffer it starts in if |gather| is 0.
+ * Returns the length of the record, which may be less than |len|.
  */
-int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
-                     size_t *written)
+static size_t ssl3_set_record_payload(OSSL_RECORD_TEMPLATE *tmpl,
+                                      const unsigned char *buf,
+                                      const SSL_CONST_IOVEC *iov,
+                                      size_t iovcnt, int gather, size_t off,
+                                      size_t len, SSL_CONST_IOVEC *segs)
+{
+    size_t i, seglen, reclen = 0, nsegs = 0;
+
+    tmpl->iov = NULL;
+    tmpl->numiov = 0;
+
+    if (iov == NULL) {
+        tmpl->buf = buf + off;
+        tmpl->buflen = len;
+        return len;
+    }
+
+    /* Find the buffer that the record starts in */
+    for (i = 0; i < iovcnt && off >= iov[i].buf_len; i++)
+        off -= iov[i].buf_len;
+
+    for (; i < iovcnt && reclen < len && nsegs < SSL3_MAX_RECORD_IOV;
+         i++, off = 0) {
+        seglen = iov[i].buf_len - off;
+        if (seglen == 0)
+            continue;
+        if (seglen > len - reclen)
+            seglen = len - reclen;
+        segs[nsegs].buf = (const unsigned char *)iov[i].buf + off;
+        segs[nsegs].buf_len = seglen;
+        nsegs++;
+        reclen += seglen;
+        if (!gather)
+            break;
+    }
+
+    if (nsegs > 1) {
+        tmpl->buf = NULL;
+        tmpl->iov = segs;
+        tmpl->numiov = nsegs;
+    } else {
+        /* A record within a single buffer needs no gathering */
+        tmpl->buf = nsegs == 1 ? segs[0].buf : NULL;
+    }
+    tmpl->buflen = reclen;
+
+    return reclen;
+}
+
+/*
+ * Write |len| bytes in records of type |type|, taking them from |buf| or, if
+ * |iov| is not NULL, from the |iovcnt| buffers in |iov| in turn. It will
+ * return <= 0 if not all data has been sent or non-blocking IO.
+ */
+static int ssl3_write_bytes_int(SSL *ssl, uint8_t type,
+                                const unsigned char *buf,
+                                const SSL_CONST_IOVEC *iov, size_t iovcnt,
+                                size_t len, size_t *written)
 {
-    const unsigned char *buf = buf_;
     size_t tot;
     size_t n, max_send_fragment, split_send_fragment, maxpipes;
-    int i;
+    int i, gather;
     SSL_CONNECTION *s = SSL_CONNECTION_FROM_SSL_ONLY(ssl);
     OSSL_RECORD_TEMPLATE tmpls[SSL_MAX_PIPELINES];
+    SSL_CONST_IOVEC segs[SSL_MAX_PIPELINES][SSL3_MAX_RECORD_IOV];
+    /* Identifies the caller's data when checking a write retry */
+    const unsigned char *wbuf = iov != NULL ? (const unsigned char *)iov : buf;
     unsigned int recversion;
 
     if (s == NULL)
@@ -330,7 +392,7 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
         }
     }
 
-    i = tls_write_check_pending(s, type, buf, len);
+    i = tls_write_check_pending(s, type, wbuf, len);
     if (i < 0) {
         /* SSLfatal() already called */
         return i;
@@ -353,7 +415,7 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
          */
         s->rlayer.wpend_tot = 0;
         s->rlayer.wpend_type = type;
-        s->rlayer.wpend_buf = buf;
+        s->rlayer.wpend_buf = wbuf;
     }
 
     if (tot == len) {           /* done? */
@@ -399,6 +461,16 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
             && s->hello_retry_request == SSL_HRR_NONE)
         recversion = TLS1_VERSION;
 
+    /*
+     * Records of a scatter-gather write may span several of the caller's
+     * buffers, except with KTLS, where the kernel reads the payload straight
+     * from the caller's buffer, or with compression, which needs the payload
+     * in one piece.
+     */
+    gather = iov != NULL
+             && !BIO_get_ktls_send(s->wbio)
+             && s->rlayer.wrlmethod->get_compression(s->rlayer.wrl) == NULL;
+
     for (;;) {
         size_t tmppipelen, remain;
         size_t j, lensofar = 0;
@@ -435,11 +507,14 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
             for (j = 0; j < maxpipes; j++) {
                 tmpls[j].type = type;
                 tmpls[j].version = recversion;
-                tmpls[j].buf = &(buf[tot]) + (j * split_send_fragment);
-                tmpls[j].buflen = split_send_fragment;
+                lensofar += ssl3_set_record_payload(&tmpls[j], buf, iov,
+                                                    iovcnt, gather,
+                                                    tot + lensofar,
+                                                    split_send_fragment,
+                                                    segs[j]);
             }
             /* Remember how much data we are going to be sending */
-            s->rlayer.wpend_tot = maxpipes * split_send_fragment;
+            s->rlayer.wpend_tot = lensofar;
         } else {
             /* We can partially fill all available pipelines */
             tmppipelen = n / maxpipes;
@@ -453,14 +528,15 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
             for (j = 0; j < maxpipes; j++) {
                 tmpls[j].type = type;
                 tmpls[j].version = recversion;
-                tmpls[j].buf = &(buf[tot]) + lensofar;
-                tmpls[j].buflen = tmppipelen;
-                lensofar += tmppipelen;
+                lensofar += ssl3_set_record_payload(&tmpls[j], buf, iov,
+                                                    iovcnt, gather,
+                                                    tot + lensofar,
+                                                    tmppipelen, segs[j]);
                 if (j + 1 == remain)
                     tmppipelen--;
             }
             /* Remember how much data we are going to be sending */
-            s->rlayer.wpend_tot = n;
+            s->rlayer.wpend_tot = lensofar;
         }
 
         i = HANDLE_RLAYER_WRITE_RETURN(s,
@@ -484,6 +560,26 @@ int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf_, size_t len,
     }
 }
 
+/*
+ * Call this to write data in records of type 'type' It will return <= 0 if
+ * not all data has been sent or non-blocking IO.
+ */
+int ssl3_write_bytes(SSL *ssl, uint8_t type, const void *buf, size_t len,
+                     size_t *written)
+{
+    return ssl3_write_bytes_int(ssl, type, buf, NULL, 0, len, written);
+}
+
+/*
+ * As ssl3_write_bytes() but takes the |len| bytes to write from the |iovcnt|
+ * buffers in |iov|, packing them into records as if they were contiguous.
+ */
+int ssl3_writev_bytes(SSL *ssl, uint8_t type, const SSL_CONST_IOVEC *iov,
+                      size_t iovcnt, size_t len, size_t *written)
+{
+    return ssl3_write_bytes_int(ssl, type, NULL, iov, iovcnt, len, written);
+}
+
 int ossl_tls_handle_rlayer_return(SSL_CONNECTION *s, int writing, int ret,
                                   char *file, int line)
 {
@@ -685,6 +781,18 @@ int ssl3_read_bytes(SSL *ssl, uint8_t type, uint8_t *recvd_type,
         do {
             rr = &s->rlayer.tlsrecs[s->rlayer.num_recs];
 
+            /*
+             * In SSL_MODE_DIRECT_READ let the record layer decrypt the first
+             * record straight into the caller's buffer if it can
+             */
+            if (s->rlayer.num_recs == 0
+                    && type == SSL3_RT_APPLICATION_DATA
+                    && !peek
+                    && len > 0
+                    && (s->mode & SSL_MODE_DIRECT_READ) != 0
+                    && s->rlayer.rrlmethod->set_read_dest != NULL)
+                s->rlayer.rrlmethod->set_read_dest(s->rlayer.rrl, buf, len);
+
             ret = HANDLE_RLAYER_READ_RETURN(s,
                     s->rlayer.rrlmethod->read_record(s->rlayer.rrl,
                                                      &rr->rechandle,
@@ -786,7 +894,9 @@ int ssl3_read_bytes(SSL *ssl, uint8_t type, uint8_t *recvd_type,
             else
                 n = len - totalbytes;
 
-            memcpy(buf, &(rr->data[rr->off]), n);
+            /* Nothing to copy if the record was decrypted into |buf| */
+            if (buf != &(rr->data[rr->off]))
+                memcpy(buf, &(rr->data[rr->off]), n);
             buf += n;
             if (peek) {
                 /* Mark any zero length record as consumed CVE-2016-6305 */
@@ -1155,11 +1265,35 @@ static size_t rlayer_padding_wrapper(void *cbarg, int type, size_t len)
                                        s->rlayer.record_padding_arg);
 }
 
+/*
+ * The connection holds a reference to the pool of the SSL_CTX it was created
+ * from, which stays the same even if s->ctx is switched or the pool of that
+ * SSL_CTX is replaced.
+ */
+static OSSL_FUNC_rlayer_buffer_alloc_fn rlayer_buffer_alloc_wrapper;
+static unsigned char *rlayer_buffer_alloc_wrapper(void *cbarg, size_t len)
+{
+    SSL_CONNECTION *s = cbarg;
+
+    return ssl_recbuf_pool_get(s->recbuf_pool, len);
+}
+
+static OSSL_FUNC_rlayer_buffer_free_fn rlayer_buffer_free_wrapper;
+static void rlayer_buffer_free_wrapper(void *cbarg, unsigned char *buf,
+                                       size_t len)
+{
+    SSL_CONNECTION *s = cbarg;
+
+    ssl_recbuf_pool_put(s->recbuf_pool, buf, len);
+}
+
 static const OSSL_DISPATCH rlayer_dispatch[] = {
     { OSSL_FUNC_RLAYER_SKIP_EARLY_DATA, (void (*)(void))ossl_statem_skip_early_data },
     { OSSL_FUNC_RLAYER_MSG_CALLBACK, (void (*)(void))rlayer_msg_callback_wrapper },
     { OSSL_FUNC_RLAYER_SECURITY, (void (*)(void))rlayer_security_wrapper },
     { OSSL_FUNC_RLAYER_PADDING, (void (*)(void))rlayer_padding_wrapper },
+    { OSSL_FUNC_RLAYER_BUFFER_ALLOC, (void (*)(void))rlayer_buffer_alloc_wrapper },
+    { OSSL_FUNC_RLAYER_BUFFER_FREE, (void (*)(void))rlayer_buffer_free_wrapper },
     OSSL_DISPATCH_END
 };
 
@@ -1403,6 +1537,16 @@ int ssl_set_new_record_layer(SSL_CONNECTION *s, int version,
                 if (s->rlayer.record_padding_cb == NULL)
                     continue;
                 break;
+            case OSSL_FUNC_RLAYER_BUFFER_ALLOC:
+            case OSSL_FUNC_RLAYER_BUFFER_FREE:
+                /*
+                 * DTLS keeps read buffers around for buffered records, so
+                 * only stream TLS uses the pool.
+                 */
+                if (s->recbuf_pool == NULL
+                        || SSL_CONNECTION_IS_DTLS(s))
+                    continue;
+                break;
             default:
                 break;
             }
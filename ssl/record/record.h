@@ -19,6 +19,12 @@
 
 #define SEQ_NUM_SIZE                            8
 
+/*
+ * The maximum number of the caller's buffers that a record of a scatter-gather
+ * write is gathered from
+ */
+#define SSL3_MAX_RECORD_IOV                     8
+
 typedef struct tls_record_st {
     void *rechandle;
     int version;
@@ -144,6 +150,8 @@ int RECORD_LAYER_is_sslv2_record(RECORD_LAYER *rl);
 __owur size_t ssl3_pending(const SSL *s);
 __owur int ssl3_write_bytes(SSL *s, uint8_t type, const void *buf, size_t len,
                             size_t *written);
+__owur int ssl3_writev_bytes(SSL *s, uint8_t type, const SSL_CONST_IOVEC *iov,
+                             size_t iovcnt, size_t len, size_t *written);
 __owur int ssl3_read_bytes(SSL *s, uint8_t type, uint8_t *recvd_type,
                            unsigned char *buf, size_t len, int peek,
                            size_t *readbytes);
@@ -194,3 +202,14 @@ OSSL_CORE_MAKE_FUNC(int, rlayer_security, (void *cbarg, int op, int bits,
                                            int nid, void *other))
 # define OSSL_FUNC_RLAYER_PADDING                4
 OSSL_CORE_MAKE_FUNC(size_t, rlayer_padding, (void *cbarg, int type, size_t len))
+/*
+ * If provided, record buffers are obtained and returned with these functions
+ * instead of being allocated and freed, and are returned as soon as they are
+ * drained.
+ */
+# define OSSL_FUNC_RLAYER_BUFFER_ALLOC           5
+OSSL_CORE_MAKE_FUNC(unsigned char *, rlayer_buffer_alloc,
+                    (void *cbarg, size_t len))
+# define OSSL_FUNC_RLAYER_BUFFER_FREE            6
+OSSL_CORE_MAKE_FUNC(void, rlayer_buffer_free,
+                    (void *cbarg, unsigned char *buf, size_t len))
@@ -11,6 +11,7 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include "../ssl_local.h"
+#include "poll_wait.h"
 
 #define ITEM_N(items, stride, n) \
     (*(SSL_POLL_ITEM *)((char *)(items) + (n)*(stride)))
@@ -33,6 +34,51 @@
         FAIL_FROM(i + 1);                                                   \
     } while (0)
 
+/*
+ * Polls the current state of a single item. Returns 0 and raises an ERR if
+ * the item cannot be polled.
+ */
+static int poll_item(SSL_POLL_ITEM *item, int do_tick, uint64_t *p_revents)
+{
+    SSL *ssl;
+
+    *p_revents = 0;
+
+    switch (item->desc.type) {
+    case BIO_POLL_DESCRIPTOR_TYPE_SSL:
+        ssl = item->desc.value.ssl;
+        if (ssl == NULL)
+            /* NULL items are no-ops and have revents reported as 0 */
+            return 1;
+
+        switch (ssl->type) {
+#ifndef OPENSSL_NO_QUIC
+        case SSL_TYPE_QUIC_CONNECTION:
+        case SSL_TYPE_QUIC_XSO:
+            /* below call raises ERR on failure */
+            return ossl_quic_conn_poll_events(ssl, item->events, do_tick,
+                                              p_revents);
+#endif
+
+        default:
+            ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                           "SSL_poll currently only supports QUIC SSL "
+                           "objects");
+            return 0;
+        }
+    case BIO_POLL_DESCRIPTOR_TYPE_SOCK_FD:
+        ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                       "SSL_poll currently does not support polling "
+                       "sockets");
+        return 0;
+    default:
+        ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                       "SSL_poll does not support unknown poll descriptor "
+                       "type %d", item->desc.type);
+        return 0;
+    }
+}
+
 int SSL_poll(SSL_POLL_ITEM *items,
              size_t num_items,
              size_t stride,
@@ -43,82 +89,103 @@ int SSL_poll(SSL_POLL_ITEM *items,
     int ok = 1;
     size_t i, result_count = 0;
     SSL_POLL_ITEM *item;
-    SSL *ssl;
     uint64_t revents;
-    ossl_unused uint64_t events;
-    ossl_unused int do_tick = ((flags & SSL_POLL_FLAG_NO_HANDLE_EVENTS) == 0);
+    int do_tick = ((flags & SSL_POLL_FLAG_NO_HANDLE_EVENTS) == 0);
     int is_immediate
         = (timeout != NULL
            && timeout->tv_sec == 0 && timeout->tv_usec == 0);
+#ifndef OPENSSL_NO_QUIC
+    RIO_POLL_WAITER waiter;
+    int blocking = 0;
+    OSSL_TIME deadline = ossl_time_infinite();
+#endif
 
-    /*
-     * Prevent calls which use SSL_poll functionality which is not currently
-     * supported.
-     */
     if (!is_immediate) {
+#ifdef OPENSSL_NO_QUIC
         ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
-                       "SSL_poll does not currently support blocking "
-                       "operation");
+                       "SSL_poll only supports blocking operation on QUIC "
+                       "SSL objects");
         FAIL_FROM(0);
-    }
+#else
+        /*
+         * Without handling events nothing would consume the network
+         * readiness we wait for, so we would just spin.
+         */
+        if (!do_tick) {
+            ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                           "SSL_poll does not support blocking operation "
+                           "with SSL_POLL_FLAG_NO_HANDLE_EVENTS");
+            FAIL_FROM(0);
+        }
 
-    /* Trivial case. */
-    if (num_items == 0)
-        goto out;
+        if (timeout != NULL)
+            deadline = ossl_time_add(ossl_time_now(),
+                                     ossl_time_from_timeval(*timeout));
+
+        if (!ossl_rio_poll_waiter_init(&waiter, num_items))
+            FAIL_FROM(0);
+        blocking = 1;
+#endif
+    }
 
     /* Poll current state of each item. */
     for (i = 0; i < num_items; ++i) {
-        item    = &ITEM_N(items, stride, i);
-        events  = item->events;
-        revents = 0;
-
-        switch (item->desc.type) {
-        case BIO_POLL_DESCRIPTOR_TYPE_SSL:
-            ssl = item->desc.value.ssl;
-            if (ssl == NULL)
-                /* NULL items are no-ops and have revents reported as 0 */
-                break;
-
-            switch (ssl->type) {
-#ifndef OPENSSL_NO_QUIC
-            case SSL_TYPE_QUIC_CONNECTION:
-            case SSL_TYPE_QUIC_XSO:
-                if (!ossl_quic_conn_poll_events(ssl, events, do_tick, &revents))
-                    /* above call raises ERR */
-                    FAIL_ITEM(i);
+        item = &ITEM_N(items, stride, i);
 
-                if (revents != 0)
-                    ++result_count;
+        if (!poll_item(item, do_tick, &revents))
+            FAIL_ITEM(i);
+
+        if (revents != 0)
+            ++result_count;
 
-                break;
+        item->revents = revents;
+
+#ifndef OPENSSL_NO_QUIC
+        /* Only needed if nothing is ready yet and we may have to wait */
+        if (blocking && result_count == 0
+                && item->desc.value.ssl != NULL
+                && !ossl_rio_poll_waiter_add(&waiter, i,
+                                             item->desc.value.ssl))
+            FAIL_ITEM(i);
 #endif
+    }
 
-            default:
-                ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
-                               "SSL_poll currently only supports QUIC SSL "
-                               "objects");
-                FAIL_ITEM(i);
+#ifndef OPENSSL_NO_QUIC
+    /*
+     * Wait for something to happen to one of the connections and then poll
+     * only the items of the connections concerned.
+     */
+    while (blocking && result_count == 0
+           && ossl_time_compare(ossl_time_now(), deadline) < 0) {
+        if (!ossl_rio_poll_waiter_wait(&waiter, deadline))
+            FAIL_FROM(0);
+
+        while (ossl_rio_poll_waiter_next_item(&waiter, &i)) {
+            item = &ITEM_N(items, stride, i);
+
+            if (!poll_item(item, do_tick, &revents)) {
+                /* All other items are already initialised */
+                item->revents = SSL_POLL_EVENT_F;
+                ++result_count;
+                ok = 0;
+                goto out;
             }
-            break;
-        case BIO_POLL_DESCRIPTOR_TYPE_SOCK_FD:
-            ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
-                           "SSL_poll currently does not support polling "
-                           "sockets");
-            FAIL_ITEM(i);
-        default:
-            ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
-                           "SSL_poll does not support unknown poll descriptor "
-                           "type %d", item->desc.type);
-            FAIL_ITEM(i);
-        }
 
-        item->revents = revents;
+            if (revents != 0)
+                ++result_count;
+
+            item->revents = revents;
+        }
     }
+#endif
 
-    /* TODO(QUIC POLLING): Blocking mode */
     /* TODO(QUIC POLLING): Support for polling FDs */
 
 out:
+#ifndef OPENSSL_NO_QUIC
+    if (blocking)
+        ossl_rio_poll_waiter_cleanup(&waiter);
+#endif
     if (p_result_count != NULL)
         *p_result_count = result_count;
 
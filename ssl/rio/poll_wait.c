@@ -0,0 +1,359 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <limits.h>
+#include <string.h>
+#include "internal/common.h"
+#include "internal/sockets.h"
+#include "internal/quic_ssl.h"
+#include <openssl/err.h>
+#include "poll_wait.h"
+
+#ifndef OPENSSL_NO_QUIC
+
+# if !defined(OPENSSL_SYS_WINDOWS) && defined(POLLIN)
+#  define RIO_USE_POLL
+# endif
+
+# define NO_ITEM            SIZE_MAX
+
+/* Readiness we can ask for on a socket */
+# define WANT_R             (1U << 0)
+# define WANT_W             (1U << 1)
+
+typedef struct {
+    int             fd;
+    unsigned int    want;
+} RIO_POLL_REG;
+
+struct rio_poll_group_st {
+    const void      *key;
+    SSL             *ssl;           /* Any SSL object driven by the reactor */
+    size_t          first_item;
+    OSSL_TIME       deadline;
+    size_t          pq_elem;
+    /* Sockets currently wanted; at most two as reads and writes may differ */
+    RIO_POLL_REG    reg[2];
+    size_t          num_reg;
+    /* Descriptor readable when any of reg is ready, or -1 to poll reg */
+    int             wait_fd;
+    unsigned int    in_pq   : 1;
+    unsigned int    ready   : 1;
+};
+
+static int group_deadline_cmp(const RIO_POLL_GROUP *a, const RIO_POLL_GROUP *b)
+{
+    return ossl_time_compare(a->deadline, b->deadline);
+}
+
+static size_t key_hash(const RIO_POLL_WAITER *w, const void *key)
+{
+    uint64_t h = (uint64_t)(uintptr_t)key * 0x9e3779b97f4a7c15ULL;
+
+    return (size_t)(h >> 32) & w->table_mask;
+}
+
+int ossl_rio_poll_waiter_init(RIO_POLL_WAITER *w, size_t num_items)
+{
+    size_t n = num_items > 0 ? num_items : 1, table_len = 2;
+
+    memset(w, 0, sizeof(*w));
+
+    while (table_len < 2 * n)
+        table_len <<= 1;
+    w->table_mask = table_len - 1;
+
+    if ((w->groups = OPENSSL_zalloc(n * sizeof(*w->groups))) == NULL
+            || (w->next_item = OPENSSL_malloc(n * sizeof(size_t))) == NULL
+            || (w->ready = OPENSSL_malloc(n * sizeof(size_t))) == NULL
+            || (w->table = OPENSSL_zalloc(table_len * sizeof(size_t))) == NULL)
+        goto err;
+
+    if ((w->deadlines = ossl_pqueue_RIO_POLL_GROUP_new(group_deadline_cmp))
+            == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+        goto err;
+    }
+
+    w->iter_item = NO_ITEM;
+    return 1;
+
+ err:
+    ossl_rio_poll_waiter_cleanup(w);
+    return 0;
+}
+
+void ossl_rio_poll_waiter_cleanup(RIO_POLL_WAITER *w)
+{
+    ossl_pqueue_RIO_POLL_GROUP_free(w->deadlines);
+    OPENSSL_free(w->groups);
+    OPENSSL_free(w->next_item);
+    OPENSSL_free(w->ready);
+    OPENSSL_free(w->table);
+    memset(w, 0, sizeof(*w));
+}
+
+int ossl_rio_poll_waiter_add(RIO_POLL_WAITER *w, size_t item, SSL *ssl)
+{
+    RIO_POLL_GROUP *g;
+    BIO_POLL_DESCRIPTOR r, wr;
+    OSSL_TIME deadline;
+    const void *key;
+    size_t i, gi;
+    int wait_fd;
+
+    if (!ossl_quic_conn_get_poll_wait(ssl, &key, &r, &wr, &wait_fd, &deadline))
+        return 0;
+
+    for (i = key_hash(w, key);; i = (i + 1) & w->table_mask) {
+        if (w->table[i] == 0) {
+            /* A reactor we have not seen yet */
+            gi = w->num_groups++;
+            w->table[i] = gi + 1;
+            g = &w->groups[gi];
+            g->key          = key;
+            g->ssl          = ssl;
+            g->first_item   = NO_ITEM;
+            g->wait_fd      = -1;
+            g->ready        = 1;
+            w->ready[w->num_ready++] = gi;
+            break;
+        }
+        if (w->groups[w->table[i] - 1].key == key) {
+            g = &w->groups[w->table[i] - 1];
+            break;
+        }
+    }
+
+    w->next_item[item] = g->first_item;
+    g->first_item = item;
+    ++w->num_items;
+    return 1;
+}
+
+static int descriptor_to_fd(const BIO_POLL_DESCRIPTOR *d, int *fd)
+{
+    if (d->type == BIO_POLL_DESCRIPTOR_TYPE_NONE) {
+        *fd = -1;
+        return 1;
+    }
+
+    if (d->type != BIO_POLL_DESCRIPTOR_TYPE_SOCK_FD
+            || d->value.fd == INVALID_SOCKET) {
+        ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                       "blocking SSL_poll requires connections whose network "
+                       "BIOs provide socket poll descriptors");
+        return 0;
+    }
+
+    *fd = d->value.fd;
+    return 1;
+}
+
+/* Refreshes what the group waits for after its items have been polled */
+static int update_group(RIO_POLL_WAITER *w, size_t gi)
+{
+    RIO_POLL_GROUP *g = &w->groups[gi];
+    BIO_POLL_DESCRIPTOR r, wr;
+    RIO_POLL_REG reg[2];
+    size_t num_reg = 0;
+    OSSL_TIME deadline;
+    const void *key;
+    int rfd, wfd, wait_fd;
+
+    if (!ossl_quic_conn_get_poll_wait(g->ssl, &key, &r, &wr, &wait_fd,
+                                      &deadline)
+            || !descriptor_to_fd(&r, &rfd)
+            || !descriptor_to_fd(&wr, &wfd))
+        return 0;
+
+    if (rfd >= 0 && rfd == wfd) {
+        reg[num_reg].fd     = rfd;
+        reg[num_reg++].want = WANT_R | WANT_W;
+    } else {
+        if (rfd >= 0) {
+            reg[num_reg].fd     = rfd;
+            reg[num_reg++].want = WANT_R;
+        }
+        if (wfd >= 0) {
+            reg[num_reg].fd     = wfd;
+            reg[num_reg++].want = WANT_W;
+        }
+    }
+
+    memcpy(g->reg, reg, num_reg * sizeof(*reg));
+    g->num_reg = num_reg;
+    g->wait_fd = wait_fd;
+
+    if (g->in_pq) {
+        ossl_pqueue_RIO_POLL_GROUP_remove(w->deadlines, g->pq_elem);
+        g->in_pq = 0;
+    }
+    g->deadline = deadline;
+    if (!ossl_time_is_infinite(g->deadline)) {
+        if (!ossl_pqueue_RIO_POLL_GROUP_push(w->deadlines, g, &g->pq_elem)) {
+            ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+            return 0;
+        }
+        g->in_pq = 1;
+    }
+    return 1;
+}
+
+static void mark_ready(RIO_POLL_WAITER *w, size_t gi)
+{
+    if (w->groups[gi].ready)
+        return;
+    w->groups[gi].ready = 1;
+    w->ready[w->num_ready++] = gi;
+}
+
+/* Converts a timeout to milliseconds, rounding up so as not to wake early */
+static int timeout_ms(OSSL_TIME deadline)
+{
+    uint64_t ticks;
+
+    if (ossl_time_is_infinite(deadline))
+        return -1;
+
+    ticks = ossl_time2ticks(ossl_time_subtract(deadline, ossl_time_now()));
+    ticks = (ticks + OSSL_TIME_MS - 1) / OSSL_TIME_MS;
+    return ticks > INT_MAX ? INT_MAX : (int)ticks;
+}
+
+# ifdef RIO_USE_POLL
+static int wait_poll(RIO_POLL_WAITER *w, OSSL_TIME deadline)
+{
+    struct pollfd *pfds;
+    size_t *pfd_group, i, j, n = 0;
+    int res, ok = 0;
+
+    pfds = OPENSSL_malloc(2 * w->num_groups * sizeof(*pfds) + 1);
+    pfd_group = OPENSSL_malloc(2 * w->num_groups * sizeof(size_t) + 1);
+    if (pfds == NULL || pfd_group == NULL)
+        goto end;
+
+    for (i = 0; i < w->num_groups; i++) {
+        if (w->groups[i].num_reg == 0)
+            continue;
+
+        if (w->groups[i].wait_fd >= 0) {
+            pfds[n].fd      = w->groups[i].wait_fd;
+            pfds[n].events  = POLLIN;
+            pfds[n].revents = 0;
+            pfd_group[n++]  = i;
+            continue;
+        }
+
+        for (j = 0; j < w->groups[i].num_reg; j++) {
+            pfds[n].fd      = w->groups[i].reg[j].fd;
+            pfds[n].events  = ((w->groups[i].reg[j].want & WANT_R) != 0
+                               ? POLLIN : 0)
+                            | ((w->groups[i].reg[j].want & WANT_W) != 0
+                               ? POLLOUT : 0);
+            pfds[n].revents = 0;
+            pfd_group[n++]  = i;
+        }
+    }
+
+    res = poll(pfds, n, timeout_ms(deadline));
+    if (res < 0) {
+        if (get_last_socket_error_is_eintr()) {
+            ok = 1;
+            goto end;
+        }
+        ERR_raise_data(ERR_LIB_SYS, get_last_sys_error(), "calling poll()");
+        goto end;
+    }
+
+    for (i = 0; i < n && res > 0; i++)
+        if (pfds[i].revents != 0) {
+            mark_ready(w, pfd_group[i]);
+            --res;
+        }
+    ok = 1;
+ end:
+    OPENSSL_free(pfds);
+    OPENSSL_free(pfd_group);
+    return ok;
+}
+# endif
+
+int ossl_rio_poll_waiter_wait(RIO_POLL_WAITER *w, OSSL_TIME deadline)
+{
+    RIO_POLL_GROUP *g;
+    OSSL_TIME now;
+    size_t i, num_fds = 0;
+    int ok;
+
+    /* The groups woken last time have been polled since */
+    for (i = 0; i < w->num_ready; i++) {
+        w->groups[w->ready[i]].ready = 0;
+        if (!update_group(w, w->ready[i]))
+            return 0;
+    }
+    w->num_ready  = 0;
+    w->iter_group = 0;
+    w->iter_item  = NO_ITEM;
+
+    if ((g = ossl_pqueue_RIO_POLL_GROUP_peek(w->deadlines)) != NULL)
+        deadline = ossl_time_min(deadline, g->deadline);
+
+    for (i = 0; i < w->num_groups; i++)
+        num_fds += w->groups[i].num_reg;
+    if (num_fds == 0 && ossl_time_is_infinite(deadline)) {
+        ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                       "SSL_poll would block forever as there is nothing to "
+                       "wait for");
+        return 0;
+    }
+
+# if defined(RIO_USE_POLL)
+    ok = wait_poll(w, deadline);
+# else
+    {
+        ERR_raise_data(ERR_LIB_SSL, SSL_R_POLL_REQUEST_NOT_SUPPORTED,
+                       "blocking SSL_poll is not supported on this platform");
+        ok = 0;
+    }
+# endif
+    if (!ok)
+        return 0;
+
+    /* Every group whose tick deadline has come is due to be ticked */
+    now = ossl_time_now();
+    while ((g = ossl_pqueue_RIO_POLL_GROUP_peek(w->deadlines)) != NULL
+           && ossl_time_compare(g->deadline, now) <= 0) {
+        ossl_pqueue_RIO_POLL_GROUP_pop(w->deadlines);
+        g->in_pq = 0;
+        mark_ready(w, (size_t)(g - w->groups));
+    }
+    return 1;
+}
+
+int ossl_rio_poll_waiter_next_item(RIO_POLL_WAITER *w, size_t *item)
+{
+    for (;;) {
+        if (w->iter_group >= w->num_ready)
+            return 0;
+
+        if (w->iter_item == NO_ITEM)
+            w->iter_item = w->groups[w->ready[w->iter_group]].first_item;
+        else
+            w->iter_item = w->next_item[w->iter_item];
+
+        if (w->iter_item != NO_ITEM) {
+            *item = w->iter_item;
+            return 1;
+        }
+        ++w->iter_group;
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_RIO_POLL_WAIT_H
+# define OSSL_RIO_POLL_WAIT_H
+
+# include <openssl/ssl.h>
+# include "internal/time.h"
+# include "internal/priority_queue.h"
+
+# ifndef OPENSSL_NO_QUIC
+
+/*
+ * Poll Waiter
+ * ===========
+ *
+ * Used by a blocking SSL_poll() to wait until the state of any of the QUIC
+ * connections its items belong to may have changed. Items are grouped by the
+ * reactor driving their connection, so that connections sharing a port form a
+ * single group; a group is woken when one of the network sockets its reactor
+ * wants to use becomes ready or when the reactor's tick deadline passes.
+ *
+ * Where the reactor keeps a persistent epoll(7) set of its sockets (see
+ * ossl_quic_reactor_get_wait_fd()) only that descriptor is polled for the
+ * group, otherwise its sockets are polled directly. Tick deadlines are kept in
+ * a priority queue, so that once the items have been added, each wait costs
+ * time in proportion to the number of groups rather than of items.
+ */
+typedef struct rio_poll_group_st RIO_POLL_GROUP;
+
+DEFINE_PRIORITY_QUEUE_OF(RIO_POLL_GROUP);
+
+typedef struct rio_poll_waiter_st {
+    RIO_POLL_GROUP                      *groups;
+    size_t                              num_groups, num_items;
+
+    /* Items of the same group are linked through next_item */
+    size_t                              *next_item;
+
+    /* Open addressing table from reactor key to group index + 1 */
+    size_t                              *table;
+    size_t                              table_mask;
+
+    /* Groups woken by the last wait, or not yet waited on */
+    size_t                              *ready;
+    size_t                              num_ready;
+
+    /* Position of ossl_rio_poll_waiter_next_item() in ready */
+    size_t                              iter_group, iter_item;
+
+    PRIORITY_QUEUE_OF(RIO_POLL_GROUP)   *deadlines;
+} RIO_POLL_WAITER;
+
+int ossl_rio_poll_waiter_init(RIO_POLL_WAITER *w, size_t num_items);
+void ossl_rio_poll_waiter_cleanup(RIO_POLL_WAITER *w);
+
+/* Adds item number |item|, which refers to the QUIC SSL object |ssl|. */
+int ossl_rio_poll_waiter_add(RIO_POLL_WAITER *w, size_t item, SSL *ssl);
+
+/*
+ * Blocks until at least one group is woken or |deadline| passes, which is
+ * not an error. The items of the woken groups can then be enumerated with
+ * ossl_rio_poll_waiter_next_item(). Returns 0 on error.
+ */
+int ossl_rio_poll_waiter_wait(RIO_POLL_WAITER *w, OSSL_TIME deadline);
+
+/*
+ * Gets the next item whose group was woken by the last wait. Returns 0 when
+ * there are no more.
+ */
+int ossl_rio_poll_waiter_next_item(RIO_POLL_WAITER *w, size_t *item);
+
+# endif
+
+#endif
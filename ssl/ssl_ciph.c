@@ -963,7 +963,8 @@ static int ssl_cipher_strength_sort(CIPHER_ORDER **head_p,
 static int ssl_cipher_process_rulestr(const char *rule_str,
                                       CIPHER_ORDER **head_p,
                                       CIPHER_ORDER **tail_p,
-                                      const SSL_CIPHER **ca_list, CERT *c)
+                                      const SSL_CIPHER **ca_list,
+                                      int *sec_level)
 {
     uint32_t alg_mkey, alg_auth, alg_enc, alg_mac, algo_strength;
     int min_tls;
@@ -1194,7 +1195,7 @@ static int ssl_cipher_process_rulestr(const char *rule_str,
                 if (level < 0 || level > 5) {
                     ERR_raise(ERR_LIB_SSL, SSL_R_INVALID_COMMAND);
                 } else {
-                    c->sec_level = level;
+                    *sec_level = level;
                     ok = 1;
                 }
             } else {
@@ -1419,6 +1420,181 @@ int SSL_set_ciphersuites(SSL *s, const char *str)
     return ret;
 }
 
+/*
+ * A process wide cache of compiled cipher lists.
+ *
+ * Building a cipher list from a rule string is fairly expensive, and
+ * applications that create many SSL_CTXs typically use the same few rule
+ * strings for all of them. The result only depends on the method, on which
+ * algorithms are disabled (i.e. on what the providers of the SSL_CTX offer),
+ * on the TLSv1.3 ciphersuites and on the rule string itself, so those form
+ * the key. The only side effect of the rule string on the CERT, a security
+ * level set with "@SECLEVEL=", is stored along with the lists.
+ */
+#define SSL_CIPHER_CACHE_MAX_ENTRIES    256
+
+typedef struct ssl_cipher_cache_entry_st {
+    const SSL_METHOD *method;
+    uint32_t disabled_mkey;
+    uint32_t disabled_auth;
+    uint32_t disabled_enc;
+    uint32_t disabled_mac;
+    const char *rule_str;
+    STACK_OF(SSL_CIPHER) *tls13_ciphersuites;
+    STACK_OF(SSL_CIPHER) *cipher_list;
+    STACK_OF(SSL_CIPHER) *cipher_list_by_id;
+    /* The security level set by the rule string, or -1 */
+    int sec_level;
+} SSL_CIPHER_CACHE_ENTRY;
+
+DEFINE_LHASH_OF_EX(SSL_CIPHER_CACHE_ENTRY);
+
+static CRYPTO_RWLOCK *cipher_cache_lock = NULL;
+static LHASH_OF(SSL_CIPHER_CACHE_ENTRY) *cipher_cache = NULL;
+
+static unsigned long cipher_cache_hash(const SSL_CIPHER_CACHE_ENTRY *e)
+{
+    unsigned long h = OPENSSL_LH_strhash(e->rule_str);
+    int i;
+
+    h ^= (unsigned long)(uintptr_t)e->method;
+    h ^= e->disabled_mkey ^ ((unsigned long)e->disabled_auth << 7)
+         ^ ((unsigned long)e->disabled_enc << 13)
+         ^ ((unsigned long)e->disabled_mac << 19);
+    for (i = 0; i < sk_SSL_CIPHER_num(e->tls13_ciphersuites); i++)
+        h = h * 31 + sk_SSL_CIPHER_value(e->tls13_ciphersuites, i)->id;
+
+    return h;
+}
+
+static int cipher_cache_cmp(const SSL_CIPHER_CACHE_ENTRY *a,
+                            const SSL_CIPHER_CACHE_ENTRY *b)
+{
+    int i, num = sk_SSL_CIPHER_num(a->tls13_ciphersuites);
+
+    if (a->method != b->method
+            || a->disabled_mkey != b->disabled_mkey
+            || a->disabled_auth != b->disabled_auth
+            || a->disabled_enc != b->disabled_enc
+            || a->disabled_mac != b->disabled_mac
+            || num != sk_SSL_CIPHER_num(b->tls13_ciphersuites))
+        return 1;
+
+    for (i = 0; i < num; i++)
+        if (sk_SSL_CIPHER_value(a->tls13_ciphersuites, i)
+                != sk_SSL_CIPHER_value(b->tls13_ciphersuites, i))
+            return 1;
+
+    return strcmp(a->rule_str, b->rule_str);
+}
+
+static void cipher_cache_entry_free(SSL_CIPHER_CACHE_ENTRY *e)
+{
+    if (e == NULL)
+        return;
+
+    OPENSSL_free((char *)e->rule_str);
+    sk_SSL_CIPHER_free(e->tls13_ciphersuites);
+    sk_SSL_CIPHER_free(e->cipher_list);
+    sk_SSL_CIPHER_free(e->cipher_list_by_id);
+    OPENSSL_free(e);
+}
+
+static void cipher_cache_cleanup(void)
+{
+    lh_SSL_CIPHER_CACHE_ENTRY_doall(cipher_cache, cipher_cache_entry_free);
+    lh_SSL_CIPHER_CACHE_ENTRY_free(cipher_cache);
+    cipher_cache = NULL;
+    CRYPTO_THREAD_lock_free(cipher_cache_lock);
+    cipher_cache_lock = NULL;
+}
+
+/*
+ * Called once when libssl is initialised. If this fails cipher lists are
+ * simply not cached.
+ */
+void ssl_cipher_cache_init(void)
+{
+    cipher_cache_lock = CRYPTO_THREAD_lock_new();
+    cipher_cache = lh_SSL_CIPHER_CACHE_ENTRY_new(cipher_cache_hash,
+                                                 cipher_cache_cmp);
+    if (cipher_cache_lock == NULL || cipher_cache == NULL
+            || !OPENSSL_atexit(cipher_cache_cleanup))
+        cipher_cache_cleanup();
+}
+
+/*
+ * Looks up the cipher lists for |key| and returns copies of them in
+ * |*cipher_list| and |*cipher_list_by_id|. Returns 0 if they are not cached.
+ */
+static int cipher_cache_get(const SSL_CIPHER_CACHE_ENTRY *key,
+                            STACK_OF(SSL_CIPHER) **cipher_list,
+                            STACK_OF(SSL_CIPHER) **cipher_list_by_id,
+                            int *sec_level)
+{
+    SSL_CIPHER_CACHE_ENTRY *e;
+    int ret = 0;
+
+    *cipher_list = *cipher_list_by_id = NULL;
+    if (cipher_cache == NULL || !CRYPTO_THREAD_read_lock(cipher_cache_lock))
+        return 0;
+
+    e = lh_SSL_CIPHER_CACHE_ENTRY_retrieve(cipher_cache, key);
+    if (e != NULL) {
+        *cipher_list = sk_SSL_CIPHER_dup(e->cipher_list);
+        *cipher_list_by_id = sk_SSL_CIPHER_dup(e->cipher_list_by_id);
+        *sec_level = e->sec_level;
+        ret = *cipher_list != NULL && *cipher_list_by_id != NULL;
+    }
+    CRYPTO_THREAD_unlock(cipher_cache_lock);
+
+    if (!ret) {
+        sk_SSL_CIPHER_free(*cipher_list);
+        sk_SSL_CIPHER_free(*cipher_list_by_id);
+        *cipher_list = *cipher_list_by_id = NULL;
+    }
+    return ret;
+}
+
+/* Adds copies of the given cipher lists for |key| to the cache */
+static void cipher_cache_put(const SSL_CIPHER_CACHE_ENTRY *key,
+                             const STACK_OF(SSL_CIPHER) *cipher_list,
+                             const STACK_OF(SSL_CIPHER) *cipher_list_by_id,
+                             int sec_level)
+{
+    SSL_CIPHER_CACHE_ENTRY *e;
+
+    if (cipher_cache == NULL)
+        return;
+
+    if ((e = OPENSSL_zalloc(sizeof(*e))) == NULL)
+        return;
+    *e = *key;
+    e->rule_str = OPENSSL_strdup(key->rule_str);
+    e->tls13_ciphersuites = sk_SSL_CIPHER_dup(key->tls13_ciphersuites);
+    e->cipher_list = sk_SSL_CIPHER_dup(cipher_list);
+    e->cipher_list_by_id = sk_SSL_CIPHER_dup(cipher_list_by_id);
+    e->sec_level = sec_level;
+    if (e->rule_str == NULL || e->tls13_ciphersuites == NULL
+            || e->cipher_list == NULL || e->cipher_list_by_id == NULL
+            || !CRYPTO_THREAD_write_lock(cipher_cache_lock)) {
+        cipher_cache_entry_free(e);
+        return;
+    }
+
+    if (lh_SSL_CIPHER_CACHE_ENTRY_num_items(cipher_cache)
+            < SSL_CIPHER_CACHE_MAX_ENTRIES) {
+        /* Another thread may have added the same lists in the meantime */
+        cipher_cache_entry_free(lh_SSL_CIPHER_CACHE_ENTRY_insert(cipher_cache,
+                                                                 e));
+        if (!lh_SSL_CIPHER_CACHE_ENTRY_error(cipher_cache))
+            e = NULL;
+    }
+    CRYPTO_THREAD_unlock(cipher_cache_lock);
+
+    cipher_cache_entry_free(e);
+}
+
 STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
                                              STACK_OF(SSL_CIPHER) *tls13_ciphersuites,
                                              STACK_OF(SSL_CIPHER) **cipher_list,
@@ -1433,6 +1609,9 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
     CIPHER_ORDER *co_list = NULL, *head = NULL, *tail = NULL, *curr;
     const SSL_CIPHER **ca_list = NULL;
     const SSL_METHOD *ssl_method = ctx->method;
+    SSL_CIPHER_CACHE_ENTRY key;
+    STACK_OF(SSL_CIPHER) *cipherstack_by_id = NULL;
+    int sec_level = -1, use_cache;
 
     /*
      * Return with error if nothing to do.
@@ -1453,6 +1632,44 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
     disabled_enc = ctx->disabled_enc_mask;
     disabled_mac = ctx->disabled_mac_mask;
 
+    /* Don't include any TLSv1.3 ciphers that are disabled */
+    for (i = 0; i < sk_SSL_CIPHER_num(tls13_ciphersuites); i++) {
+        const SSL_CIPHER *sslc = sk_SSL_CIPHER_value(tls13_ciphersuites, i);
+
+        if ((sslc->algorithm_enc & disabled_enc) != 0
+                || (ssl_cipher_table_mac[sslc->algorithm2
+                                         & SSL_HANDSHAKE_MAC_MASK].mask
+                    & ctx->disabled_mac_mask) != 0) {
+            sk_SSL_CIPHER_delete(tls13_ciphersuites, i);
+            i--;
+        }
+    }
+
+    /*
+     * If the selection is being traced, always build the list so that it
+     * shows up in the trace.
+     */
+    use_cache = !OSSL_TRACE_ENABLED(TLS_CIPHER);
+    key.method = ssl_method;
+    key.disabled_mkey = disabled_mkey;
+    key.disabled_auth = disabled_auth;
+    key.disabled_enc = disabled_enc;
+    key.disabled_mac = disabled_mac;
+    key.rule_str = rule_str;
+    key.tls13_ciphersuites = tls13_ciphersuites;
+
+    if (use_cache
+            && cipher_cache_get(&key, &cipherstack, &cipherstack_by_id,
+                                &sec_level)) {
+        if (sec_level >= 0)
+            c->sec_level = sec_level;
+        sk_SSL_CIPHER_free(*cipher_list_by_id);
+        *cipher_list_by_id = cipherstack_by_id;
+        sk_SSL_CIPHER_free(*cipher_list);
+        *cipher_list = cipherstack;
+        return cipherstack;
+    }
+
     /*
      * Now we have to collect the available ciphers from the compiled
      * in ciphers. We cannot get more than the number compiled in, so
@@ -1589,16 +1806,19 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
     rule_p = rule_str;
     if (HAS_PREFIX(rule_str, "DEFAULT")) {
         ok = ssl_cipher_process_rulestr(OSSL_default_cipher_list(),
-                                        &head, &tail, ca_list, c);
+                                        &head, &tail, ca_list, &sec_level);
         rule_p += 7;
         if (*rule_p == ':')
             rule_p++;
     }
 
     if (ok && (rule_p[0] != '\0'))
-        ok = ssl_cipher_process_rulestr(rule_p, &head, &tail, ca_list, c);
+        ok = ssl_cipher_process_rulestr(rule_p, &head, &tail, ca_list,
+                                        &sec_level);
 
     OPENSSL_free(ca_list);      /* Not needed anymore */
+    if (sec_level >= 0)
+        c->sec_level = sec_level;
 
     if (!ok) {                  /* Rule processing failure */
         OPENSSL_free(co_list);
@@ -1618,16 +1838,6 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
     for (i = 0; i < sk_SSL_CIPHER_num(tls13_ciphersuites); i++) {
         const SSL_CIPHER *sslc = sk_SSL_CIPHER_value(tls13_ciphersuites, i);
 
-        /* Don't include any TLSv1.3 ciphers that are disabled */
-        if ((sslc->algorithm_enc & disabled_enc) != 0
-                || (ssl_cipher_table_mac[sslc->algorithm2
-                                         & SSL_HANDSHAKE_MAC_MASK].mask
-                    & ctx->disabled_mac_mask) != 0) {
-            sk_SSL_CIPHER_delete(tls13_ciphersuites, i);
-            i--;
-            continue;
-        }
-
         if (!sk_SSL_CIPHER_push(cipherstack, sslc)) {
             OPENSSL_free(co_list);
             sk_SSL_CIPHER_free(cipherstack);
@@ -1664,6 +1874,9 @@ STACK_OF(SSL_CIPHER) *ssl_create_cipher_list(SSL_CTX *ctx,
     sk_SSL_CIPHER_free(*cipher_list);
     *cipher_list = cipherstack;
 
+    if (use_cache)
+        cipher_cache_put(&key, cipherstack, *cipher_list_by_id, sec_level);
+
     return cipherstack;
 }
 
@@ -135,6 +135,8 @@ static const ERR_STRING_DATA SSL_str_reasons[] = {
     "dane tlsa bad selector"},
     {ERR_PACK(ERR_LIB_SSL, 0, SSL_R_DANE_TLSA_NULL_DATA),
     "dane tlsa null data"},
+    {ERR_PACK(ERR_LIB_SSL, 0, SSL_R_DATAGRAMS_NOT_NEGOTIATED),
+    "datagrams not negotiated"},
     {ERR_PACK(ERR_LIB_SSL, 0, SSL_R_DATA_BETWEEN_CCS_AND_FINISHED),
     "data between ccs and finished"},
     {ERR_PACK(ERR_LIB_SSL, 0, SSL_R_DATA_LENGTH_TOO_LONG),
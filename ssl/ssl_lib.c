@@ -80,10 +80,11 @@ struct ssl_async_args {
     SSL *s;
     void *buf;
     size_t num;
-    enum { READFUNC, WRITEFUNC, OTHERFUNC } type;
+    enum { READFUNC, WRITEFUNC, WRITEVFUNC, OTHERFUNC } type;
     union {
         int (*func_read) (SSL *, void *, size_t, size_t *);
         int (*func_write) (SSL *, const void *, size_t, size_t *);
+        int (*func_writev) (SSL *, const SSL_CONST_IOVEC *, size_t, size_t *);
         int (*func_other) (SSL *);
     } f;
 };
@@ -819,6 +820,11 @@ SSL *ossl_ssl_connection_new_int(SSL_CTX *ctx, const SSL_METHOD *method)
     s->ext.ocsp.resp_len = 0;
     SSL_CTX_up_ref(ctx);
     s->session_ctx = ctx;
+    if (ctx->recbuf_pool != NULL) {
+        if (!ssl_recbuf_pool_up_ref(ctx->recbuf_pool))
+            goto sslerr;
+        s->recbuf_pool = ctx->recbuf_pool;
+    }
     if (ctx->ext.ecpointformats) {
         s->ext.ecpointformats =
             OPENSSL_memdup(ctx->ext.ecpointformats,
@@ -1046,6 +1052,7 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
      * by this SSL.
      */
     SSL_SESSION r, *p;
+    SSL_SESS_SHARD *shard;
     const SSL_CONNECTION *sc = SSL_CONNECTION_FROM_CONST_SSL(ssl);
 
     if (sc == NULL || id_len > sizeof(r.session_id))
@@ -1055,10 +1062,11 @@ int SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
     r.session_id_length = id_len;
     memcpy(r.session_id, id, id_len);
 
-    if (!CRYPTO_THREAD_read_lock(sc->session_ctx->lock))
+    shard = ssl_session_shard(sc->session_ctx, id, id_len);
+    if (!CRYPTO_THREAD_read_lock(shard->lock))
         return 0;
-    p = lh_SSL_SESSION_retrieve(sc->session_ctx->sessions, &r);
-    CRYPTO_THREAD_unlock(sc->session_ctx->lock);
+    p = lh_SSL_SESSION_retrieve(shard->sessions, &r);
+    CRYPTO_THREAD_unlock(shard->lock);
     return (p != NULL);
 }
 
@@ -1436,6 +1444,7 @@ void ossl_ssl_connection_free(SSL *ssl)
 
     OPENSSL_free(s->ext.hostname);
     SSL_CTX_free(s->session_ctx);
+    ssl_recbuf_pool_free(s->recbuf_pool);
     OPENSSL_free(s->ext.ecpointformats);
     OPENSSL_free(s->ext.peer_ecpointformats);
     OPENSSL_free(s->ext.supportedgroups);
@@ -1451,6 +1460,8 @@ void ossl_ssl_connection_free(SSL *ssl)
     OPENSSL_free(s->ext.ocsp.resp);
     OPENSSL_free(s->ext.alpn);
     OPENSSL_free(s->ext.tls13_cookie);
+    OPENSSL_free(s->ext.peer_quic_transport_params);
+    OPENSSL_free(s->ext.quic_early_transport_params);
     if (s->clienthello != NULL)
         OPENSSL_free(s->clienthello->pre_proc_exts);
     OPENSSL_free(s->clienthello);
@@ -2242,32 +2253,38 @@ static int ssl_start_async_job(SSL *s, struct ssl_async_args *args,
     }
 }
 
-static int ssl_io_intern(void *vargs)
+/* Runs the operation described by |args|, storing its byte count in |done| */
+static int ssl_io_call(struct ssl_async_args *args, size_t *done)
 {
-    struct ssl_async_args *args;
-    SSL *s;
-    void *buf;
-    size_t num;
-    SSL_CONNECTION *sc;
-
-    args = (struct ssl_async_args *)vargs;
-    s = args->s;
-    buf = args->buf;
-    num = args->num;
-    if ((sc = SSL_CONNECTION_FROM_SSL(s)) == NULL)
-        return -1;
+    SSL *s = args->s;
+    void *buf = args->buf;
+    size_t num = args->num;
 
     switch (args->type) {
     case READFUNC:
-        return args->f.func_read(s, buf, num, &sc->asyncrw);
+        return args->f.func_read(s, buf, num, done);
     case WRITEFUNC:
-        return args->f.func_write(s, buf, num, &sc->asyncrw);
+        return args->f.func_write(s, buf, num, done);
+    case WRITEVFUNC:
+        return args->f.func_writev(s, buf, num, done);
     case OTHERFUNC:
         return args->f.func_other(s);
     }
     return -1;
 }
 
+static int ssl_io_intern(void *vargs)
+{
+    struct ssl_async_args *args;
+    SSL_CONNECTION *sc;
+
+    args = (struct ssl_async_args *)vargs;
+    if ((sc = SSL_CONNECTION_FROM_SSL(args->s)) == NULL)
+        return -1;
+
+    return ssl_io_call(args, &sc->asyncrw);
+}
+
 int ssl_read_internal(SSL *s, void *buf, size_t num, size_t *readbytes)
 {
     SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(s);
@@ -2350,6 +2367,49 @@ int SSL_read_ex(SSL *s, void *buf, size_t num, size_t *readbytes)
     return ret;
 }
 
+int SSL_readv(SSL *s, const SSL_IOVEC *iov, size_t num_iov, size_t *readbytes)
+{
+    size_t i = 0, off, n, total;
+    unsigned char dummy;
+
+    if ((iov == NULL && num_iov > 0) || readbytes == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    while (i < num_iov && iov[i].buf_len == 0)
+        i++;
+
+    /* With no space to read into, behave as a zero length SSL_read_ex() */
+    if (i == num_iov)
+        return SSL_read_ex(s, &dummy, 0, readbytes);
+
+    /* The first read is the only one that may wait for data or fail */
+    if (!SSL_read_ex(s, iov[i].buf, iov[i].buf_len, &n))
+        return 0;
+    off = total = n;
+
+    /* Fill the remaining buffers only with data that is already available */
+    ERR_set_mark();
+    for (;;) {
+        while (i < num_iov && off == iov[i].buf_len) {
+            i++;
+            off = 0;
+        }
+        if (i == num_iov || SSL_pending(s) == 0)
+            break;
+        if (!SSL_read_ex(s, (unsigned char *)iov[i].buf + off,
+                         iov[i].buf_len - off, &n))
+            break;
+        off += n;
+        total += n;
+    }
+    ERR_pop_to_mark();
+
+    *readbytes = total;
+    return 1;
+}
+
 int SSL_read_early_data(SSL *s, void *buf, size_t num, size_t *readbytes)
 {
     int ret;
@@ -2408,9 +2468,9 @@ int SSL_read_early_data(SSL *s, void *buf, size_t num, size_t *readbytes)
 
 int SSL_get_early_data_status(const SSL *s)
 {
-    const SSL_CONNECTION *sc = SSL_CONNECTION_FROM_CONST_SSL_ONLY(s);
+    /* For QUIC, this reports whether 0-RTT data was accepted. */
+    const SSL_CONNECTION *sc = SSL_CONNECTION_FROM_CONST_SSL(s);
 
-    /* TODO(QUIC 0RTT): 0-RTT support */
     if (sc == NULL)
         return 0;
 
@@ -2487,19 +2547,49 @@ int SSL_peek_ex(SSL *s, void *buf, size_t num, size_t *readbytes)
     return ret;
 }
 
-int ssl_write_internal(SSL *s, const void *buf, size_t num,
-                       uint64_t flags, size_t *written)
+int SSL_read_peek_zc(SSL *s, SSL_CONST_IOVEC *iov, size_t *num_iov,
+                     size_t *readbytes)
 {
-    SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(s);
+    if (iov == NULL || num_iov == NULL || readbytes == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    *readbytes = 0;
+
+    if (*num_iov == 0) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
 
 #ifndef OPENSSL_NO_QUIC
     if (IS_QUIC(s))
-        return ossl_quic_write_flags(s, buf, num, flags, written);
+        return ossl_quic_read_peek_zc(s, iov, num_iov, readbytes);
 #endif
 
-    if (sc == NULL)
-        return 0;
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
 
+int SSL_read_release(SSL *s, size_t num)
+{
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_read_release(s, num);
+#endif
+
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
+
+/*
+ * The part of SSL_write() and SSL_writev() shared by TLS and DTLS: checks that
+ * |sc| can send application data, finishes the handshake first if need be and
+ * runs the write described by |args|, in an async job in async mode.
+ */
+static int ssl_write_common(SSL_CONNECTION *sc, struct ssl_async_args *args,
+                            size_t *written)
+{
     if (sc->handshake_func == NULL) {
         ERR_raise(ERR_LIB_SSL, SSL_R_UNINITIALIZED);
         return -1;
@@ -2511,11 +2601,6 @@ int ssl_write_internal(SSL *s, const void *buf, size_t num,
         return -1;
     }
 
-    if (flags != 0) {
-        ERR_raise(ERR_LIB_SSL, SSL_R_UNSUPPORTED_WRITE_FLAG);
-        return -1;
-    }
-
     if (sc->early_data_state == SSL_EARLY_DATA_CONNECT_RETRY
                 || sc->early_data_state == SSL_EARLY_DATA_ACCEPT_RETRY
                 || sc->early_data_state == SSL_EARLY_DATA_READ_RETRY) {
@@ -2527,22 +2612,97 @@ int ssl_write_internal(SSL *s, const void *buf, size_t num,
 
     if ((sc->mode & SSL_MODE_ASYNC) && ASYNC_get_current_job() == NULL) {
         int ret;
-        struct ssl_async_args args;
-
-        args.s = s;
-        args.buf = (void *)buf;
-        args.num = num;
-        args.type = WRITEFUNC;
-        args.f.func_write = s->method->ssl_write;
 
-        ret = ssl_start_async_job(s, &args, ssl_io_intern);
+        ret = ssl_start_async_job(args->s, args, ssl_io_intern);
         *written = sc->asyncrw;
         return ret;
     } else {
-        return s->method->ssl_write(s, buf, num, written);
+        return ssl_io_call(args, written);
     }
 }
 
+int ssl_write_internal(SSL *s, const void *buf, size_t num,
+                       uint64_t flags, size_t *written)
+{
+    SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(s);
+    struct ssl_async_args args;
+
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_write_flags(s, buf, num, flags, written);
+#endif
+
+    if (sc == NULL)
+        return 0;
+
+    if (flags != 0) {
+        ERR_raise(ERR_LIB_SSL, SSL_R_UNSUPPORTED_WRITE_FLAG);
+        return -1;
+    }
+
+    args.s = s;
+    args.buf = (void *)buf;
+    args.num = num;
+    args.type = WRITEFUNC;
+    args.f.func_write = s->method->ssl_write;
+
+    return ssl_write_common(sc, &args, written);
+}
+
+static int ssl_writev_internal(SSL *s, const SSL_CONST_IOVEC *iov,
+                               size_t num_iov, size_t *written)
+{
+    SSL_CONNECTION *sc = SSL_CONNECTION_FROM_SSL(s);
+    struct ssl_async_args args;
+
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_writev(s, iov, num_iov, written);
+#endif
+
+    if (sc == NULL)
+        return 0;
+
+    /* Each DTLS record is a datagram, so there is nothing to pack */
+    if (SSL_CONNECTION_IS_DTLS(sc)) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+        return -1;
+    }
+
+    args.s = s;
+    args.buf = (void *)iov;
+    args.num = num_iov;
+    args.type = WRITEVFUNC;
+    args.f.func_writev = ssl3_writev;
+
+    return ssl_write_common(sc, &args, written);
+}
+
+int SSL_writev(SSL *s, const SSL_CONST_IOVEC *iov, size_t num_iov,
+               size_t *written)
+{
+    size_t i, len = 0;
+    int ret;
+
+    if ((iov == NULL && num_iov > 0) || written == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+
+    for (i = 0; i < num_iov; i++) {
+        if (iov[i].buf_len > SIZE_MAX - len) {
+            ERR_raise(ERR_LIB_SSL, SSL_R_BAD_LENGTH);
+            return 0;
+        }
+        len += iov[i].buf_len;
+    }
+
+    ret = ssl_writev_internal(s, iov, num_iov, written);
+    if (ret < 0)
+        ret = 0;
+    return ret;
+}
+
 ossl_ssize_t SSL_sendfile(SSL *s, int fd, off_t offset, size_t size, int flags)
 {
     ossl_ssize_t ret;
@@ -2649,6 +2809,40 @@ int SSL_write_ex2(SSL *s, const void *buf, size_t num, uint64_t flags,
     return ret;
 }
 
+int SSL_write_zc(SSL *s, const void *buf, size_t num, uint64_t flags,
+                 SSL_write_zc_release_cb_fn release_cb, void *arg)
+{
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_write_zc(s, buf, num, flags, release_cb, arg);
+#endif
+
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
+
+int SSL_write_datagram(SSL *s, const void *buf, size_t num)
+{
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_write_datagram(s, buf, num);
+#endif
+
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
+
+int SSL_read_datagram(SSL *s, void *buf, size_t num, size_t *readbytes)
+{
+#ifndef OPENSSL_NO_QUIC
+    if (IS_QUIC(s))
+        return ossl_quic_read_datagram(s, buf, num, readbytes);
+#endif
+
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
+
 int SSL_write_early_data(SSL *s, const void *buf, size_t num, size_t *written)
 {
     int ret, early_data_state;
@@ -3040,10 +3234,43 @@ long SSL_callback_ctrl(SSL *s, int cmd, void (*fp) (void))
     return s->method->ssl_callback_ctrl(s, cmd, fp);
 }
 
+/* Drops the sessions of the snapshot handed out by SSL_CTX_sessions() */
+static void ssl_session_snapshot_clear(SSL_CTX *ctx)
+{
+    lh_SSL_SESSION_doall(ctx->sessions, SSL_SESSION_free);
+    lh_SSL_SESSION_flush(ctx->sessions);
+}
+
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+static void ssl_session_snapshot_add(SSL_SESSION *s, void *arg)
+{
+    LHASH_OF(SSL_SESSION) *snapshot = arg;
+
+    if (!SSL_SESSION_up_ref(s))
+        return;
+    (void)lh_SSL_SESSION_insert(snapshot, s);
+    if (lh_SSL_SESSION_error(snapshot))
+        SSL_SESSION_free(s);
+}
+
 LHASH_OF(SSL_SESSION) *SSL_CTX_sessions(SSL_CTX *ctx)
 {
-    return ctx->sessions;
+    int ok;
+
+    /*
+     * The cache itself is sharded, so gather the sessions of all the shards
+     * into a read-only snapshot table. The snapshot holds a reference to each
+     * of its sessions, so they stay valid when they leave the cache, until
+     * the next call replaces the snapshot or |ctx| is freed.
+     */
+    if (!CRYPTO_THREAD_write_lock(ctx->lock))
+        return NULL;
+    ssl_session_snapshot_clear(ctx);
+    ok = SSL_CTX_sessions_doall(ctx, ssl_session_snapshot_add, ctx->sessions);
+    CRYPTO_THREAD_unlock(ctx->lock);
+    return ok ? ctx->sessions : NULL;
 }
+#endif
 
 static int ssl_tsan_load(SSL_CTX *ctx, TSAN_QUALIFIER int *stat)
 {
@@ -3109,7 +3336,7 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         return ctx->session_cache_mode;
 
     case SSL_CTRL_SESS_NUMBER:
-        return lh_SSL_SESSION_num_items(ctx->sessions);
+        return ssl_tsan_load(ctx, &ctx->session_cache_num);
     case SSL_CTRL_SESS_CONNECT:
         return ssl_tsan_load(ctx, &ctx->stats.sess_connect);
     case SSL_CTRL_SESS_CONNECT_GOOD:
@@ -3847,6 +4074,43 @@ static int ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
     return memcmp(a->session_id, b->session_id, a->session_id_length);
 }
 
+static int ssl_session_cache_new(SSL_CTX *ctx)
+{
+    SSL_SESS_SHARD *shard;
+    size_t i;
+
+    ctx->sessions = lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
+    if (ctx->sessions == NULL)
+        return 0;
+
+    for (i = 0; i < SSL_SESS_CACHE_SHARDS; i++) {
+        shard = &ctx->sess_shards[i];
+        shard->lock = CRYPTO_THREAD_lock_new();
+        shard->sessions = lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
+        shard->expiry = ossl_timer_wheel_new(ossl_seconds2time(1),
+                                             ossl_time_now());
+        if (shard->lock == NULL || shard->sessions == NULL
+                || shard->expiry == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+static void ssl_session_cache_free(SSL_CTX *ctx)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_SESS_CACHE_SHARDS; i++) {
+        lh_SSL_SESSION_free(ctx->sess_shards[i].sessions);
+        ossl_timer_wheel_free(ctx->sess_shards[i].expiry);
+        CRYPTO_THREAD_lock_free(ctx->sess_shards[i].lock);
+    }
+    if (ctx->sessions != NULL)
+        ssl_session_snapshot_clear(ctx);
+    lh_SSL_SESSION_free(ctx->sessions);
+    ssl_shm_sess_cache_free(ctx->shm_sess_cache);
+}
+
 /*
  * These wrapper functions should remain rather than redeclaring
  * SSL_SESSION_hash and SSL_SESSION_cmp for void* types and casting each
@@ -3918,8 +4182,7 @@ SSL_CTX *SSL_CTX_new_ex(OSSL_LIB_CTX *libctx, const char *propq,
     ret->max_cert_list = SSL_MAX_CERT_LIST_DEFAULT;
     ret->verify_mode = SSL_VERIFY_NONE;
 
-    ret->sessions = lh_SSL_SESSION_new(ssl_session_hash, ssl_session_cmp);
-    if (ret->sessions == NULL) {
+    if (!ssl_session_cache_new(ret)) {
         ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
         goto err;
     }
@@ -4171,7 +4434,8 @@ void SSL_CTX_free(SSL_CTX *a)
         SSL_CTX_flush_sessions_ex(a, 0);
 
     CRYPTO_free_ex_data(CRYPTO_EX_INDEX_SSL_CTX, a, &a->ex_data);
-    lh_SSL_SESSION_free(a->sessions);
+    ssl_session_cache_free(a);
+    ssl_recbuf_pool_free(a->recbuf_pool);
     X509_STORE_free(a->cert_store);
 #ifndef OPENSSL_NO_CT
     CTLOG_STORE_free(a->ctlog_store);
@@ -4539,6 +4803,18 @@ void ssl_update_cache(SSL_CONNECTION *s, int mode)
                     || (s->options & SSL_OP_NO_TICKET) != 0))
             SSL_CTX_add_session(s->session_ctx, s->session);
 
+        /*
+         * Add the session to the shared cache. Like the internal cache this
+         * is pointless for stateless TLSv1.3 tickets. Sessions that allow
+         * early data are left out as replays can't be detected across
+         * processes.
+         */
+        if (s->server && s->session_ctx->shm_sess_cache != NULL
+                && (!SSL_CONNECTION_IS_TLS13(s)
+                    || ((s->options & SSL_OP_NO_TICKET) != 0
+                        && s->session->ext.max_early_data == 0)))
+            ssl_shm_sess_cache_add(s->session_ctx->shm_sess_cache, s->session);
+
         /*
          * Add the session to the external cache. We do this even in server side
          * TLSv1.3 without early data because some applications just want to
@@ -37,6 +37,7 @@
 # include "internal/ktls.h"
 # include "internal/time.h"
 # include "internal/ssl.h"
+# include "internal/timer_wheel.h"
 # include "internal/cryptlib.h"
 # include "record/record.h"
 
@@ -560,6 +561,14 @@ struct ssl_session_st {
          * performed at all.
          */
         uint8_t max_fragment_len_mode;
+        /*
+         * The QUIC transport parameters sent by the server. A QUIC client
+         * needs to remember these in order to send 0-RTT data. In a session
+         * held by a QUIC server, these are the ones listed in RFC 9000 s. 7.4.1
+         * in the canonical form described for quic_early_transport_params.
+         */
+        unsigned char *quic_transport_params;
+        size_t quic_transport_params_len;
     } ext;
 # ifndef OPENSSL_NO_SRP
     char *srp_username;
@@ -570,16 +579,49 @@ struct ssl_session_st {
     SSL_CTX *owner;
 
     /*
-     * These are used to make removal of session-ids more efficient and to
-     * implement a maximum cache size. Access requires protection of ctx->lock.
+     * These are used to make removal of session-ids more efficient, to
+     * implement a maximum cache size and to expire sessions. Access requires
+     * protection of the lock of the cache shard the session lives in.
      */
     struct ssl_session_st *prev, *next;
+    OSSL_TIMER_WHEEL_ENTRY expiry_entry;
+    /* The shard of |owner| holding the session while it is cached */
+    struct ssl_sess_shard_st *shard;
     CRYPTO_REF_COUNT references;
 };
 
 /* Extended master secret support */
 # define SSL_SESS_FLAG_EXTMS             0x1
 
+/*
+ * The internal session cache is split into shards selected by session ID so
+ * that lookups and inserts of unrelated sessions do not serialise on a single
+ * lock. Each shard keeps its own hash table, a list of its sessions with the
+ * most recently added or updated first for size based eviction and a timer
+ * wheel for expiry.
+ */
+# define SSL_SESS_CACHE_SHARDS           16
+
+/*
+ * The most expired sessions a shard drops when a session is added to it, so
+ * that expiry is spread over the handshakes instead of waiting for a flush.
+ */
+# define SSL_SESS_EXPIRE_BATCH           8
+
+typedef struct ssl_sess_shard_st {
+    CRYPTO_RWLOCK *lock;
+    LHASH_OF(SSL_SESSION) *sessions;
+    struct ssl_session_st *session_cache_head;
+    struct ssl_session_st *session_cache_tail;
+    OSSL_TIMER_WHEEL *expiry;
+} SSL_SESS_SHARD;
+
+/* Session cache in shared memory, see ssl_sess_shm.c */
+typedef struct ssl_shm_sess_cache_st SSL_SHM_SESS_CACHE;
+
+/* Pool of record layer buffers, see ssl_recbuf_pool.c */
+typedef struct ssl_recbuf_pool_st SSL_RECBUF_POOL;
+
 # ifndef OPENSSL_NO_SRP
 
 typedef struct srp_ctx_st {
@@ -808,14 +850,16 @@ struct ssl_ctx_st {
     /* TLSv1.3 specific ciphersuites */
     STACK_OF(SSL_CIPHER) *tls13_ciphersuites;
     struct x509_store_st /* X509_STORE */ *cert_store;
+    /* Snapshot of the session cache handed out by SSL_CTX_sessions() */
     LHASH_OF(SSL_SESSION) *sessions;
+    SSL_SESS_SHARD sess_shards[SSL_SESS_CACHE_SHARDS];
+    /* Number of sessions in all the shards */
+    TSAN_QUALIFIER int session_cache_num;
     /*
      * Most session-ids that will be cached, default is
      * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited.
      */
     size_t session_cache_size;
-    struct ssl_session_st *session_cache_head;
-    struct ssl_session_st *session_cache_tail;
     /*
      * This can have one of 2 values, ored together, SSL_SESS_CACHE_CLIENT,
      * SSL_SESS_CACHE_SERVER, Default is SSL_SESSION_CACHE_SERVER, which
@@ -842,6 +886,17 @@ struct ssl_ctx_st {
     SSL_SESSION *(*get_session_cb) (struct ssl_st *ssl,
                                     const unsigned char *data, int len,
                                     int *copy);
+    /*
+     * Server sessions are also stored here, if set, and looked up here
+     * after the internal cache and before get_session_cb.
+     */
+    SSL_SHM_SESS_CACHE *shm_sess_cache;
+
+    /*
+     * If set, TLS record layers of connections created from this SSL_CTX
+     * borrow their buffers from here while records are in flight.
+     */
+    SSL_RECBUF_POOL *recbuf_pool;
     struct {
         TSAN_QUALIFIER int sess_connect;       /* SSL new conn - started */
         TSAN_QUALIFIER int sess_connect_renegotiate; /* SSL reneg - requested */
@@ -1668,6 +1723,23 @@ struct ssl_connection_st {
          */
         int tick_identity;
 
+        /*
+         * On a QUIC client the QUIC transport parameters received from the
+         * server. These are stored in any session tickets we receive.
+         */
+        unsigned char *peer_quic_transport_params;
+        size_t peer_quic_transport_params_len;
+
+        /*
+         * On a QUIC server the transport parameters we send which a client
+         * remembers for 0-RTT (RFC 9000 s. 7.4.1), in a canonical encoding
+         * that can be compared byte for byte. These are stored in the sessions
+         * we issue tickets for, and 0-RTT is only accepted with a session
+         * holding the same ones.
+         */
+        unsigned char *quic_early_transport_params;
+        size_t quic_early_transport_params_len;
+
         /* This is the list of algorithms the peer supports that we also support */
         int compress_certificate_from_peer[TLSEXT_comp_cert_limit];
         /* indicate that we sent the extension, so we'll accept it */
@@ -1709,6 +1781,8 @@ struct ssl_connection_st {
     int scts_parsed;
 # endif
     SSL_CTX *session_ctx;       /* initial ctx, used to store sessions */
+    /* Record buffer pool of session_ctx when this connection was created */
+    SSL_RECBUF_POOL *recbuf_pool;
 # ifndef OPENSSL_NO_SRTP
     /* What we'll do */
     STACK_OF(SRTP_PROTECTION_PROFILE) *srtp_profiles;
@@ -2506,6 +2580,21 @@ __owur int ssl_get_new_session(SSL_CONNECTION *s, int session);
 __owur SSL_SESSION *lookup_sess_in_cache(SSL_CONNECTION *s,
                                          const unsigned char *sess_id,
                                          size_t sess_id_len);
+__owur SSL_SESS_SHARD *ssl_session_shard(SSL_CTX *ctx,
+                                         const unsigned char *sess_id,
+                                         size_t sess_id_len);
+void ssl_shm_sess_cache_free(SSL_SHM_SESS_CACHE *c);
+void ssl_shm_sess_cache_add(SSL_SHM_SESS_CACHE *c, SSL_SESSION *sess);
+__owur SSL_SESSION *ssl_shm_sess_cache_get(SSL_SHM_SESS_CACHE *c,
+                                           const unsigned char *id,
+                                           size_t id_len);
+void ssl_shm_sess_cache_remove(SSL_SHM_SESS_CACHE *c,
+                               const unsigned char *id, size_t id_len);
+__owur int ssl_recbuf_pool_up_ref(SSL_RECBUF_POOL *pool);
+void ssl_recbuf_pool_free(SSL_RECBUF_POOL *pool);
+__owur unsigned char *ssl_recbuf_pool_get(SSL_RECBUF_POOL *pool, size_t len);
+void ssl_recbuf_pool_put(SSL_RECBUF_POOL *pool, unsigned char *buf,
+                         size_t len);
 __owur int ssl_get_prev_session(SSL_CONNECTION *s, CLIENTHELLO_MSG *hello);
 __owur SSL_SESSION *ssl_session_dup(const SSL_SESSION *src, int ticket);
 __owur int ssl_cipher_id_cmp(const SSL_CIPHER *a, const SSL_CIPHER *b);
@@ -2580,6 +2669,7 @@ void ssl_set_masks(SSL_CONNECTION *s);
 __owur STACK_OF(SSL_CIPHER) *ssl_get_ciphers_by_id(SSL_CONNECTION *sc);
 __owur int ssl_x509err2alert(int type);
 void ssl_sort_cipher_list(void);
+void ssl_cipher_cache_init(void);
 int ssl_load_ciphers(SSL_CTX *ctx);
 __owur int ssl_setup_sigalgs(SSL_CTX *ctx);
 int ssl_load_groups(SSL_CTX *ctx);
@@ -2643,6 +2733,8 @@ void ssl3_free(SSL *s);
 __owur int ssl3_read(SSL *s, void *buf, size_t len, size_t *readbytes);
 __owur int ssl3_peek(SSL *s, void *buf, size_t len, size_t *readbytes);
 __owur int ssl3_write(SSL *s, const void *buf, size_t len, size_t *written);
+__owur int ssl3_writev(SSL *s, const SSL_CONST_IOVEC *iov, size_t iovcnt,
+                       size_t *written);
 __owur int ssl3_shutdown(SSL *s);
 int ssl3_clear(SSL *s);
 __owur long ssl3_ctrl(SSL *s, int cmd, long larg, void *parg);
@@ -3016,6 +3108,15 @@ static ossl_unused ossl_inline void ssl_tsan_counter(const SSL_CTX *ctx,
     }
 }
 
+static ossl_unused ossl_inline void ssl_tsan_decr(const SSL_CTX *ctx,
+                                                  TSAN_QUALIFIER int *stat)
+{
+    if (ssl_tsan_lock(ctx)) {
+        tsan_decr(stat);
+        ssl_tsan_unlock(ctx);
+    }
+}
+
 int ossl_comp_has_alg(int a);
 size_t ossl_calculate_comp_expansion(int alg, size_t length);
 
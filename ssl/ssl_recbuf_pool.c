@@ -0,0 +1,271 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * A pool of record layer buffers shared by the connections of an SSL_CTX.
+ *
+ * When a pool is configured, the TLS record layer only holds its read and
+ * write buffers while a record is in flight and gives them back as soon as
+ * they are drained, so an idle connection holds no buffers at all. The buffers
+ * come from and go back to the pool instead of the allocator.
+ *
+ * All pooled buffers have the same size, RECBUF_POOL_BUF_LEN, which is enough
+ * for a record of the default maximum fragment length with all overheads.
+ * Requests for larger buffers, e.g. for pipelining or a large
+ * default_read_buffer_len, bypass the pool. Since a pooled buffer is an
+ * ordinary allocation, it is always safe to free one rather than return it.
+ *
+ * To keep threads from contending for a single free list, the pool is split
+ * into RECBUF_POOL_SHARDS shards, each with its own lock and free list. A
+ * thread always uses the shard picked by a hash of its thread id, so threads
+ * mostly have a shard to themselves and its lock is rarely contended. Hashing
+ * avoids a thread local key per pool, of which there are only a limited
+ * number in a process.
+ *
+ * The pool is reference counted. Each connection holds a reference to the
+ * pool of its SSL_CTX for its whole lifetime, so replacing or removing the
+ * pool of an SSL_CTX only affects connections created after that.
+ */
+
+#include <string.h>
+#include <openssl/err.h>
+#include "internal/refcount.h"
+#include "ssl_local.h"
+
+#define RECBUF_POOL_SHARDS      16
+#define RECBUF_POOL_BUF_LEN     (SSL3_RT_MAX_PLAIN_LENGTH + 2048)
+
+typedef struct recbuf_st RECBUF;
+
+/* A free buffer; the link is stored in the buffer itself */
+struct recbuf_st {
+    RECBUF *next;
+};
+
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    RECBUF *free_list;
+    size_t num_idle;
+    size_t max_idle;
+    /*
+     * Buffers may be returned to a different shard than they were taken from,
+     * so only the sum over all shards is meaningful.
+     */
+    int64_t num_in_use;
+    uint64_t hits;
+    uint64_t misses;
+} RECBUF_POOL_SHARD;
+
+struct ssl_recbuf_pool_st {
+    CRYPTO_REF_COUNT references;
+    RECBUF_POOL_SHARD shards[RECBUF_POOL_SHARDS];
+};
+
+static SSL_RECBUF_POOL *recbuf_pool_new(size_t max_idle)
+{
+    SSL_RECBUF_POOL *pool;
+    size_t i, per_shard;
+
+    if ((pool = OPENSSL_zalloc(sizeof(*pool))) == NULL)
+        return NULL;
+
+    if (!CRYPTO_NEW_REF(&pool->references, 1)) {
+        OPENSSL_free(pool);
+        return NULL;
+    }
+
+    /* Round up, so that every shard can keep at least one buffer */
+    per_shard = (max_idle + RECBUF_POOL_SHARDS - 1) / RECBUF_POOL_SHARDS;
+
+    for (i = 0; i < RECBUF_POOL_SHARDS; i++) {
+        if ((pool->shards[i].lock = CRYPTO_THREAD_lock_new()) == NULL)
+            goto err;
+        pool->shards[i].max_idle = per_shard;
+    }
+
+    return pool;
+
+ err:
+    ssl_recbuf_pool_free(pool);
+    return NULL;
+}
+
+int ssl_recbuf_pool_up_ref(SSL_RECBUF_POOL *pool)
+{
+    int i;
+
+    if (CRYPTO_UP_REF(&pool->references, &i) <= 0)
+        return 0;
+
+    REF_PRINT_COUNT("SSL_RECBUF_POOL", pool);
+    REF_ASSERT_ISNT(i < 2);
+    return i > 1 ? 1 : 0;
+}
+
+void ssl_recbuf_pool_free(SSL_RECBUF_POOL *pool)
+{
+    RECBUF *b, *next;
+    size_t i;
+    int refs;
+
+    if (pool == NULL)
+        return;
+
+    CRYPTO_DOWN_REF(&pool->references, &refs);
+    REF_PRINT_COUNT("SSL_RECBUF_POOL", pool);
+    if (refs > 0)
+        return;
+    REF_ASSERT_ISNT(refs < 0);
+
+    for (i = 0; i < RECBUF_POOL_SHARDS; i++) {
+        for (b = pool->shards[i].free_list; b != NULL; b = next) {
+            next = b->next;
+            OPENSSL_free(b);
+        }
+        CRYPTO_THREAD_lock_free(pool->shards[i].lock);
+    }
+    CRYPTO_FREE_REF(&pool->references);
+    OPENSSL_free(pool);
+}
+
+/*
+ * Thread ids are opaque and often pointers or otherwise aligned, so all of
+ * their bytes are mixed in (FNV-1a) before picking a shard.
+ */
+static RECBUF_POOL_SHARD *recbuf_pool_shard(SSL_RECBUF_POOL *pool)
+{
+    CRYPTO_THREAD_ID tid = CRYPTO_THREAD_get_current_id();
+    unsigned char b[sizeof(tid)];
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    memcpy(b, &tid, sizeof(tid));
+    for (i = 0; i < sizeof(b); i++)
+        h = (h ^ b[i]) * 0x100000001b3ULL;
+    h ^= h >> 32;
+
+    return &pool->shards[(h ^ (h >> 16)) % RECBUF_POOL_SHARDS];
+}
+
+unsigned char *ssl_recbuf_pool_get(SSL_RECBUF_POOL *pool, size_t len)
+{
+    RECBUF_POOL_SHARD *shard;
+    RECBUF *b = NULL;
+
+    if (len > RECBUF_POOL_BUF_LEN)
+        return OPENSSL_malloc(len);
+
+    if (pool == NULL)
+        return OPENSSL_malloc(len);
+
+    shard = recbuf_pool_shard(pool);
+    if (CRYPTO_THREAD_write_lock(shard->lock)) {
+        if ((b = shard->free_list) != NULL) {
+            shard->free_list = b->next;
+            shard->num_idle--;
+            shard->hits++;
+        } else {
+            shard->misses++;
+        }
+        shard->num_in_use++;
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
+    if (b == NULL)
+        b = OPENSSL_malloc(RECBUF_POOL_BUF_LEN);
+
+    return (unsigned char *)b;
+}
+
+/*
+ * |len| must be the length that was passed to ssl_recbuf_pool_get(). |pool|
+ * need not be the pool the buffer came from.
+ */
+void ssl_recbuf_pool_put(SSL_RECBUF_POOL *pool, unsigned char *buf, size_t len)
+{
+    RECBUF_POOL_SHARD *shard;
+    RECBUF *b = (RECBUF *)buf;
+
+    if (buf == NULL)
+        return;
+
+    if (pool == NULL || len > RECBUF_POOL_BUF_LEN) {
+        OPENSSL_free(buf);
+        return;
+    }
+
+    shard = recbuf_pool_shard(pool);
+    if (CRYPTO_THREAD_write_lock(shard->lock)) {
+        shard->num_in_use--;
+        if (shard->num_idle < shard->max_idle) {
+            b->next = shard->free_list;
+            shard->free_list = b;
+            shard->num_idle++;
+            b = NULL;
+        }
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
+    OPENSSL_free(b);
+}
+
+int SSL_CTX_set_record_buffer_pool(SSL_CTX *ctx, size_t max_idle)
+{
+    SSL_RECBUF_POOL *pool = NULL;
+
+    if (IS_QUIC_CTX(ctx)) {
+        ERR_raise(ERR_LIB_SSL, SSL_R_WRONG_SSL_VERSION);
+        return 0;
+    }
+
+    if (max_idle != 0 && (pool = recbuf_pool_new(max_idle)) == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+        return 0;
+    }
+
+    /* Connections using the old pool keep their own references to it */
+    ssl_recbuf_pool_free(ctx->recbuf_pool);
+    ctx->recbuf_pool = pool;
+    return 1;
+}
+
+int SSL_CTX_get_record_buffer_pool_stats(SSL_CTX *ctx, size_t *idle,
+                                         size_t *in_use, uint64_t *hits,
+                                         uint64_t *misses)
+{
+    SSL_RECBUF_POOL *pool = ctx->recbuf_pool;
+    RECBUF_POOL_SHARD *shard;
+    size_t i, nidle = 0;
+    int64_t ninuse = 0;
+    uint64_t nhits = 0, nmisses = 0;
+
+    if (pool == NULL)
+        return 0;
+
+    for (i = 0; i < RECBUF_POOL_SHARDS; i++) {
+        shard = &pool->shards[i];
+        if (!CRYPTO_THREAD_read_lock(shard->lock))
+            return 0;
+        nidle += shard->num_idle;
+        ninuse += shard->num_in_use;
+        nhits += shard->hits;
+        nmisses += shard->misses;
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
+    if (idle != NULL)
+        *idle = nidle;
+    if (in_use != NULL)
+        *in_use = ninuse > 0 ? (size_t)ninuse : 0;
+    if (hits != NULL)
+        *hits = nhits;
+    if (misses != NULL)
+        *misses = nmisses;
+    return 1;
+}
@@ -20,8 +20,9 @@
 #include "ssl_local.h"
 #include "statem/statem_local.h"
 
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s);
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s);
+static void SSL_SESSION_list_remove(SSL_SESS_SHARD *shard, SSL_SESSION *s);
+static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESS_SHARD *shard,
+                                 SSL_SESSION *s);
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck);
 
 DEFINE_STACK_OF(SSL_SESSION)
@@ -32,21 +33,25 @@ __owur static ossl_inline int sess_timedout(OSSL_TIME t, SSL_SESSION *ss)
 }
 
 /*
- * Returns -1/0/+1 as other XXXcmp-type functions
- * Takes calculated timeout into consideration
+ * Calculates effective timeout
+ * Locking must be done by the caller of this function
  */
-__owur static ossl_inline int timeoutcmp(SSL_SESSION *a, SSL_SESSION *b)
+void ssl_session_calculate_timeout(SSL_SESSION *ss)
 {
-    return ossl_time_compare(a->calc_timeout, b->calc_timeout);
+    ss->calc_timeout = ossl_time_add(ss->time, ss->timeout);
 }
 
 /*
- * Calculates effective timeout
- * Locking must be done by the caller of this function
+ * Returns the session cache shard that holds sessions with the given ID.
+ * The LHASH in each shard hashes the leading bytes of the ID, so the shard
+ * is picked from the trailing byte to keep the shards' tables well spread.
  */
-void ssl_session_calculate_timeout(SSL_SESSION *ss)
+SSL_SESS_SHARD *ssl_session_shard(SSL_CTX *ctx, const unsigned char *sess_id,
+                                  size_t sess_id_len)
 {
-    ss->calc_timeout = ossl_time_add(ss->time, ss->timeout);
+    size_t idx = sess_id_len > 0 ? sess_id[sess_id_len - 1] : 0;
+
+    return &ctx->sess_shards[idx % SSL_SESS_CACHE_SHARDS];
 }
 
 /*
@@ -115,6 +120,7 @@ SSL_SESSION *SSL_SESSION_new(void)
     ss->timeout = ossl_seconds2time(60 * 5 + 4);
     ss->time = ossl_time_now();
     ssl_session_calculate_timeout(ss);
+    ossl_timer_wheel_entry_init(&ss->expiry_entry, ss);
     if (!CRYPTO_NEW_REF(&ss->references, 1)) {
         OPENSSL_free(ss);
         return NULL;
@@ -157,6 +163,7 @@ static SSL_SESSION *ssl_session_dup_intern(const SSL_SESSION *src, int ticket)
     dest->ext.hostname = NULL;
     dest->ext.tick = NULL;
     dest->ext.alpn_selected = NULL;
+    dest->ext.quic_transport_params = NULL;
 #ifndef OPENSSL_NO_SRP
     dest->srp_username = NULL;
 #endif
@@ -169,7 +176,9 @@ static SSL_SESSION *ssl_session_dup_intern(const SSL_SESSION *src, int ticket)
     /* As the copy is not in the cache, we remove the associated pointers */
     dest->prev = NULL;
     dest->next = NULL;
+    ossl_timer_wheel_entry_init(&dest->expiry_entry, dest);
     dest->owner = NULL;
+    dest->shard = NULL;
 
     if (!CRYPTO_NEW_REF(&dest->references, 1)) {
         OPENSSL_free(dest);
@@ -245,6 +254,14 @@ static SSL_SESSION *ssl_session_dup_intern(const SSL_SESSION *src, int ticket)
             goto err;
     }
 
+    if (src->ext.quic_transport_params != NULL) {
+        dest->ext.quic_transport_params =
+            OPENSSL_memdup(src->ext.quic_transport_params,
+                           src->ext.quic_transport_params_len);
+        if (dest->ext.quic_transport_params == NULL)
+            goto err;
+    }
+
 #ifndef OPENSSL_NO_SRP
     if (src->srp_username) {
         dest->srp_username = OPENSSL_strdup(src->srp_username);
@@ -499,6 +516,7 @@ SSL_SESSION *lookup_sess_in_cache(SSL_CONNECTION *s,
     if ((s->session_ctx->session_cache_mode
          & SSL_SESS_CACHE_NO_INTERNAL_LOOKUP) == 0) {
         SSL_SESSION data;
+        SSL_SESS_SHARD *shard;
 
         data.ssl_version = s->version;
         if (!ossl_assert(sess_id_len <= SSL_MAX_SSL_SESSION_ID_LENGTH))
@@ -507,18 +525,32 @@ SSL_SESSION *lookup_sess_in_cache(SSL_CONNECTION *s,
         memcpy(data.session_id, sess_id, sess_id_len);
         data.session_id_length = sess_id_len;
 
-        if (!CRYPTO_THREAD_read_lock(s->session_ctx->lock))
+        shard = ssl_session_shard(s->session_ctx, sess_id, sess_id_len);
+        if (!CRYPTO_THREAD_read_lock(shard->lock))
             return NULL;
-        ret = lh_SSL_SESSION_retrieve(s->session_ctx->sessions, &data);
+        ret = lh_SSL_SESSION_retrieve(shard->sessions, &data);
         if (ret != NULL) {
             /* don't allow other threads to steal it: */
             SSL_SESSION_up_ref(ret);
         }
-        CRYPTO_THREAD_unlock(s->session_ctx->lock);
+        CRYPTO_THREAD_unlock(shard->lock);
         if (ret == NULL)
             ssl_tsan_counter(s->session_ctx, &s->session_ctx->stats.sess_miss);
     }
 
+    if (ret == NULL && s->session_ctx->shm_sess_cache != NULL) {
+        ret = ssl_shm_sess_cache_get(s->session_ctx->shm_sess_cache,
+                                     sess_id, sess_id_len);
+        if (ret != NULL) {
+            ssl_tsan_counter(s->session_ctx,
+                             &s->session_ctx->stats.sess_cb_hit);
+            if ((s->session_ctx->session_cache_mode &
+                 SSL_SESS_CACHE_NO_INTERNAL_STORE) == 0)
+                (void)SSL_CTX_add_session(s->session_ctx, ret);
+            return ret;
+        }
+    }
+
     if (ret == NULL && s->session_ctx->get_session_cb != NULL) {
         int copy = 1;
 
@@ -716,10 +748,41 @@ int ssl_get_prev_session(SSL_CONNECTION *s, CLIENTHELLO_MSG *hello)
     return 0;
 }
 
+/*
+ * Evicts the oldest sessions of the shards other than |skip| until the cache
+ * is back within its configured size. Each shard is locked on its own so that
+ * no two shard locks are ever held at once.
+ */
+static void evict_from_other_shards(SSL_CTX *ctx, SSL_SESS_SHARD *skip)
+{
+    SSL_SESS_SHARD *shard;
+    size_t i, idle = 0;
+    long size = SSL_CTX_sess_get_cache_size(ctx);
+
+    for (i = skip - ctx->sess_shards + 1;
+         idle < SSL_SESS_CACHE_SHARDS && SSL_CTX_sess_number(ctx) >= size;
+         i++) {
+        shard = &ctx->sess_shards[i % SSL_SESS_CACHE_SHARDS];
+        idle++;
+        if (shard == skip || !CRYPTO_THREAD_write_lock(shard->lock))
+            continue;
+        if (SSL_CTX_sess_number(ctx) >= size
+                && remove_session_lock(ctx, shard->session_cache_tail, 0)) {
+            ssl_tsan_counter(ctx, &ctx->stats.sess_cache_full);
+            idle = 0;
+        }
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+}
+
 int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
     int ret = 0;
-    SSL_SESSION *s;
+    size_t i;
+    OSSL_TIME now;
+    SSL_SESSION *s, *expired;
+    SSL_SESS_SHARD *shard = ssl_session_shard(ctx, c->session_id,
+                                              c->session_id_length);
 
     /*
      * add just 1 reference count for the SSL_CTX's session cache even though
@@ -731,20 +794,21 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
      * if session c is in already in cache, we take back the increment later
      */
 
-    if (!CRYPTO_THREAD_write_lock(ctx->lock)) {
+    if (!CRYPTO_THREAD_write_lock(shard->lock)) {
         SSL_SESSION_free(c);
         return 0;
     }
-    s = lh_SSL_SESSION_insert(ctx->sessions, c);
+    s = lh_SSL_SESSION_insert(shard->sessions, c);
 
     /*
      * s != NULL iff we already had a session with the given PID. In this
      * case, s == c should hold (then we did not really modify
-     * ctx->sessions), or we're in trouble.
+     * the shard's sessions), or we're in trouble.
      */
     if (s != NULL && s != c) {
         /* We *are* in trouble ... */
-        SSL_SESSION_list_remove(ctx, s);
+        SSL_SESSION_list_remove(shard, s);
+        ssl_tsan_decr(ctx, &ctx->session_cache_num);
         SSL_SESSION_free(s);
         /*
          * ... so pretend the other session did not exist in cache (we cannot
@@ -754,7 +818,7 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
          */
         s = NULL;
     } else if (s == NULL &&
-               lh_SSL_SESSION_retrieve(ctx->sessions, c) == NULL) {
+               lh_SSL_SESSION_retrieve(shard->sessions, c) == NULL) {
         /* s == NULL can also mean OOM error in lh_SSL_SESSION_insert ... */
 
         /*
@@ -777,10 +841,23 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
          */
 
         ret = 1;
+        ssl_tsan_counter(ctx, &ctx->session_cache_num);
+
+        /*
+         * Drop a bounded number of expired sessions from this shard first,
+         * so expired sessions are reclaimed a few at a time and are the
+         * first to make room for new ones.
+         */
+        now = ossl_time_now();
+        for (i = 0; i < SSL_SESS_EXPIRE_BATCH; i++) {
+            expired = ossl_timer_wheel_expire(shard->expiry, now);
+            if (expired == NULL || !remove_session_lock(ctx, expired, 0))
+                break;
+        }
 
         if (SSL_CTX_sess_get_cache_size(ctx) > 0) {
             while (SSL_CTX_sess_number(ctx) >= SSL_CTX_sess_get_cache_size(ctx)) {
-                if (!remove_session_lock(ctx, ctx->session_cache_tail, 0))
+                if (!remove_session_lock(ctx, shard->session_cache_tail, 0))
                     break;
                 else
                     ssl_tsan_counter(ctx, &ctx->stats.sess_cache_full);
@@ -788,7 +865,7 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
         }
     }
 
-    SSL_SESSION_list_add(ctx, c);
+    SSL_SESSION_list_add(ctx, shard, c);
 
     if (s != NULL) {
         /*
@@ -799,34 +876,59 @@ int SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
         SSL_SESSION_free(s);    /* s == c */
         ret = 0;
     }
-    CRYPTO_THREAD_unlock(ctx->lock);
+    CRYPTO_THREAD_unlock(shard->lock);
+
+    /*
+     * Our own shard may not have held enough sessions to make room, in which
+     * case the oldest sessions of the other shards have to go instead.
+     */
+    if (ret == 1 && SSL_CTX_sess_get_cache_size(ctx) > 0
+            && SSL_CTX_sess_number(ctx) >= SSL_CTX_sess_get_cache_size(ctx))
+        evict_from_other_shards(ctx, shard);
     return ret;
 }
 
 int SSL_CTX_remove_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
+    /*
+     * Other processes must not resume it either. Sessions that are merely
+     * evicted from the internal cache stay in the shared one.
+     */
+    if (ctx->shm_sess_cache != NULL && c != NULL)
+        ssl_shm_sess_cache_remove(ctx->shm_sess_cache, c->session_id,
+                                  c->session_id_length);
     return remove_session_lock(ctx, c, 1);
 }
 
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck)
 {
     SSL_SESSION *r;
+    SSL_SESS_SHARD *shard;
     int ret = 0;
 
     if ((c != NULL) && (c->session_id_length != 0)) {
+        /*
+         * |c| may be a copy of the cached session rather than the cached
+         * session itself, in which case its ID tells where to look.
+         */
+        shard = c->owner == ctx ? c->shard : NULL;
+        if (shard == NULL)
+            shard = ssl_session_shard(ctx, c->session_id,
+                                      c->session_id_length);
         if (lck) {
-            if (!CRYPTO_THREAD_write_lock(ctx->lock))
+            if (!CRYPTO_THREAD_write_lock(shard->lock))
                 return 0;
         }
-        if ((r = lh_SSL_SESSION_retrieve(ctx->sessions, c)) != NULL) {
+        if ((r = lh_SSL_SESSION_retrieve(shard->sessions, c)) != NULL) {
             ret = 1;
-            r = lh_SSL_SESSION_delete(ctx->sessions, r);
-            SSL_SESSION_list_remove(ctx, r);
+            r = lh_SSL_SESSION_delete(shard->sessions, r);
+            SSL_SESSION_list_remove(shard, r);
+            ssl_tsan_decr(ctx, &ctx->session_cache_num);
         }
         c->not_resumable = 1;
 
         if (lck)
-            CRYPTO_THREAD_unlock(ctx->lock);
+            CRYPTO_THREAD_unlock(shard->lock);
 
         if (ctx->remove_session_cb != NULL)
             ctx->remove_session_cb(ctx, c);
@@ -866,6 +968,7 @@ void SSL_SESSION_free(SSL_SESSION *ss)
     OPENSSL_free(ss->srp_username);
 #endif
     OPENSSL_free(ss->ext.alpn_selected);
+    OPENSSL_free(ss->ext.quic_transport_params);
     OPENSSL_free(ss->ticket_appdata);
     CRYPTO_FREE_REF(&ss->references);
     OPENSSL_clear_free(ss, sizeof(*ss));
@@ -909,30 +1012,62 @@ int SSL_set_session(SSL *s, SSL_SESSION *session)
 int SSL_SESSION_set1_id(SSL_SESSION *s, const unsigned char *sid,
                         unsigned int sid_len)
 {
+    SSL_CTX *ctx = NULL;
+    SSL_SESS_SHARD *shard;
+
     if (sid_len > SSL_MAX_SSL_SESSION_ID_LENGTH) {
       ERR_raise(ERR_LIB_SSL, SSL_R_SSL_SESSION_ID_TOO_LONG);
       return 0;
     }
+
+    /*
+     * The cache finds sessions by ID, so a cached session is taken out of
+     * its shard while the ID changes and put back into the shard of the new
+     * one afterwards. The cache's reference is kept in the meantime.
+     */
+    shard = s->shard;
+    if (shard != NULL) {
+        if (!CRYPTO_THREAD_write_lock(shard->lock))
+            return 0;
+        if (s->shard == shard
+                && lh_SSL_SESSION_retrieve(shard->sessions, s) == s) {
+            ctx = s->owner;
+            lh_SSL_SESSION_delete(shard->sessions, s);
+            SSL_SESSION_list_remove(shard, s);
+            ssl_tsan_decr(ctx, &ctx->session_cache_num);
+        }
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+
     s->session_id_length = sid_len;
     if (sid != s->session_id && sid_len > 0)
         memcpy(s->session_id, sid, sid_len);
 
+    if (ctx != NULL) {
+        if (sid_len > 0)
+            (void)SSL_CTX_add_session(ctx, s);
+        SSL_SESSION_free(s);
+    }
     return 1;
 }
 
 long SSL_SESSION_set_timeout(SSL_SESSION *s, long t)
 {
     OSSL_TIME new_timeout = ossl_seconds2time(t);
+    SSL_SESS_SHARD *shard;
 
     if (s == NULL || t < 0)
         return 0;
-    if (s->owner != NULL) {
-        if (!CRYPTO_THREAD_write_lock(s->owner->lock))
+    shard = s->shard;
+    if (shard != NULL) {
+        if (!CRYPTO_THREAD_write_lock(shard->lock))
             return 0;
         s->timeout = new_timeout;
         ssl_session_calculate_timeout(s);
-        SSL_SESSION_list_add(s->owner, s);
-        CRYPTO_THREAD_unlock(s->owner->lock);
+        /* It may have left the cache while we waited for the lock */
+        if (s->shard == shard)
+            SSL_SESSION_list_add(s->owner, shard, s);
+        CRYPTO_THREAD_unlock(shard->lock);
     } else {
         s->timeout = new_timeout;
         ssl_session_calculate_timeout(s);
@@ -964,16 +1099,20 @@ time_t SSL_SESSION_get_time_ex(const SSL_SESSION *s)
 time_t SSL_SESSION_set_time_ex(SSL_SESSION *s, time_t t)
 {
     OSSL_TIME new_time = ossl_time_from_time_t(t);
+    SSL_SESS_SHARD *shard;
 
     if (s == NULL)
         return 0;
-    if (s->owner != NULL) {
-        if (!CRYPTO_THREAD_write_lock(s->owner->lock))
+    shard = s->shard;
+    if (shard != NULL) {
+        if (!CRYPTO_THREAD_write_lock(shard->lock))
             return 0;
         s->time = new_time;
         ssl_session_calculate_timeout(s);
-        SSL_SESSION_list_add(s->owner, s);
-        CRYPTO_THREAD_unlock(s->owner->lock);
+        /* It may have left the cache while we waited for the lock */
+        if (s->shard == shard)
+            SSL_SESSION_list_add(s->owner, shard, s);
+        CRYPTO_THREAD_unlock(shard->lock);
     } else {
         s->time = new_time;
         ssl_session_calculate_timeout(s);
@@ -1193,6 +1332,57 @@ int SSL_set_session_ticket_ext(SSL *s, void *ext_data, int ext_len)
     return 0;
 }
 
+/*
+ * The sessions of each shard are collected with a reference under the shard's
+ * lock and handed to |fn| once the lock is dropped, so |fn| may use the cache
+ * itself and the references only last as long as the shard's turn.
+ */
+int SSL_CTX_sessions_doall(SSL_CTX *ctx,
+                           void (*fn)(SSL_SESSION *sess, void *arg),
+                           void *arg)
+{
+    STACK_OF(SSL_SESSION) *sk;
+    SSL_SESS_SHARD *shard;
+    SSL_SESSION *s;
+    size_t i;
+    int j, ret = 1;
+
+    if (ctx == NULL || fn == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if ((sk = sk_SSL_SESSION_new_null()) == NULL) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+        return 0;
+    }
+
+    for (i = 0; ret && i < SSL_SESS_CACHE_SHARDS; i++) {
+        shard = &ctx->sess_shards[i];
+        if (!CRYPTO_THREAD_read_lock(shard->lock)) {
+            ret = 0;
+            break;
+        }
+        for (s = shard->session_cache_head;
+             s != NULL && s != (SSL_SESSION *)&shard->session_cache_tail;
+             s = s->next) {
+            if (!sk_SSL_SESSION_push(sk, s)) {
+                ERR_raise(ERR_LIB_SSL, ERR_R_CRYPTO_LIB);
+                ret = 0;
+                break;
+            }
+            SSL_SESSION_up_ref(s);
+        }
+        CRYPTO_THREAD_unlock(shard->lock);
+
+        for (j = 0; ret && j < sk_SSL_SESSION_num(sk); j++)
+            fn(sk_SSL_SESSION_value(sk, j), arg);
+        while ((s = sk_SSL_SESSION_pop(sk)) != NULL)
+            SSL_SESSION_free(s);
+    }
+    sk_SSL_SESSION_free(sk);
+    return ret;
+}
+
 #ifndef OPENSSL_NO_DEPRECATED_3_4
 void SSL_CTX_flush_sessions(SSL_CTX *s, long t)
 {
@@ -1200,32 +1390,39 @@ void SSL_CTX_flush_sessions(SSL_CTX *s, long t)
 }
 #endif
 
-void SSL_CTX_flush_sessions_ex(SSL_CTX *s, time_t t)
+static void flush_shard(SSL_CTX *s, SSL_SESS_SHARD *shard, time_t t,
+                        STACK_OF(SSL_SESSION) *sk)
 {
-    STACK_OF(SSL_SESSION) *sk;
     SSL_SESSION *current;
     unsigned long i;
     const OSSL_TIME timeout = ossl_time_from_time_t(t);
 
-    if (!CRYPTO_THREAD_write_lock(s->lock))
+    /* The shard may be missing if SSL_CTX_new() failed part way */
+    if (shard->lock == NULL || shard->sessions == NULL)
         return;
 
-    sk = sk_SSL_SESSION_new_null();
-    i = lh_SSL_SESSION_get_down_load(s->sessions);
-    lh_SSL_SESSION_set_down_load(s->sessions, 0);
+    if (!CRYPTO_THREAD_write_lock(shard->lock))
+        return;
+
+    i = lh_SSL_SESSION_get_down_load(shard->sessions);
+    lh_SSL_SESSION_set_down_load(shard->sessions, 0);
 
     /*
-     * Iterate over the list from the back (oldest), and stop
-     * when a session can no longer be removed.
+     * Take every session when flushing everything, or else the expired
+     * ones from the timer wheel.
      * Add the session to a temporary list to be freed outside
-     * the SSL_CTX lock.
+     * the shard lock.
      * But still do the remove_session_cb() within the lock.
      */
-    while (s->session_cache_tail != NULL) {
-        current = s->session_cache_tail;
-        if (t == 0 || sess_timedout(timeout, current)) {
-            lh_SSL_SESSION_delete(s->sessions, current);
-            SSL_SESSION_list_remove(s, current);
+    for (;;) {
+        if (t == 0)
+            current = shard->session_cache_tail;
+        else
+            current = ossl_timer_wheel_expire(shard->expiry, timeout);
+        if (current != NULL) {
+            lh_SSL_SESSION_delete(shard->sessions, current);
+            SSL_SESSION_list_remove(shard, current);
+            ssl_tsan_decr(s, &s->session_cache_num);
             current->not_resumable = 1;
             if (s->remove_session_cb != NULL)
                 s->remove_session_cb(s, current);
@@ -1243,9 +1440,18 @@ void SSL_CTX_flush_sessions_ex(SSL_CTX *s, time_t t)
         }
     }
 
-    lh_SSL_SESSION_set_down_load(s->sessions, i);
-    CRYPTO_THREAD_unlock(s->lock);
+    lh_SSL_SESSION_set_down_load(shard->sessions, i);
+    CRYPTO_THREAD_unlock(shard->lock);
+}
+
+void SSL_CTX_flush_sessions_ex(SSL_CTX *s, time_t t)
+{
+    STACK_OF(SSL_SESSION) *sk;
+    size_t i;
 
+    sk = sk_SSL_SESSION_new_null();
+    for (i = 0; i < SSL_SESS_CACHE_SHARDS; i++)
+        flush_shard(s, &s->sess_shards[i], t, sk);
     sk_SSL_SESSION_pop_free(sk, SSL_SESSION_free);
 }
 
@@ -1261,84 +1467,64 @@ int ssl_clear_bad_session(SSL_CONNECTION *s)
         return 0;
 }
 
-/* locked by SSL_CTX in the calling function */
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
+/* locked by the shard lock in the calling function */
+static void SSL_SESSION_list_remove(SSL_SESS_SHARD *shard, SSL_SESSION *s)
 {
     if ((s->next == NULL) || (s->prev == NULL))
         return;
 
-    if (s->next == (SSL_SESSION *)&(ctx->session_cache_tail)) {
+    if (s->next == (SSL_SESSION *)&(shard->session_cache_tail)) {
         /* last element in list */
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->session_cache_head)) {
             /* only one element in list */
-            ctx->session_cache_head = NULL;
-            ctx->session_cache_tail = NULL;
+            shard->session_cache_head = NULL;
+            shard->session_cache_tail = NULL;
         } else {
-            ctx->session_cache_tail = s->prev;
-            s->prev->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+            shard->session_cache_tail = s->prev;
+            s->prev->next = (SSL_SESSION *)&(shard->session_cache_tail);
         }
     } else {
-        if (s->prev == (SSL_SESSION *)&(ctx->session_cache_head)) {
+        if (s->prev == (SSL_SESSION *)&(shard->session_cache_head)) {
             /* first element in list */
-            ctx->session_cache_head = s->next;
-            s->next->prev = (SSL_SESSION *)&(ctx->session_cache_head);
+            shard->session_cache_head = s->next;
+            s->next->prev = (SSL_SESSION *)&(shard->session_cache_head);
         } else {
             /* middle of list */
             s->next->prev = s->prev;
             s->prev->next = s->next;
         }
     }
+    ossl_timer_wheel_remove(shard->expiry, &s->expiry_entry);
     s->prev = s->next = NULL;
     s->owner = NULL;
+    s->shard = NULL;
 }
 
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s)
+/*
+ * Puts |s| at the head of the shard's list, where the sessions evicted when
+ * the cache is full are taken from the tail, and (re)arms its expiry timer.
+ * Both are constant time, so updating a session's time or timeout is cheap.
+ */
+static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESS_SHARD *shard,
+                                 SSL_SESSION *s)
 {
-    SSL_SESSION *next;
-
     if ((s->next != NULL) && (s->prev != NULL))
-        SSL_SESSION_list_remove(ctx, s);
+        SSL_SESSION_list_remove(shard, s);
 
-    if (ctx->session_cache_head == NULL) {
-        ctx->session_cache_head = s;
-        ctx->session_cache_tail = s;
-        s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-        s->next = (SSL_SESSION *)&(ctx->session_cache_tail);
+    if (shard->session_cache_head == NULL) {
+        shard->session_cache_head = s;
+        shard->session_cache_tail = s;
+        s->prev = (SSL_SESSION *)&(shard->session_cache_head);
+        s->next = (SSL_SESSION *)&(shard->session_cache_tail);
     } else {
-        if (timeoutcmp(s, ctx->session_cache_head) >= 0) {
-            /*
-             * if we timeout after (or the same time as) the first
-             * session, put us first - usual case
-             */
-            s->next = ctx->session_cache_head;
-            s->next->prev = s;
-            s->prev = (SSL_SESSION *)&(ctx->session_cache_head);
-            ctx->session_cache_head = s;
-        } else if (timeoutcmp(s, ctx->session_cache_tail) < 0) {
-            /* if we timeout before the last session, put us last */
-            s->prev = ctx->session_cache_tail;
-            s->prev->next = s;
-            s->next = (SSL_SESSION *)&(ctx->session_cache_tail);
-            ctx->session_cache_tail = s;
-        } else {
-            /*
-             * we timeout somewhere in-between - if there is only
-             * one session in the cache it will be caught above
-             */
-            next = ctx->session_cache_head->next;
-            while (next != (SSL_SESSION*)&(ctx->session_cache_tail)) {
-                if (timeoutcmp(s, next) >= 0) {
-                    s->next = next;
-                    s->prev = next->prev;
-                    next->prev->next = s;
-                    next->prev = s;
-                    break;
-                }
-                next = next->next;
-            }
-        }
+        s->next = shard->session_cache_head;
+        s->next->prev = s;
+        s->prev = (SSL_SESSION *)&(shard->session_cache_head);
+        shard->session_cache_head = s;
     }
+    ossl_timer_wheel_add(shard->expiry, &s->expiry_entry, s->calc_timeout);
     s->owner = ctx;
+    s->shard = shard;
 }
 
 void SSL_CTX_sess_set_new_cb(SSL_CTX *ctx,
@@ -0,0 +1,408 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * A session cache in shared memory, so that server processes forked from a
+ * common parent, or unrelated processes mapping the same file, can resume
+ * each other's sessions.
+ *
+ * The mapping holds a small header followed by fixed size slots. Slots are
+ * grouped into buckets of SHM_SESS_WAYS and a session ID always maps to the
+ * same bucket. Each slot holds the session ID, the expiry time and the DER
+ * encoding of the session.
+ *
+ * Every slot is protected by a sequence lock: a writer claims the slot by
+ * atomically moving its sequence number from even to odd and releases it by
+ * making it even again. Readers never block; they copy the slot and retry or
+ * give up if the sequence number was odd or changed under them. A writer that
+ * finds a slot busy simply does not store the session, it is only a cache.
+ */
+
+#include "internal/e_os.h"
+#include <string.h>
+#include <time.h>
+#include <openssl/err.h>
+#include "ssl_local.h"
+
+#if defined(OPENSSL_SYS_UNIX) && defined(__GNUC__) \
+    && defined(__ATOMIC_ACQ_REL) && !defined(BROKEN_CLANG_ATOMICS)
+# define SHM_SESS_SUPPORTED
+#endif
+
+#ifdef SHM_SESS_SUPPORTED
+
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# if !defined(MAP_ANON) && defined(MAP_ANONYMOUS)
+#  define MAP_ANON MAP_ANONYMOUS
+# endif
+
+# define SHM_SESS_MAGIC             0x4f53534cU
+# define SHM_SESS_VERSION           1
+# define SHM_SESS_WAYS              4
+# define SHM_SESS_DEFAULT_SLOT_SIZE 4096
+/* A reader gives up on a slot that keeps changing under it */
+# define SHM_SESS_READ_RETRIES      4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_slots;
+    uint64_t slot_size;
+    unsigned char pad[40];
+} SHM_SESS_HEADER;
+
+typedef struct {
+    uint32_t seq;           /* Odd while a writer is updating the slot */
+    uint32_t der_len;       /* 0 if the slot is empty */
+    int64_t expiry;         /* time_t after which the session is stale */
+    unsigned char id_len;
+    unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    /* The DER encoded session follows, aligned to 8 bytes */
+} SHM_SESS_SLOT;
+
+# define SHM_SESS_SLOT_HDR_LEN  ((sizeof(SHM_SESS_SLOT) + 7) & ~(size_t)7)
+
+struct ssl_shm_sess_cache_st {
+    unsigned char *base;
+    size_t map_len;
+    size_t num_buckets;
+    size_t slot_size;
+};
+
+static SHM_SESS_SLOT *shm_slot(const SSL_SHM_SESS_CACHE *c, size_t i)
+{
+    return (SHM_SESS_SLOT *)(c->base + sizeof(SHM_SESS_HEADER)
+                             + i * c->slot_size);
+}
+
+static unsigned char *shm_slot_der(SHM_SESS_SLOT *slot)
+{
+    return (unsigned char *)slot + SHM_SESS_SLOT_HDR_LEN;
+}
+
+/* FNV-1a, the session IDs are random so anything cheap will do */
+static size_t shm_bucket(const SSL_SHM_SESS_CACHE *c,
+                         const unsigned char *id, size_t id_len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    for (i = 0; i < id_len; i++) {
+        h ^= id[i];
+        h *= 0x100000001b3ULL;
+    }
+    return (size_t)(h % c->num_buckets) * SHM_SESS_WAYS;
+}
+
+static int shm_slot_lock(SHM_SESS_SLOT *slot, uint32_t *seq)
+{
+    uint32_t s = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+    if ((s & 1) != 0
+            || !__atomic_compare_exchange_n(&slot->seq, &s, s + 1, 0,
+                                            __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
+        return 0;
+    *seq = s;
+    return 1;
+}
+
+static void shm_slot_unlock(SHM_SESS_SLOT *slot, uint32_t seq)
+{
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static int shm_slot_matches(const SHM_SESS_SLOT *slot,
+                            const unsigned char *id, size_t id_len)
+{
+    return slot->der_len != 0 && slot->id_len == id_len
+        && memcmp(slot->id, id, id_len) == 0;
+}
+
+void ssl_shm_sess_cache_free(SSL_SHM_SESS_CACHE *c)
+{
+    if (c == NULL)
+        return;
+    munmap(c->base, c->map_len);
+    OPENSSL_free(c);
+}
+
+static SSL_SHM_SESS_CACHE *shm_sess_cache_new(const char *path,
+                                              size_t num_slots,
+                                              size_t slot_size)
+{
+    SSL_SHM_SESS_CACHE *c;
+    SHM_SESS_HEADER *hdr;
+    struct stat st;
+    int fd = -1, init = 1;
+    void *p;
+
+    if (slot_size == 0)
+        slot_size = SHM_SESS_DEFAULT_SLOT_SIZE;
+    slot_size = (slot_size + 7) & ~(size_t)7;
+    num_slots -= num_slots % SHM_SESS_WAYS;
+    if (num_slots == 0 || slot_size <= SHM_SESS_SLOT_HDR_LEN
+            || num_slots > (SIZE_MAX - sizeof(*hdr)) / slot_size) {
+        ERR_raise(ERR_LIB_SSL, ERR_R_PASSED_INVALID_ARGUMENT);
+        return NULL;
+    }
+
+    if ((c = OPENSSL_zalloc(sizeof(*c))) == NULL)
+        return NULL;
+    c->map_len = sizeof(*hdr) + num_slots * slot_size;
+    c->num_buckets = num_slots / SHM_SESS_WAYS;
+    c->slot_size = slot_size;
+
+    if (path == NULL) {
+        /* Anonymous shared memory, shared with the processes forked later */
+        p = mmap(NULL, c->map_len, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANON, -1, 0);
+    } else {
+        fd = open(path, O_RDWR | O_CREAT, 0600);
+        if (fd < 0) {
+            ERR_raise_data(ERR_LIB_SYS, errno, "calling open(%s)", path);
+            goto err;
+        }
+        if (fstat(fd, &st) != 0) {
+            ERR_raise_data(ERR_LIB_SYS, errno, "calling fstat(%s)", path);
+            goto err;
+        }
+        if (st.st_size == 0) {
+            if (ftruncate(fd, (off_t)c->map_len) != 0) {
+                ERR_raise_data(ERR_LIB_SYS, errno, "calling ftruncate(%s)",
+                               path);
+                goto err;
+            }
+        } else if ((size_t)st.st_size != c->map_len) {
+            ERR_raise_data(ERR_LIB_SSL, ERR_R_PASSED_INVALID_ARGUMENT,
+                           "%s has a different size", path);
+            goto err;
+        } else {
+            init = 0;
+        }
+        p = mmap(NULL, c->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        fd = -1;
+    }
+    if (p == MAP_FAILED) {
+        ERR_raise_data(ERR_LIB_SYS, errno, "calling mmap()");
+        goto err;
+    }
+    c->base = p;
+    hdr = (SHM_SESS_HEADER *)c->base;
+
+    if (init) {
+        /* Fresh mappings are zero filled, which is a valid empty cache */
+        hdr->version = SHM_SESS_VERSION;
+        hdr->num_slots = num_slots;
+        hdr->slot_size = slot_size;
+        __atomic_store_n(&hdr->magic, SHM_SESS_MAGIC, __ATOMIC_RELEASE);
+    } else if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_SESS_MAGIC
+               || hdr->version != SHM_SESS_VERSION
+               || hdr->num_slots != num_slots
+               || hdr->slot_size != slot_size) {
+        ERR_raise_data(ERR_LIB_SSL, ERR_R_PASSED_INVALID_ARGUMENT,
+                       "%s has a different layout", path);
+        goto err;
+    }
+    return c;
+
+ err:
+    if (fd >= 0)
+        close(fd);
+    if (c->base != NULL)
+        munmap(c->base, c->map_len);
+    OPENSSL_free(c);
+    return NULL;
+}
+
+void ssl_shm_sess_cache_add(SSL_SHM_SESS_CACHE *c, SSL_SESSION *sess)
+{
+    SHM_SESS_SLOT *slot, *victim = NULL;
+    unsigned char *der = NULL, *p;
+    int der_len;
+    size_t i, bucket;
+    int64_t now = (int64_t)time(NULL);
+    uint32_t seq;
+
+    if (sess->session_id_length == 0)
+        return;
+
+    der_len = i2d_SSL_SESSION(sess, NULL);
+    if (der_len <= 0
+            || (size_t)der_len > c->slot_size - SHM_SESS_SLOT_HDR_LEN
+            || (der = OPENSSL_malloc(der_len)) == NULL)
+        return;
+    p = der;
+    if (i2d_SSL_SESSION(sess, &p) != der_len)
+        goto end;
+
+    /*
+     * Reuse the slot already holding this session if there is one, else
+     * an empty or stale slot, else the slot that would expire first.
+     */
+    bucket = shm_bucket(c, sess->session_id, sess->session_id_length);
+    for (i = 0; i < SHM_SESS_WAYS; i++) {
+        slot = shm_slot(c, bucket + i);
+        if (shm_slot_matches(slot, sess->session_id,
+                             sess->session_id_length)) {
+            victim = slot;
+            break;
+        }
+        if (victim == NULL
+                || (victim->der_len != 0 && victim->expiry > now
+                    && (slot->der_len == 0 || slot->expiry < victim->expiry)))
+            victim = slot;
+    }
+
+    if (!shm_slot_lock(victim, &seq))
+        goto end;
+    victim->der_len = (uint32_t)der_len;
+    victim->expiry = (int64_t)ossl_time_to_time_t(sess->calc_timeout);
+    victim->id_len = (unsigned char)sess->session_id_length;
+    memcpy(victim->id, sess->session_id, sess->session_id_length);
+    memcpy(shm_slot_der(victim), der, der_len);
+    shm_slot_unlock(victim, seq);
+
+ end:
+    OPENSSL_free(der);
+}
+
+SSL_SESSION *ssl_shm_sess_cache_get(SSL_SHM_SESS_CACHE *c,
+                                    const unsigned char *id, size_t id_len)
+{
+    SHM_SESS_SLOT *slot;
+    SSL_SESSION *ret = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    size_t i, bucket, der_len;
+    int64_t expiry;
+    uint32_t seq;
+    int tries;
+
+    if (id_len == 0 || id_len > SSL_MAX_SSL_SESSION_ID_LENGTH)
+        return NULL;
+
+    bucket = shm_bucket(c, id, id_len);
+    for (i = 0; i < SHM_SESS_WAYS; i++) {
+        slot = shm_slot(c, bucket + i);
+        for (tries = 0; tries < SHM_SESS_READ_RETRIES; tries++) {
+            seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            if ((seq & 1) != 0)
+                continue;
+            if (!shm_slot_matches(slot, id, id_len))
+                break;
+            der_len = slot->der_len;
+            expiry = slot->expiry;
+            if (der_len > c->slot_size - SHM_SESS_SLOT_HDR_LEN)
+                continue;
+            OPENSSL_free(der);
+            if ((der = OPENSSL_malloc(der_len)) == NULL)
+                return NULL;
+            memcpy(der, shm_slot_der(slot), der_len);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+                continue;
+
+            /* A consistent copy, the rest can be done outside the slot */
+            if (expiry > (int64_t)time(NULL)) {
+                p = der;
+                ret = d2i_SSL_SESSION(NULL, &p, (long)der_len);
+                /* The session ID is checked in case of a corrupt slot */
+                if (ret != NULL
+                        && (ret->session_id_length != id_len
+                            || memcmp(ret->session_id, id, id_len) != 0)) {
+                    SSL_SESSION_free(ret);
+                    ret = NULL;
+                }
+            }
+            OPENSSL_free(der);
+            return ret;
+        }
+    }
+    OPENSSL_free(der);
+    return NULL;
+}
+
+void ssl_shm_sess_cache_remove(SSL_SHM_SESS_CACHE *c,
+                               const unsigned char *id, size_t id_len)
+{
+    SHM_SESS_SLOT *slot;
+    size_t i, bucket;
+    uint32_t seq;
+
+    if (id_len == 0 || id_len > SSL_MAX_SSL_SESSION_ID_LENGTH)
+        return;
+
+    bucket = shm_bucket(c, id, id_len);
+    for (i = 0; i < SHM_SESS_WAYS; i++) {
+        slot = shm_slot(c, bucket + i);
+        if (!shm_slot_matches(slot, id, id_len) || !shm_slot_lock(slot, &seq))
+            continue;
+        /* Check again now that nobody else can change the slot */
+        if (shm_slot_matches(slot, id, id_len))
+            slot->der_len = 0;
+        shm_slot_unlock(slot, seq);
+    }
+}
+
+int SSL_CTX_set_shared_session_cache(SSL_CTX *ctx, const char *path,
+                                     size_t num_slots, size_t slot_size)
+{
+    SSL_SHM_SESS_CACHE *c = NULL;
+
+    if (IS_QUIC_CTX(ctx)) {
+        ERR_raise(ERR_LIB_SSL, SSL_R_WRONG_SSL_VERSION);
+        return 0;
+    }
+
+    if (num_slots != 0
+            && (c = shm_sess_cache_new(path, num_slots, slot_size)) == NULL)
+        return 0;
+
+    ssl_shm_sess_cache_free(ctx->shm_sess_cache);
+    ctx->shm_sess_cache = c;
+    return 1;
+}
+
+#else
+
+void ssl_shm_sess_cache_free(SSL_SHM_SESS_CACHE *c)
+{
+}
+
+void ssl_shm_sess_cache_add(SSL_SHM_SESS_CACHE *c, SSL_SESSION *sess)
+{
+}
+
+SSL_SESSION *ssl_shm_sess_cache_get(SSL_SHM_SESS_CACHE *c,
+                                    const unsigned char *id, size_t id_len)
+{
+    return NULL;
+}
+
+void ssl_shm_sess_cache_remove(SSL_SHM_SESS_CACHE *c,
+                               const unsigned char *id, size_t id_len)
+{
+}
+
+int SSL_CTX_set_shared_session_cache(SSL_CTX *ctx, const char *path,
+                                     size_t num_slots, size_t slot_size)
+{
+    if (num_slots == 0)
+        return 1;
+    ERR_raise(ERR_LIB_SSL, ERR_R_UNSUPPORTED);
+    return 0;
+}
+
+#endif
@@ -965,15 +965,6 @@ static int final_renegotiate(SSL_CONNECTION *s, unsigned int context, int sent)
     return 1;
 }
 
-static ossl_inline void ssl_tsan_decr(const SSL_CTX *ctx,
-                                      TSAN_QUALIFIER int *stat)
-{
-    if (ssl_tsan_lock(ctx)) {
-        tsan_decr(stat);
-        ssl_tsan_unlock(ctx);
-    }
-}
-
 static int init_server_name(SSL_CONNECTION *s, unsigned int context)
 {
     if (s->server) {
@@ -1709,6 +1700,24 @@ int tls_psk_do_binder(SSL_CONNECTION *s, const EVP_MD *md,
     return ret;
 }
 
+/*
+ * A QUIC server must not accept 0-RTT data sent under transport parameters
+ * that it would now reduce or change (RFC 9000 s. 7.4.1), so it only does so
+ * if the session was issued with the same ones as it is sending now.
+ */
+static int quic_early_transport_params_match(const SSL_CONNECTION *s)
+{
+    const SSL_SESSION *sess = s->session;
+
+    return s->ext.quic_early_transport_params != NULL
+        && sess->ext.quic_transport_params != NULL
+        && sess->ext.quic_transport_params_len
+           == s->ext.quic_early_transport_params_len
+        && memcmp(sess->ext.quic_transport_params,
+                  s->ext.quic_early_transport_params,
+                  s->ext.quic_early_transport_params_len) == 0;
+}
+
 static int final_early_data(SSL_CONNECTION *s, unsigned int context, int sent)
 {
     if (!sent)
@@ -1735,6 +1744,8 @@ static int final_early_data(SSL_CONNECTION *s, unsigned int context, int sent)
             || s->early_data_state != SSL_EARLY_DATA_ACCEPTING
             || !s->ext.early_data_ok
             || s->hello_retry_request != SSL_HRR_NONE
+            || (SSL_IS_QUIC_HANDSHAKE(s)
+                && !quic_early_transport_params_match(s))
             || (s->allow_early_data_cb != NULL
                 && !s->allow_early_data_cb(SSL_CONNECTION_GET_SSL(s),
                                          s->allow_early_data_cb_data))) {
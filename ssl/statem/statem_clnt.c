@@ -490,7 +490,9 @@ static WRITE_TRAN ossl_statem_client13_write_transition(SSL_CONNECTION *s)
         return WRITE_TRAN_CONTINUE;
 
     case TLS_ST_PENDING_EARLY_DATA_END:
-        if (s->ext.early_data == SSL_EARLY_DATA_ACCEPTED) {
+        /* QUIC does not use the EndOfEarlyData message (RFC 9001 s. 8.3) */
+        if (s->ext.early_data == SSL_EARLY_DATA_ACCEPTED
+                && !SSL_IS_QUIC_HANDSHAKE(s)) {
             st->hand_state = TLS_ST_CW_END_OF_EARLY_DATA;
             return WRITE_TRAN_CONTINUE;
         }
@@ -1796,10 +1798,11 @@ MSG_PROCESS_RETURN tls_process_server_hello(SSL_CONNECTION *s, PACKET *pkt)
          * immediately. Otherwise we have to defer this until after all possible
          * early data is written. We could just always defer until the last
          * moment except QUIC needs it done at the same time as the read keys
-         * are changed. Since QUIC doesn't do TLS early data or need middlebox
-         * compat this doesn't cause a problem.
+         * are changed. QUIC never needs middlebox compat, and its 0-RTT data
+         * is not sent via TLS records, so it can always change them now.
          */
-        if (s->early_data_state == SSL_EARLY_DATA_NONE
+        if ((s->early_data_state == SSL_EARLY_DATA_NONE
+                    || SSL_IS_QUIC_HANDSHAKE(s))
                 && (s->options & SSL_OP_ENABLE_MIDDLEBOX_COMPAT) == 0
                 && !ssl->method->ssl3_enc->change_cipher_state(s,
                     SSL3_CC_HANDSHAKE | SSL3_CHANGE_CIPHER_CLIENT_WRITE)) {
@@ -2787,6 +2790,25 @@ MSG_PROCESS_RETURN tls_process_new_session_ticket(SSL_CONNECTION *s,
             /* SSLfatal() already called */
             goto err;
         }
+
+        /*
+         * A QUIC client must remember the server's transport parameters
+         * alongside the ticket in order to use it for 0-RTT (RFC 9000 s. 7.4.1)
+         */
+        if (SSL_IS_QUIC_HANDSHAKE(s)
+                && s->ext.peer_quic_transport_params != NULL) {
+            OPENSSL_free(s->session->ext.quic_transport_params);
+            s->session->ext.quic_transport_params
+                = OPENSSL_memdup(s->ext.peer_quic_transport_params,
+                                 s->ext.peer_quic_transport_params_len);
+            if (s->session->ext.quic_transport_params == NULL) {
+                s->session->ext.quic_transport_params_len = 0;
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_CRYPTO_LIB);
+                goto err;
+            }
+            s->session->ext.quic_transport_params_len
+                = s->ext.peer_quic_transport_params_len;
+        }
     }
 
     /*
@@ -3797,7 +3819,8 @@ CON_FUNC_RETURN tls_construct_client_certificate(SSL_CONNECTION *s,
      */
     if (SSL_CONNECTION_IS_TLS13(s)
             && SSL_IS_FIRST_HANDSHAKE(s)
-            && (s->early_data_state != SSL_EARLY_DATA_NONE
+            && ((s->early_data_state != SSL_EARLY_DATA_NONE
+                 && !SSL_IS_QUIC_HANDSHAKE(s))
                 || (s->options & SSL_OP_ENABLE_MIDDLEBOX_COMPAT) != 0)
             && (!ssl->method->ssl3_enc->change_cipher_state(s,
                     SSL3_CC_HANDSHAKE | SSL3_CHANGE_CIPHER_CLIENT_WRITE))) {
@@ -3886,7 +3909,8 @@ CON_FUNC_RETURN tls_construct_client_compressed_certificate(SSL_CONNECTION *sc,
      * moment. We need to do it now.
      */
     if (SSL_IS_FIRST_HANDSHAKE(sc)
-            && (sc->early_data_state != SSL_EARLY_DATA_NONE
+            && ((sc->early_data_state != SSL_EARLY_DATA_NONE
+                 && !SSL_IS_QUIC_HANDSHAKE(sc))
                 || (sc->options & SSL_OP_ENABLE_MIDDLEBOX_COMPAT) != 0)
             && (!ssl->method->ssl3_enc->change_cipher_state(sc,
                     SSL3_CC_HANDSHAKE | SSL3_CHANGE_CIPHER_CLIENT_WRITE))) {
@@ -82,7 +82,9 @@ static int ossl_statem_server13_read_transition(SSL_CONNECTION *s, int mt)
                 return 1;
             }
             break;
-        } else if (s->ext.early_data == SSL_EARLY_DATA_ACCEPTED) {
+        } else if (s->ext.early_data == SSL_EARLY_DATA_ACCEPTED
+                   && !SSL_IS_QUIC_HANDSHAKE(s)) {
+            /* QUIC does not use the EndOfEarlyData message (RFC 9001 s. 8.3) */
             if (mt == SSL3_MT_END_OF_EARLY_DATA) {
                 st->hand_state = TLS_ST_SR_END_OF_EARLY_DATA;
                 return 1;
@@ -964,7 +966,14 @@ WORK_STATE ossl_statem_server_post_work(SSL_CONNECTION *s, WORK_STATE wst)
                 return WORK_ERROR;
             }
 
-            if (s->ext.early_data != SSL_EARLY_DATA_ACCEPTED
+            /*
+             * If we accepted early data we would normally wait for the
+             * EndOfEarlyData message before changing the read keys. QUIC has
+             * no such message, and reads early data and handshake data at
+             * different encryption levels, so it changes them now.
+             */
+            if ((s->ext.early_data != SSL_EARLY_DATA_ACCEPTED
+                 || SSL_IS_QUIC_HANDSHAKE(s))
                 && !ssl->method->ssl3_enc->change_cipher_state(s,
                         SSL3_CC_HANDSHAKE |SSL3_CHANGE_CIPHER_SERVER_READ)) {
                 /* SSLfatal() already called */
@@ -4241,6 +4250,25 @@ CON_FUNC_RETURN tls_construct_new_session_ticket(SSL_CONNECTION *s, WPACKET *pkt
             s->session->ext.alpn_selected_len = s->s3.alpn_selected_len;
         }
         s->session->ext.max_early_data = s->max_early_data;
+
+        /*
+         * A QUIC server remembers which transport parameters the client may
+         * rely on when it uses this ticket for 0-RTT (RFC 9000 s. 7.4.1)
+         */
+        if (SSL_IS_QUIC_HANDSHAKE(s)
+                && s->ext.quic_early_transport_params != NULL) {
+            OPENSSL_free(s->session->ext.quic_transport_params);
+            s->session->ext.quic_transport_params =
+                OPENSSL_memdup(s->ext.quic_early_transport_params,
+                               s->ext.quic_early_transport_params_len);
+            if (s->session->ext.quic_transport_params == NULL) {
+                s->session->ext.quic_transport_params_len = 0;
+                SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_CRYPTO_LIB);
+                goto err;
+            }
+            s->session->ext.quic_transport_params_len
+                = s->ext.quic_early_transport_params_len;
+        }
     }
 
     if (tctx->generate_ticket_cb != NULL &&
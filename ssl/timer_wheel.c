@@ -0,0 +1,258 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include "internal/common.h"
+#include "internal/timer_wheel.h"
+
+/*
+ * Six levels of 64 slots cover 2^36 ticks, which is over two years with a one
+ * millisecond granularity. Anything further out is parked and refiled.
+ */
+#define TW_LEVEL_BITS   6
+#define TW_SLOTS        (1 << TW_LEVEL_BITS)
+#define TW_SLOT_MASK    (TW_SLOTS - 1)
+#define TW_LEVELS       6
+
+struct ossl_timer_wheel_st {
+    OSSL_TIMER_WHEEL_ENTRY *slots[TW_LEVELS][TW_SLOTS];
+    size_t level_num[TW_LEVELS];
+    size_t num;
+    uint64_t granularity;   /* Length of a tick in OSSL_TIME ticks */
+    uint64_t cur;           /* The current tick */
+};
+
+static uint64_t tw_tick(const OSSL_TIMER_WHEEL *tw, OSSL_TIME t)
+{
+    return ossl_time2ticks(t) / tw->granularity;
+}
+
+static void tw_link(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e,
+                    size_t level, size_t slot)
+{
+    e->prev = NULL;
+    e->next = tw->slots[level][slot];
+    if (e->next != NULL)
+        e->next->prev = e;
+    tw->slots[level][slot] = e;
+    e->level = (unsigned char)level;
+    e->slot = (unsigned char)slot;
+    e->armed = 1;
+    tw->level_num[level]++;
+    tw->num++;
+}
+
+static void tw_unlink(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e)
+{
+    if (e->prev != NULL)
+        e->prev->next = e->next;
+    else
+        tw->slots[e->level][e->slot] = e->next;
+    if (e->next != NULL)
+        e->next->prev = e->prev;
+    e->prev = e->next = NULL;
+    e->armed = 0;
+    tw->level_num[e->level]--;
+    tw->num--;
+}
+
+/* Files |e| in the slot matching its expiry relative to the current tick */
+static void tw_file(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e)
+{
+    uint64_t t = tw_tick(tw, e->expiry), diff;
+    size_t level = 0, slot;
+
+    if (t <= tw->cur) {
+        /* Already due, it goes in the slot that is looked at next */
+        tw_link(tw, e, 0, (size_t)(tw->cur & TW_SLOT_MASK));
+        return;
+    }
+
+    /*
+     * The entry goes on the lowest level at which its tick and the current
+     * tick only differ in that level's slot index. That slot is always ahead
+     * of the current one on its level, so it is refiled before it is due.
+     */
+    diff = t ^ tw->cur;
+    while (level < TW_LEVELS - 1
+           && (diff >> (TW_LEVEL_BITS * (level + 1))) != 0)
+        level++;
+
+    if ((diff >> (TW_LEVEL_BITS * TW_LEVELS)) != 0)
+        /* Too far out, park it in the top level slot that is reached last */
+        slot = (size_t)(((tw->cur >> (TW_LEVEL_BITS * level)) - 1)
+                        & TW_SLOT_MASK);
+    else
+        slot = (size_t)((t >> (TW_LEVEL_BITS * level)) & TW_SLOT_MASK);
+
+    tw_link(tw, e, level, slot);
+}
+
+/*
+ * Called after the current tick has moved onto a slot boundary: every higher
+ * level slot that has just been reached is emptied into the lower levels.
+ */
+static void tw_cascade(OSSL_TIMER_WHEEL *tw)
+{
+    OSSL_TIMER_WHEEL_ENTRY *e, *next;
+    size_t level, slot;
+
+    for (level = TW_LEVELS - 1; level > 0; level--) {
+        if ((tw->cur & ((1ULL << (TW_LEVEL_BITS * level)) - 1)) != 0)
+            continue;
+
+        slot = (size_t)((tw->cur >> (TW_LEVEL_BITS * level)) & TW_SLOT_MASK);
+        e = tw->slots[level][slot];
+        tw->slots[level][slot] = NULL;
+        for (; e != NULL; e = next) {
+            next = e->next;
+            e->prev = e->next = NULL;
+            tw->level_num[level]--;
+            tw->num--;
+            tw_file(tw, e);
+        }
+    }
+}
+
+OSSL_TIMER_WHEEL *ossl_timer_wheel_new(OSSL_TIME granularity, OSSL_TIME now)
+{
+    OSSL_TIMER_WHEEL *tw;
+
+    if (ossl_time_is_zero(granularity))
+        return NULL;
+
+    if ((tw = OPENSSL_zalloc(sizeof(*tw))) == NULL)
+        return NULL;
+
+    tw->granularity = ossl_time2ticks(granularity);
+    tw->cur = tw_tick(tw, now);
+    return tw;
+}
+
+void ossl_timer_wheel_free(OSSL_TIMER_WHEEL *tw)
+{
+    OPENSSL_free(tw);
+}
+
+void ossl_timer_wheel_entry_init(OSSL_TIMER_WHEEL_ENTRY *e, void *data)
+{
+    memset(e, 0, sizeof(*e));
+    e->data = data;
+}
+
+int ossl_timer_wheel_entry_armed(const OSSL_TIMER_WHEEL_ENTRY *e)
+{
+    return e->armed;
+}
+
+void ossl_timer_wheel_add(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e,
+                          OSSL_TIME expiry)
+{
+    if (e->armed)
+        tw_unlink(tw, e);
+    e->expiry = expiry;
+    tw_file(tw, e);
+}
+
+void ossl_timer_wheel_remove(OSSL_TIMER_WHEEL *tw, OSSL_TIMER_WHEEL_ENTRY *e)
+{
+    if (e->armed)
+        tw_unlink(tw, e);
+}
+
+void *ossl_timer_wheel_expire(OSSL_TIMER_WHEEL *tw, OSSL_TIME now)
+{
+    OSSL_TIMER_WHEEL_ENTRY *e;
+    uint64_t now_tick = tw_tick(tw, now), next;
+    size_t level;
+
+    for (;;) {
+        /*
+         * Everything in the current slot is due in the current tick or
+         * before, but only the entries that are strictly before |now| go.
+         */
+        for (e = tw->slots[0][tw->cur & TW_SLOT_MASK]; e != NULL; e = e->next)
+            if (ossl_time_compare(now, e->expiry) > 0) {
+                tw_unlink(tw, e);
+                return e->data;
+            }
+
+        if (tw->cur >= now_tick)
+            return NULL;
+
+        /*
+         * Nothing changes before the next slot boundary of the lowest level
+         * that holds any entries, so jump straight there.
+         */
+        for (level = 0; level < TW_LEVELS && tw->level_num[level] == 0; level++)
+            continue;
+        if (level == TW_LEVELS) {
+            tw->cur = now_tick;
+            return NULL;
+        }
+        next = ((tw->cur >> (TW_LEVEL_BITS * level)) + 1)
+               << (TW_LEVEL_BITS * level);
+        if (next > now_tick) {
+            tw->cur = now_tick;
+        } else {
+            tw->cur = next;
+            tw_cascade(tw);
+        }
+    }
+}
+
+OSSL_TIME ossl_timer_wheel_next_expiry(const OSSL_TIMER_WHEEL *tw)
+{
+    OSSL_TIMER_WHEEL_ENTRY *e;
+    OSSL_TIME t = ossl_time_infinite();
+    uint64_t tick;
+    size_t level, k, slot, shift;
+
+    for (level = 0; level < TW_LEVELS && tw->level_num[level] == 0; level++)
+        continue;
+    if (level == TW_LEVELS)
+        return t;
+
+    /*
+     * Slots behind the current one on a level are always empty, as is the
+     * current slot on the higher levels, so the first occupied slot ahead
+     * holds the earliest entries on this level and all higher levels are
+     * later still.
+     */
+    shift = TW_LEVEL_BITS * level;
+    for (k = (level == 0 ? 0 : 1); k < TW_SLOTS; k++) {
+        slot = (size_t)(((tw->cur >> shift) + k) & TW_SLOT_MASK);
+        if (tw->slots[level][slot] != NULL)
+            break;
+    }
+    if (!ossl_assert(k < TW_SLOTS))
+        return t;
+
+    if (level == 0) {
+        for (e = tw->slots[0][slot]; e != NULL; e = e->next)
+            t = ossl_time_min(t, e->expiry);
+        return t;
+    }
+
+    /*
+     * Entries on higher levels are only known to the slot, so report the
+     * start of the slot, when they are moved down to where they can be told
+     * apart.
+     */
+    tick = ((tw->cur >> shift) + k) << shift;
+    if (tick > UINT64_MAX / tw->granularity)
+        return t;
+    return ossl_ticks2time(tick * tw->granularity);
+}
+
+size_t ossl_timer_wheel_num(const OSSL_TIMER_WHEEL *tw)
+{
+    return tw->num;
+}
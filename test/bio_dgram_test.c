@@ -452,6 +452,117 @@ static int test_bio_dgram(int idx)
                                bio_dgram_cases[idx].local);
 }
 
+static int test_bio_dgram_gso(void)
+{
+    int testresult = 0, enable = 0;
+    BIO *b1 = NULL, *b2 = NULL;
+    int fd1 = -1, fd2 = -1;
+    BIO_ADDR *addr1 = NULL, *addr2 = NULL;
+    struct in_addr ina;
+    union BIO_sock_info_u info1 = {0}, info2 = {0};
+    unsigned char tx_buf[250], rx_buf[512];
+    BIO_MSG tx_msg, rx_msg;
+    size_t i, num_processed = 0, rx_len = 0, seg_len, off, len;
+
+    ina.s_addr = htonl(0x7f000001UL);
+
+    if (!TEST_ptr(addr1 = BIO_ADDR_new())
+        || !TEST_ptr(addr2 = BIO_ADDR_new())
+        || !TEST_int_eq(BIO_ADDR_rawmake(addr1, AF_INET, &ina, sizeof(ina), 0), 1)
+        || !TEST_int_eq(BIO_ADDR_rawmake(addr2, AF_INET, &ina, sizeof(ina), 0), 1))
+        goto err;
+
+    fd1 = BIO_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, 0);
+    fd2 = BIO_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, 0);
+    if (!TEST_int_ge(fd1, 0) || !TEST_int_ge(fd2, 0))
+        goto err;
+
+    if (BIO_bind(fd1, addr1, 0) <= 0 || BIO_bind(fd2, addr2, 0) <= 0) {
+        testresult = TEST_skip("BIO_bind() failed");
+        goto err;
+    }
+
+    info1.addr = addr1;
+    info2.addr = addr2;
+    if (!TEST_int_gt(BIO_sock_info(fd1, BIO_SOCK_INFO_ADDRESS, &info1), 0)
+        || !TEST_int_gt(BIO_sock_info(fd2, BIO_SOCK_INFO_ADDRESS, &info2), 0))
+        goto err;
+
+    if (!TEST_ptr(b1 = BIO_new_dgram(fd1, 1)))
+        goto err;
+    fd1 = -1;
+
+    if (!TEST_ptr(b2 = BIO_new_dgram(fd2, 1)))
+        goto err;
+    fd2 = -1;
+
+    if (BIO_dgram_get_gso_cap(b1) < 3) {
+        testresult = TEST_skip("UDP segmentation offload not supported");
+        goto err;
+    }
+
+    /* GRO is optional; datagrams must be intact either way. */
+    if (BIO_dgram_set_gro_enable(b2, 1)
+        && (!TEST_true(BIO_dgram_get_gro_enable(b2, &enable))
+            || !TEST_int_eq(enable, 1)))
+        goto err;
+
+    for (i = 0; i < sizeof(tx_buf); ++i)
+        tx_buf[i] = (unsigned char)i;
+
+    /* Send three datagrams of 100, 100 and 50 bytes in one message. */
+    tx_msg.data     = tx_buf;
+    tx_msg.data_len = sizeof(tx_buf);
+    tx_msg.peer     = addr2;
+    tx_msg.local    = NULL;
+    tx_msg.flags    = 100;
+    if (!TEST_true(do_sendmmsg(b1, &tx_msg, 1, 0, &num_processed))
+        || !TEST_size_t_eq(num_processed, 1)
+        || !TEST_size_t_eq(tx_msg.data_len, sizeof(tx_buf)))
+        goto err;
+
+    while (rx_len < sizeof(tx_buf)) {
+        rx_msg.data     = rx_buf;
+        rx_msg.data_len = sizeof(rx_buf);
+        rx_msg.peer     = NULL;
+        rx_msg.local    = NULL;
+        rx_msg.flags    = 0;
+
+        /* The socket is blocking, so only wait for one message at a time. */
+        if (!TEST_true(do_recvmmsg(b2, &rx_msg, 1, 0, &num_processed)))
+            goto err;
+
+        seg_len = BIO_MSG_SEGMENT_SIZE(rx_msg.flags);
+        if (seg_len == 0)
+            seg_len = rx_msg.data_len;
+
+        for (off = 0; off < rx_msg.data_len; off += len) {
+            len = rx_msg.data_len - off;
+            if (len > seg_len)
+                len = seg_len;
+
+            if (!TEST_size_t_eq(len, rx_len < 200 ? 100 : 50)
+                || !TEST_size_t_le(rx_len + len, sizeof(tx_buf))
+                || !TEST_mem_eq(rx_buf + off, len, tx_buf + rx_len, len))
+                goto err;
+
+            rx_len += len;
+        }
+    }
+
+    testresult = 1;
+err:
+    BIO_free(b1);
+    BIO_free(b2);
+    if (fd1 >= 0)
+        BIO_closesocket(fd1);
+    if (fd2 >= 0)
+        BIO_closesocket(fd2);
+    BIO_ADDR_free(addr1);
+    BIO_ADDR_free(addr2);
+    return testresult;
+}
+
 # if !defined(OPENSSL_NO_CHACHA)
 static int random_data(const uint32_t *key, uint8_t *data, size_t data_len, size_t offset)
 {
@@ -785,6 +896,7 @@ int setup_tests(void)
 
 #if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
     ADD_ALL_TESTS(test_bio_dgram, OSSL_NELEM(bio_dgram_cases));
+    ADD_TEST(test_bio_dgram_gso);
 # if !defined(OPENSSL_NO_CHACHA)
     ADD_ALL_TESTS(test_bio_dgram_pair, 3);
 # endif
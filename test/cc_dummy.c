@@ -104,6 +104,11 @@ static OSSL_TIME dummy_get_wakeup_deadline(OSSL_CC_DATA *cc)
     return ossl_time_infinite();
 }
 
+static uint64_t dummy_get_pacing_rate(OSSL_CC_DATA *cc)
+{
+    return 0;
+}
+
 static int dummy_on_data_sent(OSSL_CC_DATA *cc,
                               uint64_t num_bytes)
 {
@@ -143,6 +148,7 @@ const OSSL_CC_METHOD ossl_cc_dummy_method = {
     dummy_unbind_diagnostic,
     dummy_get_tx_allowance,
     dummy_get_wakeup_deadline,
+    dummy_get_pacing_rate,
     dummy_on_data_sent,
     dummy_on_data_acked,
     dummy_on_data_lost,
@@ -5534,6 +5534,133 @@ static int test_aes_gcm_ivlen_change_cve_2023_5363(void)
                            gcm_ct, sizeof(gcm_ct), gcm_tag, sizeof(gcm_tag));
 }
 
+static const char *aead_batch_ciphers[] = {
+    "AES-128-GCM",
+    "AES-256-GCM",
+    "AES-128-CCM",
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    "ChaCha20-Poly1305",
+#endif
+};
+
+#define AEAD_BATCH_NUM      3
+#define AEAD_BATCH_TAGLEN   16
+
+/*
+ * Seal a batch of messages with EVP_CipherAEADBatch(), check that the result
+ * matches sealing each message individually, then open the batch again and
+ * check that a corrupted tag is detected.
+ */
+static int test_evp_aead_batch(int idx)
+{
+    static const size_t msglen[AEAD_BATCH_NUM] = { 0, 17, 100 };
+    unsigned char key[32], pt[AEAD_BATCH_NUM][100], ct[AEAD_BATCH_NUM][100];
+    unsigned char dec[AEAD_BATCH_NUM][100], buf[100];
+    unsigned char nonce[AEAD_BATCH_NUM][16], aadbuf[AEAD_BATCH_NUM][13];
+    unsigned char tags[AEAD_BATCH_NUM][AEAD_BATCH_TAGLEN];
+    unsigned char tagbuf[AEAD_BATCH_TAGLEN];
+    const unsigned char *iv[AEAD_BATCH_NUM], *aad[AEAD_BATCH_NUM];
+    const unsigned char *in[AEAD_BATCH_NUM];
+    unsigned char *out[AEAD_BATCH_NUM], *tag[AEAD_BATCH_NUM];
+    size_t aadlen[AEAD_BATCH_NUM];
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER *type = NULL;
+    int ivlen, outl, finl, ccm, testresult = 0;
+    size_t i;
+
+    if ((type = EVP_CIPHER_fetch(testctx, aead_batch_ciphers[idx],
+                                 testpropq)) == NULL)
+        return TEST_skip("%s is not available", aead_batch_ciphers[idx]);
+    ccm = EVP_CIPHER_get_mode(type) == EVP_CIPH_CCM_MODE;
+
+    if (!TEST_ptr(ctx = EVP_CIPHER_CTX_new())
+            || !TEST_int_gt(RAND_bytes_ex(testctx, key, sizeof(key), 0), 0)
+            || !TEST_int_gt(RAND_bytes_ex(testctx, (unsigned char *)pt,
+                                          sizeof(pt), 0), 0)
+            || !TEST_int_gt(RAND_bytes_ex(testctx, (unsigned char *)nonce,
+                                          sizeof(nonce), 0), 0)
+            || !TEST_int_gt(RAND_bytes_ex(testctx, (unsigned char *)aadbuf,
+                                          sizeof(aadbuf), 0), 0))
+        goto err;
+
+    for (i = 0; i < AEAD_BATCH_NUM; i++) {
+        iv[i] = nonce[i];
+        aad[i] = aadbuf[i];
+        aadlen[i] = i == 1 ? 0 : sizeof(aadbuf[i]);
+        in[i] = pt[i];
+        out[i] = ct[i];
+        tag[i] = tags[i];
+    }
+
+    if (!TEST_true(EVP_EncryptInit_ex(ctx, type, NULL, NULL, NULL))
+            || (ccm && !TEST_int_gt(EVP_CIPHER_CTX_ctrl(ctx,
+                                                        EVP_CTRL_AEAD_SET_TAG,
+                                                        AEAD_BATCH_TAGLEN,
+                                                        NULL), 0))
+            || !TEST_true(EVP_EncryptInit_ex(ctx, NULL, NULL, key, NULL))
+            || !TEST_int_gt(ivlen = EVP_CIPHER_CTX_get_iv_length(ctx), 0)
+            || !TEST_true(EVP_CipherAEADBatch(ctx, AEAD_BATCH_NUM, iv, ivlen,
+                                              aad, aadlen, in, msglen, out,
+                                              tag, AEAD_BATCH_TAGLEN)))
+        goto err;
+
+    /* Each message must match the result of sealing it on its own */
+    for (i = 0; i < AEAD_BATCH_NUM; i++) {
+        if (!TEST_true(EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, nonce[i]))
+                || (ccm && !TEST_true(EVP_EncryptUpdate(ctx, NULL, &outl, NULL,
+                                                        (int)msglen[i])))
+                || (aadlen[i] > 0
+                    && !TEST_true(EVP_EncryptUpdate(ctx, NULL, &outl, aad[i],
+                                                    (int)aadlen[i])))
+                || !TEST_true(EVP_EncryptUpdate(ctx, buf, &outl, pt[i],
+                                                (int)msglen[i]))
+                || !TEST_true(EVP_EncryptFinal_ex(ctx, buf + outl, &finl))
+                || !TEST_int_gt(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                                    AEAD_BATCH_TAGLEN, tagbuf),
+                                0)
+                || !TEST_mem_eq(buf, outl + finl, ct[i], msglen[i])
+                || !TEST_mem_eq(tagbuf, sizeof(tagbuf), tags[i],
+                                sizeof(tags[i])))
+            goto err;
+    }
+
+    for (i = 0; i < AEAD_BATCH_NUM; i++) {
+        in[i] = ct[i];
+        out[i] = dec[i];
+    }
+
+    if (!TEST_true(EVP_DecryptInit_ex(ctx, NULL, NULL, key, NULL))
+            || !TEST_true(EVP_CipherAEADBatch(ctx, AEAD_BATCH_NUM, iv, ivlen,
+                                              aad, aadlen, in, msglen, out,
+                                              tag, AEAD_BATCH_TAGLEN)))
+        goto err;
+
+    for (i = 0; i < AEAD_BATCH_NUM; i++)
+        if (!TEST_mem_eq(dec[i], msglen[i], pt[i], msglen[i]))
+            goto err;
+
+    /*
+     * A corrupted tag on any message must fail the whole batch, and no
+     * plaintext may be left behind, even for messages which authenticated.
+     */
+    tags[2][0] ^= 1;
+    if (!TEST_false(EVP_CipherAEADBatch(ctx, AEAD_BATCH_NUM, iv, ivlen,
+                                        aad, aadlen, in, msglen, out,
+                                        tag, AEAD_BATCH_TAGLEN)))
+        goto err;
+
+    memset(buf, 0, sizeof(buf));
+    for (i = 0; i < AEAD_BATCH_NUM; i++)
+        if (!TEST_mem_eq(dec[i], msglen[i], buf, msglen[i]))
+            goto err;
+
+    testresult = 1;
+ err:
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(type);
+    return testresult;
+}
+
 #ifndef OPENSSL_NO_RC4
 static int rc4_encrypt(const unsigned char *rc4_key, size_t rc4_key_s,
                        const unsigned char *rc4_pt, size_t rc4_pt_s,
@@ -5794,6 +5921,7 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_evp_reset, OSSL_NELEM(evp_reset_tests));
     ADD_ALL_TESTS(test_evp_reinit_seq, OSSL_NELEM(evp_reinit_tests));
     ADD_ALL_TESTS(test_gcm_reinit, OSSL_NELEM(gcm_reinit_tests));
+    ADD_ALL_TESTS(test_evp_aead_batch, OSSL_NELEM(aead_batch_ciphers));
     ADD_ALL_TESTS(test_evp_updated_iv, OSSL_NELEM(evp_updated_iv_tests));
     ADD_ALL_TESTS(test_ivlen_change, OSSL_NELEM(ivlen_change_ciphers));
     if (OSSL_NELEM(keylen_change_ciphers) - 1 > 0)
@@ -22,7 +22,7 @@ static int test_namemap_empty(void)
     int ok;
 
     ok = TEST_int_eq(ossl_namemap_empty(NULL), 1)
-         && TEST_ptr(nm = ossl_namemap_new())
+         && TEST_ptr(nm = ossl_namemap_new(NULL))
          && TEST_int_eq(ossl_namemap_empty(nm), 1)
          && TEST_int_ne(ossl_namemap_add_name(nm, 0, NAME1), 0)
          && TEST_int_eq(ossl_namemap_empty(nm), 0);
@@ -55,7 +55,7 @@ static int test_namemap(OSSL_NAMEMAP *nm)
 
 static int test_namemap_independent(void)
 {
-    OSSL_NAMEMAP *nm = ossl_namemap_new();
+    OSSL_NAMEMAP *nm = ossl_namemap_new(NULL);
     int ok = TEST_ptr(nm) && test_namemap(nm);
 
     ossl_namemap_free(nm);
@@ -603,6 +603,67 @@ err:
     return res;
 }
 
+/*
+ * Removing a provider's implementations flushes the cached queries of every
+ * algorithm it provided, whichever provider they were cached for, and leaves
+ * the other algorithms alone.
+ */
+static int test_remove_all_provided(void)
+{
+    const int num = 40, other = 100;
+    OSSL_METHOD_STORE *store;
+    OSSL_PROVIDER prov1 = { 1 }, prov2 = { 2 };
+    void *result;
+    int i, res = 0;
+
+    if (!TEST_ptr(store = ossl_method_store_new(NULL)))
+        goto err;
+
+    for (i = 1; i <= num; i++)
+        if (!TEST_true(ossl_method_store_add(store, &prov1, i, "", "a",
+                                             &up_ref, &down_ref))
+                || (i % 3 == 0
+                    && !TEST_true(ossl_method_store_add(store, &prov2, i, "",
+                                                        "b", &up_ref,
+                                                        &down_ref)))
+                || !TEST_true(ossl_method_store_cache_set(store, &prov1, i, "",
+                                                          "a", &up_ref,
+                                                          &down_ref))
+                || (i % 3 == 0
+                    && !TEST_true(ossl_method_store_cache_set(store, &prov2, i,
+                                                              "", "b",
+                                                              &up_ref,
+                                                              &down_ref))))
+            goto err;
+    if (!TEST_true(ossl_method_store_add(store, &prov2, other, "", "c",
+                                         &up_ref, &down_ref))
+            || !TEST_true(ossl_method_store_cache_set(store, &prov2, other, "",
+                                                      "c", &up_ref,
+                                                      &down_ref))
+            || !TEST_true(ossl_method_store_remove_all_provided(store, &prov1)))
+        goto err;
+
+    for (i = 1; i <= num; i++)
+        if (!TEST_false(ossl_method_store_cache_get(store, &prov1, i, "",
+                                                    &result))
+                || !TEST_false(ossl_method_store_cache_get(store, &prov2, i, "",
+                                                           &result))
+                || !TEST_false(ossl_method_store_cache_get(store, NULL, i, "",
+                                                           &result))) {
+            TEST_note("nid %d", i);
+            goto err;
+        }
+
+    if (!TEST_true(ossl_method_store_cache_get(store, &prov2, other, "",
+                                               &result))
+            || !TEST_str_eq(result, "c"))
+        goto err;
+    res = 1;
+err:
+    ossl_method_store_free(store);
+    return res;
+}
+
 static int test_fips_mode(void)
 {
     int ret = 0;
@@ -699,6 +760,7 @@ int setup_tests(void)
     ADD_TEST(test_register_deregister);
     ADD_TEST(test_property);
     ADD_TEST(test_query_cache_stochastic);
+    ADD_TEST(test_remove_all_provided);
     ADD_TEST(test_fips_mode);
     ADD_ALL_TESTS(test_property_list_to_string, OSSL_NELEM(to_string_tests));
     return 1;
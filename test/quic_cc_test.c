@@ -80,6 +80,10 @@ typedef struct net_pkt_st {
     /* Size of simulated packet in bytes. */
     size_t      size;
 
+    /* Delivery rate estimation state when the packet was sent. */
+    uint64_t    delivered;
+    OSSL_TIME   delivered_time, first_tx_time;
+
     /* pqueue internal index. */
     size_t      idx;
 } NET_PKT;
@@ -102,6 +106,15 @@ struct net_sim {
     PRIORITY_QUEUE_OF(NET_PKT) *pkts;
 
     uint64_t total_acked, total_lost; /* bytes */
+
+    /* Random (non-congestive) loss rate in packets per thousand. */
+    uint32_t random_loss;
+
+    /*
+     * Delivery rate estimation, as done by the ACKM in a real connection.
+     */
+    uint64_t    bytes_in_flight, delivered;
+    OSSL_TIME   delivered_time, first_tx_time;
 };
 
 static int net_sim_init(struct net_sim *s,
@@ -118,6 +131,12 @@ static int net_sim_init(struct net_sim *s,
 
     s->total_acked      = 0;
     s->total_lost       = 0;
+    s->random_loss      = 0;
+
+    s->bytes_in_flight  = 0;
+    s->delivered        = 0;
+    s->delivered_time   = ossl_time_zero();
+    s->first_tx_time    = ossl_time_zero();
 
     if (!TEST_ptr(s->pkts = ossl_pqueue_NET_PKT_new(net_pkt_cmp)))
         return 0;
@@ -155,6 +174,11 @@ static int net_sim_send(struct net_sim *s, size_t sz)
     /* Do we have room for the packet in the network? */
     success = (sz <= s->spare_capacity);
 
+    /* Simulate loss not caused by congestion (e.g. on a radio link). */
+    if (success && s->random_loss > 0
+        && test_random() % 1000 < s->random_loss)
+        success = 0;
+
     pkt->tx_time = fake_time;
     pkt->success = success;
     if (success) {
@@ -184,6 +208,16 @@ static int net_sim_send(struct net_sim *s, size_t sz)
 
     pkt->size = sz;
 
+    if (s->bytes_in_flight == 0) {
+        s->first_tx_time    = fake_time;
+        s->delivered_time   = fake_time;
+    }
+
+    pkt->delivered      = s->delivered;
+    pkt->delivered_time = s->delivered_time;
+    pkt->first_tx_time  = s->first_tx_time;
+    s->bytes_in_flight += sz;
+
     if (!TEST_true(s->ccm->on_data_sent(s->cc, sz)))
         goto err;
 
@@ -233,6 +267,7 @@ static int net_sim_process_one(struct net_sim *s, int skip_forward)
 
         loss_info.tx_time = pkt->tx_time;
         loss_info.tx_size = pkt->size;
+        s->bytes_in_flight -= pkt->size;
 
         if (!TEST_true(s->ccm->on_data_lost(s->cc, &loss_info)))
             return 0;
@@ -249,6 +284,16 @@ static int net_sim_process_one(struct net_sim *s, int skip_forward)
         ack_info.tx_time = pkt->tx_time;
         ack_info.tx_size = pkt->size;
 
+        s->bytes_in_flight -= pkt->size;
+        s->delivered       += pkt->size;
+        s->delivered_time   = fake_time;
+        ack_info.tx_delivered = pkt->delivered;
+        ack_info.delivered    = s->delivered - pkt->delivered;
+        ack_info.interval
+            = ossl_time_max(ossl_time_subtract(pkt->tx_time, pkt->first_tx_time),
+                            ossl_time_subtract(fake_time, pkt->delivered_time));
+        s->first_tx_time    = ossl_time_max(s->first_tx_time, pkt->tx_time);
+
         if (!TEST_true(s->ccm->on_data_acked(s->cc, &ack_info)))
             return 0;
 
@@ -317,6 +362,11 @@ static int dump_state(const OSSL_CC_METHOD *ccm, OSSL_CC_DATA *cc,
     return 1;
 }
 
+static const OSSL_CC_METHOD *cc_methods[] = {
+    &ossl_cc_newreno_method,
+    &ossl_cc_bbr_method,
+};
+
 /*
  * Simulation Test
  * ===============
@@ -325,12 +375,12 @@ static int dump_state(const OSSL_CC_METHOD *ccm, OSSL_CC_DATA *cc,
  * capacity. The average estimated channel capacity should not be too far from
  * the actual channel capacity.
  */
-static int test_simulate(void)
+static int test_simulate(int idx)
 {
     int testresult = 0;
     int rc;
     int have_sim = 0;
-    const OSSL_CC_METHOD *ccm = &ossl_cc_newreno_method;
+    const OSSL_CC_METHOD *ccm = cc_methods[idx];
     OSSL_CC_DATA *cc = NULL;
     size_t mdpl = 1472;
     uint64_t total_sent = 0, total_to_send, allowance;
@@ -480,17 +530,17 @@ err:
  *
  * Basic test of the congestion control APIs.
  */
-static int test_sanity(void)
+static int test_sanity(int idx)
 {
     int testresult = 0;
     OSSL_CC_DATA *cc = NULL;
-    const OSSL_CC_METHOD *ccm = &ossl_cc_newreno_method;
+    const OSSL_CC_METHOD *ccm = cc_methods[idx];
     OSSL_CC_LOSS_INFO loss_info = {0};
     OSSL_CC_ACK_INFO ack_info = {0};
     uint64_t allowance, allowance2;
     OSSL_PARAM params[3], *p = params;
     size_t mdpl = 1472, diag_mdpl = SIZE_MAX;
-    uint64_t diag_cur_bytes_in_flight = UINT64_MAX;
+    uint64_t diag_cur_bytes_in_flight = UINT64_MAX, smoothed_rtt;
 
     fake_time = TIME_BASE;
 
@@ -548,12 +598,29 @@ static int test_sanity(void)
     if (!TEST_uint64_t_ge(allowance2 = ccm->get_tx_allowance(cc), allowance))
         goto err;
 
+    /*
+     * We should now have a pacing rate. NewReno paces at twice cwnd per
+     * smoothed RTT during slow start, and the ACKM would pass in a smoothed RTT
+     * of 100ms after taking the sample.
+     */
+    smoothed_rtt = ossl_time2ticks(ossl_ms2time(100));
+    params[0] = OSSL_PARAM_construct_uint64(OSSL_CC_OPTION_SMOOTHED_RTT,
+                                            &smoothed_rtt);
+    params[1] = OSSL_PARAM_construct_end();
+    if (!TEST_true(ccm->set_input_params(cc, params))
+        || !TEST_uint64_t_gt(ccm->get_pacing_rate(cc), 0))
+        goto err;
+
+    if (ccm == &ossl_cc_newreno_method
+        && !TEST_uint64_t_eq(ccm->get_pacing_rate(cc), allowance2 * 20))
+        goto err;
+
     /* Test invalidation. */
     if (!TEST_true(ccm->on_data_sent(cc, 1200)))
         goto err;
 
     /* Allowance should have decreased. */
-    if (!TEST_uint64_t_eq(ccm->get_tx_allowance(cc), allowance - 1200))
+    if (!TEST_uint64_t_eq(ccm->get_tx_allowance(cc), allowance2 - 1200))
         goto err;
 
     if (!TEST_true(ccm->on_data_invalidated(cc, 1200)))
@@ -608,6 +675,90 @@ err:
     return testresult;
 }
 
+/*
+ * Random Loss Test
+ * ================
+ *
+ * Simulate a path with a fixed send rate of one datagram per millisecond, a
+ * 50ms round trip time and 1% random loss which is not caused by congestion,
+ * and measure the goodput achieved by each congestion controller.
+ */
+static int run_lossy(const OSSL_CC_METHOD *ccm, uint64_t *goodput)
+{
+    int ok = 0, rc, have_sim = 0;
+    OSSL_CC_DATA *cc = NULL;
+    size_t mdpl = 1472;
+    OSSL_TIME end_time;
+    struct net_sim sim;
+    OSSL_PARAM params[2];
+
+    fake_time = TIME_BASE;
+    end_time = ossl_time_add(fake_time, ossl_seconds2time(20));
+
+    if (!TEST_ptr(cc = ccm->new(fake_now, NULL)))
+        goto err;
+
+    params[0] = OSSL_PARAM_construct_size_t(OSSL_CC_OPTION_MAX_DGRAM_PAYLOAD_LEN,
+                                            &mdpl);
+    params[1] = OSSL_PARAM_construct_end();
+
+    if (!TEST_true(ccm->set_input_params(cc, params)))
+        goto err;
+
+    ccm->reset(cc);
+
+    if (!TEST_true(net_sim_init(&sim, ccm, cc, UINT32_MAX, 25)))
+        goto err;
+
+    have_sim = 1;
+    sim.random_loss = 10;
+
+    while (ossl_time_compare(fake_time, end_time) < 0) {
+        if (ccm->get_tx_allowance(cc) >= mdpl) {
+            if (!TEST_true(net_sim_send(&sim, mdpl)))
+                goto err;
+
+            step_time(1);
+            continue;
+        }
+
+        rc = net_sim_process(&sim, 1);
+        if (!TEST_int_gt(rc, 0))
+            goto err;
+    }
+
+    *goodput = sim.total_acked / 20;
+    ok = 1;
+err:
+    if (have_sim)
+        net_sim_cleanup(&sim);
+
+    if (cc != NULL)
+        ccm->free(cc);
+
+    return ok;
+}
+
+static int test_random_loss(void)
+{
+    uint64_t newreno_goodput = 0, bbr_goodput = 0;
+
+    if (!TEST_true(run_lossy(&ossl_cc_newreno_method, &newreno_goodput))
+        || !TEST_true(run_lossy(&ossl_cc_bbr_method, &bbr_goodput)))
+        return 0;
+
+    TEST_info("goodput with 1%% random loss: NewReno %llu B/s, BBR %llu B/s",
+              (unsigned long long)newreno_goodput,
+              (unsigned long long)bbr_goodput);
+
+    /*
+     * The path can carry about 1.47 MB/s. BBR should be able to use most of
+     * it, and should do much better than NewReno.
+     */
+    return TEST_uint64_t_gt(bbr_goodput, 1000000)
+        && TEST_uint64_t_gt(bbr_goodput, 2 * newreno_goodput);
+}
+
 int setup_tests(void)
 {
 
@@ -623,7 +774,8 @@ int setup_tests(void)
         "\"State\"\n");
 #endif
 
-    ADD_TEST(test_simulate);
-    ADD_TEST(test_sanity);
+    ADD_ALL_TESTS(test_simulate, OSSL_NELEM(cc_methods));
+    ADD_ALL_TESTS(test_sanity, OSSL_NELEM(cc_methods));
+    ADD_TEST(test_random_loss);
     return 1;
 }
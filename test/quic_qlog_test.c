@@ -74,11 +74,18 @@ static OSSL_TIME now(void *arg)
     return t;
 }
 
-static int test_qlog(void)
+/*
+ * Test 0: synchronous output
+ * Test 1: asynchronous output via a writer; must produce identical output
+ */
+static int test_qlog(int idx)
 {
     int testresult = 0;
     QLOG_TRACE_INFO qti = {0};
-    QLOG *qlog;
+    QLOG *qlog = NULL;
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    QLOG_WRITER *w = NULL;
+#endif
     BIO *bio;
     char *buf = NULL;
     size_t buf_len = 0;
@@ -106,6 +113,17 @@ static int test_qlog(void)
     if (!TEST_true(ossl_qlog_set_sink_bio(qlog, bio)))
         goto err;
 
+    if (idx == 1) {
+#ifndef OPENSSL_NO_QLOG_ASYNC
+        if (!TEST_ptr(w = ossl_qlog_writer_new())
+            || !TEST_true(ossl_qlog_set_writer(qlog, w, 0)))
+            goto err;
+#else
+        testresult = TEST_skip("asynchronous qlog not supported");
+        goto err;
+#endif
+    }
+
     QLOG_EVENT_BEGIN(qlog, transport, packet_sent)
         QLOG_STR("field1", "foo");
         QLOG_STR_LEN("field2", "bar", 3);
@@ -145,11 +163,83 @@ static int test_qlog(void)
     if (!TEST_mem_eq(buf, buf_len, expected, sizeof(expected)))
         goto err;
 
+    if (!TEST_uint64_t_eq(ossl_qlog_get_num_dropped(qlog), 0))
+        goto err;
+
+    testresult = 1;
+err:
+    ossl_qlog_free(qlog);
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    ossl_qlog_writer_free(w);
+#endif
+    return testresult;
+}
+
+#ifndef OPENSSL_NO_QLOG_ASYNC
+/*
+ * An event which does not fit in the ring buffer must be dropped without
+ * blocking, and the drop reported in the log.
+ */
+static int test_qlog_async_drop(void)
+{
+    int testresult = 0;
+    QLOG_TRACE_INFO qti = {0};
+    QLOG *qlog = NULL;
+    QLOG_WRITER *w = NULL;
+    BIO *bio;
+    char *buf = NULL, *str = NULL;
+    long buf_len;
+    static const char big[200] = {0};
+
+    last_time = ossl_time_from_time_t(170653117);
+
+    qti.odcid.id_len        = 1;
+    qti.odcid.id[0]         = 0x55;
+    qti.override_process_id = 123;
+    qti.now_cb              = now;
+    qti.override_impl_name  = "OpenSSL/x.y.z";
+
+    if (!TEST_ptr(qlog = ossl_qlog_new(&qti))
+        || !TEST_true(ossl_qlog_set_event_type_enabled(qlog, QLOG_EVENT_TYPE_transport_packet_sent, 1))
+        || !TEST_ptr(bio = BIO_new(BIO_s_mem())))
+        goto err;
+
+    if (!TEST_true(ossl_qlog_set_sink_bio(qlog, bio))
+        || !TEST_ptr(w = ossl_qlog_writer_new())
+        || !TEST_true(ossl_qlog_set_writer(qlog, w, 128)))
+        goto err;
+
+    QLOG_EVENT_BEGIN(qlog, transport, packet_sent)
+        QLOG_BIN("big", big, sizeof(big));
+    QLOG_EVENT_END()
+
+    if (!TEST_uint64_t_eq(ossl_qlog_get_num_dropped(qlog), 1))
+        goto err;
+
+    QLOG_EVENT_BEGIN(qlog, transport, packet_sent)
+        QLOG_STR("field1", "small");
+    QLOG_EVENT_END()
+
+    if (!TEST_true(ossl_qlog_flush(qlog)))
+        goto err;
+
+    buf_len = BIO_get_mem_data(bio, &buf);
+    if (!TEST_long_gt(buf_len, 0)
+        || !TEST_ptr(str = OPENSSL_strndup(buf, buf_len))
+        || !TEST_ptr(strstr(str, "\"field1\":\"small\""))
+        || !TEST_ptr(strstr(str, "\"loglevel:warning\""))
+        || !TEST_ptr(strstr(str, "1 qlog events dropped"))
+        || !TEST_ptr_null(strstr(str, "\"big\"")))
+        goto err;
+
     testresult = 1;
 err:
+    OPENSSL_free(str);
     ossl_qlog_free(qlog);
+    ossl_qlog_writer_free(w);
     return testresult;
 }
+#endif
 
 struct filter_spec {
     const char *filter;
@@ -242,7 +332,10 @@ err:
 
 int setup_tests(void)
 {
-    ADD_TEST(test_qlog);
+    ADD_ALL_TESTS(test_qlog, 2);
+#ifndef OPENSSL_NO_QLOG_ASYNC
+    ADD_TEST(test_qlog_async_drop);
+#endif
     ADD_ALL_TESTS(test_qlog_filter, OSSL_NELEM(filters));
     return 1;
 }
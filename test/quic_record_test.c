@@ -2993,6 +2993,104 @@ static int test_wire_pkt_hdr(int idx)
     return test_wire_pkt_hdr_inner(tidx, repeat, cipher);
 }
 
+/*
+ * Checks that applying and removing header protection for a batch of packets
+ * gives the same results as doing so for each packet individually.
+ */
+#define HPR_BATCH_PKT_LEN   48
+
+static int test_hdr_prot_batch(int cipher)
+{
+    int testresult = 0, have_hpr = 0;
+    QUIC_HDR_PROTECTOR hpr = {0};
+    unsigned char hpr_key[32] = {0,1,2,3,4,5,6,7};
+    unsigned char orig[QUIC_HDR_PROT_MAX_BATCH + 1][HPR_BATCH_PKT_LEN];
+    unsigned char one[QUIC_HDR_PROT_MAX_BATCH + 1][HPR_BATCH_PKT_LEN];
+    unsigned char batch[QUIC_HDR_PROT_MAX_BATCH + 1][HPR_BATCH_PKT_LEN];
+    QUIC_PKT_HDR_PTRS ptrs[QUIC_HDR_PROT_MAX_BATCH + 1];
+    uint32_t hpr_cipher_id = QUIC_HDR_PROT_CIPHER_AES_128;
+    size_t hpr_key_len = 16, i, j;
+
+    switch (cipher) {
+    case 0:
+        break;
+    case 1:
+        hpr_cipher_id = QUIC_HDR_PROT_CIPHER_AES_256;
+        hpr_key_len   = 32;
+        break;
+    case 2:
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+        hpr_cipher_id = QUIC_HDR_PROT_CIPHER_CHACHA;
+#else
+        hpr_cipher_id = QUIC_HDR_PROT_CIPHER_AES_256;
+#endif
+        hpr_key_len   = 32;
+        break;
+    default:
+        goto err;
+    }
+
+    if (!TEST_true(ossl_quic_hdr_protector_init(&hpr, NULL, NULL,
+                                                hpr_cipher_id,
+                                                hpr_key, hpr_key_len)))
+        goto err;
+
+    have_hpr = 1;
+
+    for (i = 0; i < OSSL_NELEM(orig); ++i) {
+        for (j = 0; j < HPR_BATCH_PKT_LEN; ++j)
+            orig[i][j] = (unsigned char)test_random();
+
+        /* Alternate between short and long headers. */
+        orig[i][0] = (unsigned char)((i % 2 == 0 ? 0x40 : 0xc0) | (i & 3));
+    }
+
+    memcpy(one, orig, sizeof(orig));
+    memcpy(batch, orig, sizeof(orig));
+
+    for (i = 0; i < OSSL_NELEM(orig); ++i) {
+        ptrs[i].raw_start       = one[i];
+        ptrs[i].raw_pn          = one[i] + 9;
+        ptrs[i].raw_sample      = one[i] + 13;
+        ptrs[i].raw_sample_len  = HPR_BATCH_PKT_LEN - 13;
+        if (!TEST_true(ossl_quic_hdr_protector_encrypt(&hpr, &ptrs[i])))
+            goto err;
+
+        ptrs[i].raw_start       = batch[i];
+        ptrs[i].raw_pn          = batch[i] + 9;
+        ptrs[i].raw_sample      = batch[i] + 13;
+    }
+
+    /* Too many packets for one batch. */
+    if (!TEST_false(ossl_quic_hdr_protector_encrypt_batch(&hpr, ptrs,
+                                                          OSSL_NELEM(ptrs)))
+        || !TEST_mem_eq(batch, sizeof(batch), orig, sizeof(orig)))
+        goto err;
+
+    /* Split into two batches of differing sizes. */
+    if (!TEST_true(ossl_quic_hdr_protector_encrypt_batch(&hpr, ptrs, 5))
+        || !TEST_true(ossl_quic_hdr_protector_encrypt_batch(&hpr, ptrs + 5,
+                                                            OSSL_NELEM(ptrs) - 5))
+        || !TEST_mem_eq(batch, sizeof(batch), one, sizeof(one))
+        || !TEST_true(ossl_quic_hdr_protector_decrypt_batch(&hpr, ptrs + 1,
+                                                            QUIC_HDR_PROT_MAX_BATCH))
+        || !TEST_true(ossl_quic_hdr_protector_decrypt_batch(&hpr, ptrs, 1))
+        || !TEST_mem_eq(batch, sizeof(batch), orig, sizeof(orig)))
+        goto err;
+
+    /* A sample which is too short causes the whole batch to fail. */
+    ptrs[3].raw_sample_len = 15;
+    if (!TEST_false(ossl_quic_hdr_protector_encrypt_batch(&hpr, ptrs, 4))
+        || !TEST_mem_eq(batch, sizeof(batch), orig, sizeof(orig)))
+        goto err;
+
+    testresult = 1;
+err:
+    if (have_hpr)
+        ossl_quic_hdr_protector_cleanup(&hpr);
+    return testresult;
+}
+
 /* TX Tests */
 #define TX_TEST_OP_END                     0 /* end of script */
 #define TX_TEST_OP_WRITE                   1 /* write packet */
@@ -3713,6 +3811,7 @@ int setup_tests(void)
      * and otherwise random test ordering will cause itt to randomly fail.
      */
     ADD_ALL_TESTS(test_wire_pkt_hdr, NUM_WIRE_PKT_HDR_TESTS + 1);
+    ADD_ALL_TESTS(test_hdr_prot_batch, HPR_CIPHER_COUNT);
     ADD_ALL_TESTS(test_tx_script, OSSL_NELEM(tx_scripts));
     return 1;
 }
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <openssl/err.h>
+#include "internal/quic_shard.h"
+#include "internal/quic_lcidm.h"
+#include "internal/quic_demux.h"
+#include "internal/quic_reactor.h"
+#include "internal/sockets.h"
+#include "testutil.h"
+
+static char ptrs[4];
+
+static int test_lcidm_routing_byte(void)
+{
+    int testresult = 0;
+    QUIC_LCIDM *lcidm = NULL, *lcidm0 = NULL;
+    QUIC_CONN_ID lcid;
+    OSSL_QUIC_FRAME_NEW_CONN_ID ncid;
+    int i;
+
+    if (!TEST_ptr(lcidm = ossl_quic_lcidm_new(NULL, 8))
+        || !TEST_ptr(lcidm0 = ossl_quic_lcidm_new(NULL, 0)))
+        goto err;
+
+    if (!TEST_false(ossl_quic_lcidm_set_routing_byte(lcidm, 256))
+        || !TEST_false(ossl_quic_lcidm_set_routing_byte(lcidm0, 1))
+        || !TEST_true(ossl_quic_lcidm_set_routing_byte(lcidm0, -1))
+        || !TEST_true(ossl_quic_lcidm_set_routing_byte(lcidm, 0xa5)))
+        goto err;
+
+    if (!TEST_true(ossl_quic_lcidm_generate_initial(lcidm, ptrs + 0, &lcid))
+        || !TEST_size_t_eq(lcid.id_len, 8)
+        || !TEST_uchar_eq(lcid.id[0], 0xa5))
+        goto err;
+
+    for (i = 0; i < 8; ++i)
+        if (!TEST_true(ossl_quic_lcidm_generate(lcidm, ptrs + 0, &ncid))
+            || !TEST_uchar_eq(ncid.conn_id.id[0], 0xa5))
+            goto err;
+
+    testresult = 1;
+err:
+    ossl_quic_lcidm_free(lcidm);
+    ossl_quic_lcidm_free(lcidm0);
+    return testresult;
+}
+
+static size_t num_handled;
+static QUIC_CONN_ID last_dcid;
+
+static void demux_default_handler(QUIC_URXE *e, void *arg,
+                                  const QUIC_CONN_ID *dcid)
+{
+    QUIC_DEMUX *demux = arg;
+
+    ++num_handled;
+    if (dcid != NULL)
+        last_dcid = *dcid;
+
+    ossl_quic_demux_release_urxe(demux, e);
+}
+
+static int test_shard_forward(void)
+{
+    int testresult = 0;
+    QUIC_SHARD_GROUP *grp = NULL;
+    QUIC_DEMUX *demux = NULL;
+    QUIC_URXE *e = NULL;
+    QUIC_CONN_ID cid = { 8, { 1, 2, 3, 4, 5, 6, 7, 8 } };
+    unsigned char *data;
+    size_t i, data_len = 64;
+
+    if (!TEST_ptr_null(ossl_quic_shard_group_new(0))
+        || !TEST_ptr_null(ossl_quic_shard_group_new(QUIC_SHARD_GROUP_MAX_SHARDS + 1))
+        || !TEST_ptr(grp = ossl_quic_shard_group_new(2))
+        || !TEST_size_t_eq(ossl_quic_shard_group_get_num_shards(grp), 2))
+        goto err;
+
+    /* CID owner is taken from the first byte. */
+    if (!TEST_size_t_eq(ossl_quic_shard_group_get_cid_owner(grp, &cid), 1))
+        goto err;
+
+    cid.id[0] = 2;
+    if (!TEST_size_t_eq(ossl_quic_shard_group_get_cid_owner(grp, &cid),
+                        SIZE_MAX))
+        goto err;
+
+    cid.id[0] = 1;
+
+    if (!TEST_ptr(demux = ossl_quic_demux_new(NULL, 8, NULL, NULL)))
+        goto err;
+
+    ossl_quic_demux_set_default_handler(demux, demux_default_handler, demux);
+
+    /* Build a 1-RTT packet with the CID above as its DCID. */
+    if (!TEST_ptr(e = OPENSSL_zalloc(sizeof(QUIC_URXE) + data_len)))
+        goto err;
+
+    e->data_len = data_len;
+    data = ossl_quic_urxe_data(e);
+    data[0] = 0x40;
+    memcpy(data + 1, cid.id, cid.id_len);
+    for (i = 1 + cid.id_len; i < data_len; ++i)
+        data[i] = (unsigned char)i;
+
+    /* Nothing queued yet. */
+    if (!TEST_size_t_eq(ossl_quic_shard_group_collect(grp, 1, demux), 0))
+        goto err;
+
+    if (!TEST_false(ossl_quic_shard_group_forward(grp, 2, e))
+        || !TEST_true(ossl_quic_shard_group_forward(grp, 1, e))
+        || !TEST_true(ossl_quic_shard_group_forward(grp, 1, e)))
+        goto err;
+
+    /* Datagrams for shard 1 are not visible to shard 0. */
+    if (!TEST_size_t_eq(ossl_quic_shard_group_collect(grp, 0, demux), 0)
+        || !TEST_size_t_eq(num_handled, 0))
+        goto err;
+
+    if (!TEST_size_t_eq(ossl_quic_shard_group_collect(grp, 1, demux), 2)
+        || !TEST_size_t_eq(num_handled, 2)
+        || !TEST_true(ossl_quic_conn_id_eq(&last_dcid, &cid)))
+        goto err;
+
+    /* Queue is now empty. */
+    if (!TEST_size_t_eq(ossl_quic_shard_group_collect(grp, 1, demux), 0))
+        goto err;
+
+    /* Uncollected datagrams are freed with the group. */
+    if (!TEST_true(ossl_quic_shard_group_forward(grp, 0, e)))
+        goto err;
+
+    testresult = 1;
+err:
+    OPENSSL_free(e);
+    ossl_quic_demux_free(demux);
+    ossl_quic_shard_group_free(grp);
+    return testresult;
+}
+
+static size_t num_ticks;
+static OSSL_TIME wake_deadline;
+static int woken_early;
+
+static void notify_tick(QUIC_TICK_RESULT *res, void *arg, uint32_t flags)
+{
+    ++num_ticks;
+    res->tick_deadline = wake_deadline;
+}
+
+static int notify_pred(void *arg)
+{
+    if (num_ticks == 0)
+        return 0;
+
+    woken_early = ossl_time_compare(ossl_time_now(), wake_deadline) < 0;
+    return 1;
+}
+
+/* Forwarding a datagram must wake a thread blocked on the owner's reactor. */
+static int test_shard_notify(void)
+{
+    int testresult = 0;
+    QUIC_SHARD_GROUP *grp = NULL;
+    QUIC_REACTOR rtor;
+    QUIC_URXE *e = NULL;
+
+    /* If we are not woken, the deadline ends the wait and the test fails. */
+    wake_deadline = ossl_time_add(ossl_time_now(), ossl_seconds2time(10));
+    ossl_quic_reactor_init(&rtor, notify_tick, NULL, wake_deadline);
+
+    if (!ossl_quic_reactor_enable_notifier(&rtor)) {
+        testresult = TEST_skip("reactor notifier not supported");
+        goto err;
+    }
+
+    if (!TEST_ptr(grp = ossl_quic_shard_group_new(2))
+        || !TEST_ptr(e = OPENSSL_zalloc(sizeof(QUIC_URXE) + 1)))
+        goto err;
+
+    ossl_quic_shard_group_set_reactor(grp, 1, &rtor);
+    e->data_len = 1;
+    if (!TEST_true(ossl_quic_shard_group_forward(grp, 1, e)))
+        goto err;
+
+    if (!TEST_true(ossl_quic_reactor_block_until_pred(&rtor, notify_pred, NULL,
+                                                      SKIP_FIRST_TICK, NULL))
+        || !TEST_size_t_eq(num_ticks, 1)
+        || !TEST_true(woken_early))
+        goto err;
+
+    testresult = 1;
+err:
+    OPENSSL_free(e);
+    ossl_quic_shard_group_free(grp);
+    ossl_quic_reactor_cleanup(&rtor);
+    return testresult;
+}
+
+static int test_bind_reuseport(void)
+{
+    int testresult = 0;
+    int fd1 = -1, fd2 = -1, fd3 = -1;
+    BIO_ADDR *addr = NULL;
+    union BIO_sock_info_u info = {0};
+    struct in_addr ina;
+
+    ina.s_addr = htonl(0x7f000001UL);
+
+    if (!TEST_ptr(addr = BIO_ADDR_new())
+        || !TEST_ptr(info.addr = BIO_ADDR_new())
+        || !TEST_int_eq(BIO_ADDR_rawmake(addr, AF_INET, &ina, sizeof(ina), 0), 1))
+        goto err;
+
+    fd1 = BIO_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, 0);
+    fd2 = BIO_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, 0);
+    fd3 = BIO_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, 0);
+    if (!TEST_int_ge(fd1, 0) || !TEST_int_ge(fd2, 0) || !TEST_int_ge(fd3, 0))
+        goto err;
+
+    if (BIO_bind(fd1, addr, BIO_SOCK_REUSEPORT) <= 0) {
+        if (ERR_GET_REASON(ERR_peek_last_error()) == BIO_R_UNABLE_TO_REUSEPORT)
+            testresult = TEST_skip("SO_REUSEPORT not supported");
+        else
+            testresult = TEST_skip("BIO_bind() failed");
+        goto err;
+    }
+
+    if (!TEST_int_gt(BIO_sock_info(fd1, BIO_SOCK_INFO_ADDRESS, &info), 0))
+        goto err;
+
+    /* A second socket can share the port only if it also asks to. */
+    ERR_set_mark();
+    if (!TEST_int_le(BIO_bind(fd3, info.addr, 0), 0)) {
+        ERR_clear_last_mark();
+        goto err;
+    }
+    ERR_pop_to_mark();
+
+    if (!TEST_int_gt(BIO_bind(fd2, info.addr, BIO_SOCK_REUSEPORT), 0))
+        goto err;
+
+    testresult = 1;
+err:
+    if (fd1 >= 0)
+        BIO_closesocket(fd1);
+    if (fd2 >= 0)
+        BIO_closesocket(fd2);
+    if (fd3 >= 0)
+        BIO_closesocket(fd3);
+    BIO_ADDR_free(addr);
+    BIO_ADDR_free(info.addr);
+    return testresult;
+}
+
+int setup_tests(void)
+{
+    ADD_TEST(test_lcidm_routing_byte);
+    ADD_TEST(test_shard_forward);
+    ADD_TEST(test_shard_notify);
+    ADD_TEST(test_bind_reuseport);
+    return 1;
+}
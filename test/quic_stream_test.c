@@ -213,6 +213,131 @@ static int test_sstream_simple(void)
     return testresult;
 }
 
+static size_t num_released;
+static const void *last_released;
+
+static void release_cb(const void *buf, size_t buf_len, void *arg)
+{
+    ++num_released;
+    last_released = buf;
+}
+
+static int test_sstream_append_ref(void)
+{
+    int testresult = 0;
+    QUIC_SSTREAM *sstream = NULL;
+    OSSL_QUIC_FRAME_STREAM hdr;
+    OSSL_QTX_IOVEC iov[2];
+    size_t num_iov = 0, wr = 0;
+    unsigned char lent[32];
+
+    memset(lent, 0xaa, sizeof(lent));
+    num_released = 0;
+
+    if (!TEST_ptr(sstream = ossl_quic_sstream_new(8192)))
+        goto err;
+
+    /* Copied data followed by referenced data */
+    if (!TEST_true(ossl_quic_sstream_append(sstream, data_1, sizeof(data_1),
+                                            &wr))
+        || !TEST_size_t_eq(wr, sizeof(data_1))
+        || !TEST_false(ossl_quic_sstream_append_ref(sstream, lent, 0,
+                                                    release_cb, NULL))
+        || !TEST_true(ossl_quic_sstream_append_ref(sstream, lent, sizeof(lent),
+                                                   release_cb, NULL))
+        || !TEST_uint64_t_eq(ossl_quic_sstream_get_cur_size(sstream),
+                             sizeof(data_1) + sizeof(lent))
+        || !TEST_size_t_eq(ossl_quic_sstream_get_buffer_used(sstream),
+                           sizeof(data_1)))
+        goto err;
+
+    /* No copied data may be appended while the buffer is referenced */
+    if (!TEST_true(ossl_quic_sstream_append(sstream, data_1, sizeof(data_1),
+                                            &wr))
+        || !TEST_size_t_eq(wr, 0))
+        goto err;
+
+    /* One frame covers both; the second iovec points into the lent buffer */
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_sstream_get_stream_frame(sstream, 0, &hdr, iov,
+                                                      &num_iov))
+        || !TEST_size_t_eq(num_iov, 2)
+        || !TEST_uint64_t_eq(hdr.offset, 0)
+        || !TEST_uint64_t_eq(hdr.len, sizeof(data_1) + sizeof(lent))
+        || !TEST_true(compare_iov(data_1, sizeof(data_1), iov, 1))
+        || !TEST_ptr_eq(iov[1].buf, lent)
+        || !TEST_size_t_eq(iov[1].buf_len, sizeof(lent)))
+        goto err;
+
+    if (!TEST_true(ossl_quic_sstream_mark_transmitted(sstream, 0, 47)))
+        goto err;
+
+    /* Lose part of the lent range and retransmit it from the lent buffer */
+    if (!TEST_true(ossl_quic_sstream_mark_lost(sstream, 20, 29)))
+        goto err;
+
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_sstream_get_stream_frame(sstream, 0, &hdr, iov,
+                                                      &num_iov))
+        || !TEST_size_t_eq(num_iov, 1)
+        || !TEST_uint64_t_eq(hdr.offset, 20)
+        || !TEST_uint64_t_eq(hdr.len, 10)
+        || !TEST_ptr_eq(iov[0].buf, lent + 4))
+        goto err;
+
+    if (!TEST_true(ossl_quic_sstream_mark_transmitted(sstream, 20, 29)))
+        goto err;
+
+    /* Acking the lent range alone releases it */
+    if (!TEST_true(ossl_quic_sstream_mark_acked(sstream, 16, 47))
+        || !TEST_size_t_eq(num_released, 1)
+        || !TEST_ptr_eq(last_released, lent))
+        goto err;
+
+    /* But copied data still cannot be appended until everything is acked */
+    if (!TEST_true(ossl_quic_sstream_append(sstream, data_1, sizeof(data_1),
+                                            &wr))
+        || !TEST_size_t_eq(wr, 0))
+        goto err;
+
+    if (!TEST_true(ossl_quic_sstream_mark_acked(sstream, 0, 15))
+        || !TEST_size_t_eq(ossl_quic_sstream_get_buffer_used(sstream), 0)
+        || !TEST_true(ossl_quic_sstream_append(sstream, data_1,
+                                               sizeof(data_1), &wr))
+        || !TEST_size_t_eq(wr, sizeof(data_1)))
+        goto err;
+
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_sstream_get_stream_frame(sstream, 0, &hdr, iov,
+                                                      &num_iov))
+        || !TEST_uint64_t_eq(hdr.offset, 48)
+        || !TEST_uint64_t_eq(hdr.len, sizeof(data_1))
+        || !TEST_true(compare_iov(data_1, sizeof(data_1), iov, num_iov)))
+        goto err;
+
+    /* A referenced buffer still outstanding is released on free */
+    if (!TEST_true(ossl_quic_sstream_append_ref(sstream, lent, sizeof(lent),
+                                                release_cb, NULL)))
+        goto err;
+
+    ossl_quic_sstream_fin(sstream);
+    if (!TEST_false(ossl_quic_sstream_append_ref(sstream, lent, sizeof(lent),
+                                                 release_cb, NULL))
+        || !TEST_true(ossl_quic_sstream_get_final_size(sstream, &hdr.offset))
+        || !TEST_uint64_t_eq(hdr.offset, 96))
+        goto err;
+
+    ossl_quic_sstream_free(sstream);
+    sstream = NULL;
+    if (!TEST_size_t_eq(num_released, 2))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_sstream_free(sstream);
+    return testresult;
+}
+
 static int test_sstream_bulk(int idx)
 {
     int testresult = 0;
@@ -472,6 +597,123 @@ static int test_rstream_simple(int idx)
     return ret;
 }
 
+static int test_rstream_zc(void)
+{
+    unsigned char data[40], buf[16];
+    QUIC_RSTREAM *rstream = NULL;
+    SSL_CONST_IOVEC iov[4];
+    size_t i, num_iov, readbytes = 0;
+    int fin = 0, ret = 0;
+
+    for (i = 0; i < sizeof(data); ++i)
+        data[i] = (unsigned char)i;
+
+    if (!TEST_ptr(rstream = ossl_quic_rstream_new(NULL, NULL, 16)))
+        goto err;
+
+    /* Nothing to peek at yet. */
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_rstream_peek_zc(rstream, iov, &num_iov,
+                                             &readbytes, &fin))
+        || !TEST_size_t_eq(num_iov, 0)
+        || !TEST_size_t_eq(readbytes, 0)
+        || !TEST_false(fin)
+        || !TEST_false(ossl_quic_rstream_is_zc_peeked(rstream)))
+        goto err;
+
+    /* Put [8, 20) in the ring buffer so that it wraps at offset 16. */
+    if (!TEST_true(ossl_quic_rstream_queue_data(rstream, NULL, 0, data, 12, 0))
+        || !TEST_true(ossl_quic_rstream_move_to_rbuf(rstream))
+        || !TEST_true(ossl_quic_rstream_read(rstream, buf, 8, &readbytes, &fin))
+        || !TEST_size_t_eq(readbytes, 8)
+        || !TEST_true(ossl_quic_rstream_queue_data(rstream, NULL, 12, data + 12,
+                                                   8, 0))
+        || !TEST_true(ossl_quic_rstream_move_to_rbuf(rstream)))
+        goto err;
+
+    /* [20, 30) stays in the "packet". */
+    if (!TEST_true(ossl_quic_rstream_queue_data(rstream, NULL, 20, data + 20,
+                                                10, 0)))
+        goto err;
+
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_rstream_peek_zc(rstream, iov, &num_iov,
+                                             &readbytes, &fin))
+        || !TEST_size_t_eq(num_iov, 3)
+        || !TEST_size_t_eq(readbytes, 22)
+        || !TEST_false(fin)
+        || !TEST_mem_eq(iov[0].buf, iov[0].buf_len, data + 8, 8)
+        || !TEST_mem_eq(iov[1].buf, iov[1].buf_len, data + 16, 4)
+        || !TEST_ptr_eq(iov[2].buf, data + 20)
+        || !TEST_size_t_eq(iov[2].buf_len, 10)
+        || !TEST_true(ossl_quic_rstream_is_zc_peeked(rstream)))
+        goto err;
+
+    /*
+     * A retransmission overlapping the peeked data does not replace it, and
+     * peeked data is not moved to the ring buffer.
+     */
+    if (!TEST_true(ossl_quic_rstream_queue_data(rstream, NULL, 18, data + 18,
+                                                16, 0))
+        || !TEST_false(ossl_quic_rstream_move_to_rbuf(rstream))
+        || !TEST_false(ossl_quic_rstream_resize_rbuf(rstream, 32)))
+        goto err;
+
+    /* Only one span requested; the data beyond it is not consumed. */
+    num_iov = 1;
+    if (!TEST_true(ossl_quic_rstream_peek_zc(rstream, iov, &num_iov,
+                                             &readbytes, &fin))
+        || !TEST_size_t_eq(num_iov, 1)
+        || !TEST_size_t_eq(readbytes, 8)
+        || !TEST_false(fin))
+        goto err;
+
+    /* Cannot release more than was peeked. */
+    if (!TEST_false(ossl_quic_rstream_release_zc(rstream, 9, &fin))
+        || !TEST_true(ossl_quic_rstream_release_zc(rstream, 5, &fin))
+        || !TEST_false(fin)
+        || !TEST_false(ossl_quic_rstream_is_zc_peeked(rstream))
+        || !TEST_false(ossl_quic_rstream_release_zc(rstream, 0, &fin)))
+        goto err;
+
+    if (!TEST_true(ossl_quic_rstream_queue_data(rstream, NULL, 34, data + 34,
+                                                6, 1)))
+        goto err;
+
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_rstream_peek_zc(rstream, iov, &num_iov,
+                                             &readbytes, &fin))
+        || !TEST_size_t_eq(num_iov, 4)
+        || !TEST_size_t_eq(readbytes, 21)
+        || !TEST_false(fin)
+        || !TEST_mem_eq(iov[0].buf, iov[0].buf_len, data + 13, 3)
+        || !TEST_mem_eq(iov[1].buf, iov[1].buf_len, data + 16, 4)
+        || !TEST_ptr_eq(iov[2].buf, data + 20)
+        || !TEST_size_t_eq(iov[2].buf_len, 10)
+        || !TEST_ptr_eq(iov[3].buf, data + 30)
+        || !TEST_size_t_eq(iov[3].buf_len, 4)
+        || !TEST_true(ossl_quic_rstream_release_zc(rstream, 21, &fin))
+        || !TEST_false(fin))
+        goto err;
+
+    num_iov = OSSL_NELEM(iov);
+    if (!TEST_true(ossl_quic_rstream_peek_zc(rstream, iov, &num_iov,
+                                             &readbytes, &fin))
+        || !TEST_size_t_eq(num_iov, 1)
+        || !TEST_size_t_eq(readbytes, 6)
+        || !TEST_true(fin)
+        || !TEST_ptr_eq(iov[0].buf, data + 34)
+        || !TEST_true(ossl_quic_rstream_release_zc(rstream, 6, &fin))
+        || !TEST_true(fin))
+        goto err;
+
+    ret = 1;
+
+ err:
+    ossl_quic_rstream_free(rstream);
+    return ret;
+}
+
 static int test_rstream_random(int idx)
 {
     unsigned char *bulk_data = NULL;
@@ -598,8 +840,10 @@ static int test_rstream_random(int idx)
 int setup_tests(void)
 {
     ADD_TEST(test_sstream_simple);
+    ADD_TEST(test_sstream_append_ref);
     ADD_ALL_TESTS(test_sstream_bulk, 100);
     ADD_ALL_TESTS(test_rstream_simple, 4);
+    ADD_TEST(test_rstream_zc);
     ADD_ALL_TESTS(test_rstream_random, 100);
     return 1;
 }
@@ -281,6 +281,93 @@ static int test_fin_only_blocking(void)
     return ret;
 }
 
+/*
+ * Test that a blocking SSL_poll() waits until the timeout when nothing
+ * happens, and wakes up when the peer opens a stream.
+ */
+static int test_poll_blocking(void)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    SSL_POLL_ITEM items[2] = {0};
+    struct timeval tv;
+    size_t result_count = 0, numbytes;
+    uint64_t sid;
+    OSSL_TIME timer, timediff;
+    int ret = 0;
+
+    if (!qtest_supports_blocking())
+        return TEST_skip("Blocking tests not supported in this build");
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL,
+                                                    cert, privkey,
+                                                    QTEST_FLAG_BLOCK,
+                                                    &qtserv, &clientquic,
+                                                    NULL, NULL))
+            || !TEST_true(SSL_set_tlsext_host_name(clientquic, "localhost"))
+            || !TEST_true(SSL_set_default_stream_mode(clientquic,
+                                                      SSL_DEFAULT_STREAM_MODE_NONE))
+            || !TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto end;
+
+    items[0].desc   = SSL_as_poll_descriptor(clientquic);
+    items[0].events = SSL_POLL_EVENT_ISB;
+    /* A NULL item is ignored */
+    items[1].desc   = SSL_as_poll_descriptor(NULL);
+    items[1].events = SSL_POLL_EVENT_R;
+
+    /* Blocking is not possible without handling events */
+    if (!TEST_false(SSL_poll(items, OSSL_NELEM(items), sizeof(items[0]),
+                             NULL, SSL_POLL_FLAG_NO_HANDLE_EVENTS,
+                             &result_count))
+            || !TEST_size_t_eq(result_count, 0))
+        goto end;
+    ERR_clear_error();
+
+    /* Nothing happens, so this times out */
+    tv.tv_sec  = 0;
+    tv.tv_usec = 200000;
+    timer = ossl_time_now();
+    if (!TEST_true(SSL_poll(items, OSSL_NELEM(items), sizeof(items[0]), &tv, 0,
+                            &result_count))
+            || !TEST_size_t_eq(result_count, 0)
+            || !TEST_uint64_t_eq(items[0].revents, 0))
+        goto end;
+    timediff = ossl_time_subtract(ossl_time_now(), timer);
+    if (!TEST_uint64_t_ge(ossl_time2ms(timediff), 200))
+        goto end;
+
+    if (!TEST_true(ossl_quic_tserver_stream_new(qtserv, 0, &sid))
+            || !TEST_true(ossl_quic_tserver_write(qtserv, sid,
+                                                  (unsigned char *)"x", 1,
+                                                  &numbytes)))
+        goto end;
+    ossl_quic_tserver_tick(qtserv);
+
+    /* The incoming stream wakes us up well before the timeout */
+    tv.tv_sec  = 10;
+    tv.tv_usec = 0;
+    timer = ossl_time_now();
+    if (!TEST_true(SSL_poll(items, OSSL_NELEM(items), sizeof(items[0]), &tv, 0,
+                            &result_count))
+            || !TEST_size_t_eq(result_count, 1)
+            || !TEST_uint64_t_eq(items[0].revents, SSL_POLL_EVENT_ISB)
+            || !TEST_uint64_t_eq(items[1].revents, 0))
+        goto end;
+    timediff = ossl_time_subtract(ossl_time_now(), timer);
+    if (!TEST_uint64_t_lt(ossl_time2ms(timediff), 5000))
+        goto end;
+
+    ret = 1;
+ end:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    return ret;
+}
+
 /* Test that a vanilla QUIC SSL object has the expected ciphersuites available */
 static int test_ciphersuites(void)
 {
@@ -1665,6 +1752,902 @@ static int test_bw_limit(void)
     return testresult;
 }
 
+/*
+ * Check the goodput achieved by each congestion controller when sending data
+ * over a transport with limited bandwidth and a moderate amount of noise. Both
+ * should make use of most of the bandwidth without exceeding it.
+ * Test 0: NewReno
+ * Test 1: BBR
+ */
+#define TEST_CC_TRANSFER_DATA_SIZE (512*1024)   /* 512 kBytes */
+#define TEST_CC_NOISE_RATE 20                   /* 1 in 20 datagrams */
+#define TEST_CC_MIN_GOODPUT (TEST_BW_LIMIT / 2) /* Bytes/ms */
+static int test_cc_goodput(int idx)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0;
+    unsigned char *msg = NULL, *recvbuf = NULL;
+    size_t sendlen = TEST_CC_TRANSFER_DATA_SIZE;
+    size_t recvlen = TEST_CC_TRANSFER_DATA_SIZE;
+    size_t written, readbytes;
+    int flags = QTEST_FLAG_NOISE | QTEST_FLAG_FAKE_TIME;
+    QTEST_FAULT *fault = NULL;
+    uint64_t alg, goodput;
+    static const char *alg_names[] = { "NewReno", "BBR" };
+
+    alg = (idx == 0) ? SSL_VALUE_QUIC_CC_ALGORITHM_NEWRENO
+                     : SSL_VALUE_QUIC_CC_ALGORITHM_BBR;
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey, flags,
+                                                    &qtserv,
+                                                    &clientquic, &fault, NULL)))
+        goto err;
+
+    if (!TEST_ptr(msg = OPENSSL_zalloc(TEST_SINGLE_WRITE_SIZE))
+        || !TEST_ptr(recvbuf = OPENSSL_zalloc(TEST_SINGLE_WRITE_SIZE)))
+        goto err;
+
+    if (!TEST_true(SSL_set_quic_cc_algorithm(clientquic, alg)))
+        goto err;
+
+    if (!TEST_true(qtest_fault_set_bw_limit(fault, TEST_BW_LIMIT, TEST_BW_LIMIT,
+                                            TEST_CC_NOISE_RATE)))
+        goto err;
+
+    if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+            goto err;
+
+    /* The algorithm cannot be changed once the connection has started. */
+    if (!TEST_false(SSL_set_quic_cc_algorithm(clientquic, 1 - alg))
+            || !TEST_true(SSL_get_quic_cc_algorithm(clientquic, &alg))
+            || !TEST_uint64_t_eq(alg, (uint64_t)idx))
+        goto err;
+
+    qtest_start_stopwatch();
+
+    while (recvlen > 0) {
+        qtest_add_time(1);
+
+        if (sendlen > 0) {
+            if (!SSL_write_ex(clientquic, msg,
+                              sendlen > TEST_SINGLE_WRITE_SIZE ? TEST_SINGLE_WRITE_SIZE
+                                                               : sendlen,
+                              &written)) {
+                if (!TEST_int_eq(SSL_get_error(clientquic, 0), SSL_ERROR_WANT_WRITE))
+                    goto err;
+            } else {
+                sendlen -= written;
+            }
+        } else {
+            SSL_handle_events(clientquic);
+        }
+
+        if (ossl_quic_tserver_read(qtserv, 0, recvbuf,
+                                   recvlen > TEST_SINGLE_WRITE_SIZE ? TEST_SINGLE_WRITE_SIZE
+                                                                    : recvlen,
+                                   &readbytes))
+            recvlen -= readbytes;
+
+        ossl_quic_tserver_tick(qtserv);
+    }
+    goodput = TEST_CC_TRANSFER_DATA_SIZE / qtest_get_stopwatch_time();
+
+    TEST_info("%s: BW limit: %d Bytes/ms, 1 in %d datagrams noisy, goodput: %llu Bytes/ms",
+              alg_names[idx], TEST_BW_LIMIT, TEST_CC_NOISE_RATE,
+              (unsigned long long)goodput);
+
+    if (!TEST_uint64_t_lt(goodput, TEST_BW_LIMIT)
+            || !TEST_uint64_t_ge(goodput, TEST_CC_MIN_GOODPUT))
+        goto err;
+
+    testresult = 1;
+ err:
+    OPENSSL_free(msg);
+    OPENSSL_free(recvbuf);
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    qtest_fault_free(fault);
+
+    return testresult;
+}
+
+/*
+ * Test that data written with SSL_write_zc() is received correctly and that
+ * the buffer is released once it has been acknowledged.
+ */
+static size_t zc_num_released;
+
+static void zc_release_cb(const void *buf, size_t num, void *arg)
+{
+    if (buf == arg && num == TEST_CC_TRANSFER_DATA_SIZE)
+        ++zc_num_released;
+}
+
+static int test_write_zc(void)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0;
+    unsigned char *msg = NULL, *recvbuf = NULL;
+    size_t recvlen = 0, readbytes, written, i;
+    QTEST_FAULT *fault = NULL;
+
+    zc_num_released = 0;
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, &fault, NULL)))
+        goto err;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(TEST_CC_TRANSFER_DATA_SIZE))
+        || !TEST_ptr(recvbuf = OPENSSL_zalloc(TEST_CC_TRANSFER_DATA_SIZE)))
+        goto err;
+
+    for (i = 0; i < TEST_CC_TRANSFER_DATA_SIZE; ++i)
+        msg[i] = (unsigned char)(i * 7);
+
+    if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto err;
+
+    /* Zero-length writes fail */
+    if (!TEST_false(SSL_write_zc(clientquic, msg, 0, 0, zc_release_cb, msg)))
+        goto err;
+
+    if (!TEST_true(SSL_write_zc(clientquic, msg, TEST_CC_TRANSFER_DATA_SIZE,
+                                SSL_WRITE_FLAG_CONCLUDE, zc_release_cb, msg)))
+        goto err;
+
+    /* The stream is concluded, so no more data can be written */
+    if (!TEST_false(SSL_write_ex(clientquic, msg, 1, &written)))
+        goto err;
+
+    while (recvlen < TEST_CC_TRANSFER_DATA_SIZE || zc_num_released == 0) {
+        qtest_add_time(1);
+        SSL_handle_events(clientquic);
+
+        if (recvlen < TEST_CC_TRANSFER_DATA_SIZE
+            && ossl_quic_tserver_read(qtserv, 0, recvbuf + recvlen,
+                                      TEST_CC_TRANSFER_DATA_SIZE - recvlen,
+                                      &readbytes))
+            recvlen += readbytes;
+
+        ossl_quic_tserver_tick(qtserv);
+
+        if (!TEST_size_t_le(zc_num_released, 1))
+            goto err;
+    }
+
+    if (!TEST_mem_eq(msg, TEST_CC_TRANSFER_DATA_SIZE,
+                     recvbuf, TEST_CC_TRANSFER_DATA_SIZE)
+        || !TEST_true(ossl_quic_tserver_has_read_ended(qtserv, 0)))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    qtest_fault_free(fault);
+    /* The buffer must not be freed until it has been released */
+    OPENSSL_free(msg);
+    OPENSSL_free(recvbuf);
+
+    return testresult;
+}
+
+/*
+ * Test SSL_writev() with partial writes and SSL_readv() on a QUIC stream
+ */
+static int test_writev(void)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0;
+    unsigned char *msg = NULL, *recvbuf = NULL;
+    static const char reply[] = "a reply read into several buffers";
+    char replybuf[sizeof(reply)];
+    SSL_CONST_IOVEC wiov[5];
+    SSL_IOVEC riov[3];
+    size_t sentlen = 0, recvlen = 0, readbytes, written, i, first;
+    QTEST_FAULT *fault = NULL;
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, &fault, NULL)))
+        goto err;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(TEST_CC_TRANSFER_DATA_SIZE))
+        || !TEST_ptr(recvbuf = OPENSSL_zalloc(TEST_CC_TRANSFER_DATA_SIZE)))
+        goto err;
+
+    for (i = 0; i < TEST_CC_TRANSFER_DATA_SIZE; ++i)
+        msg[i] = (unsigned char)(i * 7);
+
+    /* Uneven buffers, one of them empty */
+    wiov[0].buf = msg;
+    wiov[0].buf_len = 100;
+    wiov[1].buf = msg + 100;
+    wiov[1].buf_len = 0;
+    wiov[2].buf = msg + 100;
+    wiov[2].buf_len = 70000;
+    wiov[3].buf = msg + 70100;
+    wiov[3].buf_len = 1;
+    wiov[4].buf = msg + 70101;
+    wiov[4].buf_len = TEST_CC_TRANSFER_DATA_SIZE - 70101;
+
+    SSL_set_mode(clientquic, SSL_MODE_ENABLE_PARTIAL_WRITE);
+
+    if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto err;
+
+    while (recvlen < TEST_CC_TRANSFER_DATA_SIZE) {
+        if (sentlen < TEST_CC_TRANSFER_DATA_SIZE) {
+            /* Skip what has been written and resume from there */
+            for (first = 0; wiov[first].buf_len == 0; first++)
+                continue;
+            if (SSL_writev(clientquic, wiov + first, OSSL_NELEM(wiov) - first,
+                           &written)) {
+                sentlen += written;
+                for (i = first; written > 0; i++) {
+                    size_t n = written < wiov[i].buf_len ? written
+                                                         : wiov[i].buf_len;
+
+                    wiov[i].buf = (const unsigned char *)wiov[i].buf + n;
+                    wiov[i].buf_len -= n;
+                    written -= n;
+                }
+            } else if (!TEST_int_eq(SSL_get_error(clientquic, 0),
+                                    SSL_ERROR_WANT_WRITE)) {
+                goto err;
+            }
+        }
+
+        qtest_add_time(1);
+        SSL_handle_events(clientquic);
+
+        if (ossl_quic_tserver_read(qtserv, 0, recvbuf + recvlen,
+                                   TEST_CC_TRANSFER_DATA_SIZE - recvlen,
+                                   &readbytes))
+            recvlen += readbytes;
+
+        ossl_quic_tserver_tick(qtserv);
+    }
+
+    if (!TEST_mem_eq(msg, TEST_CC_TRANSFER_DATA_SIZE,
+                     recvbuf, TEST_CC_TRANSFER_DATA_SIZE))
+        goto err;
+
+    /* Now read the reply of the server into several buffers */
+    if (!TEST_true(ossl_quic_tserver_write(qtserv, 0,
+                                           (const unsigned char *)reply,
+                                           sizeof(reply), &written))
+            || !TEST_size_t_eq(written, sizeof(reply)))
+        goto err;
+
+    for (recvlen = 0; recvlen < sizeof(reply); ) {
+        ossl_quic_tserver_tick(qtserv);
+        qtest_add_time(1);
+
+        riov[0].buf = replybuf + recvlen;
+        riov[0].buf_len = recvlen < 5 ? 5 - recvlen : 0;
+        riov[1].buf = replybuf + recvlen + riov[0].buf_len;
+        riov[1].buf_len = recvlen < 10 ? 10 - recvlen - riov[0].buf_len : 0;
+        riov[2].buf = replybuf + recvlen + riov[0].buf_len + riov[1].buf_len;
+        riov[2].buf_len = sizeof(reply) - recvlen - riov[0].buf_len
+                          - riov[1].buf_len;
+        if (SSL_readv(clientquic, riov, OSSL_NELEM(riov), &readbytes))
+            recvlen += readbytes;
+        else if (!TEST_int_eq(SSL_get_error(clientquic, 0),
+                              SSL_ERROR_WANT_READ))
+            goto err;
+    }
+
+    if (!TEST_mem_eq(reply, sizeof(reply), replybuf, recvlen))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    qtest_fault_free(fault);
+    OPENSSL_free(msg);
+    OPENSSL_free(recvbuf);
+
+    return testresult;
+}
+
+static int test_read_peek_zc(void)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0, ret;
+    unsigned char *msg = NULL, *recvbuf = NULL, byte = 0;
+    size_t sentlen = 0, recvlen = 0, readbytes, written, num_iov, i;
+    SSL_CONST_IOVEC iov[2];
+    QTEST_FAULT *fault = NULL;
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, &fault, NULL)))
+        goto err;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(TEST_CC_TRANSFER_DATA_SIZE))
+        || !TEST_ptr(recvbuf = OPENSSL_zalloc(TEST_CC_TRANSFER_DATA_SIZE)))
+        goto err;
+
+    for (i = 0; i < TEST_CC_TRANSFER_DATA_SIZE; ++i)
+        msg[i] = (unsigned char)(i * 13);
+
+    if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto err;
+
+    /* Open stream 0 so that the server can send on it. */
+    if (!TEST_true(SSL_write_ex(clientquic, &byte, 1, &written)))
+        goto err;
+
+    /* Nothing has been peeked yet, so there is nothing to release */
+    if (!TEST_false(SSL_read_release(clientquic, 0)))
+        goto err;
+
+    num_iov = 0;
+    if (!TEST_false(SSL_read_peek_zc(clientquic, iov, &num_iov, &readbytes)))
+        goto err;
+
+    for (;;) {
+        qtest_add_time(1);
+        ossl_quic_tserver_tick(qtserv);
+
+        if (sentlen < TEST_CC_TRANSFER_DATA_SIZE) {
+            if (ossl_quic_tserver_write(qtserv, 0, msg + sentlen,
+                                        TEST_CC_TRANSFER_DATA_SIZE - sentlen,
+                                        &written))
+                sentlen += written;
+
+            if (sentlen == TEST_CC_TRANSFER_DATA_SIZE
+                && !TEST_true(ossl_quic_tserver_conclude(qtserv, 0)))
+                goto err;
+        }
+
+        num_iov = OSSL_NELEM(iov);
+        ret = SSL_read_peek_zc(clientquic, iov, &num_iov, &readbytes);
+        if (!ret) {
+            if (SSL_get_error(clientquic, ret) == SSL_ERROR_ZERO_RETURN)
+                break;
+            if (!TEST_int_eq(SSL_get_error(clientquic, ret),
+                             SSL_ERROR_WANT_READ))
+                goto err;
+            continue;
+        }
+
+        if (!TEST_size_t_gt(num_iov, 0)
+            || !TEST_size_t_le(num_iov, OSSL_NELEM(iov))
+            || !TEST_size_t_le(recvlen + readbytes,
+                               TEST_CC_TRANSFER_DATA_SIZE))
+            goto err;
+
+        /* Consume only part of the data if there is more than one byte */
+        if (readbytes > 1)
+            readbytes /= 2;
+
+        for (i = 0, written = 0; written < readbytes; ++i) {
+            size_t l = iov[i].buf_len;
+
+            if (l > readbytes - written)
+                l = readbytes - written;
+            memcpy(recvbuf + recvlen + written, iov[i].buf, l);
+            written += l;
+        }
+
+        if (!TEST_true(SSL_read_release(clientquic, readbytes)))
+            goto err;
+
+        recvlen += readbytes;
+
+        /* A second release without a peek is an error */
+        if (!TEST_false(SSL_read_release(clientquic, 0)))
+            goto err;
+    }
+
+    if (!TEST_mem_eq(msg, TEST_CC_TRANSFER_DATA_SIZE, recvbuf, recvlen))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    qtest_fault_free(fault);
+    OPENSSL_free(msg);
+    OPENSSL_free(recvbuf);
+
+    return testresult;
+}
+
+/*
+ * Test RFC 9221 DATAGRAM frames.
+ * idx == 0: Both endpoints accept datagrams
+ * idx == 1: Only the client accepts datagrams
+ */
+#define TEST_DATAGRAM_MAX_FRAME_SIZE    1200
+#define TEST_DATAGRAM_NUM               100
+
+static int test_datagram(int idx)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0, ret;
+    unsigned char buf[TEST_DATAGRAM_MAX_FRAME_SIZE];
+    size_t readbytes, i, num_read;
+    uint64_t v;
+    static const unsigned char msg[] = "telemetry";
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, NULL, NULL)))
+        goto err;
+
+    /* Datagrams are disabled by default */
+    if (!TEST_true(SSL_get_feature_request_uint(clientquic,
+                                                SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE,
+                                                &v))
+        || !TEST_uint64_t_eq(v, 0)
+        || !TEST_true(SSL_set_feature_request_uint(clientquic,
+                                                   SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE,
+                                                   TEST_DATAGRAM_MAX_FRAME_SIZE)))
+        goto err;
+
+    if (idx == 0)
+        ossl_quic_tserver_set_max_datagram_frame_size(qtserv,
+                                                      TEST_DATAGRAM_MAX_FRAME_SIZE);
+
+    if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto err;
+
+    /* The request cannot be changed after the handshake */
+    if (!TEST_false(SSL_set_feature_request_uint(clientquic,
+                                                 SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE,
+                                                 0))
+        || !TEST_true(SSL_get_feature_peer_request_uint(clientquic,
+                                                        SSL_VALUE_QUIC_DATAGRAM_MAX_FRAME_SIZE,
+                                                        &v))
+        || !TEST_uint64_t_eq(v, idx == 0 ? TEST_DATAGRAM_MAX_FRAME_SIZE : 0)
+        || !TEST_true(SSL_get_quic_datagram_max_write_size(clientquic, &v)))
+        goto err;
+
+    if (idx == 1) {
+        /* The server does not accept datagrams, so we cannot send any */
+        if (!TEST_uint64_t_eq(v, 0)
+            || !TEST_false(SSL_write_datagram(clientquic, msg, sizeof(msg)))
+            || !TEST_int_eq(ERR_GET_REASON(ERR_peek_last_error()),
+                            SSL_R_DATAGRAMS_NOT_NEGOTIATED))
+            goto err;
+    } else {
+        if (!TEST_uint64_t_gt(v, 0)
+            || !TEST_uint64_t_lt(v, TEST_DATAGRAM_MAX_FRAME_SIZE)
+            || !TEST_false(SSL_write_datagram(clientquic, buf, (size_t)v + 1))
+            || !TEST_int_eq(ERR_GET_REASON(ERR_peek_last_error()),
+                            SSL_R_DATA_LENGTH_TOO_LONG))
+            goto err;
+
+        /* A datagram of the maximum size and an empty datagram */
+        memset(buf, 'A', sizeof(buf));
+        if (!TEST_true(SSL_write_datagram(clientquic, buf, (size_t)v))
+            || !TEST_true(SSL_write_datagram(clientquic, msg, 0))
+            || !TEST_true(SSL_write_datagram(clientquic, msg, sizeof(msg))))
+            goto err;
+
+        for (i = 0; i < 3;) {
+            qtest_add_time(1);
+            ossl_quic_tserver_tick(qtserv);
+            if (!ossl_quic_tserver_read_datagram(qtserv, buf, sizeof(buf),
+                                                 &readbytes))
+                continue;
+
+            if ((i == 0 && !TEST_size_t_eq(readbytes, (size_t)v))
+                || (i == 1 && !TEST_size_t_eq(readbytes, 0))
+                || (i == 2 && !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))))
+                goto err;
+
+            ++i;
+        }
+    }
+
+    /* Server to client */
+    if (!TEST_true(ossl_quic_tserver_write_datagram(qtserv, msg, sizeof(msg))))
+        goto err;
+
+    for (;;) {
+        qtest_add_time(1);
+        ossl_quic_tserver_tick(qtserv);
+
+        /* A buffer which is too small fails without consuming the datagram */
+        ret = SSL_read_datagram(clientquic, buf, 1, &readbytes);
+        if (!ret && SSL_get_error(clientquic, ret) == SSL_ERROR_WANT_READ)
+            continue;
+
+        if (!TEST_false(ret)
+            || !TEST_int_eq(ERR_GET_REASON(ERR_peek_last_error()),
+                            SSL_R_BAD_LENGTH))
+            goto err;
+        break;
+    }
+
+    if (!TEST_true(SSL_read_datagram(clientquic, buf, sizeof(buf), &readbytes))
+        || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))
+        || !TEST_false(SSL_read_datagram(clientquic, buf, sizeof(buf),
+                                         &readbytes))
+        || !TEST_int_eq(SSL_get_error(clientquic, 0), SSL_ERROR_WANT_READ))
+        goto err;
+
+    /*
+     * Datagrams the client does not read are dropped once its receive queue is
+     * full, oldest first.
+     */
+    for (i = 0; i < TEST_DATAGRAM_NUM; ++i) {
+        buf[0] = (unsigned char)i;
+        if (!TEST_true(ossl_quic_tserver_write_datagram(qtserv, buf, 1)))
+            goto err;
+    }
+
+    for (i = 0; i < 50; ++i) {
+        qtest_add_time(1);
+        ossl_quic_tserver_tick(qtserv);
+        SSL_handle_events(clientquic);
+    }
+
+    for (num_read = 0;; ++num_read) {
+        if (!SSL_read_datagram(clientquic, buf, sizeof(buf), &readbytes))
+            break;
+
+        if (!TEST_size_t_eq(readbytes, 1))
+            goto err;
+    }
+
+    if (!TEST_size_t_gt(num_read, 0)
+        || !TEST_size_t_lt(num_read, TEST_DATAGRAM_NUM)
+        || !TEST_int_eq(buf[0], TEST_DATAGRAM_NUM - 1))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/*
+ * Test QUIC 0-RTT data.
+ * Test 0: The server accepts 0-RTT data
+ * Test 1: The server does not permit 0-RTT data in the resumed connection
+ * Test 2: The client replays a ticket, which the server must reject
+ * Test 3: The server's transport parameters have changed since it issued the
+ *         ticket, so it resumes the session but rejects 0-RTT data
+ */
+static int test_quic_early_data(int idx)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL_CTX *sctx = NULL;
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    SSL_SESSION *sess = NULL;
+    int k, testresult = 0;
+    unsigned char buf[64];
+    static char *msg = "A test message";
+    size_t msglen = strlen(msg);
+    size_t numbytes = 0, total, expected;
+    uint64_t v;
+
+    if (!TEST_ptr(cctx))
+        goto err;
+
+    /*
+     * Connection 0 gets a ticket, which is used by all remaining connections.
+     * In test 2 the ticket is used twice.
+     */
+    for (k = 0; k < (idx == 2 ? 3 : 2); k++) {
+        if (!TEST_true(qtest_create_quic_objects(libctx, cctx, sctx, cert,
+                                                 privkey, 0, &qtserv,
+                                                 &clientquic, NULL, NULL))
+                || !TEST_true(SSL_set_tlsext_host_name(clientquic,
+                                                       "localhost")))
+            goto err;
+
+        if (k == 0 || idx != 1)
+            ossl_quic_tserver_set_max_early_data(qtserv, 0xffffffff);
+        if (k > 0 && idx == 3)
+            ossl_quic_tserver_set_max_datagram_frame_size(qtserv, 1200);
+
+        if (!TEST_true(SSL_get_quic_early_data_enabled(clientquic, &v))
+                || !TEST_uint64_t_eq(v, 0))
+            goto err;
+
+        if (k == 0) {
+            if (!TEST_true(qtest_create_quic_connection(qtserv, clientquic))
+                    || !TEST_int_eq(SSL_get_early_data_status(clientquic),
+                                    SSL_EARLY_DATA_NOT_SENT)
+                    /* Cannot be enabled once the connection has started */
+                    || !TEST_false(SSL_set_quic_early_data_enabled(clientquic,
+                                                                   1)))
+                goto err;
+        } else {
+            if (!TEST_true(SSL_set_session(clientquic, sess))
+                    || !TEST_true(SSL_set_quic_early_data_enabled(clientquic,
+                                                                  1))
+                    || !TEST_true(SSL_get_quic_early_data_enabled(clientquic,
+                                                                  &v))
+                    || !TEST_uint64_t_eq(v, 1))
+                goto err;
+
+            /* We can write before the handshake has even started. */
+            if (!TEST_true(SSL_write_ex(clientquic, msg, msglen, &numbytes))
+                    || !TEST_size_t_eq(numbytes, msglen)
+                    || !TEST_false(SSL_is_init_finished(clientquic))
+                    || !TEST_true(qtest_create_quic_connection(qtserv,
+                                                               clientquic)))
+                goto err;
+
+            if (idx == 0 || (idx == 2 && k == 1)) {
+                if (!TEST_int_eq(SSL_get_early_data_status(clientquic),
+                                 SSL_EARLY_DATA_ACCEPTED)
+                        || !TEST_true(SSL_session_reused(clientquic)))
+                    goto err;
+            } else if (idx == 3) {
+                if (!TEST_int_eq(SSL_get_early_data_status(clientquic),
+                                 SSL_EARLY_DATA_REJECTED)
+                        || !TEST_true(SSL_session_reused(clientquic)))
+                    goto err;
+            } else {
+                /*
+                 * In test 1 the server cannot resume the single-use ticket as
+                 * it does not accept 0-RTT data. In test 2 the replayed ticket
+                 * has already been used. Either way a full handshake is done.
+                 */
+                if (!TEST_int_eq(SSL_get_early_data_status(clientquic),
+                                 SSL_EARLY_DATA_REJECTED)
+                        || !TEST_false(SSL_session_reused(clientquic)))
+                    goto err;
+            }
+        }
+
+        /* Whether or not it was sent as 0-RTT data, the server gets it. */
+        if (!TEST_true(SSL_write_ex(clientquic, msg, msglen, &numbytes)))
+            goto err;
+
+        expected = (k == 0 ? 1 : 2) * msglen;
+        for (total = 0; total < expected; total += numbytes) {
+            ossl_quic_tserver_tick(qtserv);
+            if (!TEST_true(ossl_quic_tserver_read(qtserv, 0, buf + total,
+                                                  expected - total,
+                                                  &numbytes)))
+                goto err;
+        }
+
+        if (!TEST_mem_eq(buf, msglen, msg, msglen)
+                || !TEST_mem_eq(buf + expected - msglen, msglen, msg, msglen))
+            goto err;
+
+        if (k == 0) {
+            /* The client needs to see the ticket. */
+            if (!TEST_true(ossl_quic_tserver_write(qtserv, 0,
+                                                   (unsigned char *)msg,
+                                                   msglen, &numbytes)))
+                goto err;
+            do {
+                ossl_quic_tserver_tick(qtserv);
+            } while (!SSL_read_ex(clientquic, buf, sizeof(buf), &numbytes));
+
+            sess = SSL_get1_session(clientquic);
+            if (!TEST_ptr(sess)
+                    || !TEST_uint_eq(SSL_SESSION_get_max_early_data(sess),
+                                     0xffffffff))
+                goto err;
+        }
+
+        if (!TEST_true(qtest_shutdown(qtserv, clientquic)))
+            goto err;
+
+        if (sctx == NULL) {
+            sctx = ossl_quic_tserver_get0_ssl_ctx(qtserv);
+            if (!TEST_true(SSL_CTX_up_ref(sctx))) {
+                sctx = NULL;
+                goto err;
+            }
+        }
+        ossl_quic_tserver_free(qtserv);
+        qtserv = NULL;
+        SSL_free(clientquic);
+        clientquic = NULL;
+    }
+
+    testresult = 1;
+ err:
+    SSL_SESSION_free(sess);
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+    SSL_CTX_free(sctx);
+
+    return testresult;
+}
+
+/*
+ * Data peeked with SSL_read_peek_zc() must stay valid when the peer resets the
+ * stream. In test 0 the data is then released, after which the reset is
+ * reported; in test 1 the connection is freed without releasing it.
+ */
+static int test_read_peek_zc_reset(int idx)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0, ret;
+    unsigned char msg[64], buf[64], byte = 0;
+    size_t readbytes, written, num_iov, i, off;
+    SSL_CONST_IOVEC iov[4];
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, NULL, NULL))
+            || !TEST_true(qtest_create_quic_connection(qtserv, clientquic)))
+        goto err;
+
+    for (i = 0; i < sizeof(msg); ++i)
+        msg[i] = (unsigned char)(i * 7);
+
+    /* Open stream 0 so that the server can send on it. */
+    if (!TEST_true(SSL_write_ex(clientquic, &byte, 1, &written)))
+        goto err;
+
+    for (i = 0; i < 100; ++i) {
+        qtest_add_time(1);
+        ossl_quic_tserver_tick(qtserv);
+        if (i == 0
+                && !TEST_true(ossl_quic_tserver_write(qtserv, 0, msg,
+                                                      sizeof(msg), &written)))
+            goto err;
+
+        num_iov = OSSL_NELEM(iov);
+        ret = SSL_read_peek_zc(clientquic, iov, &num_iov, &readbytes);
+        if (ret && readbytes == sizeof(msg))
+            break;
+        if (!ret && !TEST_int_eq(SSL_get_error(clientquic, ret),
+                                 SSL_ERROR_WANT_READ))
+            goto err;
+    }
+    if (!TEST_size_t_lt(i, 100))
+        goto err;
+
+    if (!TEST_true(ossl_quic_tserver_stream_reset(qtserv, 0, 42)))
+        goto err;
+
+    for (i = 0; i < 100; ++i) {
+        qtest_add_time(1);
+        ossl_quic_tserver_tick(qtserv);
+        SSL_handle_events(clientquic);
+        if (SSL_get_stream_read_state(clientquic)
+                == SSL_STREAM_STATE_RESET_REMOTE)
+            break;
+    }
+    if (!TEST_size_t_lt(i, 100))
+        goto err;
+
+    /* The peeked data must still be intact. */
+    for (i = 0, off = 0; i < num_iov; off += iov[i].buf_len, ++i)
+        memcpy(buf + off, iov[i].buf, iov[i].buf_len);
+    if (!TEST_mem_eq(buf, off, msg, sizeof(msg)))
+        goto err;
+
+    if (idx == 0) {
+        if (!TEST_true(SSL_read_release(clientquic, readbytes / 2))
+                || !TEST_false(SSL_read_ex(clientquic, buf, sizeof(buf),
+                                           &readbytes))
+                || !TEST_int_eq(SSL_get_error(clientquic, 0), SSL_ERROR_SSL))
+            goto err;
+    }
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/*
+ * In explicit event handling mode a write does not tick the connection, so it
+ * must instead make the connection due for event handling straight away.
+ */
+static int test_explicit_write(void)
+{
+    SSL_CTX *cctx = SSL_CTX_new_ex(libctx, NULL, OSSL_QUIC_client_method());
+    SSL *clientquic = NULL;
+    QUIC_TSERVER *qtserv = NULL;
+    int testresult = 0, is_infinite;
+    static const unsigned char msg[] = "explicit";
+    unsigned char buf[sizeof(msg)];
+    size_t written, readbytes = 0, i;
+    struct timeval tv;
+
+    if (!TEST_ptr(cctx)
+            || !TEST_true(qtest_create_quic_objects(libctx, cctx, NULL, cert,
+                                                    privkey,
+                                                    QTEST_FLAG_FAKE_TIME,
+                                                    &qtserv,
+                                                    &clientquic, NULL, NULL))
+            || !TEST_true(qtest_create_quic_connection(qtserv, clientquic))
+            || !TEST_true(SSL_set_event_handling_mode(clientquic,
+                                                      SSL_VALUE_EVENT_HANDLING_MODE_EXPLICIT)))
+        goto err;
+
+    /* Let the connection settle until nothing is due immediately. */
+    for (i = 0; i < 100; ++i) {
+        SSL_handle_events(clientquic);
+        ossl_quic_tserver_tick(qtserv);
+        if (!TEST_true(SSL_get_event_timeout(clientquic, &tv, &is_infinite)))
+            goto err;
+        if (is_infinite || tv.tv_sec > 0 || tv.tv_usec > 0)
+            break;
+        qtest_add_time(1);
+    }
+    if (!TEST_size_t_lt(i, 100))
+        goto err;
+
+    if (!TEST_true(SSL_write_ex(clientquic, msg, sizeof(msg), &written))
+            || !TEST_size_t_eq(written, sizeof(msg))
+            || !TEST_true(SSL_get_event_timeout(clientquic, &tv, &is_infinite))
+            || !TEST_false(is_infinite)
+            || !TEST_long_eq((long)tv.tv_sec, 0)
+            || !TEST_long_eq((long)tv.tv_usec, 0))
+        goto err;
+
+    for (i = 0; i < 100 && readbytes == 0; ++i) {
+        SSL_handle_events(clientquic);
+        ossl_quic_tserver_tick(qtserv);
+        if (!TEST_true(ossl_quic_tserver_read(qtserv, 0, buf, sizeof(buf),
+                                              &readbytes)))
+            goto err;
+        qtest_add_time(1);
+    }
+    if (!TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+        goto err;
+
+    testresult = 1;
+ err:
+    ossl_quic_tserver_free(qtserv);
+    SSL_free(clientquic);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
 enum {
     TPARAM_OP_DUP,
     TPARAM_OP_DROP,
@@ -2246,6 +3229,7 @@ int setup_tests(void)
 
     ADD_ALL_TESTS(test_quic_write_read, 3);
     ADD_TEST(test_fin_only_blocking);
+    ADD_TEST(test_poll_blocking);
     ADD_TEST(test_ciphersuites);
     ADD_TEST(test_cipher_find);
     ADD_TEST(test_version);
@@ -2265,6 +3249,14 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_alpn, 2);
     ADD_ALL_TESTS(test_noisy_dgram, 2);
     ADD_TEST(test_bw_limit);
+    ADD_ALL_TESTS(test_cc_goodput, 2);
+    ADD_TEST(test_write_zc);
+    ADD_TEST(test_read_peek_zc);
+    ADD_ALL_TESTS(test_read_peek_zc_reset, 2);
+    ADD_TEST(test_explicit_write);
+    ADD_TEST(test_writev);
+    ADD_ALL_TESTS(test_datagram, 2);
+    ADD_ALL_TESTS(test_quic_early_data, 4);
     ADD_TEST(test_get_shutdown);
     ADD_ALL_TESTS(test_tparam, OSSL_NELEM(tparam_tests));
 
@@ -4705,6 +4705,72 @@ static int test_early_data_tls1_2(int idx)
 }
 # endif /* OPENSSL_NO_TLS1_2 */
 
+/*
+ * Test that SSL_CTXs configured with the same cipher string get the same, but
+ * independent, cipher lists, including the side effects of the string
+ */
+static int test_cipher_list_reuse(void)
+{
+    SSL_CTX *ctx1 = NULL, *ctx2 = NULL;
+    SSL *ssl = NULL;
+    STACK_OF(SSL_CIPHER) *sk1, *sk2;
+    const char *str = "DEFAULT:!AES256:@SECLEVEL=0";
+    int i, testresult = 0;
+
+    if (!TEST_ptr(ctx1 = SSL_CTX_new_ex(libctx, NULL, TLS_method()))
+            || !TEST_ptr(ctx2 = SSL_CTX_new_ex(libctx, NULL, TLS_method())))
+        goto end;
+
+    SSL_CTX_set_security_level(ctx1, 3);
+    SSL_CTX_set_security_level(ctx2, 3);
+    if (!TEST_true(SSL_CTX_set_cipher_list(ctx1, str))
+            || !TEST_true(SSL_CTX_set_cipher_list(ctx2, str))
+            || !TEST_int_eq(SSL_CTX_get_security_level(ctx1), 0)
+            || !TEST_int_eq(SSL_CTX_get_security_level(ctx2), 0))
+        goto end;
+
+    sk1 = SSL_CTX_get_ciphers(ctx1);
+    sk2 = SSL_CTX_get_ciphers(ctx2);
+    if (!TEST_ptr_ne(sk1, sk2)
+            || !TEST_int_gt(sk_SSL_CIPHER_num(sk1), 0)
+            || !TEST_int_eq(sk_SSL_CIPHER_num(sk1), sk_SSL_CIPHER_num(sk2)))
+        goto end;
+    for (i = 0; i < sk_SSL_CIPHER_num(sk1); i++)
+        if (!TEST_ptr_eq(sk_SSL_CIPHER_value(sk1, i),
+                         sk_SSL_CIPHER_value(sk2, i)))
+            goto end;
+
+    /* Changing the list of one SSL_CTX must not affect the other one */
+    i = sk_SSL_CIPHER_num(sk2);
+    if (!TEST_true(SSL_CTX_set_ciphersuites(ctx1, "TLS_AES_128_GCM_SHA256"))
+            || !TEST_int_lt(sk_SSL_CIPHER_num(SSL_CTX_get_ciphers(ctx1)), i)
+            || !TEST_int_eq(sk_SSL_CIPHER_num(SSL_CTX_get_ciphers(ctx2)), i))
+        goto end;
+
+    /* The same string with other TLSv1.3 ciphersuites gives another list */
+    if (!TEST_true(SSL_CTX_set_ciphersuites(ctx2, "TLS_AES_256_GCM_SHA384"))
+            || !TEST_true(SSL_CTX_set_cipher_list(ctx2, str))
+            || !TEST_str_eq(SSL_CIPHER_get_name(sk_SSL_CIPHER_value(
+                                SSL_CTX_get_ciphers(ctx2), 0)),
+                            "TLS_AES_256_GCM_SHA384"))
+        goto end;
+
+    /* The security level is also set for an SSL */
+    if (!TEST_ptr(ssl = SSL_new(ctx2)))
+        goto end;
+    SSL_set_security_level(ssl, 3);
+    if (!TEST_true(SSL_set_cipher_list(ssl, str))
+            || !TEST_int_eq(SSL_get_security_level(ssl), 0))
+        goto end;
+
+    testresult = 1;
+end:
+    SSL_free(ssl);
+    SSL_CTX_free(ctx1);
+    SSL_CTX_free(ctx2);
+    return testresult;
+}
+
 /*
  * Test configuring the TLSv1.3 ciphersuites
  *
@@ -9346,6 +9412,13 @@ static int test_session_timeout(int test)
     memset(middle->session_id, 2, SSL3_SSL_SESSION_ID_LENGTH);
     late->session_id_length = SSL3_SSL_SESSION_ID_LENGTH;
     memset(late->session_id, 3, SSL3_SSL_SESSION_ID_LENGTH);
+    /*
+     * The cache shard is picked from the last byte of the session id, keep
+     * all three in the same shard so that their relative order is visible
+     */
+    early->session_id[SSL3_SSL_SESSION_ID_LENGTH - 1] = 0;
+    middle->session_id[SSL3_SSL_SESSION_ID_LENGTH - 1] = 0;
+    late->session_id[SSL3_SSL_SESSION_ID_LENGTH - 1] = 0;
 
     if (!TEST_int_eq(SSL_CTX_add_session(ctx, early), 1)
         || !TEST_int_eq(SSL_CTX_add_session(ctx, middle), 1)
@@ -9402,7 +9475,14 @@ static int test_session_timeout(int test)
         || !TEST_ptr_null(late->prev))
         goto end;
 
-    /* Add them back in again */
+    /*
+     * Add them back in again. Adding a session drops expired ones from the
+     * cache, so move them all into the future first.
+     */
+    if (!TEST_time_t_ne(SSL_SESSION_set_time_ex(early, now + 10), 0)
+        || !TEST_time_t_ne(SSL_SESSION_set_time_ex(middle, now + 20), 0)
+        || !TEST_time_t_ne(SSL_SESSION_set_time_ex(late, now + 30), 0))
+        goto end;
     if (!TEST_int_eq(SSL_CTX_add_session(ctx, early), 1)
         || !TEST_int_eq(SSL_CTX_add_session(ctx, middle), 1)
         || !TEST_int_eq(SSL_CTX_add_session(ctx, late), 1))
@@ -9440,6 +9520,336 @@ static int test_session_timeout(int test)
     return testresult;
 }
 
+/*
+ * Test that the session cache size is honoured across all the cache shards and
+ * that SSL_CTX_sessions_doall() and SSL_CTX_sessions() still see every cached
+ * session
+ */
+static long doall_count;
+
+static void count_and_remove_session(SSL_SESSION *s, void *arg)
+{
+    doall_count++;
+    /* Removing the sessions from the cache must not upset the iteration */
+    if (arg != NULL && !SSL_CTX_remove_session(arg, s))
+        doall_count = -1000;
+}
+
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+static int snapshot_ok;
+
+static void check_snapshot_session(SSL_SESSION *s)
+{
+    if (s->session_id_length != SSL3_SSL_SESSION_ID_LENGTH)
+        snapshot_ok = 0;
+}
+#endif
+
+static int test_session_cache_shards(void)
+{
+    SSL_SESSION *sess[40] = { NULL };
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+    LHASH_OF(SSL_SESSION) *snapshot = NULL;
+    unsigned long num_snapshot = 0;
+#endif
+    SSL_CTX *ctx;
+    size_t i;
+    int testresult = 0;
+#define CACHE_SIZE 20
+
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+    snapshot_ok = 1;
+#endif
+
+    if (!TEST_ptr(ctx = SSL_CTX_new_ex(libctx, NULL, TLS_method())))
+        goto end;
+    SSL_CTX_sess_set_cache_size(ctx, CACHE_SIZE);
+
+    for (i = 0; i < OSSL_NELEM(sess); i++) {
+        if (!TEST_ptr(sess[i] = SSL_SESSION_new()))
+            goto end;
+        sess[i]->session_id_length = SSL3_SSL_SESSION_ID_LENGTH;
+        memset(sess[i]->session_id, (int)i + 1, SSL3_SSL_SESSION_ID_LENGTH);
+        if (!TEST_int_eq(SSL_CTX_add_session(ctx, sess[i]), 1)
+            || !TEST_long_le(SSL_CTX_sess_number(ctx), CACHE_SIZE))
+            goto end;
+    }
+
+    if (!TEST_long_gt(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+    if (!TEST_ptr(snapshot = SSL_CTX_sessions(ctx))
+        || !TEST_ulong_eq(num_snapshot = lh_SSL_SESSION_num_items(snapshot),
+                          (unsigned long)SSL_CTX_sess_number(ctx)))
+        goto end;
+#endif
+
+    /* The most recently added session must have survived */
+    if (!TEST_ptr(sess[OSSL_NELEM(sess) - 1]->prev))
+        goto end;
+
+    doall_count = 0;
+    if (!TEST_true(SSL_CTX_sessions_doall(ctx, count_and_remove_session, NULL))
+            || !TEST_long_eq(doall_count, SSL_CTX_sess_number(ctx)))
+        goto end;
+    doall_count = 0;
+    if (!TEST_true(SSL_CTX_sessions_doall(ctx, count_and_remove_session, ctx))
+            || !TEST_long_gt(doall_count, 0)
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+
+    SSL_CTX_flush_sessions_ex(ctx, 0);
+    if (!TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+#ifndef OPENSSL_NO_DEPRECATED_3_4
+    /*
+     * The snapshot keeps the sessions that have left the cache alive until
+     * it is replaced, even once they have been freed by the test
+     */
+    for (i = 0; i < OSSL_NELEM(sess); i++) {
+        SSL_SESSION_free(sess[i]);
+        sess[i] = NULL;
+    }
+    if (!TEST_ulong_eq(lh_SSL_SESSION_num_items(snapshot), num_snapshot))
+        goto end;
+    lh_SSL_SESSION_doall(snapshot, check_snapshot_session);
+    if (!TEST_true(snapshot_ok)
+        || !TEST_ulong_eq(lh_SSL_SESSION_num_items(SSL_CTX_sessions(ctx)), 0))
+        goto end;
+#endif
+
+    testresult = 1;
+ end:
+    SSL_CTX_free(ctx);
+    for (i = 0; i < OSSL_NELEM(sess); i++)
+        SSL_SESSION_free(sess[i]);
+    return testresult;
+}
+
+/*
+ * Test that a cached session whose ID is changed moves to the shard of its new
+ * ID, and can still be updated and removed through the cache
+ */
+static int test_session_cache_set1_id(void)
+{
+    SSL_SESSION *sess = NULL;
+    SSL_CTX *ctx;
+    unsigned char id[SSL3_SSL_SESSION_ID_LENGTH];
+    int testresult = 0;
+
+    if (!TEST_ptr(ctx = SSL_CTX_new_ex(libctx, NULL, TLS_method()))
+            || !TEST_ptr(sess = SSL_SESSION_new()))
+        goto end;
+    memset(id, 1, sizeof(id));
+    if (!TEST_true(SSL_SESSION_set1_id(sess, id, sizeof(id)))
+            || !TEST_int_eq(SSL_CTX_add_session(ctx, sess), 1)
+            || !TEST_ptr_eq(sess->shard, &ctx->sess_shards[1]))
+        goto end;
+
+    /* The last byte of the ID picks the shard */
+    id[sizeof(id) - 1] = 2;
+    if (!TEST_true(SSL_SESSION_set1_id(sess, id, sizeof(id)))
+            || !TEST_ptr_eq(sess->owner, ctx)
+            || !TEST_ptr_eq(sess->shard, &ctx->sess_shards[2])
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 1)
+            || !TEST_long_eq(SSL_SESSION_set_timeout(sess, 100), 1)
+            || !TEST_ptr_eq(sess->shard, &ctx->sess_shards[2])
+            || !TEST_int_eq(SSL_CTX_remove_session(ctx, sess), 1)
+            || !TEST_ptr_null(sess->shard)
+            || !TEST_long_eq(SSL_CTX_sess_number(ctx), 0))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_CTX_free(ctx);
+    SSL_SESSION_free(sess);
+    return testresult;
+}
+
+#if defined(OPENSSL_SYS_UNIX) && !defined(OPENSSL_NO_TLS1_2)
+/*
+ * Test that two servers sharing a session cache file can resume each other's
+ * sessions, and that removing a session from one of them removes it from the
+ * other too.
+ */
+static int test_shared_session_cache(void)
+{
+    SSL_CTX *sctx[3] = { NULL }, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL;
+    size_t i;
+    int testresult = 0;
+
+    remove(tmpfilename);
+    for (i = 0; i < OSSL_NELEM(sctx); i++) {
+        if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                           TLS_client_method(),
+                                           TLS1_VERSION, TLS1_2_VERSION,
+                                           &sctx[i], i == 0 ? &cctx : NULL,
+                                           cert, privkey))
+                || !TEST_true(SSL_CTX_set_shared_session_cache(sctx[i],
+                                                               tmpfilename,
+                                                               64, 0)))
+            goto end;
+        SSL_CTX_set_options(sctx[i], SSL_OP_NO_TICKET);
+    }
+
+    /* A file with a different layout is refused */
+    if (!TEST_false(SSL_CTX_set_shared_session_cache(sctx[2], tmpfilename,
+                                                     128, 0)))
+        goto end;
+    ERR_clear_error();
+
+    if (!TEST_true(create_ssl_objects(sctx[0], cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_ptr(sess = SSL_get1_session(clientssl)))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
+
+    /* The second server has never seen the session */
+    if (!TEST_true(create_ssl_objects(sctx[1], cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(SSL_set_session(clientssl, sess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_session_reused(clientssl))
+            || !TEST_long_eq(SSL_CTX_sess_cb_hits(sctx[1]), 1))
+        goto end;
+    shutdown_ssl_connection(serverssl, clientssl);
+    serverssl = clientssl = NULL;
+
+    if (!TEST_true(SSL_CTX_remove_session(sctx[0], sess))
+            || !TEST_true(create_ssl_objects(sctx[2], cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(SSL_set_session(clientssl, sess))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_false(SSL_session_reused(clientssl)))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_SESSION_free(sess);
+    for (i = 0; i < OSSL_NELEM(sctx); i++)
+        SSL_CTX_free(sctx[i]);
+    SSL_CTX_free(cctx);
+    remove(tmpfilename);
+    return testresult;
+}
+#endif
+
+/*
+ * Test that connections using a record buffer pool give their buffers back
+ * once records are drained, and that later connections reuse them.
+ */
+static int test_record_buffer_pool(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    const char msg[] = "Hello";
+    char buf[sizeof(msg)];
+    size_t written, readbytes, idle, in_use;
+    uint64_t hits, misses;
+    int i, testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_false(SSL_CTX_get_record_buffer_pool_stats(sctx, NULL,
+                                                                NULL, NULL,
+                                                                NULL))
+            || !TEST_true(SSL_CTX_set_record_buffer_pool(sctx, 64))
+            || !TEST_true(SSL_CTX_set_record_buffer_pool(cctx, 64)))
+        goto end;
+
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                          NULL, NULL))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE))
+                || !TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg),
+                                           &written))
+                || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                          &readbytes))
+                || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))
+                || !TEST_true(SSL_write_ex(serverssl, msg, sizeof(msg),
+                                           &written))
+                || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf),
+                                          &readbytes))
+                || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+            goto end;
+
+        /* Neither side has a record in flight so holds no buffers */
+        if (!TEST_true(SSL_CTX_get_record_buffer_pool_stats(sctx, &idle,
+                                                            &in_use, &hits,
+                                                            &misses))
+                || !TEST_size_t_eq(in_use, 0)
+                || !TEST_size_t_gt(idle, 0)
+                || !TEST_true(SSL_CTX_get_record_buffer_pool_stats(cctx, NULL,
+                                                                   &in_use,
+                                                                   NULL, NULL))
+                || !TEST_size_t_eq(in_use, 0))
+            goto end;
+
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    /* The second connection reused the buffers of the first */
+    if (!TEST_true(SSL_CTX_get_record_buffer_pool_stats(sctx, NULL, NULL,
+                                                        &hits, &misses))
+            || !TEST_uint64_t_gt(hits, 0)
+            || !TEST_uint64_t_gt(misses, 0))
+        goto end;
+
+    /*
+     * Replacing the pool while connections are using it is safe, and they
+     * carry on using the pool they were created with.
+     */
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE))
+            || !TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_CTX_set_record_buffer_pool(sctx, 32))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                      &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg))
+            || !TEST_true(SSL_CTX_get_record_buffer_pool_stats(sctx, &idle,
+                                                               &in_use, &hits,
+                                                               &misses))
+            || !TEST_size_t_eq(idle, 0)
+            || !TEST_size_t_eq(in_use, 0)
+            || !TEST_uint64_t_eq(hits, 0)
+            || !TEST_uint64_t_eq(misses, 0))
+        goto end;
+
+    /* Likewise for removing it */
+    if (!TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written))
+            || !TEST_true(SSL_CTX_set_record_buffer_pool(sctx, 0))
+            || !TEST_false(SSL_CTX_get_record_buffer_pool_stats(sctx, NULL,
+                                                                NULL, NULL,
+                                                                NULL))
+            || !TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf),
+                                      &readbytes))
+            || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+
 /*
  * Test that a session cache overflow works as expected
  * Test 0: TLSv1.3, timeout on new session later than old session
@@ -11215,10 +11625,10 @@ end:
 
 #if !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_DYNAMIC_ENGINE)
 /*
- * Test TLSv1.2 with a pipeline capable cipher. TLSv1.3 and DTLS do not
- * support this yet. The only pipeline capable cipher that we have is in the
- * dasync engine (providers don't support this yet), so we have to use
- * deprecated APIs for this test.
+ * Test TLSv1.2 with a pipeline capable cipher. DTLS does not support this
+ * yet, and TLSv1.3 is tested separately. The only pipeline capable cipher that
+ * we have is in the dasync engine (providers don't support this yet), so we
+ * have to use deprecated APIs for this test.
  *
  * Test 0: Client has pipelining enabled, server does not
  * Test 1: Server has pipelining enabled, client does not
@@ -11412,6 +11822,371 @@ end:
 }
 #endif /* !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_DYNAMIC_ENGINE) */
 
+#ifndef OSSL_NO_USABLE_TLS1_3
+static const char *pipeline_ciphersuites[] = {
+    "TLS_AES_128_GCM_SHA256",
+    "TLS_AES_256_GCM_SHA384",
+    "TLS_AES_128_CCM_SHA256",
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    "TLS_CHACHA20_POLY1305_SHA256",
+#endif
+};
+
+/*
+ * Test that TLSv1.3 writes are split into several records which are sealed
+ * together when pipelining is enabled, and that the peer can read them.
+ */
+static int test_tls13_pipelining(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0, numreads;
+    /* A 50 byte message */
+    const unsigned char *msg = (const unsigned char *)
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwx";
+    unsigned char buf[50];
+    size_t written, readbytes, offset, msglen = 50, fragsize = 10;
+    size_t numpipes = 5;
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey))
+            || !TEST_true(SSL_CTX_set_ciphersuites(sctx,
+                                                   pipeline_ciphersuites[idx]))
+            || !TEST_true(SSL_CTX_set_ciphersuites(cctx,
+                                                   pipeline_ciphersuites[idx]))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(SSL_set_max_pipelines(clientssl, numpipes))
+            || !TEST_true(SSL_set_split_send_fragment(clientssl, fragsize))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    if (!TEST_true(SSL_write_ex(clientssl, msg, msglen, &written))
+            || !TEST_size_t_eq(written, msglen))
+        goto end;
+
+    /*
+     * The server is not using read_ahead so it should see each of the
+     * |numpipes| records in a separate read.
+     */
+    for (offset = 0, numreads = 0;
+         offset < msglen;
+         offset += readbytes, numreads++) {
+        if (!TEST_true(SSL_read_ex(serverssl, buf + offset,
+                                   msglen - offset, &readbytes)))
+            goto end;
+    }
+
+    if (!TEST_mem_eq(msg, msglen, buf, offset)
+            || !TEST_int_eq(numreads, (int)numpipes))
+        goto end;
+
+    /* Data must still flow in the other direction */
+    if (!TEST_true(SSL_write_ex(serverssl, msg, msglen, &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, sizeof(buf), &readbytes))
+            || !TEST_mem_eq(msg, msglen, buf, readbytes))
+        goto end;
+
+    testresult = 1;
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    return testresult;
+}
+#endif /* OSSL_NO_USABLE_TLS1_3 */
+
+#if !defined(OPENSSL_NO_TLS1_2) || !defined(OSSL_NO_USABLE_TLS1_3)
+static int bio_write_count;
+
+static long count_bio_writes_cb(BIO *bio, int oper, const char *argp,
+                                size_t len, int argi, long argl, int ret,
+                                size_t *processed)
+{
+    if (oper == (BIO_CB_WRITE | BIO_CB_RETURN) && ret > 0)
+        bio_write_count++;
+    return ret;
+}
+
+static const struct {
+    int version;
+    const char *ciphers;
+} multirecord_ciphers[] = {
+#ifndef OPENSSL_NO_TLS1_2
+    { TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256" },
+# if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    { TLS1_2_VERSION, "ECDHE-RSA-CHACHA20-POLY1305" },
+# endif
+#endif
+#ifndef OSSL_NO_USABLE_TLS1_3
+    { TLS1_3_VERSION, "TLS_AES_256_GCM_SHA384" },
+# if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    { TLS1_3_VERSION, "TLS_CHACHA20_POLY1305_SHA256" },
+# endif
+#endif
+};
+
+/*
+ * Test that a large write with an AEAD cipher is sealed as several records
+ * which are sent with a single BIO write, and that the peer can read them.
+ */
+static int test_aead_multirecord_write(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int version = multirecord_ciphers[idx].version, testresult = 0;
+    const char *ciphers = multirecord_ciphers[idx].ciphers;
+    /* Eight full records and a short one */
+    size_t msglen = 8 * SSL3_RT_MAX_PLAIN_LENGTH + 100;
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t i, written, readbytes, offset;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(msglen))
+            || !TEST_ptr(buf = OPENSSL_malloc(msglen)))
+        goto end;
+    for (i = 0; i < msglen; i++)
+        msg[i] = (unsigned char)i;
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey)))
+        goto end;
+    if (version == TLS1_3_VERSION) {
+        if (!TEST_true(SSL_CTX_set_ciphersuites(sctx, ciphers))
+                || !TEST_true(SSL_CTX_set_ciphersuites(cctx, ciphers)))
+            goto end;
+    } else {
+        if (!TEST_true(SSL_CTX_set_cipher_list(sctx, ciphers))
+                || !TEST_true(SSL_CTX_set_cipher_list(cctx, ciphers)))
+            goto end;
+    }
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    bio_write_count = 0;
+    BIO_set_callback_ex(SSL_get_wbio(clientssl), count_bio_writes_cb);
+    if (!TEST_true(SSL_write_ex(clientssl, msg, msglen, &written))
+            || !TEST_size_t_eq(written, msglen)
+            /* One write for the eight full records and one for the rest */
+            || !TEST_int_eq(bio_write_count, 2))
+        goto end;
+    BIO_set_callback_ex(SSL_get_wbio(clientssl), NULL);
+
+    for (offset = 0; offset < msglen; offset += readbytes)
+        if (!TEST_true(SSL_read_ex(serverssl, buf + offset, msglen - offset,
+                                   &readbytes)))
+            goto end;
+    if (!TEST_mem_eq(msg, msglen, buf, offset))
+        goto end;
+
+    /* Records sealed one at a time must still be fine afterwards */
+    if (!TEST_true(SSL_write_ex(clientssl, msg, 100, &written))
+            || !TEST_true(SSL_read_ex(serverssl, buf, msglen, &readbytes))
+            || !TEST_mem_eq(msg, 100, buf, readbytes))
+        goto end;
+
+    testresult = 1;
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
+    return testresult;
+}
+#endif
+
+#ifndef OSSL_NO_USABLE_TLS1_3
+/*
+ * Test that SSL_MODE_DIRECT_READ returns the right data, whether or not the
+ * records fit in the buffer passed to SSL_read_ex(), and that post-handshake
+ * messages are still processed.
+ * Test 0: Read buffer large enough for a full record
+ * Test 1: Read buffer smaller than a full record
+ */
+static int test_direct_read(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0, round;
+    size_t msglen = 4 * SSL3_RT_MAX_PLAIN_LENGTH + 100;
+    size_t bufmax = idx == 0 ? msglen : 1000;
+    unsigned char *msg = NULL, *buf = NULL;
+    size_t i, written, readbytes, offset, toread;
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(msglen))
+            || !TEST_ptr(buf = OPENSSL_malloc(msglen)))
+        goto end;
+    for (i = 0; i < msglen; i++)
+        msg[i] = (unsigned char)(i * 7);
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_3_VERSION,
+                                       TLS1_3_VERSION, &sctx, &cctx, cert,
+                                       privkey)))
+        goto end;
+    SSL_CTX_set_mode(sctx, SSL_MODE_DIRECT_READ);
+
+    if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl, &clientssl,
+                                      NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+
+    for (round = 0; round < 2; round++) {
+        /* In the second round the data follows a KeyUpdate */
+        if (round == 1
+                && !TEST_true(SSL_key_update(clientssl,
+                                             SSL_KEY_UPDATE_REQUESTED)))
+            goto end;
+        if (!TEST_true(SSL_write_ex(clientssl, msg, msglen, &written))
+                || !TEST_size_t_eq(written, msglen))
+            goto end;
+
+        memset(buf, 0, msglen);
+        for (offset = 0; offset < msglen; offset += readbytes) {
+            toread = msglen - offset < bufmax ? msglen - offset : bufmax;
+            if (!TEST_true(SSL_read_ex(serverssl, buf + offset, toread,
+                                       &readbytes)))
+                goto end;
+        }
+        if (!TEST_mem_eq(msg, msglen, buf, offset))
+            goto end;
+    }
+
+    /* The server must have updated its keys as requested */
+    if (!TEST_true(SSL_write_ex(serverssl, msg, 100, &written))
+            || !TEST_true(SSL_read_ex(clientssl, buf, msglen, &readbytes))
+            || !TEST_mem_eq(msg, 100, buf, readbytes))
+        goto end;
+
+    testresult = 1;
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
+    return testresult;
+}
+#endif
+
+/*
+ * Test SSL_writev() and SSL_readv().
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_writev(int idx)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    int testresult = 0;
+    int version = idx == 0 ? TLS1_2_VERSION : TLS1_3_VERSION;
+    size_t msglen = 4 * SSL3_RT_MAX_PLAIN_LENGTH;
+    unsigned char *msg = NULL, *buf = NULL;
+    SSL_CONST_IOVEC wiov[20];
+    SSL_IOVEC riov[3];
+    size_t i, written, readbytes, offset, pending;
+    BIO *wbio;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (idx == 0)
+        return TEST_skip("TLSv1.2 is disabled");
+#endif
+#ifdef OSSL_NO_USABLE_TLS1_3
+    if (idx == 1)
+        return TEST_skip("No usable TLSv1.3");
+#endif
+
+    if (!TEST_ptr(msg = OPENSSL_malloc(msglen))
+            || !TEST_ptr(buf = OPENSSL_malloc(msglen)))
+        goto end;
+    for (i = 0; i < msglen; i++)
+        msg[i] = (unsigned char)(i * 11);
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), version, version,
+                                       &sctx, &cctx, cert, privkey))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))
+            || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                SSL_ERROR_NONE)))
+        goto end;
+    wbio = SSL_get_wbio(clientssl);
+
+    /* Find out what a single full record looks like on the wire */
+    if (!TEST_true(SSL_write_ex(clientssl, msg, SSL3_RT_MAX_PLAIN_LENGTH,
+                                &written))
+            || !TEST_size_t_gt(pending = BIO_pending(wbio),
+                               SSL3_RT_MAX_PLAIN_LENGTH)
+            || !TEST_true(SSL_read_ex(serverssl, buf, msglen, &readbytes))
+            || !TEST_size_t_eq(readbytes, SSL3_RT_MAX_PLAIN_LENGTH))
+        goto end;
+
+    /* A header and a body that together fill a record are sent in one */
+    wiov[0].buf = msg;
+    wiov[0].buf_len = 10;
+    wiov[1].buf = msg + 10;
+    wiov[1].buf_len = SSL3_RT_MAX_PLAIN_LENGTH - 10;
+    if (!TEST_true(SSL_writev(clientssl, wiov, 2, &written))
+            || !TEST_size_t_eq(written, SSL3_RT_MAX_PLAIN_LENGTH)
+            || !TEST_size_t_eq(BIO_pending(wbio), pending))
+        goto end;
+
+    /* Read the record into several buffers in one call */
+    riov[0].buf = buf;
+    riov[0].buf_len = 7;
+    riov[1].buf = buf + 7;
+    riov[1].buf_len = 9000;
+    riov[2].buf = buf + 9007;
+    riov[2].buf_len = msglen - 9007;
+    if (!TEST_true(SSL_readv(serverssl, riov, 3, &readbytes))
+            || !TEST_size_t_eq(readbytes, SSL3_RT_MAX_PLAIN_LENGTH)
+            || !TEST_mem_eq(msg, SSL3_RT_MAX_PLAIN_LENGTH, buf, readbytes))
+        goto end;
+
+    /*
+     * More buffers, some of them empty, than a record is gathered from, and
+     * more data than fits in a record
+     */
+    for (i = 0, offset = 0; i < OSSL_NELEM(wiov); i++) {
+        wiov[i].buf = msg + offset;
+        wiov[i].buf_len = i == 5 ? 0 : (i * 997) % 6000;
+        offset += wiov[i].buf_len;
+    }
+    if (!TEST_size_t_le(offset, msglen)
+            || !TEST_true(SSL_writev(clientssl, wiov, OSSL_NELEM(wiov),
+                                     &written))
+            || !TEST_size_t_eq(written, offset))
+        goto end;
+    for (offset = 0; offset < written; offset += readbytes)
+        if (!TEST_true(SSL_read_ex(serverssl, buf + offset, msglen - offset,
+                                   &readbytes)))
+            goto end;
+    if (!TEST_mem_eq(msg, written, buf, offset))
+        goto end;
+
+    testresult = 1;
+end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    OPENSSL_free(msg);
+    OPENSSL_free(buf);
+    return testresult;
+}
+
 static int check_version_string(SSL *s, int version)
 {
     const char *verstr = NULL;
@@ -12563,6 +13338,7 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_early_data_tls1_2, 3);
 # endif
 #endif
+    ADD_TEST(test_cipher_list_reuse);
 #ifndef OSSL_NO_USABLE_TLS1_3
     ADD_ALL_TESTS(test_set_ciphersuite, 10);
     ADD_TEST(test_ciphersuite_change);
@@ -12652,6 +13428,12 @@ int setup_tests(void)
     ADD_TEST(test_set_verify_cert_store_ssl_ctx);
     ADD_TEST(test_set_verify_cert_store_ssl);
     ADD_ALL_TESTS(test_session_timeout, 1);
+    ADD_TEST(test_session_cache_shards);
+    ADD_TEST(test_session_cache_set1_id);
+#if defined(OPENSSL_SYS_UNIX) && !defined(OPENSSL_NO_TLS1_2)
+    ADD_TEST(test_shared_session_cache);
+#endif
+    ADD_TEST(test_record_buffer_pool);
 #if !defined(OSSL_NO_USABLE_TLS1_3) || !defined(OPENSSL_NO_TLS1_2)
     ADD_ALL_TESTS(test_session_cache_overflow, 4);
 #endif
@@ -12666,6 +13448,16 @@ int setup_tests(void)
 #if !defined(OPENSSL_NO_TLS1_2) && !defined(OPENSSL_NO_DYNAMIC_ENGINE)
     ADD_ALL_TESTS(test_pipelining, 7);
 #endif
+#ifndef OSSL_NO_USABLE_TLS1_3
+    ADD_ALL_TESTS(test_tls13_pipelining, OSSL_NELEM(pipeline_ciphersuites));
+#endif
+#if !defined(OPENSSL_NO_TLS1_2) || !defined(OSSL_NO_USABLE_TLS1_3)
+    ADD_ALL_TESTS(test_aead_multirecord_write, OSSL_NELEM(multirecord_ciphers));
+#endif
+#ifndef OSSL_NO_USABLE_TLS1_3
+    ADD_ALL_TESTS(test_direct_read, 2);
+#endif
+    ADD_ALL_TESTS(test_writev, 2);
     ADD_ALL_TESTS(test_version, 6);
     ADD_TEST(test_rstate_string);
     ADD_ALL_TESTS(test_handshake_retry, 16);
@@ -31,6 +31,7 @@
 #include "internal/nelem.h"
 #include "internal/time.h"
 #include "internal/rcu.h"
+#include "internal/namemap.h"
 #include "testutil.h"
 #include "threadstest.h"
 
@@ -1122,6 +1123,182 @@ static int test_obj_add(void)
                            1, default_provider);
 }
 
+#define NAMEMAP_LOOKUPS     20000
+/* Enough names to make the number->names index grow more than once */
+#define NAMEMAP_NEW_NAMES   400
+#define NAMEMAP_NAME_LEN    80
+#define NAMEMAP_MAX_THREADS 64
+
+/* The number of reader threads in each run */
+static const size_t namemap_threads[] = { 1, 4, 16, NAMEMAP_MAX_THREADS };
+
+static OSSL_NAMEMAP *namemap_shared = NULL;
+static const char *namemap_lookup_names[] = {
+    "SHA2-256", "AES-128-GCM", "ChaCha20-Poly1305", "RSA", "X25519",
+    "id-ecPublicKey", "1.2.840.113549.1.1.1", "HMAC"
+};
+static int namemap_lookup_nums[OSSL_NELEM(namemap_lookup_names)];
+
+/*
+ * Names added while the readers run. Half of them are longer than the part
+ * of a name that is hashed and share that part, so they collide in the hash
+ * table. Every other one also gets an alias.
+ */
+static char namemap_new_names[NAMEMAP_NEW_NAMES][NAMEMAP_NAME_LEN];
+static char namemap_new_aliases[NAMEMAP_NEW_NAMES][NAMEMAP_NAME_LEN];
+static int namemap_new_nums[NAMEMAP_NEW_NAMES];
+/* How many of the new names have been added, published by the writer */
+static uint64_t namemap_num_added;
+static CRYPTO_RWLOCK *namemap_added_lock;
+
+/*
+ * Checks that |name| maps to |number| and back. The names that were there
+ * before may have been registered after other names for the same number, in
+ * which case another name comes back, but it must map to the same number.
+ */
+static int namemap_check(const char *name, int number, int idx, int exact)
+{
+    const char *back;
+
+    if (!TEST_int_eq(ossl_namemap_name2num(namemap_shared, name), number)
+            || !TEST_ptr(back = ossl_namemap_num2name(namemap_shared, number,
+                                                      idx)))
+        return 0;
+    if (exact)
+        return TEST_str_eq(back, name);
+    return TEST_int_eq(ossl_namemap_name2num(namemap_shared, back), number);
+}
+
+static void test_namemap_write_one(void)
+{
+    size_t i;
+    int num;
+
+    for (i = 0; i < NAMEMAP_NEW_NAMES; i++) {
+        if (!TEST_int_ne(num = ossl_namemap_add_name(namemap_shared, 0,
+                                                     namemap_new_names[i]),
+                         0)
+                || ((i & 1) != 0
+                    && !TEST_int_eq(ossl_namemap_add_name(namemap_shared, num,
+                                                          namemap_new_aliases[i]),
+                                    num))) {
+            multi_set_success(0);
+            return;
+        }
+        namemap_new_nums[i] = num;
+        if (!CRYPTO_atomic_store(&namemap_num_added, i + 1,
+                                 namemap_added_lock)) {
+            multi_set_success(0);
+            return;
+        }
+    }
+}
+
+static void test_namemap_read_one(void)
+{
+    size_t i, j;
+    uint64_t added;
+
+    for (i = 0; i < NAMEMAP_LOOKUPS; i++) {
+        j = i % OSSL_NELEM(namemap_lookup_names);
+        if (!namemap_check(namemap_lookup_names[j], namemap_lookup_nums[j], 0,
+                           0))
+            goto err;
+
+        /* Look up one of the names that the writer has added so far */
+        if (!CRYPTO_atomic_load(&namemap_num_added, &added,
+                                namemap_added_lock))
+            goto err;
+        if (added == 0)
+            continue;
+        j = (size_t)((i * 7919) % added);
+        if (!namemap_check(namemap_new_names[j], namemap_new_nums[j], 0, 1)
+                || ((j & 1) != 0
+                    && !namemap_check(namemap_new_aliases[j],
+                                      namemap_new_nums[j], 1, 1)))
+            goto err;
+    }
+    return;
+ err:
+    multi_set_success(0);
+}
+
+/*
+ * Namemap lookups don't take any lock. Check that many threads reading the
+ * namemap while another one adds names to it all get the right answers, for
+ * both the names that were there before and the ones being added, and report
+ * how the lookup rate scales with the number of readers.
+ */
+static int test_namemap_read(int idx)
+{
+    thread_t threads[NAMEMAP_MAX_THREADS], writer;
+    OSSL_LIB_CTX *ctx = NULL;
+    OSSL_TIME t1, t2;
+    size_t i, nthreads = namemap_threads[idx], started;
+    uint64_t us;
+    int testresult = 0, ok = 1;
+
+    multi_intialise();
+    namemap_num_added = 0;
+    if (!TEST_ptr(namemap_added_lock = CRYPTO_THREAD_lock_new())
+            || !TEST_ptr(ctx = OSSL_LIB_CTX_new())
+            || !TEST_ptr(namemap_shared = ossl_namemap_stored(ctx)))
+        goto err;
+    for (i = 0; i < OSSL_NELEM(namemap_lookup_names); i++)
+        if (!TEST_int_ne(namemap_lookup_nums[i]
+                         = ossl_namemap_add_name(namemap_shared, 0,
+                                                 namemap_lookup_names[i]),
+                         0))
+            goto err;
+    for (i = 0; i < NAMEMAP_NEW_NAMES; i++) {
+        if ((i & 1) == 0)
+            BIO_snprintf(namemap_new_names[i], NAMEMAP_NAME_LEN,
+                         "namemap-test-%zu", i);
+        else
+            BIO_snprintf(namemap_new_names[i], NAMEMAP_NAME_LEN,
+                         "namemap-test-name-long-enough-to-share-its-hash-key"
+                         "-with-others-%zu", i);
+        BIO_snprintf(namemap_new_aliases[i], NAMEMAP_NAME_LEN,
+                     "namemap-test-alias-%zu", i);
+    }
+
+    t1 = ossl_time_now();
+    if (!TEST_true(run_thread(&writer, test_namemap_write_one)))
+        goto err;
+    for (started = 0; started < nthreads; started++)
+        if (!TEST_true(run_thread(&threads[started], test_namemap_read_one)))
+            break;
+    for (i = 0; i < started; i++)
+        if (!TEST_true(wait_for_thread(threads[i])))
+            ok = 0;
+    t2 = ossl_time_now();
+    if (!TEST_true(wait_for_thread(writer)))
+        ok = 0;
+    if (!ok || started != nthreads || !TEST_true(multi_success))
+        goto err;
+
+    /* Each reader iteration maps two names to numbers and back */
+    us = ossl_time2us(ossl_time_subtract(t2, t1));
+    if (us > 0)
+        TEST_info("%zu reader(s): %e reads/sec", nthreads,
+                  (double)nthreads * NAMEMAP_LOOKUPS * 2 * 1000000 / us);
+
+    /* Every name must still be there once the writer is done */
+    if (!TEST_uint64_t_eq(namemap_num_added, NAMEMAP_NEW_NAMES))
+        goto err;
+    for (i = 0; i < NAMEMAP_NEW_NAMES; i++)
+        if (!namemap_check(namemap_new_names[i], namemap_new_nums[i], 0, 1))
+            goto err;
+
+    testresult = 1;
+ err:
+    namemap_shared = NULL;
+    OSSL_LIB_CTX_free(ctx);
+    CRYPTO_THREAD_lock_free(namemap_added_lock);
+    namemap_added_lock = NULL;
+    return testresult;
+}
+
 #if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
 static BIO *multi_bio1, *multi_bio2;
 
@@ -1308,6 +1485,7 @@ int setup_tests(void)
 #endif
     ADD_TEST(test_multi_load_unload_provider);
     ADD_TEST(test_obj_add);
+    ADD_ALL_TESTS(test_namemap_read, OSSL_NELEM(namemap_threads));
 #if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
     ADD_TEST(test_bio_dgram_pair);
 #endif
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+
+#include "internal/timer_wheel.h"
+#include "internal/nelem.h"
+#include "testutil.h"
+
+#define NUM_ENTRIES 2000
+
+typedef struct {
+    OSSL_TIMER_WHEEL_ENTRY entry;
+    int expired;
+} TIMER;
+
+static TIMER timers[NUM_ENTRIES];
+
+/*
+ * Spreads expiry times over everything from already expired to beyond the
+ * span of the wheel, so that every level and the overflow slot are used.
+ */
+static OSSL_TIME random_expiry(OSSL_TIME start, int i)
+{
+    static const uint64_t spans[] = {
+        2, 64, 4096, 262144, 16777216, UINT64_C(1) << 40
+    };
+    uint64_t span = spans[i % OSSL_NELEM(spans)];
+
+    if (i % 97 == 0)
+        return ossl_time_subtract(start, ossl_ms2time(test_random() % 1000));
+    return ossl_time_add(start, ossl_ms2time(test_random() % span));
+}
+
+/*
+ * Turns the wheel in steps of at least |steps[idx]| milliseconds and checks
+ * that every entry comes out in the step it expires in, never earlier or later.
+ */
+static int test_timer_wheel_expire(int idx)
+{
+    static const uint64_t steps[] = { 1, 37, 1000, 65536, UINT64_C(1) << 32 };
+    OSSL_TIMER_WHEEL *tw = NULL;
+    OSSL_TIME start = ossl_ms2time(123456789), now = start, next;
+    TIMER *t;
+    size_t left = NUM_ENTRIES;
+    int i, res = 0;
+
+    if (!TEST_ptr(tw = ossl_timer_wheel_new(ossl_ms2time(1), start)))
+        goto err;
+
+    for (i = 0; i < NUM_ENTRIES; i++) {
+        ossl_timer_wheel_entry_init(&timers[i].entry, &timers[i]);
+        timers[i].expired = 0;
+        ossl_timer_wheel_add(tw, &timers[i].entry, random_expiry(start, i));
+    }
+    if (!TEST_size_t_eq(ossl_timer_wheel_num(tw), NUM_ENTRIES))
+        goto err;
+
+    while (left > 0) {
+        while ((t = ossl_timer_wheel_expire(tw, now)) != NULL) {
+            if (!TEST_false(t->expired)
+                    || !TEST_false(ossl_timer_wheel_entry_armed(&t->entry))
+                    || !TEST_int_lt(ossl_time_compare(t->entry.expiry, now), 0))
+                goto err;
+            t->expired = 1;
+            left--;
+        }
+        next = ossl_time_infinite();
+        for (i = 0; i < NUM_ENTRIES; i++) {
+            if (timers[i].expired)
+                continue;
+            if (!TEST_int_ge(ossl_time_compare(timers[i].entry.expiry, now), 0))
+                goto err;
+            next = ossl_time_min(next, timers[i].entry.expiry);
+        }
+        if (!TEST_size_t_eq(ossl_timer_wheel_num(tw), left)
+                || !TEST_int_le(ossl_time_compare(ossl_timer_wheel_next_expiry(tw),
+                                                  next), 0))
+            goto err;
+
+        /* Skip quiet stretches like a caller sleeping until the next timer */
+        now = ossl_time_max(ossl_time_add(now, ossl_ms2time(steps[idx])),
+                            ossl_time_add(next, ossl_ticks2time(1)));
+    }
+    res = 1;
+ err:
+    ossl_timer_wheel_free(tw);
+    return res;
+}
+
+/*
+ * Turns the wheel only to just past the time reported by
+ * ossl_timer_wheel_next_expiry() and checks that this always makes progress,
+ * that no entry is ever found late, and that deadlines finer than the
+ * granularity are reported exactly once they are near.
+ */
+static int test_timer_wheel_next_expiry(void)
+{
+    OSSL_TIMER_WHEEL *tw = NULL;
+    OSSL_TIME start = ossl_ms2time(987654321), now = start, prev, next;
+    TIMER *t;
+    size_t left = NUM_ENTRIES, wakeups = 0;
+    int i, res = 0;
+
+    if (!TEST_ptr(tw = ossl_timer_wheel_new(ossl_ms2time(1), start))
+            || !TEST_true(ossl_time_is_infinite(ossl_timer_wheel_next_expiry(tw))))
+        goto err;
+
+    for (i = 0; i < NUM_ENTRIES; i++) {
+        ossl_timer_wheel_entry_init(&timers[i].entry, &timers[i]);
+        timers[i].expired = 0;
+        ossl_timer_wheel_add(tw, &timers[i].entry,
+                             ossl_time_add(random_expiry(start, i),
+                                           ossl_us2time(test_random() % 1000)));
+    }
+
+    while (left > 0) {
+        next = ossl_timer_wheel_next_expiry(tw);
+        if (!TEST_false(ossl_time_is_infinite(next)))
+            goto err;
+
+        prev = now;
+        now = ossl_time_max(now, ossl_time_add(next, ossl_ticks2time(1)));
+        while ((t = ossl_timer_wheel_expire(tw, now)) != NULL) {
+            if (!TEST_false(t->expired)
+                    || !TEST_int_lt(ossl_time_compare(t->entry.expiry, now), 0)
+                    || (wakeups > 0
+                        && !TEST_int_ge(ossl_time_compare(t->entry.expiry,
+                                                          prev), 0)))
+                goto err;
+            t->expired = 1;
+            left--;
+        }
+        wakeups++;
+    }
+
+    /*
+     * Every entry needs at most one wakeup of its own plus one for each level
+     * it is moved down.
+     */
+    if (!TEST_size_t_le(wakeups, (size_t)NUM_ENTRIES * 6)
+            || !TEST_true(ossl_time_is_infinite(ossl_timer_wheel_next_expiry(tw))))
+        goto err;
+
+    /* Sub-granularity deadlines in the current revolution are exact */
+    ossl_timer_wheel_free(tw);
+    now = ossl_ms2time(64 * 1000);
+    if (!TEST_ptr(tw = ossl_timer_wheel_new(ossl_ms2time(1), now)))
+        goto err;
+    ossl_timer_wheel_add(tw, &timers[0].entry,
+                         ossl_time_add(now, ossl_us2time(2500)));
+    ossl_timer_wheel_add(tw, &timers[1].entry,
+                         ossl_time_add(now, ossl_us2time(2300)));
+    if (!TEST_uint64_t_eq(ossl_time2ticks(ossl_timer_wheel_next_expiry(tw)),
+                          ossl_time2ticks(ossl_time_add(now,
+                                                        ossl_us2time(2300)))))
+        goto err;
+    ossl_timer_wheel_remove(tw, &timers[1].entry);
+    if (!TEST_uint64_t_eq(ossl_time2ticks(ossl_timer_wheel_next_expiry(tw)),
+                          ossl_time2ticks(ossl_time_add(now,
+                                                        ossl_us2time(2500)))))
+        goto err;
+    res = 1;
+ err:
+    ossl_timer_wheel_free(tw);
+    return res;
+}
+
+static int test_timer_wheel_rearm(void)
+{
+    OSSL_TIMER_WHEEL *tw = NULL;
+    OSSL_TIME start = ossl_seconds2time(1000);
+    TIMER a, b;
+    int res = 0;
+
+    if (!TEST_ptr(tw = ossl_timer_wheel_new(ossl_seconds2time(1), start)))
+        goto err;
+
+    ossl_timer_wheel_entry_init(&a.entry, &a);
+    ossl_timer_wheel_entry_init(&b.entry, &b);
+    ossl_timer_wheel_add(tw, &a.entry, ossl_seconds2time(1010));
+    ossl_timer_wheel_add(tw, &b.entry, ossl_seconds2time(5000));
+    if (!TEST_true(ossl_timer_wheel_entry_armed(&a.entry))
+            || !TEST_size_t_eq(ossl_timer_wheel_num(tw), 2))
+        goto err;
+
+    /* Pushing |a| out means nothing is due at 1011 */
+    ossl_timer_wheel_add(tw, &a.entry, ossl_seconds2time(2000));
+    if (!TEST_size_t_eq(ossl_timer_wheel_num(tw), 2)
+            || !TEST_ptr_null(ossl_timer_wheel_expire(tw,
+                                                      ossl_seconds2time(1011))))
+        goto err;
+
+    /* A removed entry never expires */
+    ossl_timer_wheel_remove(tw, &b.entry);
+    ossl_timer_wheel_remove(tw, &b.entry);
+    if (!TEST_false(ossl_timer_wheel_entry_armed(&b.entry))
+            || !TEST_size_t_eq(ossl_timer_wheel_num(tw), 1))
+        goto err;
+
+    /* Nothing is due before |a| */
+    if (!TEST_ptr_null(ossl_timer_wheel_expire(tw, ossl_seconds2time(1500)))
+            || !TEST_ptr_eq(ossl_timer_wheel_expire(tw,
+                                                    ossl_seconds2time(9000)),
+                            &a)
+            || !TEST_ptr_null(ossl_timer_wheel_expire(tw,
+                                                      ossl_seconds2time(9000))))
+        goto err;
+
+    /* Added in the past, it is due even though the wheel has moved on */
+    ossl_timer_wheel_add(tw, &b.entry, ossl_seconds2time(10));
+    if (!TEST_ptr_eq(ossl_timer_wheel_expire(tw, ossl_seconds2time(11)), &b)
+            || !TEST_size_t_eq(ossl_timer_wheel_num(tw), 0))
+        goto err;
+    res = 1;
+ err:
+    ossl_timer_wheel_free(tw);
+    return res;
+}
+
+int setup_tests(void)
+{
+    ADD_ALL_TESTS(test_timer_wheel_expire, 5);
+    ADD_TEST(test_timer_wheel_next_expiry);
+    ADD_TEST(test_timer_wheel_rearm);
+    return 1;
+}
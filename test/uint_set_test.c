@@ -0,0 +1,257 @@
+/*
+ * Copyright 2024 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "internal/uint_set.h"
+#include "internal/nelem.h"
+#include "testutil.h"
+
+/*
+ * Checks the structural invariants of the list and the search tree. Returns
+ * the number of tree nodes visited under x, or SIZE_MAX on failure.
+ */
+static size_t check_subtree(UINT_SET_ITEM *x, UINT_SET_ITEM **expect)
+{
+    size_t l, r;
+
+    if (x == NULL)
+        return 0;
+
+    if ((x->left != NULL
+         && (!TEST_ptr_eq(x->left->parent, x)
+             || !TEST_uint_le(x->left->prio, x->prio)))
+        || (x->right != NULL
+            && (!TEST_ptr_eq(x->right->parent, x)
+                || !TEST_uint_le(x->right->prio, x->prio))))
+        return SIZE_MAX;
+
+    if ((l = check_subtree(x->left, expect)) == SIZE_MAX)
+        return SIZE_MAX;
+
+    /* In-order traversal must visit the items in list order. */
+    if (!TEST_ptr_eq(x, *expect))
+        return SIZE_MAX;
+    *expect = ossl_list_uint_set_next(x);
+
+    if ((r = check_subtree(x->right, expect)) == SIZE_MAX)
+        return SIZE_MAX;
+
+    return l + r + 1;
+}
+
+static int check_set(UINT_SET *s, const unsigned char *bits, size_t nbits)
+{
+    UINT_SET_ITEM *x, *prev = NULL, *root, *expect;
+    size_t i;
+
+    for (x = ossl_list_uint_set_head(s); x != NULL;
+         prev = x, x = ossl_list_uint_set_next(x))
+        if (!TEST_uint64_t_le(x->range.start, x->range.end)
+            || (prev != NULL
+                && !TEST_uint64_t_gt(x->range.start, prev->range.end + 1)))
+            return 0;
+
+    root = ossl_list_uint_set_tail(s);
+    if (root != NULL)
+        while (root->parent != NULL)
+            root = root->parent;
+
+    expect = ossl_list_uint_set_head(s);
+    if (!TEST_size_t_eq(check_subtree(root, &expect),
+                        ossl_list_uint_set_num(s))
+        || !TEST_ptr_null(expect))
+        return 0;
+
+    for (i = 0; i < nbits; ++i)
+        if (!TEST_int_eq(ossl_uint_set_query(s, i), bits[i]))
+            return 0;
+
+    return 1;
+}
+
+#define RANDOM_NBITS    512
+
+static int test_uint_set_random(int idx)
+{
+    int testresult = 0;
+    UINT_SET s;
+    UINT_RANGE r;
+    unsigned char bits[RANDOM_NBITS] = {0};
+    size_t i, j, max_len = idx % 2 == 0 ? 4 : 64;
+
+    ossl_uint_set_init(&s);
+
+    for (i = 0; i < 1000; ++i) {
+        r.start = test_random() % RANDOM_NBITS;
+        r.end   = r.start + test_random() % max_len;
+        if (r.end >= RANDOM_NBITS)
+            r.end = RANDOM_NBITS - 1;
+
+        if (test_random() % 3 != 0) {
+            if (!TEST_true(ossl_uint_set_insert(&s, &r)))
+                goto err;
+            for (j = (size_t)r.start; j <= r.end; ++j)
+                bits[j] = 1;
+        } else {
+            if (!TEST_true(ossl_uint_set_remove(&s, &r)))
+                goto err;
+            for (j = (size_t)r.start; j <= r.end; ++j)
+                bits[j] = 0;
+        }
+
+        if (!check_set(&s, bits, RANDOM_NBITS))
+            goto err;
+    }
+
+    testresult = 1;
+err:
+    ossl_uint_set_destroy(&s);
+    return testresult;
+}
+
+static int test_uint_set_limits(void)
+{
+    int testresult = 0;
+    UINT_SET s;
+    UINT_RANGE r;
+
+    ossl_uint_set_init(&s);
+
+    r.start = UINT64_MAX - 1;
+    r.end   = UINT64_MAX;
+    if (!TEST_true(ossl_uint_set_insert(&s, &r)))
+        goto err;
+
+    r.start = 0;
+    r.end   = 0;
+    if (!TEST_true(ossl_uint_set_insert(&s, &r))
+        || !TEST_size_t_eq(ossl_list_uint_set_num(&s), 2)
+        || !TEST_true(ossl_uint_set_query(&s, 0))
+        || !TEST_false(ossl_uint_set_query(&s, 1))
+        || !TEST_true(ossl_uint_set_query(&s, UINT64_MAX)))
+        goto err;
+
+    /* Remove the middle of the top range; it is split. */
+    r.start = UINT64_MAX - 1;
+    r.end   = UINT64_MAX - 1;
+    if (!TEST_true(ossl_uint_set_remove(&s, &r))
+        || !TEST_false(ossl_uint_set_query(&s, UINT64_MAX - 1))
+        || !TEST_true(ossl_uint_set_query(&s, UINT64_MAX)))
+        goto err;
+
+    /* A range covering everything replaces all existing ranges. */
+    r.start = 0;
+    r.end   = UINT64_MAX;
+    if (!TEST_true(ossl_uint_set_insert(&s, &r))
+        || !TEST_size_t_eq(ossl_list_uint_set_num(&s), 1))
+        goto err;
+
+    r.start = 1;
+    r.end   = UINT64_MAX - 1;
+    if (!TEST_true(ossl_uint_set_remove(&s, &r))
+        || !TEST_size_t_eq(ossl_list_uint_set_num(&s), 2)
+        || !TEST_true(ossl_uint_set_remove(&s, &r))
+        || !TEST_size_t_eq(ossl_list_uint_set_num(&s), 2))
+        goto err;
+
+    r.start = 0;
+    r.end   = UINT64_MAX;
+    if (!TEST_true(ossl_uint_set_remove(&s, &r))
+        || !TEST_true(ossl_list_uint_set_is_empty(&s)))
+        goto err;
+
+    testresult = 1;
+err:
+    ossl_uint_set_destroy(&s);
+    return testresult;
+}
+
+static size_t tree_height(const UINT_SET_ITEM *x)
+{
+    size_t l, r;
+
+    if (x == NULL)
+        return 0;
+
+    l = tree_height(x->left);
+    r = tree_height(x->right);
+    return (l > r ? l : r) + 1;
+}
+
+/*
+ * Exercises a set with many disjoint ranges, as happens when tracking received
+ * PNs under heavy loss and reordering. The set holds every other integer in
+ * [0, 2n), and each iteration fills and reopens a random gap and queries a
+ * random value. The search tree must stay balanced throughout.
+ */
+static const size_t frag_num_ranges[] = { 16, 256, 4096, 65536 };
+
+#define FRAG_OPS    20000
+
+static int test_uint_set_fragmentation(int idx)
+{
+    int testresult = 0;
+    UINT_SET s;
+    UINT_RANGE r;
+    UINT_SET_ITEM *root;
+    size_t i, n = frag_num_ranges[idx], log2n = 0, v, gap;
+
+    ossl_uint_set_init(&s);
+
+    for (i = 0; i < n; ++i) {
+        r.start = r.end = 2 * i;
+        if (!TEST_true(ossl_uint_set_insert(&s, &r)))
+            goto err;
+    }
+
+    if (!TEST_size_t_eq(ossl_list_uint_set_num(&s), n))
+        goto err;
+
+    for (i = 0; i < FRAG_OPS; ++i) {
+        gap = test_random() % n;
+        r.start = r.end = 2 * gap + 1;
+
+        /* Filling a gap merges the neighbouring ranges, except at the end. */
+        if (!TEST_true(ossl_uint_set_insert(&s, &r))
+            || !TEST_size_t_eq(ossl_list_uint_set_num(&s),
+                               gap == n - 1 ? n : n - 1)
+            || !TEST_true(ossl_uint_set_query(&s, r.start))
+            || !TEST_true(ossl_uint_set_remove(&s, &r))
+            || !TEST_size_t_eq(ossl_list_uint_set_num(&s), n)
+            || !TEST_false(ossl_uint_set_query(&s, r.start)))
+            goto err;
+
+        v = test_random() % (2 * n);
+        if (!TEST_int_eq(ossl_uint_set_query(&s, v), v % 2 == 0))
+            goto err;
+    }
+
+    /* The height of a treap is logarithmic with overwhelming probability. */
+    while (((size_t)1 << log2n) < n)
+        ++log2n;
+
+    root = ossl_list_uint_set_head(&s);
+    while (root->parent != NULL)
+        root = root->parent;
+
+    if (!TEST_size_t_le(tree_height(root), 4 * log2n))
+        goto err;
+
+    testresult = 1;
+err:
+    ossl_uint_set_destroy(&s);
+    return testresult;
+}
+
+int setup_tests(void)
+{
+    ADD_ALL_TESTS(test_uint_set_random, 20);
+    ADD_TEST(test_uint_set_limits);
+    ADD_ALL_TESTS(test_uint_set_fragmentation, OSSL_NELEM(frag_num_ranges));
+    return 1;
+}